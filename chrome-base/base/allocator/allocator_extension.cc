@@ -6,6 +6,10 @@
 
 #include "base/logging.h"
 
+#if defined(USE_TCMALLOC)
+#include "third_party/tcmalloc/chromium/src/gperftools/malloc_extension.h"
+#endif
+
 namespace base {
 namespace allocator {
 
@@ -15,13 +19,23 @@ GetNumericPropertyFunction g_get_numeric_property_function = nullptr;
 }
 
 void ReleaseFreeMemory() {
-  if (g_release_free_memory_function)
+  if (g_release_free_memory_function) {
     g_release_free_memory_function();
+    return;
+  }
+#if defined(USE_TCMALLOC)
+  ::MallocExtension::instance()->ReleaseFreeMemory();
+#endif
 }
 
 bool GetNumericProperty(const char* name, size_t* value) {
-  return g_get_numeric_property_function &&
-         g_get_numeric_property_function(name, value);
+  if (g_get_numeric_property_function)
+    return g_get_numeric_property_function(name, value);
+#if defined(USE_TCMALLOC)
+  return ::MallocExtension::instance()->GetNumericProperty(name, value);
+#else
+  return false;
+#endif
 }
 
 void SetReleaseFreeMemoryFunction(
@@ -24,12 +24,19 @@ BASE_EXPORT void ReleaseFreeMemory();
 // Returns false if the property is not a valid property name for the current
 // allocator implementation.
 // |name| or |value| cannot be NULL
+//
+// When built with USE_TCMALLOC and no function has been set, both of the above
+// go to tcmalloc's MallocExtension. Useful properties include:
+//   "generic.current_allocated_bytes"  Bytes in use by the application.
+//   "generic.heap_size"                Bytes reserved from the system.
+//   "tcmalloc.pageheap_free_bytes"     Free pages not yet returned.
+//   "tcmalloc.current_total_thread_cache_bytes"
 BASE_EXPORT bool GetNumericProperty(const char* name, size_t* value);
 
 // These settings allow specifying a callback used to implement the allocator
-// extension functions.  These are optional, but if set they must only be set
-// once.  These will typically called in an allocator-specific initialization
-// routine.
+// extension functions, and take precedence over tcmalloc.  These are optional,
+// but if set they must only be set once.  These will typically be called in
+// an allocator-specific initialization routine.
 //
 // No threading promises are made.  The caller is responsible for making sure
 // these pointers are set before any other threads attempt to call the above
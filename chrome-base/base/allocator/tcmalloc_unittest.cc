@@ -5,6 +5,8 @@
 #include <stddef.h>
 #include <stdio.h>
 
+#include "base/allocator/allocator_check.h"
+#include "base/allocator/allocator_extension.h"
 #include "base/logging.h"
 #include "base/process/process_metrics.h"
 #include "build/build_config.h"
@@ -177,6 +179,31 @@ TEST(TCMallocTest, Realloc) {
   free(p);
 }
 
+TEST(TCMallocTest, AllocatorExtensionReportsHeapStats) {
+  EXPECT_TRUE(base::allocator::IsAllocatorInitialized());
+
+  const size_t kSize = 10 * 1024 * 1024;
+  size_t before = 0;
+  ASSERT_TRUE(base::allocator::GetNumericProperty(
+      "generic.current_allocated_bytes", &before));
+  unsigned char* buffer = reinterpret_cast<unsigned char*>(malloc(kSize));
+  Fill(buffer, kSize);
+  size_t after = 0;
+  ASSERT_TRUE(base::allocator::GetNumericProperty(
+      "generic.current_allocated_bytes", &after));
+  EXPECT_GE(after, before + kSize);
+  size_t heap_size = 0;
+  EXPECT_TRUE(
+      base::allocator::GetNumericProperty("generic.heap_size", &heap_size));
+  EXPECT_GE(heap_size, after);
+  free(buffer);
+
+  base::allocator::ReleaseFreeMemory();
+  size_t unused;
+  EXPECT_FALSE(
+      base::allocator::GetNumericProperty("no.such.property", &unused));
+}
+
 #ifdef NDEBUG
 TEST(TCMallocFreeTest, BadPointerInFirstPageOfTheLargeObject) {
   const size_t kPageSize = base::GetPageSize();
@@ -0,0 +1,329 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/audio/polyphase_resampler.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "base/cpu_dispatch.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/memory/aligned_memory.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY) && defined(COMPILER_GCC)
+#include <immintrin.h>
+// The kernels are compiled with function attributes rather than build flags,
+// and only used when the CPU has the instructions.
+#define RESAMPLER_USE_SIMD 1
+#endif
+
+namespace base {
+
+namespace {
+
+// The cutoff of the low-pass filter as a fraction of the lower Nyquist
+// frequency. The transition band lies between it and the Nyquist frequency.
+const double kCutoff = 0.9;
+
+// The zero crossings of the sinc on each side of its center. More make the
+// transition band narrower.
+const double kZeroCrossings = 32;
+
+// Gives a stopband attenuation of about 80 dB.
+const double kKaiserBeta = 7.857;
+
+// Taps are padded to a multiple of the widest vector, in floats.
+const size_t kTapAlignment = 8;
+
+int GreatestCommonDivisor(int a, int b) {
+  while (b) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// The modified Bessel function of the first kind of order zero, which the
+// Kaiser window is made of. The series converges quickly for the arguments
+// used here.
+double BesselI0(double x) {
+  double sum = 1;
+  double term = 1;
+  for (int k = 1; k < 50; ++k) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+    if (term < sum * 1e-12)
+      break;
+  }
+  return sum;
+}
+
+// Returns the dot product of |taps| floats at |a| and |b|. |taps| is a
+// multiple of kTapAlignment and |b| is aligned to 32 bytes.
+typedef float (*DotProductFunction)(const float* a, const float* b,
+                                    size_t taps);
+
+float DotProductPortable(const float* a, const float* b, size_t taps) {
+  float sum = 0;
+  for (size_t i = 0; i < taps; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
+
+#if defined(RESAMPLER_USE_SIMD)
+
+__attribute__((target("sse2"))) float DotProductSSE2(const float* a,
+                                                     const float* b,
+                                                     size_t taps) {
+  __m128 sum0 = _mm_setzero_ps();
+  __m128 sum1 = _mm_setzero_ps();
+  for (size_t i = 0; i < taps; i += 8) {
+    sum0 = _mm_add_ps(sum0,
+                      _mm_mul_ps(_mm_loadu_ps(a + i), _mm_load_ps(b + i)));
+    sum1 = _mm_add_ps(
+        sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_load_ps(b + i + 4)));
+  }
+  __m128 sum = _mm_add_ps(sum0, sum1);
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+
+__attribute__((target("avx2,fma"))) float DotProductAVX2(const float* a,
+                                                         const float* b,
+                                                         size_t taps) {
+  // Two accumulators hide the latency of the multiply-adds.
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= taps; i += 16) {
+    sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_load_ps(b + i), sum0);
+    sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),
+                           _mm256_load_ps(b + i + 8), sum1);
+  }
+  if (i < taps)
+    sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_load_ps(b + i), sum0);
+  __m256 sum = _mm256_add_ps(sum0, sum1);
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum),
+                           _mm256_extractf128_ps(sum, 1));
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+  return _mm_cvtss_f32(half);
+}
+
+#endif  // defined(RESAMPLER_USE_SIMD)
+
+const CPUKernelVariant<DotProductFunction> kDotProductVariants[] = {
+#if defined(RESAMPLER_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2 | CPU_FEATURE_FMA3, &DotProductAVX2},
+    {"sse2", CPU_FEATURE_SSE2, &DotProductSSE2},
+#endif
+    {"portable", 0, &DotProductPortable},
+};
+
+CPUDispatchedKernel<DotProductFunction> g_dot_product =
+    CPU_DISPATCHED_KERNEL("resampler_dot_product", kDotProductVariants);
+
+}  // namespace
+
+namespace internal {
+
+// The phases of the low-pass filter for one ratio L / M. Phase p holds the
+// taps for the outputs whose position in the input falls p / L of the way
+// between two samples, in the order of the input samples they multiply.
+class ResamplerFilterBank
+    : public RefCountedThreadSafe<ResamplerFilterBank> {
+ public:
+  ResamplerFilterBank(int up, int down)
+      : up_(up), down_(down), taps_(0) {
+    // The cutoff in cycles per sample of the input upsampled by L.
+    const double cutoff = kCutoff * 0.5 / std::max(up, down);
+    taps_ = static_cast<size_t>(ceil(kZeroCrossings / (cutoff * up)));
+    taps_ = (taps_ + kTapAlignment - 1) / kTapAlignment * kTapAlignment;
+    const size_t length = taps_ * up;
+    const double center = length / 2.0;
+
+    phases_.reset(static_cast<float*>(
+        AlignedAlloc(length * sizeof(float), kTapAlignment * sizeof(float))));
+    std::vector<double> prototype(length);
+    for (size_t t = 0; t < length; ++t) {
+      const double x = t - center;
+      const double sinc =
+          x == 0 ? 1 : sin(2 * M_PI * cutoff * x) / (2 * M_PI * cutoff * x);
+      const double r = x / center;
+      const double window =
+          BesselI0(kKaiserBeta * sqrt(std::max(0.0, 1 - r * r))) /
+          BesselI0(kKaiserBeta);
+      prototype[t] = sinc * window;
+    }
+
+    // Tap j of phase p multiplies the j-th oldest of the |taps_| samples, so
+    // it takes prototype tap (taps_ - 1 - j) * L + p. Each phase is
+    // normalized to unit gain at DC.
+    for (int p = 0; p < up; ++p) {
+      float* phase = phases_.get() + p * taps_;
+      double sum = 0;
+      for (size_t j = 0; j < taps_; ++j)
+        sum += prototype[(taps_ - 1 - j) * up + p];
+      for (size_t j = 0; j < taps_; ++j) {
+        phase[j] =
+            static_cast<float>(prototype[(taps_ - 1 - j) * up + p] / sum);
+      }
+    }
+  }
+
+  int up() const { return up_; }
+  int down() const { return down_; }
+  size_t taps() const { return taps_; }
+  const float* phase(int p) const { return phases_.get() + p * taps_; }
+
+ private:
+  friend class RefCountedThreadSafe<ResamplerFilterBank>;
+  ~ResamplerFilterBank() {}
+
+  const int up_;
+  const int down_;
+  size_t taps_;
+  scoped_ptr<float, AlignedFreeDeleter> phases_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResamplerFilterBank);
+};
+
+}  // namespace internal
+
+namespace {
+
+// The filter banks made so far, by reduced ratio. They are kept for the life
+// of the process; a service only sees a handful of rates.
+class FilterBankCache {
+ public:
+  FilterBankCache() {}
+
+  scoped_refptr<const internal::ResamplerFilterBank> Get(int up, int down) {
+    AutoLock auto_lock(lock_);
+    scoped_refptr<const internal::ResamplerFilterBank>& bank =
+        banks_[std::make_pair(up, down)];
+    if (!bank)
+      bank = new internal::ResamplerFilterBank(up, down);
+    return bank;
+  }
+
+ private:
+  Lock lock_;
+  std::map<std::pair<int, int>,
+           scoped_refptr<const internal::ResamplerFilterBank>>
+      banks_;
+
+  DISALLOW_COPY_AND_ASSIGN(FilterBankCache);
+};
+
+LazyInstance<FilterBankCache>::Leaky g_filter_banks = LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+const int PolyphaseResampler::kMaxPhases;
+
+// static
+bool PolyphaseResampler::IsSupported(int input_rate, int output_rate) {
+  if (input_rate <= 0 || output_rate <= 0)
+    return false;
+  return output_rate / GreatestCommonDivisor(input_rate, output_rate) <=
+         kMaxPhases;
+}
+
+PolyphaseResampler::PolyphaseResampler(int input_rate, int output_rate)
+    : input_rate_(input_rate),
+      output_rate_(output_rate),
+      position_(0),
+      phase_(0),
+      input_count_(0),
+      output_count_(0) {
+  CHECK(IsSupported(input_rate, output_rate));
+  const int gcd = GreatestCommonDivisor(input_rate, output_rate);
+  bank_ = g_filter_banks.Get().Get(output_rate / gcd, input_rate / gcd);
+  Reset();
+}
+
+PolyphaseResampler::~PolyphaseResampler() {}
+
+size_t PolyphaseResampler::taps() const {
+  return bank_->taps();
+}
+
+// static
+void PolyphaseResampler::ResetKernelsForTesting() {
+  g_dot_product.ResetForTesting();
+}
+
+size_t PolyphaseResampler::MaxOutputSize(size_t input_size) const {
+  // Covers the input that waits in |buffer_| and the padding that Flush()
+  // adds.
+  const uint64_t pending = input_size + bank_->taps();
+  return static_cast<size_t>(pending * bank_->up() / bank_->down() + 1);
+}
+
+size_t PolyphaseResampler::Resample(const float* input,
+                                    size_t input_size,
+                                    float* output) {
+  buffer_.insert(buffer_.end(), input, input + input_size);
+  input_count_ += input_size;
+  return Process(output);
+}
+
+size_t PolyphaseResampler::Flush(float* output) {
+  // The last outputs are centered up to half the filter before the end of
+  // the buffer.
+  buffer_.resize(buffer_.size() + bank_->taps() / 2, 0.0f);
+  size_t written = Process(output);
+  const uint64_t expected =
+      (input_count_ * bank_->up() + bank_->down() - 1) / bank_->down();
+  DCHECK_EQ(expected, output_count_);
+  Reset();
+  return written;
+}
+
+void PolyphaseResampler::Reset() {
+  // Output 0 is centered on input sample 0 when the taps before it see
+  // half a filter of zeros.
+  const size_t taps = bank_->taps();
+  buffer_.assign(taps / 2 - 1, 0.0f);
+  position_ = taps - 1;
+  phase_ = 0;
+  input_count_ = 0;
+  output_count_ = 0;
+}
+
+size_t PolyphaseResampler::Process(float* output) {
+  DotProductFunction dot_product = g_dot_product.Get();
+  const size_t taps = bank_->taps();
+  const int up = bank_->up();
+  const int down = bank_->down();
+  size_t written = 0;
+  while (position_ < buffer_.size()) {
+    output[written++] = dot_product(&buffer_[position_ + 1 - taps],
+                                    bank_->phase(phase_), taps);
+    phase_ += down;
+    position_ += phase_ / up;
+    phase_ %= up;
+  }
+  output_count_ += written;
+
+  // Keep the samples from the oldest one that the next output uses.
+  const size_t drop = std::min(position_ + 1 - taps, buffer_.size());
+  buffer_.erase(buffer_.begin(), buffer_.begin() + drop);
+  position_ -= drop;
+  return written;
+}
+
+}  // namespace base
@@ -0,0 +1,116 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_AUDIO_POLYPHASE_RESAMPLER_H_
+#define BASE_AUDIO_POLYPHASE_RESAMPLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+
+namespace base {
+
+namespace internal {
+class ResamplerFilterBank;
+}
+
+// Converts a stream of mono float samples from one sample rate to another,
+// e.g. 8 kHz telephony or 44.1 and 48 kHz recordings to the 16 kHz that
+// speech models take.
+//
+// The ratio of the rates is reduced to L / M. Each output sample is a dot
+// product of the recent input with one of L phases of a Kaiser-windowed sinc
+// low-pass filter. Its cutoff is at 90% of the lower Nyquist frequency and it
+// attenuates aliases by about 80 dB. The filter banks are computed once per
+// ratio and shared by all resamplers, so a resampler is cheap to create per
+// stream. The dot products have SSE2 and AVX2 kernels.
+//
+// The output is aligned with the input: output sample n is the input
+// interpolated at time n / output_rate. Feed the input in chunks of any size
+// and call Flush() at the end of the stream:
+//
+//   PolyphaseResampler resampler(48000, 16000);
+//   std::vector<float> output(resampler.MaxOutputSize(chunk_size));
+//   for each chunk:
+//     size_t n = resampler.Resample(chunk, chunk_size, output.data());
+//     Consume(output.data(), n);
+//   size_t n = resampler.Flush(output.data());
+//   Consume(output.data(), n);
+//
+// Not thread-safe; use one resampler per stream.
+class BASE_EXPORT PolyphaseResampler {
+ public:
+  // The largest L, after reduction, that the resampler supports. It covers
+  // every conversion between the usual rates, such as 44.1 kHz to 16 kHz
+  // with L = 160.
+  static const int kMaxPhases = 1024;
+
+  // Returns whether a resampler from |input_rate| to |output_rate| can be
+  // created: both rates are positive and the reduced ratio has at most
+  // kMaxPhases phases.
+  static bool IsSupported(int input_rate, int output_rate);
+
+  // IsSupported(|input_rate|, |output_rate|) must be true.
+  PolyphaseResampler(int input_rate, int output_rate);
+  ~PolyphaseResampler();
+
+  // Returns the most samples that Resample() can write for |input_size|
+  // input samples, and that Flush() can write.
+  size_t MaxOutputSize(size_t input_size) const;
+
+  // Resamples |input_size| samples at |input| and writes the output samples
+  // that they complete to |output|. Returns how many were written. The last
+  // few output samples of a chunk wait for input from the next one.
+  size_t Resample(const float* input, size_t input_size, float* output);
+
+  // Writes the output samples that still wait for input, as if the stream
+  // were followed by silence, and resets the resampler for a new stream.
+  // After Flush(), the stream has given ceil(input samples * L / M) output
+  // samples in total.
+  size_t Flush(float* output);
+
+  // Forgets the input so far, to start a new stream.
+  void Reset();
+
+  int input_rate() const { return input_rate_; }
+  int output_rate() const { return output_rate_; }
+
+  // The number of filter taps per output sample.
+  size_t taps() const;
+
+  // Makes resamplers pick their dot product kernel again, e.g. after
+  // SetCPUFeatureMaskForTesting().
+  static void ResetKernelsForTesting();
+
+ private:
+  // Writes every output whose input is in |buffer_| and drops the input
+  // that no later output needs.
+  size_t Process(float* output);
+
+  const int input_rate_;
+  const int output_rate_;
+  scoped_refptr<const internal::ResamplerFilterBank> bank_;
+
+  // Input samples that later outputs still need, preceded at the start of a
+  // stream by zeros for the outputs before the first input sample.
+  std::vector<float> buffer_;
+  // The index in |buffer_| of the newest sample that the next output uses.
+  size_t position_;
+  // The phase of the next output, in [0, L).
+  int phase_;
+  // Input samples since the start of the stream, and outputs written.
+  uint64_t input_count_;
+  uint64_t output_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(PolyphaseResampler);
+};
+
+}  // namespace base
+
+#endif  // BASE_AUDIO_POLYPHASE_RESAMPLER_H_
@@ -0,0 +1,175 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/audio/polyphase_resampler.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/cpu_dispatch.h"
+#include "base/macros.h"
+#include "base/rand_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class PolyphaseResamplerTest : public testing::Test {
+ protected:
+  void TearDown() override { UseFeatures(~0u); }
+
+  void UseFeatures(CPUFeatures mask) {
+    SetCPUFeatureMaskForTesting(mask);
+    PolyphaseResampler::ResetKernelsForTesting();
+  }
+};
+
+std::vector<float> Sine(double frequency, int rate, size_t count) {
+  std::vector<float> samples(count);
+  for (size_t i = 0; i < count; ++i)
+    samples[i] = static_cast<float>(sin(2 * M_PI * frequency * i / rate));
+  return samples;
+}
+
+// Resamples |input| in chunks of |chunk_size| samples and flushes.
+std::vector<float> ResampleAll(PolyphaseResampler* resampler,
+                               const std::vector<float>& input,
+                               size_t chunk_size) {
+  std::vector<float> output;
+  std::vector<float> chunk_output(resampler->MaxOutputSize(chunk_size));
+  for (size_t i = 0; i < input.size(); i += chunk_size) {
+    size_t size = std::min(chunk_size, input.size() - i);
+    size_t written =
+        resampler->Resample(&input[i], size, chunk_output.data());
+    EXPECT_LE(written, chunk_output.size());
+    output.insert(output.end(), chunk_output.begin(),
+                  chunk_output.begin() + written);
+  }
+  size_t written = resampler->Flush(chunk_output.data());
+  EXPECT_LE(written, chunk_output.size());
+  output.insert(output.end(), chunk_output.begin(),
+                chunk_output.begin() + written);
+  return output;
+}
+
+// Returns the ratio in dB of the power of |expected| to the power of the
+// difference of |actual| from it, over samples [begin, end).
+double SignalToNoise(const std::vector<float>& expected,
+                     const std::vector<float>& actual,
+                     size_t begin,
+                     size_t end) {
+  double signal = 0;
+  double noise = 0;
+  for (size_t i = begin; i < end; ++i) {
+    signal += expected[i] * expected[i];
+    noise += (actual[i] - expected[i]) * (actual[i] - expected[i]);
+  }
+  return 10 * log10(signal / noise);
+}
+
+}  // namespace
+
+TEST_F(PolyphaseResamplerTest, IsSupported) {
+  EXPECT_TRUE(PolyphaseResampler::IsSupported(48000, 16000));
+  EXPECT_TRUE(PolyphaseResampler::IsSupported(44100, 16000));
+  EXPECT_TRUE(PolyphaseResampler::IsSupported(8000, 16000));
+  EXPECT_TRUE(PolyphaseResampler::IsSupported(16000, 16000));
+  EXPECT_TRUE(PolyphaseResampler::IsSupported(22050, 16000));
+  EXPECT_FALSE(PolyphaseResampler::IsSupported(0, 16000));
+  EXPECT_FALSE(PolyphaseResampler::IsSupported(16000, -1));
+  // L = 16000 after reduction.
+  EXPECT_FALSE(PolyphaseResampler::IsSupported(16001, 16000));
+}
+
+TEST_F(PolyphaseResamplerTest, OutputCountAndChunking) {
+  const int kRates[] = {8000, 11025, 16000, 22050, 44100, 48000};
+  const size_t kChunkSizes[] = {1, 7, 160, 4096};
+  std::vector<float> input(5000);
+  for (size_t i = 0; i < input.size(); ++i)
+    input[i] = static_cast<float>(RandDouble() * 2 - 1);
+
+  for (size_t r = 0; r < arraysize(kRates); ++r) {
+    PolyphaseResampler resampler(kRates[r], 16000);
+    std::vector<float> expected = ResampleAll(&resampler, input, input.size());
+    EXPECT_EQ((input.size() * 16000 + kRates[r] - 1) / kRates[r],
+              expected.size())
+        << kRates[r];
+    for (size_t c = 0; c < arraysize(kChunkSizes); ++c) {
+      // Flush() resets, so the same resampler starts a new stream.
+      std::vector<float> output =
+          ResampleAll(&resampler, input, kChunkSizes[c]);
+      EXPECT_TRUE(expected == output)
+          << kRates[r] << ", chunks of " << kChunkSizes[c];
+    }
+  }
+}
+
+// A tone in the passband comes out as the same tone at the output rate, in
+// phase with the input.
+TEST_F(PolyphaseResamplerTest, PassbandSine) {
+  const int kRates[] = {8000, 16000, 44100, 48000};
+  const double kFrequencies[] = {440, 1000, 3000};
+  for (size_t r = 0; r < arraysize(kRates); ++r) {
+    for (size_t f = 0; f < arraysize(kFrequencies); ++f) {
+      const int input_rate = kRates[r];
+      const size_t seconds = 1;
+      PolyphaseResampler resampler(input_rate, 16000);
+      std::vector<float> output = ResampleAll(
+          &resampler, Sine(kFrequencies[f], input_rate, input_rate * seconds),
+          1024);
+      std::vector<float> expected =
+          Sine(kFrequencies[f], 16000, output.size());
+      // Skip the edges, where the filter sees the start and end of the tone.
+      const size_t edge = resampler.taps() * 16000 / input_rate + 16;
+      EXPECT_GT(SignalToNoise(expected, output, edge, output.size() - edge),
+                70)
+          << input_rate << " Hz, " << kFrequencies[f] << " Hz tone";
+    }
+  }
+}
+
+// A tone above the output Nyquist frequency is filtered out rather than
+// aliased.
+TEST_F(PolyphaseResamplerTest, StopbandSine) {
+  const double kFrequencies[] = {8500, 9000, 12000, 20000};
+  for (size_t f = 0; f < arraysize(kFrequencies); ++f) {
+    PolyphaseResampler resampler(48000, 16000);
+    std::vector<float> output =
+        ResampleAll(&resampler, Sine(kFrequencies[f], 48000, 48000), 1024);
+    const size_t edge = resampler.taps() / 3 + 16;
+    double power = 0;
+    for (size_t i = edge; i < output.size() - edge; ++i)
+      power += output[i] * output[i];
+    power /= output.size() - 2 * edge;
+    // The tone has power 0.5.
+    EXPECT_LT(10 * log10(power / 0.5), -70) << kFrequencies[f] << " Hz";
+  }
+}
+
+// The kernels differ only by rounding.
+TEST_F(PolyphaseResamplerTest, KernelsAgree) {
+  const CPUFeatures kFeatureMasks[] = {0, CPU_FEATURE_SSE2, ~0u};
+  std::vector<float> input(3000);
+  for (size_t i = 0; i < input.size(); ++i)
+    input[i] = static_cast<float>(RandDouble() * 2 - 1);
+
+  std::vector<float> expected;
+  for (size_t m = 0; m < arraysize(kFeatureMasks); ++m) {
+    UseFeatures(kFeatureMasks[m]);
+    PolyphaseResampler resampler(44100, 16000);
+    std::vector<float> output = ResampleAll(&resampler, input, 500);
+    if (m == 0) {
+      expected = output;
+      continue;
+    }
+    ASSERT_EQ(expected.size(), output.size());
+    for (size_t i = 0; i < output.size(); ++i)
+      ASSERT_NEAR(expected[i], output[i], 1e-4f) << "mask " << m << ", " << i;
+  }
+}
+
+}  // namespace base
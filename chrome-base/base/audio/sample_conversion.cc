@@ -0,0 +1,763 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/audio/sample_conversion.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/cpu_dispatch.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/sys_byteorder.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY) && defined(COMPILER_GCC)
+#include <immintrin.h>
+// The kernels are compiled with function attributes rather than build flags,
+// and only used when the CPU has the instructions.
+#define SAMPLE_CONVERSION_USE_SIMD 1
+#endif
+
+namespace base {
+
+namespace {
+
+// Converts |count| samples at |source| to floats, multiplying their values
+// by |factor|.
+typedef void (*ToFloatFunction)(const uint8_t* source,
+                                size_t count,
+                                float factor,
+                                float* dest);
+
+// Rounds and saturates |count| floats in the int16 range.
+typedef void (*FloatToInt16Function)(const float* source,
+                                     size_t count,
+                                     int16_t* dest);
+
+// Splits |frames| interleaved stereo frames at |source| into |left| and
+// |right|.
+typedef void (*SplitStereoFunction)(const float* source,
+                                    size_t frames,
+                                    float* left,
+                                    float* right);
+
+// Writes the sum of the two samples of each of |frames| interleaved stereo
+// frames at |source| to |dest|.
+typedef void (*SumStereoFunction)(const float* source,
+                                  size_t frames,
+                                  float* dest);
+
+// The number of samples that the conversions with an intermediate step
+// convert at a time. Small enough to stay in the L1 cache.
+const size_t kChunkSamples = 1024;
+
+// The value of a full scale sample, indexed by SampleFormat.
+const float kFullScale[] = {
+    128.0f,        128.0f,        32768.0f,      32768.0f, 8388608.0f,
+    8388608.0f,    2147483648.0f, 2147483648.0f, 1.0f,     1.0f,
+};
+static_assert(arraysize(kFullScale) == SAMPLE_FORMAT_MAX + 1,
+              "kFullScale must cover every SampleFormat");
+
+template <typename T>
+inline T LoadUnaligned(const uint8_t* p) {
+  T value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline float BitsToFloat(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline float SignExtend24(uint32_t value) {
+  return static_cast<float>(static_cast<int32_t>(value << 8) >> 8);
+}
+
+// Reads one sample as a float of its integer value, or its float value.
+template <SampleFormat kFormat>
+struct SampleReader;
+
+template <>
+struct SampleReader<SAMPLE_FORMAT_U8> {
+  static const size_t kBytes = 1;
+  static float Read(const uint8_t* p) {
+    return static_cast<float>(static_cast<int>(*p) - 128);
+  }
+};
+
+template <>
+struct SampleReader<SAMPLE_FORMAT_S8> {
+  static const size_t kBytes = 1;
+  static float Read(const uint8_t* p) {
+    return static_cast<float>(static_cast<int8_t>(*p));
+  }
+};
+
+template <>
+struct SampleReader<SAMPLE_FORMAT_S16LE> {
+  static const size_t kBytes = 2;
+  static float Read(const uint8_t* p) {
+    return static_cast<float>(
+        static_cast<int16_t>(ByteSwapToLE16(LoadUnaligned<uint16_t>(p))));
+  }
+};
+
+template <>
+struct SampleReader<SAMPLE_FORMAT_S16BE> {
+  static const size_t kBytes = 2;
+  static float Read(const uint8_t* p) {
+    return static_cast<float>(
+        static_cast<int16_t>(NetToHost16(LoadUnaligned<uint16_t>(p))));
+  }
+};
+
+template <>
+struct SampleReader<SAMPLE_FORMAT_S24LE> {
+  static const size_t kBytes = 3;
+  static float Read(const uint8_t* p) {
+    return SignExtend24(p[0] | (p[1] << 8) |
+                        (static_cast<uint32_t>(p[2]) << 16));
+  }
+};
+
+template <>
+struct SampleReader<SAMPLE_FORMAT_S24BE> {
+  static const size_t kBytes = 3;
+  static float Read(const uint8_t* p) {
+    return SignExtend24(p[2] | (p[1] << 8) |
+                        (static_cast<uint32_t>(p[0]) << 16));
+  }
+};
+
+template <>
+struct SampleReader<SAMPLE_FORMAT_S32LE> {
+  static const size_t kBytes = 4;
+  static float Read(const uint8_t* p) {
+    return static_cast<float>(
+        static_cast<int32_t>(ByteSwapToLE32(LoadUnaligned<uint32_t>(p))));
+  }
+};
+
+template <>
+struct SampleReader<SAMPLE_FORMAT_S32BE> {
+  static const size_t kBytes = 4;
+  static float Read(const uint8_t* p) {
+    return static_cast<float>(
+        static_cast<int32_t>(NetToHost32(LoadUnaligned<uint32_t>(p))));
+  }
+};
+
+template <>
+struct SampleReader<SAMPLE_FORMAT_F32LE> {
+  static const size_t kBytes = 4;
+  static float Read(const uint8_t* p) {
+    return BitsToFloat(ByteSwapToLE32(LoadUnaligned<uint32_t>(p)));
+  }
+};
+
+template <>
+struct SampleReader<SAMPLE_FORMAT_F32BE> {
+  static const size_t kBytes = 4;
+  static float Read(const uint8_t* p) {
+    return BitsToFloat(NetToHost32(LoadUnaligned<uint32_t>(p)));
+  }
+};
+
+// The reference that the other kernels must match exactly. They use it for
+// the samples that don't fill a vector.
+template <SampleFormat kFormat>
+void ToFloatPortable(const uint8_t* source,
+                     size_t count,
+                     float factor,
+                     float* dest) {
+  typedef SampleReader<kFormat> Reader;
+  for (size_t i = 0; i < count; ++i)
+    dest[i] = Reader::Read(source + i * Reader::kBytes) * factor;
+}
+
+void FloatToInt16Portable(const float* source, size_t count, int16_t* dest) {
+  for (size_t i = 0; i < count; ++i) {
+    float value = std::min(std::max(source[i], -32768.0f), 32767.0f);
+    dest[i] = static_cast<int16_t>(lrintf(value));
+  }
+}
+
+void SplitStereoPortable(const float* source,
+                         size_t frames,
+                         float* left,
+                         float* right) {
+  for (size_t i = 0; i < frames; ++i) {
+    left[i] = source[i * 2];
+    right[i] = source[i * 2 + 1];
+  }
+}
+
+void SumStereoPortable(const float* source, size_t frames, float* dest) {
+  for (size_t i = 0; i < frames; ++i)
+    dest[i] = source[i * 2] + source[i * 2 + 1];
+}
+
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+
+// SSE2 -----------------------------------------------------------------------
+
+__attribute__((target("sse2"))) inline __m128i SwapBytes16SSE2(__m128i v) {
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+__attribute__((target("sse2"))) inline __m128i SwapBytes32SSE2(__m128i v) {
+  v = SwapBytes16SSE2(v);
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+}
+
+template <bool kBigEndian>
+__attribute__((target("sse2"))) void S16ToFloatSSE2(const uint8_t* source,
+                                                    size_t count,
+                                                    float factor,
+                                                    float* dest) {
+  const __m128 f = _mm_set1_ps(factor);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+    if (kBigEndian)
+      v = SwapBytes16SSE2(v);
+    // Unpacking a sample with itself and shifting it back sign-extends it.
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), f));
+    _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), f));
+  }
+  ToFloatPortable<kBigEndian ? SAMPLE_FORMAT_S16BE : SAMPLE_FORMAT_S16LE>(
+      source + i * 2, count - i, factor, dest + i);
+}
+
+template <bool kBigEndian, bool kFloat>
+__attribute__((target("sse2"))) void Bits32ToFloatSSE2(const uint8_t* source,
+                                                       size_t count,
+                                                       float factor,
+                                                       float* dest) {
+  const __m128 f = _mm_set1_ps(factor);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+    if (kBigEndian)
+      v = SwapBytes32SSE2(v);
+    __m128 samples = kFloat ? _mm_castsi128_ps(v) : _mm_cvtepi32_ps(v);
+    _mm_storeu_ps(dest + i, _mm_mul_ps(samples, f));
+  }
+  const SampleFormat format =
+      kFloat ? (kBigEndian ? SAMPLE_FORMAT_F32BE : SAMPLE_FORMAT_F32LE)
+             : (kBigEndian ? SAMPLE_FORMAT_S32BE : SAMPLE_FORMAT_S32LE);
+  ToFloatPortable<format>(source + i * 4, count - i, factor, dest + i);
+}
+
+__attribute__((target("sse2"))) void FloatToInt16SSE2(const float* source,
+                                                      size_t count,
+                                                      int16_t* dest) {
+  const __m128 min = _mm_set1_ps(-32768.0f);
+  const __m128 max = _mm_set1_ps(32767.0f);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128 lo = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i), min), max);
+    __m128 hi = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i + 4), min), max);
+    // Rounds to nearest even, like lrintf() in the default rounding mode.
+    __m128i packed =
+        _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), packed);
+  }
+  FloatToInt16Portable(source + i, count - i, dest + i);
+}
+
+__attribute__((target("sse2"))) void SplitStereoSSE2(const float* source,
+                                                     size_t frames,
+                                                     float* left,
+                                                     float* right) {
+  size_t i = 0;
+  for (; i + 4 <= frames; i += 4) {
+    __m128 a = _mm_loadu_ps(source + i * 2);
+    __m128 b = _mm_loadu_ps(source + i * 2 + 4);
+    _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  SplitStereoPortable(source + i * 2, frames - i, left + i, right + i);
+}
+
+__attribute__((target("sse2"))) void SumStereoSSE2(const float* source,
+                                                   size_t frames,
+                                                   float* dest) {
+  size_t i = 0;
+  for (; i + 4 <= frames; i += 4) {
+    __m128 a = _mm_loadu_ps(source + i * 2);
+    __m128 b = _mm_loadu_ps(source + i * 2 + 4);
+    _mm_storeu_ps(dest + i,
+                  _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                             _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+  }
+  SumStereoPortable(source + i * 2, frames - i, dest + i);
+}
+
+// SSSE3 ----------------------------------------------------------------------
+
+// Moves the three bytes of each of four 24-bit samples to the top of an int32
+// lane, so that an arithmetic shift right by 8 sign-extends them.
+template <bool kBigEndian>
+__attribute__((target("ssse3"))) inline __m128i S24ShuffleMask() {
+  return kBigEndian ? _mm_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3,
+                                    -1, 8, 7, 6, -1, 11, 10, 9)
+                    : _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5,
+                                    -1, 6, 7, 8, -1, 9, 10, 11);
+}
+
+template <bool kBigEndian>
+__attribute__((target("ssse3"))) void S24ToFloatSSSE3(const uint8_t* source,
+                                                      size_t count,
+                                                      float factor,
+                                                      float* dest) {
+  const __m128 f = _mm_set1_ps(factor);
+  const __m128i mask = S24ShuffleMask<kBigEndian>();
+  size_t i = 0;
+  // Each load reads 16 bytes for 12 bytes of samples, so stop while the
+  // extra bytes are still in bounds.
+  for (; i + 6 <= count; i += 4) {
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+    v = _mm_srai_epi32(_mm_shuffle_epi8(v, mask), 8);
+    _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(v), f));
+  }
+  ToFloatPortable<kBigEndian ? SAMPLE_FORMAT_S24BE : SAMPLE_FORMAT_S24LE>(
+      source + i * 3, count - i, factor, dest + i);
+}
+
+// AVX2 -----------------------------------------------------------------------
+
+template <bool kBigEndian>
+__attribute__((target("avx2"))) void S16ToFloatAVX2(const uint8_t* source,
+                                                    size_t count,
+                                                    float factor,
+                                                    float* dest) {
+  const __m256 f = _mm256_set1_ps(factor);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i lo =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+    __m128i hi =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2 + 16));
+    if (kBigEndian) {
+      lo = SwapBytes16SSE2(lo);
+      hi = SwapBytes16SSE2(hi);
+    }
+    __m256 lo_samples = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(lo));
+    __m256 hi_samples = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(hi));
+    _mm256_storeu_ps(dest + i, _mm256_mul_ps(lo_samples, f));
+    _mm256_storeu_ps(dest + i + 8, _mm256_mul_ps(hi_samples, f));
+  }
+  ToFloatPortable<kBigEndian ? SAMPLE_FORMAT_S16BE : SAMPLE_FORMAT_S16LE>(
+      source + i * 2, count - i, factor, dest + i);
+}
+
+template <bool kBigEndian>
+__attribute__((target("avx2"))) void S24ToFloatAVX2(const uint8_t* source,
+                                                    size_t count,
+                                                    float factor,
+                                                    float* dest) {
+  const __m256 f = _mm256_set1_ps(factor);
+  const __m128i lane_mask = S24ShuffleMask<kBigEndian>();
+  const __m256i mask =
+      _mm256_inserti128_si256(_mm256_castsi128_si256(lane_mask), lane_mask, 1);
+  size_t i = 0;
+  // The second load reads 4 bytes past the 24 bytes of samples.
+  for (; i + 10 <= count; i += 8) {
+    const uint8_t* p = source + i * 3;
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+    __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    v = _mm256_srai_epi32(_mm256_shuffle_epi8(v, mask), 8);
+    _mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), f));
+  }
+  ToFloatPortable<kBigEndian ? SAMPLE_FORMAT_S24BE : SAMPLE_FORMAT_S24LE>(
+      source + i * 3, count - i, factor, dest + i);
+}
+
+template <bool kBigEndian, bool kFloat>
+__attribute__((target("avx2"))) void Bits32ToFloatAVX2(const uint8_t* source,
+                                                       size_t count,
+                                                       float factor,
+                                                       float* dest) {
+  const __m256 f = _mm256_set1_ps(factor);
+  const __m256i swap = _mm256_setr_epi8(
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+    if (kBigEndian)
+      v = _mm256_shuffle_epi8(v, swap);
+    __m256 samples = kFloat ? _mm256_castsi256_ps(v) : _mm256_cvtepi32_ps(v);
+    _mm256_storeu_ps(dest + i, _mm256_mul_ps(samples, f));
+  }
+  const SampleFormat format =
+      kFloat ? (kBigEndian ? SAMPLE_FORMAT_F32BE : SAMPLE_FORMAT_F32LE)
+             : (kBigEndian ? SAMPLE_FORMAT_S32BE : SAMPLE_FORMAT_S32LE);
+  ToFloatPortable<format>(source + i * 4, count - i, factor, dest + i);
+}
+
+__attribute__((target("avx2"))) void FloatToInt16AVX2(const float* source,
+                                                      size_t count,
+                                                      int16_t* dest) {
+  const __m256 min = _mm256_set1_ps(-32768.0f);
+  const __m256 max = _mm256_set1_ps(32767.0f);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256 lo =
+        _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(source + i), min), max);
+    __m256 hi =
+        _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(source + i + 8), min), max);
+    // Packing works within 128-bit lanes, so put the quarters back in order.
+    __m256i packed =
+        _mm256_packs_epi32(_mm256_cvtps_epi32(lo), _mm256_cvtps_epi32(hi));
+    packed = _mm256_permute4x64_epi64(packed, 0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), packed);
+  }
+  FloatToInt16Portable(source + i, count - i, dest + i);
+}
+
+// Shuffles work within 128-bit lanes, so the even and odd samples of 8
+// frames come out with their middle quarters swapped. Returns them in order.
+__attribute__((target("avx2"))) inline void SplitStereo8AVX2(
+    const float* source,
+    __m256* left,
+    __m256* right) {
+  __m256 a = _mm256_loadu_ps(source);
+  __m256 b = _mm256_loadu_ps(source + 8);
+  *left = _mm256_castpd_ps(_mm256_permute4x64_pd(
+      _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+      0xd8));
+  *right = _mm256_castpd_ps(_mm256_permute4x64_pd(
+      _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))),
+      0xd8));
+}
+
+__attribute__((target("avx2"))) void SplitStereoAVX2(const float* source,
+                                                     size_t frames,
+                                                     float* left,
+                                                     float* right) {
+  size_t i = 0;
+  for (; i + 8 <= frames; i += 8) {
+    __m256 l, r;
+    SplitStereo8AVX2(source + i * 2, &l, &r);
+    _mm256_storeu_ps(left + i, l);
+    _mm256_storeu_ps(right + i, r);
+  }
+  SplitStereoPortable(source + i * 2, frames - i, left + i, right + i);
+}
+
+__attribute__((target("avx2"))) void SumStereoAVX2(const float* source,
+                                                   size_t frames,
+                                                   float* dest) {
+  size_t i = 0;
+  for (; i + 8 <= frames; i += 8) {
+    __m256 l, r;
+    SplitStereo8AVX2(source + i * 2, &l, &r);
+    _mm256_storeu_ps(dest + i, _mm256_add_ps(l, r));
+  }
+  SumStereoPortable(source + i * 2, frames - i, dest + i);
+}
+
+#endif  // defined(SAMPLE_CONVERSION_USE_SIMD)
+
+// Kernels --------------------------------------------------------------------
+
+const CPUKernelVariant<ToFloatFunction> kU8Variants[] = {
+    {"portable", 0, &ToFloatPortable<SAMPLE_FORMAT_U8>},
+};
+
+const CPUKernelVariant<ToFloatFunction> kS8Variants[] = {
+    {"portable", 0, &ToFloatPortable<SAMPLE_FORMAT_S8>},
+};
+
+const CPUKernelVariant<ToFloatFunction> kS16LEVariants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &S16ToFloatAVX2<false>},
+    {"sse2", CPU_FEATURE_SSE2, &S16ToFloatSSE2<false>},
+#endif
+    {"portable", 0, &ToFloatPortable<SAMPLE_FORMAT_S16LE>},
+};
+
+const CPUKernelVariant<ToFloatFunction> kS16BEVariants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &S16ToFloatAVX2<true>},
+    {"sse2", CPU_FEATURE_SSE2, &S16ToFloatSSE2<true>},
+#endif
+    {"portable", 0, &ToFloatPortable<SAMPLE_FORMAT_S16BE>},
+};
+
+const CPUKernelVariant<ToFloatFunction> kS24LEVariants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &S24ToFloatAVX2<false>},
+    {"ssse3", CPU_FEATURE_SSSE3, &S24ToFloatSSSE3<false>},
+#endif
+    {"portable", 0, &ToFloatPortable<SAMPLE_FORMAT_S24LE>},
+};
+
+const CPUKernelVariant<ToFloatFunction> kS24BEVariants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &S24ToFloatAVX2<true>},
+    {"ssse3", CPU_FEATURE_SSSE3, &S24ToFloatSSSE3<true>},
+#endif
+    {"portable", 0, &ToFloatPortable<SAMPLE_FORMAT_S24BE>},
+};
+
+const CPUKernelVariant<ToFloatFunction> kS32LEVariants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &Bits32ToFloatAVX2<false, false>},
+    {"sse2", CPU_FEATURE_SSE2, &Bits32ToFloatSSE2<false, false>},
+#endif
+    {"portable", 0, &ToFloatPortable<SAMPLE_FORMAT_S32LE>},
+};
+
+const CPUKernelVariant<ToFloatFunction> kS32BEVariants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &Bits32ToFloatAVX2<true, false>},
+    {"sse2", CPU_FEATURE_SSE2, &Bits32ToFloatSSE2<true, false>},
+#endif
+    {"portable", 0, &ToFloatPortable<SAMPLE_FORMAT_S32BE>},
+};
+
+const CPUKernelVariant<ToFloatFunction> kF32LEVariants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &Bits32ToFloatAVX2<false, true>},
+    {"sse2", CPU_FEATURE_SSE2, &Bits32ToFloatSSE2<false, true>},
+#endif
+    {"portable", 0, &ToFloatPortable<SAMPLE_FORMAT_F32LE>},
+};
+
+const CPUKernelVariant<ToFloatFunction> kF32BEVariants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &Bits32ToFloatAVX2<true, true>},
+    {"sse2", CPU_FEATURE_SSE2, &Bits32ToFloatSSE2<true, true>},
+#endif
+    {"portable", 0, &ToFloatPortable<SAMPLE_FORMAT_F32BE>},
+};
+
+// Indexed by SampleFormat.
+CPUDispatchedKernel<ToFloatFunction> g_to_float[] = {
+    CPU_DISPATCHED_KERNEL("pcm_u8_to_float", kU8Variants),
+    CPU_DISPATCHED_KERNEL("pcm_s8_to_float", kS8Variants),
+    CPU_DISPATCHED_KERNEL("pcm_s16le_to_float", kS16LEVariants),
+    CPU_DISPATCHED_KERNEL("pcm_s16be_to_float", kS16BEVariants),
+    CPU_DISPATCHED_KERNEL("pcm_s24le_to_float", kS24LEVariants),
+    CPU_DISPATCHED_KERNEL("pcm_s24be_to_float", kS24BEVariants),
+    CPU_DISPATCHED_KERNEL("pcm_s32le_to_float", kS32LEVariants),
+    CPU_DISPATCHED_KERNEL("pcm_s32be_to_float", kS32BEVariants),
+    CPU_DISPATCHED_KERNEL("pcm_f32le_to_float", kF32LEVariants),
+    CPU_DISPATCHED_KERNEL("pcm_f32be_to_float", kF32BEVariants),
+};
+static_assert(arraysize(g_to_float) == SAMPLE_FORMAT_MAX + 1,
+              "g_to_float must cover every SampleFormat");
+
+const CPUKernelVariant<FloatToInt16Function> kFloatToInt16Variants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &FloatToInt16AVX2},
+    {"sse2", CPU_FEATURE_SSE2, &FloatToInt16SSE2},
+#endif
+    {"portable", 0, &FloatToInt16Portable},
+};
+
+CPUDispatchedKernel<FloatToInt16Function> g_float_to_int16 =
+    CPU_DISPATCHED_KERNEL("pcm_float_to_s16", kFloatToInt16Variants);
+
+const CPUKernelVariant<SplitStereoFunction> kSplitStereoVariants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &SplitStereoAVX2},
+    {"sse2", CPU_FEATURE_SSE2, &SplitStereoSSE2},
+#endif
+    {"portable", 0, &SplitStereoPortable},
+};
+
+CPUDispatchedKernel<SplitStereoFunction> g_split_stereo =
+    CPU_DISPATCHED_KERNEL("pcm_split_stereo", kSplitStereoVariants);
+
+const CPUKernelVariant<SumStereoFunction> kSumStereoVariants[] = {
+#if defined(SAMPLE_CONVERSION_USE_SIMD)
+    {"avx2", CPU_FEATURE_AVX2, &SumStereoAVX2},
+    {"sse2", CPU_FEATURE_SSE2, &SumStereoSSE2},
+#endif
+    {"portable", 0, &SumStereoPortable},
+};
+
+CPUDispatchedKernel<SumStereoFunction> g_sum_stereo =
+    CPU_DISPATCHED_KERNEL("pcm_sum_stereo", kSumStereoVariants);
+
+}  // namespace
+
+size_t SampleFormatBytes(SampleFormat format) {
+  switch (format) {
+    case SAMPLE_FORMAT_U8:
+    case SAMPLE_FORMAT_S8:
+      return 1;
+    case SAMPLE_FORMAT_S16LE:
+    case SAMPLE_FORMAT_S16BE:
+      return 2;
+    case SAMPLE_FORMAT_S24LE:
+    case SAMPLE_FORMAT_S24BE:
+      return 3;
+    case SAMPLE_FORMAT_S32LE:
+    case SAMPLE_FORMAT_S32BE:
+    case SAMPLE_FORMAT_F32LE:
+    case SAMPLE_FORMAT_F32BE:
+      return 4;
+  }
+  NOTREACHED();
+  return 0;
+}
+
+void ConvertSamplesToFloat(const void* source,
+                           SampleFormat format,
+                           size_t count,
+                           float scale,
+                           float* dest) {
+  DCHECK_LE(format, SAMPLE_FORMAT_MAX);
+  g_to_float[format].Get()(static_cast<const uint8_t*>(source), count,
+                           scale / kFullScale[format], dest);
+}
+
+void ConvertSamplesToInt16(const void* source,
+                           SampleFormat format,
+                           size_t count,
+                           int16_t* dest) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(source);
+  switch (format) {
+    case SAMPLE_FORMAT_U8:
+      for (size_t i = 0; i < count; ++i)
+        dest[i] = static_cast<int16_t>((bytes[i] - 128) * 256);
+      return;
+    case SAMPLE_FORMAT_S8:
+      for (size_t i = 0; i < count; ++i)
+        dest[i] = static_cast<int16_t>(static_cast<int8_t>(bytes[i]) * 256);
+      return;
+    case SAMPLE_FORMAT_S16LE:
+#if defined(ARCH_CPU_LITTLE_ENDIAN)
+      memcpy(dest, bytes, count * sizeof(int16_t));
+#else
+      for (size_t i = 0; i < count; ++i) {
+        dest[i] = static_cast<int16_t>(
+            ByteSwapToLE16(LoadUnaligned<uint16_t>(bytes + i * 2)));
+      }
+#endif
+      return;
+    case SAMPLE_FORMAT_S16BE:
+      for (size_t i = 0; i < count; ++i) {
+        dest[i] = static_cast<int16_t>(
+            NetToHost16(LoadUnaligned<uint16_t>(bytes + i * 2)));
+      }
+      return;
+    default:
+      break;
+  }
+
+  ToFloatFunction to_float = g_to_float[format].Get();
+  FloatToInt16Function to_int16 = g_float_to_int16.Get();
+  const float factor = kInt16SampleScale / kFullScale[format];
+  const size_t sample_bytes = SampleFormatBytes(format);
+  float buffer[kChunkSamples];
+  for (size_t i = 0; i < count; i += kChunkSamples) {
+    size_t chunk = std::min(kChunkSamples, count - i);
+    to_float(bytes + i * sample_bytes, chunk, factor, buffer);
+    to_int16(buffer, chunk, dest + i);
+  }
+}
+
+void DeinterleaveSamplesToFloat(const void* source,
+                                SampleFormat format,
+                                int channels,
+                                size_t frames,
+                                float scale,
+                                float* const* dest) {
+  DCHECK_GT(channels, 0);
+  DCHECK_LE(channels, kMaxSampleChannels);
+  if (channels == 1) {
+    ConvertSamplesToFloat(source, format, frames, scale, dest[0]);
+    return;
+  }
+
+  const uint8_t* bytes = static_cast<const uint8_t*>(source);
+  ToFloatFunction to_float = g_to_float[format].Get();
+  const float factor = scale / kFullScale[format];
+  const size_t frame_bytes = SampleFormatBytes(format) * channels;
+  const size_t chunk_frames = kChunkSamples / channels;
+  float buffer[kChunkSamples];
+  // Stereo, the common case, has its own kernel.
+  SplitStereoFunction split_stereo =
+      channels == 2 ? g_split_stereo.Get() : nullptr;
+  for (size_t frame = 0; frame < frames; frame += chunk_frames) {
+    size_t chunk = std::min(chunk_frames, frames - frame);
+    to_float(bytes + frame * frame_bytes, chunk * channels, factor, buffer);
+    if (split_stereo) {
+      split_stereo(buffer, chunk, dest[0] + frame, dest[1] + frame);
+      continue;
+    }
+    for (int c = 0; c < channels; ++c) {
+      float* out = dest[c] + frame;
+      for (size_t i = 0; i < chunk; ++i)
+        out[i] = buffer[i * channels + c];
+    }
+  }
+}
+
+void DownmixSamplesToFloat(const void* source,
+                           SampleFormat format,
+                           int channels,
+                           size_t frames,
+                           float scale,
+                           float* dest) {
+  DCHECK_GT(channels, 0);
+  DCHECK_LE(channels, kMaxSampleChannels);
+  if (channels == 1) {
+    ConvertSamplesToFloat(source, format, frames, scale, dest);
+    return;
+  }
+
+  const uint8_t* bytes = static_cast<const uint8_t*>(source);
+  ToFloatFunction to_float = g_to_float[format].Get();
+  // Fold the averaging into the conversion.
+  const float factor = scale / kFullScale[format] / channels;
+  const size_t frame_bytes = SampleFormatBytes(format) * channels;
+  const size_t chunk_frames = kChunkSamples / channels;
+  float buffer[kChunkSamples];
+  SumStereoFunction sum_stereo = channels == 2 ? g_sum_stereo.Get() : nullptr;
+  for (size_t frame = 0; frame < frames; frame += chunk_frames) {
+    size_t chunk = std::min(chunk_frames, frames - frame);
+    to_float(bytes + frame * frame_bytes, chunk * channels, factor, buffer);
+    if (sum_stereo) {
+      sum_stereo(buffer, chunk, dest + frame);
+      continue;
+    }
+    for (size_t i = 0; i < chunk; ++i) {
+      const float* samples = buffer + i * channels;
+      float sum = samples[0];
+      for (int c = 1; c < channels; ++c)
+        sum += samples[c];
+      dest[frame + i] = sum;
+    }
+  }
+}
+
+void ResetSampleConversionKernelsForTesting() {
+  for (size_t i = 0; i < arraysize(g_to_float); ++i)
+    g_to_float[i].ResetForTesting();
+  g_float_to_int16.ResetForTesting();
+  g_split_stereo.ResetForTesting();
+  g_sum_stereo.ResetForTesting();
+}
+
+}  // namespace base
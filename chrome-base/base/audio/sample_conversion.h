@@ -0,0 +1,92 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Converts PCM samples between the formats found in audio files and streams
+// and the float or int16 samples that audio processing works on.
+//
+// The common conversions have SSE2 and AVX2 kernels that CPUDispatchedKernel
+// picks at run time (see base/cpu_dispatch.h), and the others a portable
+// one. Every kernel produces exactly the same output as the portable one.
+
+#ifndef BASE_AUDIO_SAMPLE_CONVERSION_H_
+#define BASE_AUDIO_SAMPLE_CONVERSION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/base_export.h"
+
+namespace base {
+
+enum SampleFormat {
+  // Unsigned 8-bit, with silence at 128, as in 8-bit WAV files.
+  SAMPLE_FORMAT_U8,
+  SAMPLE_FORMAT_S8,
+  SAMPLE_FORMAT_S16LE,
+  SAMPLE_FORMAT_S16BE,
+  // Packed into three bytes.
+  SAMPLE_FORMAT_S24LE,
+  SAMPLE_FORMAT_S24BE,
+  SAMPLE_FORMAT_S32LE,
+  SAMPLE_FORMAT_S32BE,
+  SAMPLE_FORMAT_F32LE,
+  SAMPLE_FORMAT_F32BE,
+  SAMPLE_FORMAT_MAX = SAMPLE_FORMAT_F32BE,
+};
+
+// The most channels that the de-interleaving conversions accept.
+const int kMaxSampleChannels = 32;
+
+// Pass as |scale| to get floats in the range of int16 samples, which is what
+// most speech models expect. A |scale| of 1 gives the range [-1, 1).
+const float kInt16SampleScale = 32768.0f;
+
+// Returns the number of bytes of one sample in |format|.
+BASE_EXPORT size_t SampleFormatBytes(SampleFormat format);
+
+// Converts |count| samples in |format| at |source| to floats in |dest|.
+// Integer samples become their fraction of full scale times |scale|, e.g.
+// int16 samples become value / 32768 * |scale|. Float samples are multiplied
+// by |scale|. |source| needs no alignment.
+BASE_EXPORT void ConvertSamplesToFloat(const void* source,
+                                       SampleFormat format,
+                                       size_t count,
+                                       float scale,
+                                       float* dest);
+
+// Converts |count| samples in |format| at |source| to int16 samples. 8 and
+// 16-bit samples convert exactly; wider and float samples are rounded to
+// the nearest int16 and saturated. NaNs give unspecified values.
+BASE_EXPORT void ConvertSamplesToInt16(const void* source,
+                                       SampleFormat format,
+                                       size_t count,
+                                       int16_t* dest);
+
+// Converts |frames| frames of |channels| interleaved samples like
+// ConvertSamplesToFloat(), and writes channel c to |dest|[c], which must
+// have room for |frames| floats.
+BASE_EXPORT void DeinterleaveSamplesToFloat(const void* source,
+                                            SampleFormat format,
+                                            int channels,
+                                            size_t frames,
+                                            float scale,
+                                            float* const* dest);
+
+// Converts |frames| frames of |channels| interleaved samples like
+// ConvertSamplesToFloat(), and writes the average of the channels of each
+// frame to |dest|.
+BASE_EXPORT void DownmixSamplesToFloat(const void* source,
+                                       SampleFormat format,
+                                       int channels,
+                                       size_t frames,
+                                       float scale,
+                                       float* dest);
+
+// Makes the conversions pick their kernels again, e.g. after
+// SetCPUFeatureMaskForTesting().
+BASE_EXPORT void ResetSampleConversionKernelsForTesting();
+
+}  // namespace base
+
+#endif  // BASE_AUDIO_SAMPLE_CONVERSION_H_
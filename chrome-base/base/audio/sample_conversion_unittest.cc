@@ -0,0 +1,239 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/audio/sample_conversion.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/cpu_dispatch.h"
+#include "base/macros.h"
+#include "base/rand_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Feature masks that make the conversions pick each of their kernels.
+const CPUFeatures kFeatureMasks[] = {
+    0,
+    CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3,
+    ~0u,
+};
+
+class SampleConversionTest : public testing::Test {
+ protected:
+  void TearDown() override { UseFeatures(~0u); }
+
+  void UseFeatures(CPUFeatures mask) {
+    SetCPUFeatureMaskForTesting(mask);
+    ResetSampleConversionKernelsForTesting();
+  }
+};
+
+// Returns |count| random samples in |format|, with float samples in [-2, 2]
+// so that some saturate when converted to int16.
+std::vector<uint8_t> RandomSamples(SampleFormat format, size_t count) {
+  std::vector<uint8_t> bytes(count * SampleFormatBytes(format));
+  if (format == SAMPLE_FORMAT_F32LE || format == SAMPLE_FORMAT_F32BE) {
+    for (size_t i = 0; i < count; ++i) {
+      float value = static_cast<float>(RandDouble() * 4 - 2);
+      uint8_t* p = &bytes[i * 4];
+      memcpy(p, &value, 4);
+      if (format == SAMPLE_FORMAT_F32BE) {
+        std::swap(p[0], p[3]);
+        std::swap(p[1], p[2]);
+      }
+    }
+  } else {
+    RandBytes(bytes.data(), bytes.size());
+  }
+  return bytes;
+}
+
+}  // namespace
+
+TEST_F(SampleConversionTest, KnownValues) {
+  const uint8_t u8[] = {0, 128, 192};
+  const uint8_t s16le[] = {0x00, 0x80, 0xff, 0x7f, 0x00, 0x40};
+  const uint8_t s16be[] = {0x80, 0x00, 0x7f, 0xff, 0x40, 0x00};
+  const uint8_t s24le[] = {0x00, 0x00, 0x80, 0x01, 0x00, 0x00,
+                           0x00, 0x00, 0x40};
+  const uint8_t s24be[] = {0x80, 0x00, 0x00, 0x00, 0x00, 0x01,
+                           0x40, 0x00, 0x00};
+  const uint8_t s32be[] = {0x80, 0, 0, 0, 0, 0, 0, 0, 0x40, 0, 0, 0};
+  const float f32[] = {-1.0f, 0.25f, 0.5f};
+  float out[3];
+
+  ConvertSamplesToFloat(u8, SAMPLE_FORMAT_U8, 3, 1.0f, out);
+  EXPECT_EQ(-1.0f, out[0]);
+  EXPECT_EQ(0.0f, out[1]);
+  EXPECT_EQ(0.5f, out[2]);
+
+  ConvertSamplesToFloat(s16le, SAMPLE_FORMAT_S16LE, 3, kInt16SampleScale, out);
+  EXPECT_EQ(-32768.0f, out[0]);
+  EXPECT_EQ(32767.0f, out[1]);
+  EXPECT_EQ(16384.0f, out[2]);
+  ConvertSamplesToFloat(s16be, SAMPLE_FORMAT_S16BE, 3, kInt16SampleScale, out);
+  EXPECT_EQ(-32768.0f, out[0]);
+  EXPECT_EQ(32767.0f, out[1]);
+  EXPECT_EQ(16384.0f, out[2]);
+
+  ConvertSamplesToFloat(s24le, SAMPLE_FORMAT_S24LE, 3, 1.0f, out);
+  EXPECT_EQ(-1.0f, out[0]);
+  EXPECT_EQ(1.0f / 8388608, out[1]);
+  EXPECT_EQ(0.5f, out[2]);
+  ConvertSamplesToFloat(s24be, SAMPLE_FORMAT_S24BE, 3, 1.0f, out);
+  EXPECT_EQ(-1.0f, out[0]);
+  EXPECT_EQ(1.0f / 8388608, out[1]);
+  EXPECT_EQ(0.5f, out[2]);
+
+  ConvertSamplesToFloat(s32be, SAMPLE_FORMAT_S32BE, 3, 2.0f, out);
+  EXPECT_EQ(-2.0f, out[0]);
+  EXPECT_EQ(0.0f, out[1]);
+  EXPECT_EQ(1.0f, out[2]);
+
+  ConvertSamplesToFloat(f32, SAMPLE_FORMAT_F32LE, 3, 4.0f, out);
+  EXPECT_EQ(-4.0f, out[0]);
+  EXPECT_EQ(1.0f, out[1]);
+  EXPECT_EQ(2.0f, out[2]);
+}
+
+TEST_F(SampleConversionTest, Int16RoundsAndSaturates) {
+  const float f32[] = {-2.0f, 2.0f, 0.5f / 32768, 1.5f / 32768, -0.5f};
+  int16_t out[5];
+  ConvertSamplesToInt16(f32, SAMPLE_FORMAT_F32LE, 5, out);
+  EXPECT_EQ(-32768, out[0]);
+  EXPECT_EQ(32767, out[1]);
+  EXPECT_EQ(0, out[2]);
+  EXPECT_EQ(2, out[3]);
+  EXPECT_EQ(-16384, out[4]);
+
+  const uint8_t s24le[] = {0x80, 0x00, 0x00, 0x80, 0x01, 0x00,
+                           0xff, 0xff, 0x7f};
+  ConvertSamplesToInt16(s24le, SAMPLE_FORMAT_S24LE, 3, out);
+  EXPECT_EQ(0, out[0]);  // 0.5 rounds to even.
+  EXPECT_EQ(2, out[1]);  // 1.5 rounds to even.
+  EXPECT_EQ(32767, out[2]);
+
+  const uint8_t u8[] = {0, 255};
+  ConvertSamplesToInt16(u8, SAMPLE_FORMAT_U8, 2, out);
+  EXPECT_EQ(-32768, out[0]);
+  EXPECT_EQ(32512, out[1]);
+}
+
+// Every kernel must give exactly the output of the portable one, for every
+// format and for counts that leave partial vectors.
+TEST_F(SampleConversionTest, KernelsMatchPortable) {
+  const size_t kCounts[] = {0, 1, 7, 9, 15, 17, 33, 1000, 2500};
+  for (int f = 0; f <= SAMPLE_FORMAT_MAX; ++f) {
+    SampleFormat format = static_cast<SampleFormat>(f);
+    for (size_t c = 0; c < arraysize(kCounts); ++c) {
+      const size_t count = kCounts[c];
+      std::vector<uint8_t> source = RandomSamples(format, count);
+      std::vector<float> expected_float(count + 1);
+      std::vector<int16_t> expected_int16(count + 1);
+      for (size_t m = 0; m < arraysize(kFeatureMasks); ++m) {
+        UseFeatures(kFeatureMasks[m]);
+        // The extra element catches writes past the end.
+        std::vector<float> floats(count + 1, 123.0f);
+        std::vector<int16_t> int16s(count + 1, 123);
+        ConvertSamplesToFloat(source.data(), format, count, 0.75f,
+                              floats.data());
+        ConvertSamplesToInt16(source.data(), format, count, int16s.data());
+        EXPECT_EQ(123.0f, floats[count]);
+        EXPECT_EQ(123, int16s[count]);
+        if (m == 0) {
+          expected_float = floats;
+          expected_int16 = int16s;
+          continue;
+        }
+        EXPECT_EQ(0, memcmp(expected_float.data(), floats.data(),
+                            count * sizeof(float)))
+            << "format " << f << ", count " << count << ", mask " << m;
+        EXPECT_TRUE(expected_int16 == int16s)
+            << "format " << f << ", count " << count << ", mask " << m;
+      }
+    }
+  }
+}
+
+TEST_F(SampleConversionTest, DeinterleaveAndDownmix) {
+  // Enough frames for several chunks.
+  const size_t kFrames = 1500;
+  const int kChannels = 3;
+  std::vector<int16_t> source(kFrames * kChannels);
+  for (size_t i = 0; i < source.size(); ++i)
+    source[i] = static_cast<int16_t>(i % 1000 - 500);
+
+  std::vector<std::vector<float>> channels(kChannels,
+                                           std::vector<float>(kFrames));
+  float* dest[kChannels];
+  for (int c = 0; c < kChannels; ++c)
+    dest[c] = channels[c].data();
+  DeinterleaveSamplesToFloat(source.data(), SAMPLE_FORMAT_S16LE, kChannels,
+                             kFrames, kInt16SampleScale, dest);
+
+  std::vector<float> mixed(kFrames);
+  DownmixSamplesToFloat(source.data(), SAMPLE_FORMAT_S16LE, kChannels,
+                        kFrames, kInt16SampleScale, mixed.data());
+
+  for (size_t i = 0; i < kFrames; ++i) {
+    float sum = 0;
+    for (int c = 0; c < kChannels; ++c) {
+      ASSERT_EQ(source[i * kChannels + c], channels[c][i]);
+      sum += source[i * kChannels + c];
+    }
+    ASSERT_NEAR(sum / kChannels, mixed[i], 1e-3f);
+  }
+
+  // One channel is a plain conversion.
+  DownmixSamplesToFloat(source.data(), SAMPLE_FORMAT_S16LE, 1, 4, 1.0f,
+                        mixed.data());
+  EXPECT_EQ(source[3] / 32768.0f, mixed[3]);
+}
+
+// Stereo has its own kernels, which must match the generic path exactly.
+TEST_F(SampleConversionTest, StereoKernelsMatchPortable) {
+  const size_t kFrames[] = {0, 1, 3, 5, 9, 17, 511, 512, 513, 2000};
+  for (size_t f = 0; f < arraysize(kFrames); ++f) {
+    const size_t frames = kFrames[f];
+    std::vector<uint8_t> source =
+        RandomSamples(SAMPLE_FORMAT_S16LE, frames * 2);
+    std::vector<float> interleaved(frames * 2);
+    ConvertSamplesToFloat(source.data(), SAMPLE_FORMAT_S16LE, frames * 2,
+                          kInt16SampleScale, interleaved.data());
+    for (size_t m = 0; m < arraysize(kFeatureMasks); ++m) {
+      UseFeatures(kFeatureMasks[m]);
+      // The extra element catches writes past the end.
+      std::vector<float> left(frames + 1, 123.0f);
+      std::vector<float> right(frames + 1, 123.0f);
+      std::vector<float> mixed(frames + 1, 123.0f);
+      float* dest[] = {left.data(), right.data()};
+      DeinterleaveSamplesToFloat(source.data(), SAMPLE_FORMAT_S16LE, 2, frames,
+                                 kInt16SampleScale, dest);
+      DownmixSamplesToFloat(source.data(), SAMPLE_FORMAT_S16LE, 2, frames,
+                            kInt16SampleScale, mixed.data());
+      EXPECT_EQ(123.0f, left[frames]);
+      EXPECT_EQ(123.0f, right[frames]);
+      EXPECT_EQ(123.0f, mixed[frames]);
+      for (size_t i = 0; i < frames; ++i) {
+        ASSERT_EQ(interleaved[i * 2], left[i]) << "mask " << m << ", " << i;
+        ASSERT_EQ(interleaved[i * 2 + 1], right[i])
+            << "mask " << m << ", " << i;
+        // The averaging is folded into the conversion, so the halves add
+        // exactly.
+        ASSERT_EQ(interleaved[i * 2] / 2 + interleaved[i * 2 + 1] / 2,
+                  mixed[i])
+            << "mask " << m << ", " << i;
+      }
+    }
+  }
+}
+
+}  // namespace base
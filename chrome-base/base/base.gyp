@@ -439,6 +439,8 @@
         'android/sys_utils_unittest.cc',
         'at_exit_unittest.cc',
         'atomicops_unittest.cc',
+        'audio/polyphase_resampler_unittest.cc',
+        'audio/sample_conversion_unittest.cc',
         'barrier_closure_unittest.cc',
         'base64_unittest.cc',
         'base64url_unittest.cc',
@@ -455,12 +457,14 @@
         'cancelable_callback_unittest.cc',
         'command_line_unittest.cc',
         'containers/adapters_unittest.cc',
+        'containers/concurrent_mru_cache_unittest.cc',
         'containers/hash_tables_unittest.cc',
         'containers/linked_list_unittest.cc',
         'containers/mru_cache_unittest.cc',
         'containers/scoped_ptr_hash_map_unittest.cc',
         'containers/small_map_unittest.cc',
         'containers/stack_container_unittest.cc',
+        'cpu_dispatch_unittest.cc',
         'cpu_unittest.cc',
         'debug/crash_logging_unittest.cc',
         'debug/debugger_unittest.cc',
@@ -491,6 +495,7 @@
         'i18n/char_iterator_unittest.cc',
         'i18n/file_util_icu_unittest.cc',
         'i18n/icu_string_conversions_unittest.cc',
+        'i18n/icu_util_unittest.cc',
         'i18n/message_formatter_unittest.cc',
         'i18n/number_formatting_unittest.cc',
         'i18n/rtl_unittest.cc',
@@ -502,8 +507,11 @@
         'ios/crb_protocol_observers_unittest.mm',
         'ios/device_util_unittest.mm',
         'ios/weak_nsobject_unittest.mm',
+        'json/json_arena_document_unittest.cc',
         'json/json_parser_unittest.cc',
         'json/json_reader_unittest.cc',
+        'json/json_sax_reader_unittest.cc',
+        'json/json_stream_writer_unittest.cc',
         'json/json_value_converter_unittest.cc',
         'json/json_value_serializer_unittest.cc',
         'json/json_writer_unittest.cc',
@@ -522,21 +530,27 @@
         'mac/scoped_sending_event_unittest.mm',
         'md5_unittest.cc',
         'memory/aligned_memory_unittest.cc',
+        'memory/arena_unittest.cc',
+        'memory/discardable_cache_unittest.cc',
         'memory/discardable_shared_memory_unittest.cc',
         'memory/linked_ptr_unittest.cc',
+        'memory/madv_free_discardable_memory_posix_unittest.cc',
         'memory/memory_pressure_listener_unittest.cc',
         'memory/memory_pressure_monitor_chromeos_unittest.cc',
+        'memory/memory_pressure_monitor_linux_unittest.cc',
         'memory/memory_pressure_monitor_mac_unittest.cc',
         'memory/memory_pressure_monitor_win_unittest.cc',
         'memory/ptr_util_unittest.cc',
         'memory/ref_counted_memory_unittest.cc',
         'memory/ref_counted_unittest.cc',
+        'memory/scoped_arena_unittest.cc',
         'memory/scoped_ptr_unittest.cc',
         'memory/scoped_ptr_unittest.nc',
         'memory/scoped_vector_unittest.cc',
         'memory/shared_memory_unittest.cc',
         'memory/shared_memory_mac_unittest.cc',
         'memory/singleton_unittest.cc',
+        'memory/small_object_pool_unittest.cc',
         'memory/weak_ptr_unittest.cc',
         'memory/weak_ptr_unittest.nc',
         'message_loop/message_loop_task_runner_unittest.cc',
@@ -552,9 +566,11 @@
         'metrics/histogram_snapshot_manager_unittest.cc',
         'metrics/histogram_unittest.cc',
         'metrics/metrics_hashes_unittest.cc',
+        'metrics/persistent_histogram_allocator_unittest.cc',
         'metrics/persistent_memory_allocator_unittest.cc',
         'metrics/sample_map_unittest.cc',
         'metrics/sample_vector_unittest.cc',
+        'metrics/sharded_sample_vector_unittest.cc',
         'metrics/sparse_histogram_unittest.cc',
         'metrics/statistics_recorder_unittest.cc',
         'native_library_unittest.cc',
@@ -577,6 +593,7 @@
         'prefs/pref_value_map_unittest.cc',
         'prefs/pref_value_store_unittest.cc',
         'prefs/scoped_user_pref_update_unittest.cc',
+        'process/concurrency_controller_unittest.cc',
         'process/memory_unittest.cc',
         'process/memory_unittest_mac.h',
         'process/memory_unittest_mac.mm',
@@ -838,7 +855,9 @@
         '../testing/gtest.gyp:gtest',
       ],
       'sources': [
+        'hash_perftest.cc',
         'message_loop/message_pump_perftest.cc',
+        'process/process_startup_perftest.cc',
         'test/run_all_unittests.cc',
         'threading/thread_perftest.cc',
         '../testing/perf/perf_test.cc'
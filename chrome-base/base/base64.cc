@@ -36,4 +36,18 @@ bool Base64Decode(const StringPiece& input, std::string* output) {
   return true;
 }
 
+size_t Base64DecodedMaxSize(size_t input_size) {
+  return modp_b64_decode_len(input_size);
+}
+
+bool Base64DecodeToBuffer(const StringPiece& input,
+                          char* output,
+                          size_t* output_size) {
+  size_t size = modp_b64_decode(output, input.data(), input.size());
+  if (size == MODP_B64_ERROR)
+    return false;
+  *output_size = size;
+  return true;
+}
+
 }  // namespace base
@@ -5,6 +5,8 @@
 #ifndef BASE_BASE64_H_
 #define BASE_BASE64_H_
 
+#include <stddef.h>
+
 #include <string>
 
 #include "base/base_export.h"
@@ -20,6 +22,17 @@ BASE_EXPORT void Base64Encode(const StringPiece& input, std::string* output);
 // be done in-place.
 BASE_EXPORT bool Base64Decode(const StringPiece& input, std::string* output);
 
+// Returns the size of the buffer Base64DecodeToBuffer() needs for an input of
+// |input_size| bytes.
+BASE_EXPORT size_t Base64DecodedMaxSize(size_t input_size);
+
+// Decodes |input| into |output|, which must have room for
+// Base64DecodedMaxSize(input.size()) bytes, for callers that manage their own
+// memory. Sets |output_size| and returns true if successful.
+BASE_EXPORT bool Base64DecodeToBuffer(const StringPiece& input,
+                                      char* output,
+                                      size_t* output_size);
+
 }  // namespace base
 
 #endif  // BASE_BASE64_H_
@@ -4,6 +4,10 @@
 
 #include "base/base64.h"
 
+#include <stddef.h>
+
+#include <vector>
+
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace base {
@@ -37,4 +41,19 @@ TEST(Base64Test, InPlace) {
   EXPECT_EQ(text, kText);
 }
 
+TEST(Base64Test, DecodeToBuffer) {
+  const std::string kText = "hello world!";
+  std::string encoded;
+  Base64Encode(kText, &encoded);
+
+  std::vector<char> buffer(Base64DecodedMaxSize(encoded.size()));
+  size_t size = 0;
+  EXPECT_TRUE(Base64DecodeToBuffer(encoded, buffer.data(), &size));
+  EXPECT_EQ(kText, std::string(buffer.data(), size));
+
+  size = 42;
+  EXPECT_FALSE(Base64DecodeToBuffer("aGVsbG8*", buffer.data(), &size));
+  EXPECT_EQ(42u, size);
+}
+
 }  // namespace base
@@ -17,6 +17,7 @@
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/small_object_pool.h"
 #include "base/template_util.h"
 
 namespace base {
@@ -35,6 +36,18 @@ class CallbackBase;
 // of bloat. Its only task is to call the destructor which can be done with a
 // function pointer.
 class BindStateBase {
+ public:
+  // BindStates are created by every Bind() and usually destroyed on another
+  // thread after the task runs, so they come from a SmallObjectPool rather
+  // than malloc. BindState::Destroy() deletes the derived type, which passes
+  // its size here.
+  static void* operator new(size_t size) {
+    return SmallObjectPool::Allocate(size);
+  }
+  static void operator delete(void* ptr, size_t size) {
+    SmallObjectPool::Free(ptr, size);
+  }
+
  protected:
   explicit BindStateBase(void (*destructor)(BindStateBase*))
       : ref_count_(0), destructor_(destructor) {}
@@ -0,0 +1,283 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file contains a thread-safe counterpart of MRUCache for caches that
+// many threads look up at once. Instead of one lock around one list, the keys
+// are spread over independently locked shards, and each shard evicts with the
+// CLOCK algorithm, an approximation of least-recently-used: a lookup only
+// sets a reference bit on the entry, and eviction sweeps a hand over the
+// entries, clearing the bits it finds set and evicting the first entry whose
+// bit is clear. A hit therefore never reorders a list, and holds its shard's
+// lock only for the hash lookup and the copy of the payload.
+//
+// The capacity is a number of bytes that the caller charges to each entry,
+// split evenly across the shards. Payloads are copied in and out, so a
+// large payload is best held by a scoped_refptr.
+//
+// Example:
+//
+//   ConcurrentMRUCache<uint64_t, std::string> results(4 << 20);
+//   results.Put(key, json, json.size());
+//   ...
+//   std::string cached;
+//   if (results.Get(key, &cached))
+//     return cached;
+
+#ifndef BASE_CONTAINERS_CONCURRENT_MRU_CACHE_H_
+#define BASE_CONTAINERS_CONCURRENT_MRU_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/containers/hash_tables.h"
+#include "base/hash.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+template <class KeyType,
+          class PayloadType,
+          class HashType = BASE_HASH_NAMESPACE::hash<KeyType>>
+class ConcurrentMRUCache {
+ public:
+  enum { kDefaultShards = 16 };
+
+  struct Stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+  };
+
+  // |num_shards| is rounded up to a power of two. Each shard holds at most
+  // |max_bytes| / |num_shards| bytes, so a single entry can't be larger than
+  // that.
+  explicit ConcurrentMRUCache(size_t max_bytes,
+                              size_t num_shards = kDefaultShards)
+      : shard_mask_(RoundUpToPowerOfTwo(num_shards) - 1),
+        shards_(new Shard[shard_mask_ + 1]) {
+    for (size_t i = 0; i <= shard_mask_; ++i)
+      shards_[i].max_bytes = max_bytes / (shard_mask_ + 1);
+  }
+
+  ~ConcurrentMRUCache() {}
+
+  // Inserts |payload| for |key|, charging it |bytes|, and replaces any
+  // existing payload for |key|. Evicts entries from the key's shard until
+  // the new entry fits. Returns false without inserting if |bytes| exceeds
+  // the capacity of a shard; an older payload for |key| is removed anyway so
+  // that a later Get can't return a stale value.
+  bool Put(const KeyType& key, const PayloadType& payload, size_t bytes) {
+    Shard& shard = ShardFor(key);
+    AutoLock lock(shard.lock);
+    typename KeyIndex::iterator it = shard.index.find(key);
+    if (it != shard.index.end()) {
+      shard.Remove(it->second);
+      shard.index.erase(it);
+    }
+    if (bytes > shard.max_bytes)
+      return false;
+    while (shard.bytes + bytes > shard.max_bytes)
+      shard.EvictOne();
+
+    size_t slot;
+    if (shard.free_slots.empty()) {
+      slot = shard.slots.size();
+      shard.slots.push_back(Entry());
+    } else {
+      slot = shard.free_slots.back();
+      shard.free_slots.pop_back();
+    }
+    Entry& entry = shard.slots[slot];
+    entry.key = key;
+    entry.payload = payload;
+    entry.bytes = bytes;
+    // A new entry has to be looked up once to survive the next sweep.
+    entry.referenced = false;
+    entry.in_use = true;
+    shard.bytes += bytes;
+    shard.index[key] = slot;
+    return true;
+  }
+
+  // If |key| is present, copies its payload to |payload|, marks it recently
+  // used and returns true.
+  bool Get(const KeyType& key, PayloadType* payload) {
+    Shard& shard = ShardFor(key);
+    AutoLock lock(shard.lock);
+    typename KeyIndex::const_iterator it = shard.index.find(key);
+    if (it == shard.index.end()) {
+      ++shard.stats.misses;
+      return false;
+    }
+    ++shard.stats.hits;
+    Entry& entry = shard.slots[it->second];
+    entry.referenced = true;
+    *payload = entry.payload;
+    return true;
+  }
+
+  // Same as Get, but doesn't mark the entry as used or count in the stats.
+  bool Peek(const KeyType& key, PayloadType* payload) const {
+    const Shard& shard = ShardFor(key);
+    AutoLock lock(shard.lock);
+    typename KeyIndex::const_iterator it = shard.index.find(key);
+    if (it == shard.index.end())
+      return false;
+    *payload = shard.slots[it->second].payload;
+    return true;
+  }
+
+  // Returns true if |key| was present.
+  bool Erase(const KeyType& key) {
+    Shard& shard = ShardFor(key);
+    AutoLock lock(shard.lock);
+    typename KeyIndex::iterator it = shard.index.find(key);
+    if (it == shard.index.end())
+      return false;
+    shard.Remove(it->second);
+    shard.index.erase(it);
+    return true;
+  }
+
+  void Clear() {
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+      Shard& shard = shards_[i];
+      AutoLock lock(shard.lock);
+      shard.index.clear();
+      shard.slots.clear();
+      shard.free_slots.clear();
+      shard.hand = 0;
+      shard.bytes = 0;
+    }
+  }
+
+  // The totals over all shards. Other threads may change them while they are
+  // being added up, so they are exact only when the cache is not in use.
+  size_t size() const {
+    size_t size = 0;
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+      AutoLock lock(shards_[i].lock);
+      size += shards_[i].index.size();
+    }
+    return size;
+  }
+
+  size_t bytes() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+      AutoLock lock(shards_[i].lock);
+      bytes += shards_[i].bytes;
+    }
+    return bytes;
+  }
+
+  void GetStats(Stats* stats) const {
+    stats->hits = 0;
+    stats->misses = 0;
+    stats->evictions = 0;
+    for (size_t i = 0; i <= shard_mask_; ++i) {
+      AutoLock lock(shards_[i].lock);
+      stats->hits += shards_[i].stats.hits;
+      stats->misses += shards_[i].stats.misses;
+      stats->evictions += shards_[i].stats.evictions;
+    }
+  }
+
+  size_t num_shards() const { return shard_mask_ + 1; }
+
+ private:
+  typedef hash_map<KeyType, size_t, HashType> KeyIndex;
+
+  struct Entry {
+    Entry() : bytes(0), referenced(false), in_use(false) {}
+
+    KeyType key;
+    PayloadType payload;
+    size_t bytes;
+    bool referenced;
+    bool in_use;
+  };
+
+  struct Shard {
+    Shard() : max_bytes(0), bytes(0), hand(0) {
+      stats.hits = 0;
+      stats.misses = 0;
+      stats.evictions = 0;
+    }
+
+    // Frees |slot| without touching |index|.
+    void Remove(size_t slot) {
+      Entry& entry = slots[slot];
+      bytes -= entry.bytes;
+      entry = Entry();
+      free_slots.push_back(slot);
+    }
+
+    // Advances the clock hand to the first unreferenced entry, clearing the
+    // reference bits it passes, and evicts that entry. Terminates within two
+    // sweeps since the first one clears every bit. Must only be called when
+    // |bytes| is not zero.
+    void EvictOne() {
+      DCHECK_GT(bytes, 0u);
+      for (;;) {
+        if (hand >= slots.size())
+          hand = 0;
+        Entry& entry = slots[hand++];
+        if (!entry.in_use)
+          continue;
+        if (entry.referenced) {
+          entry.referenced = false;
+          continue;
+        }
+        index.erase(entry.key);
+        Remove(hand - 1);
+        ++stats.evictions;
+        return;
+      }
+    }
+
+    mutable Lock lock;
+    KeyIndex index;
+    std::vector<Entry> slots;
+    std::vector<size_t> free_slots;
+    size_t max_bytes;
+    size_t bytes;
+    size_t hand;
+    Stats stats;
+
+    // Keeps shards that are used by different threads on different cache
+    // lines.
+    char padding[64];
+  };
+
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t power = 1;
+    while (power < n)
+      power <<= 1;
+    return power;
+  }
+
+  // Mixes the hash first, since the standard hash of an integer is the
+  // integer itself and its low bits may not vary.
+  Shard& ShardFor(const KeyType& key) {
+    return shards_[HashInts64(HashType()(key), 0) & shard_mask_];
+  }
+  const Shard& ShardFor(const KeyType& key) const {
+    return shards_[HashInts64(HashType()(key), 0) & shard_mask_];
+  }
+
+  const size_t shard_mask_;
+  scoped_ptr<Shard[]> shards_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentMRUCache);
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_CONCURRENT_MRU_CACHE_H_
@@ -0,0 +1,174 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/concurrent_mru_cache.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "base/macros.h"
+#include "base/memory/scoped_vector.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+typedef ConcurrentMRUCache<int, std::string> StringCache;
+
+class CacheUser : public DelegateSimpleThread::Delegate {
+ public:
+  CacheUser(ConcurrentMRUCache<int, int>* cache, int first_key)
+      : cache_(cache), first_key_(first_key), mismatches_(0) {}
+
+  void Run() override {
+    for (int i = 0; i < 10000; ++i) {
+      int key = first_key_ + i % 200;
+      int value;
+      if (cache_->Get(key, &value)) {
+        if (value != key * 3)
+          ++mismatches_;
+      } else {
+        cache_->Put(key, key * 3, 1);
+      }
+      if (i % 7 == 0)
+        cache_->Erase(key);
+    }
+  }
+
+  int mismatches() const { return mismatches_; }
+
+ private:
+  ConcurrentMRUCache<int, int>* cache_;
+  const int first_key_;
+  int mismatches_;
+
+  DISALLOW_COPY_AND_ASSIGN(CacheUser);
+};
+
+}  // namespace
+
+TEST(ConcurrentMRUCacheTest, Basic) {
+  StringCache cache(100, 1);
+  std::string value;
+  EXPECT_FALSE(cache.Get(1, &value));
+  EXPECT_FALSE(cache.Peek(1, &value));
+
+  EXPECT_TRUE(cache.Put(1, "one", 10));
+  EXPECT_TRUE(cache.Put(2, "two", 20));
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(30u, cache.bytes());
+  EXPECT_TRUE(cache.Get(1, &value));
+  EXPECT_EQ("one", value);
+  EXPECT_TRUE(cache.Peek(2, &value));
+  EXPECT_EQ("two", value);
+
+  // Replacing a payload replaces its charge.
+  EXPECT_TRUE(cache.Put(1, "uno", 5));
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(25u, cache.bytes());
+  EXPECT_TRUE(cache.Get(1, &value));
+  EXPECT_EQ("uno", value);
+
+  EXPECT_TRUE(cache.Erase(1));
+  EXPECT_FALSE(cache.Erase(1));
+  EXPECT_FALSE(cache.Get(1, &value));
+  EXPECT_EQ(20u, cache.bytes());
+
+  cache.Clear();
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(0u, cache.bytes());
+  EXPECT_FALSE(cache.Get(2, &value));
+
+  StringCache::Stats stats;
+  cache.GetStats(&stats);
+  EXPECT_EQ(2u, stats.hits);
+  EXPECT_EQ(3u, stats.misses);
+  EXPECT_EQ(0u, stats.evictions);
+}
+
+TEST(ConcurrentMRUCacheTest, EvictsUnreferencedEntriesFirst) {
+  StringCache cache(30, 1);
+  cache.Put(1, "one", 10);
+  cache.Put(2, "two", 10);
+  cache.Put(3, "three", 10);
+
+  // 1 and 3 get a second chance; 2 has not been used since it was added.
+  std::string value;
+  EXPECT_TRUE(cache.Get(1, &value));
+  EXPECT_TRUE(cache.Get(3, &value));
+  EXPECT_TRUE(cache.Put(4, "four", 10));
+  EXPECT_FALSE(cache.Peek(2, &value));
+  EXPECT_TRUE(cache.Peek(1, &value));
+  EXPECT_TRUE(cache.Peek(3, &value));
+  EXPECT_TRUE(cache.Peek(4, &value));
+
+  // The sweep stopped at 2 after clearing the bit of 1 only, so it clears
+  // the bit of 3 and evicts 1 next. Peek doesn't set bits, so 4 and 3 go
+  // after that.
+  EXPECT_TRUE(cache.Put(5, "five", 10));
+  EXPECT_FALSE(cache.Peek(1, &value));
+  EXPECT_TRUE(cache.Peek(3, &value));
+  EXPECT_TRUE(cache.Put(6, "six", 20));
+  EXPECT_FALSE(cache.Peek(4, &value));
+  EXPECT_FALSE(cache.Peek(3, &value));
+  EXPECT_TRUE(cache.Peek(5, &value));
+  EXPECT_TRUE(cache.Peek(6, &value));
+  EXPECT_EQ(30u, cache.bytes());
+
+  StringCache::Stats stats;
+  cache.GetStats(&stats);
+  EXPECT_EQ(4u, stats.evictions);
+}
+
+TEST(ConcurrentMRUCacheTest, RejectsEntriesLargerThanAShard) {
+  StringCache cache(100, 4);
+  EXPECT_EQ(4u, cache.num_shards());
+  EXPECT_TRUE(cache.Put(1, "one", 25));
+  // The old payload is dropped even though the new one doesn't fit.
+  EXPECT_FALSE(cache.Put(1, "big", 26));
+  std::string value;
+  EXPECT_FALSE(cache.Get(1, &value));
+  EXPECT_EQ(0u, cache.bytes());
+}
+
+TEST(ConcurrentMRUCacheTest, RoundsShardsUpToPowerOfTwo) {
+  StringCache cache(1000, 5);
+  EXPECT_EQ(8u, cache.num_shards());
+}
+
+TEST(ConcurrentMRUCacheTest, StaysWithinCapacity) {
+  StringCache cache(64, 4);
+  for (int i = 0; i < 1000; ++i) {
+    cache.Put(i, "x", 1 + i % 3);
+    EXPECT_LE(cache.bytes(), 64u);
+  }
+  StringCache::Stats stats;
+  cache.GetStats(&stats);
+  EXPECT_GT(stats.evictions, 0u);
+}
+
+TEST(ConcurrentMRUCacheTest, ThreadSafety) {
+  const int kThreads = 8;
+  ConcurrentMRUCache<int, int> cache(256);
+  ScopedVector<CacheUser> users;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    // Half of the threads share their keys with another thread.
+    users.push_back(new CacheUser(&cache, (i / 2) * 100));
+    threads.push_back(new DelegateSimpleThread(users.back(), "CacheUser"));
+    threads.back()->Start();
+  }
+  for (int i = 0; i < kThreads; ++i) {
+    threads[i]->Join();
+    EXPECT_EQ(0, users[i]->mismatches());
+  }
+  EXPECT_LE(cache.bytes(), 256u);
+  EXPECT_EQ(cache.size(), cache.bytes());
+}
+
+}  // namespace base
@@ -21,6 +21,10 @@
 #include "base/lazy_instance.h"
 #endif
 
+#if defined(OS_POSIX)
+#include <unistd.h>
+#endif
+
 #if defined(ARCH_CPU_X86_FAMILY)
 #if defined(_MSC_VER)
 #include <intrin.h>
@@ -48,9 +52,20 @@ CPU::CPU()
     has_avx_(false),
     has_avx2_(false),
     has_aesni_(false),
+    has_sha_(false),
+    has_fma3_(false),
+    has_f16c_(false),
+    has_bmi2_(false),
+    has_avx512f_(false),
+    has_avx512bw_(false),
+    has_avx512vl_(false),
+    has_avx512vnni_(false),
     has_non_stop_time_stamp_counter_(false),
     has_broken_neon_(false),
     cpu_vendor_("unknown") {
+  memset(&l1d_cache_, 0, sizeof(l1d_cache_));
+  memset(&l2_cache_, 0, sizeof(l2_cache_));
+  memset(&l3_cache_, 0, sizeof(l3_cache_));
   Initialize();
 }
 
@@ -61,28 +76,32 @@ namespace {
 
 #if defined(__pic__) && defined(__i386__)
 
-void __cpuid(int cpu_info[4], int info_type) {
+void __cpuidex(int cpu_info[4], int info_type, int info_index) {
   __asm__ volatile (
     "mov %%ebx, %%edi\n"
     "cpuid\n"
     "xchg %%edi, %%ebx\n"
     : "=a"(cpu_info[0]), "=D"(cpu_info[1]), "=c"(cpu_info[2]), "=d"(cpu_info[3])
-    : "a"(info_type)
+    : "a"(info_type), "c"(info_index)
   );
 }
 
 #else
 
-void __cpuid(int cpu_info[4], int info_type) {
+void __cpuidex(int cpu_info[4], int info_type, int info_index) {
   __asm__ volatile (
     "cpuid\n"
     : "=a"(cpu_info[0]), "=b"(cpu_info[1]), "=c"(cpu_info[2]), "=d"(cpu_info[3])
-    : "a"(info_type)
+    : "a"(info_type), "c"(info_index)
   );
 }
 
 #endif
 
+void __cpuid(int cpu_info[4], int info_type) {
+  __cpuidex(cpu_info, info_type, 0);
+}
+
 // _xgetbv returns the value of an Intel Extended Control Register (XCR).
 // Currently only XCR0 is defined by Intel so |xcr| should always be zero.
 uint64_t _xgetbv(uint32_t xcr) {
@@ -244,13 +263,26 @@ void CPU::Initialize() {
     // even after following Intel's example code. (See crbug.com/375968.)
     // Because of that, we also test the XSAVE bit because its description in
     // the CPUID documentation suggests that it signals xgetbv support.
+    const bool has_osxsave =
+        (cpu_info[2] & 0x04000000) != 0 /* XSAVE */ &&
+        (cpu_info[2] & 0x08000000) != 0 /* OSXSAVE */;
+    const uint64_t xcr0 = has_osxsave ? _xgetbv(0) : 0;
     has_avx_ =
         (cpu_info[2] & 0x10000000) != 0 &&
-        (cpu_info[2] & 0x04000000) != 0 /* XSAVE */ &&
-        (cpu_info[2] & 0x08000000) != 0 /* OSXSAVE */ &&
-        (_xgetbv(0) & 6) == 6 /* XSAVE enabled by kernel */;
+        (xcr0 & 6) == 6 /* XSAVE enabled by kernel */;
     has_aesni_ = (cpu_info[2] & 0x02000000) != 0;
+    has_fma3_ = has_avx_ && (cpu_info[2] & 0x00001000) != 0;
+    has_f16c_ = has_avx_ && (cpu_info[2] & 0x20000000) != 0;
     has_avx2_ = has_avx_ && (cpu_info7[1] & 0x00000020) != 0;
+    has_bmi2_ = (cpu_info7[1] & 0x00000100) != 0;
+    has_sha_ = (cpu_info7[1] & 0x20000000) != 0;
+    // AVX-512 additionally needs the kernel to save the opmask registers and
+    // the upper halves of all 32 vector registers.
+    const bool has_avx512_state = has_avx_ && (xcr0 & 0xe0) == 0xe0;
+    has_avx512f_ = has_avx512_state && (cpu_info7[1] & 0x00010000) != 0;
+    has_avx512bw_ = has_avx512f_ && (cpu_info7[1] & 0x40000000) != 0;
+    has_avx512vl_ = has_avx512f_ && (cpu_info7[1] & 0x80000000) != 0;
+    has_avx512vnni_ = has_avx512f_ && (cpu_info7[2] & 0x00000800) != 0;
   }
 
   // Get the brand string of the cpu.
@@ -275,9 +307,72 @@ void CPU::Initialize() {
     __cpuid(cpu_info, parameter_containing_non_stop_time_stamp_counter);
     has_non_stop_time_stamp_counter_ = (cpu_info[3] & (1 << 8)) != 0;
   }
+
+  // Intel describes its caches in leaf 4, AMD in leaf 0x8000001D when it
+  // reports topology extensions. Both use the same layout.
+  int cache_leaf = 0;
+  if (cpu_vendor_ == "GenuineIntel" && num_ids >= 4) {
+    cache_leaf = 4;
+  } else if (static_cast<uint32_t>(max_parameter) >= 0x8000001D) {
+    __cpuid(cpu_info, 0x80000001);
+    if (cpu_info[2] & 0x00400000)
+      cache_leaf = 0x8000001D;
+  }
+  InitializeCacheInfo(cache_leaf);
 #elif defined(ARCH_CPU_ARM_FAMILY) && (defined(OS_ANDROID) || defined(OS_LINUX))
   cpu_brand_.assign(g_lazy_cpuinfo.Get().brand());
   has_broken_neon_ = g_lazy_cpuinfo.Get().has_broken_neon();
+  InitializeCacheInfo(0);
+#else
+  InitializeCacheInfo(0);
+#endif
+}
+
+void CPU::InitializeCacheInfo(int leaf) {
+#if defined(ARCH_CPU_X86_FAMILY)
+  // Each subleaf describes one cache until one reports the null type.
+  for (int index = 0; leaf && index < 16; ++index) {
+    int cpu_info[4];
+    __cpuidex(cpu_info, leaf, index);
+    const int type = cpu_info[0] & 0x1f;
+    if (type == 0)
+      break;
+    // Skip the instruction caches.
+    if (type == 2)
+      continue;
+    const int level = (cpu_info[0] >> 5) & 0x7;
+    CacheInfo* cache = level == 1 ? &l1d_cache_
+                     : level == 2 ? &l2_cache_
+                     : level == 3 ? &l3_cache_ : NULL;
+    if (!cache)
+      continue;
+    const int ways = ((cpu_info[1] >> 22) & 0x3ff) + 1;
+    const int partitions = ((cpu_info[1] >> 12) & 0x3ff) + 1;
+    const int line_size = (cpu_info[1] & 0xfff) + 1;
+    const int sets = cpu_info[2] + 1;
+    cache->size = ways * partitions * line_size * sets;
+    cache->line_size = line_size;
+    cache->shared_by = ((cpu_info[0] >> 14) & 0xfff) + 1;
+  }
+#endif
+#if defined(OS_LINUX) && defined(_SC_LEVEL1_DCACHE_SIZE)
+  // glibc reads the same CPUID leaves on x86, and sysfs or the auxiliary
+  // vector elsewhere. It doesn't know which processors share a cache.
+  if (!l1d_cache_.size) {
+    l1d_cache_.size = static_cast<int>(sysconf(_SC_LEVEL1_DCACHE_SIZE));
+    l1d_cache_.line_size =
+        static_cast<int>(sysconf(_SC_LEVEL1_DCACHE_LINESIZE));
+    l2_cache_.size = static_cast<int>(sysconf(_SC_LEVEL2_CACHE_SIZE));
+    l2_cache_.line_size = static_cast<int>(sysconf(_SC_LEVEL2_CACHE_LINESIZE));
+    l3_cache_.size = static_cast<int>(sysconf(_SC_LEVEL3_CACHE_SIZE));
+    l3_cache_.line_size = static_cast<int>(sysconf(_SC_LEVEL3_CACHE_LINESIZE));
+    // sysconf returns -1 or 0 for levels it can't query.
+    CacheInfo* caches[] = {&l1d_cache_, &l2_cache_, &l3_cache_};
+    for (size_t i = 0; i < arraysize(caches); ++i) {
+      if (caches[i]->size <= 0 || caches[i]->line_size < 0)
+        memset(caches[i], 0, sizeof(*caches[i]));
+    }
+  }
 #endif
 }
 
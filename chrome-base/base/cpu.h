@@ -17,6 +17,16 @@ class BASE_EXPORT CPU {
   // Constructor
   CPU();
 
+  // One level of the data cache hierarchy. All fields are zero when the
+  // level is absent or could not be queried.
+  struct CacheInfo {
+    int size;         // in bytes
+    int line_size;    // in bytes
+    // The number of logical processors that share this cache, as reported
+    // by the CPU. It can be larger than the number actually present.
+    int shared_by;
+  };
+
   enum IntelMicroArchitecture {
     PENTIUM,
     SSE,
@@ -49,6 +59,19 @@ class BASE_EXPORT CPU {
   bool has_avx() const { return has_avx_; }
   bool has_avx2() const { return has_avx2_; }
   bool has_aesni() const { return has_aesni_; }
+  // The SHA-1 and SHA-256 instructions.
+  bool has_sha() const { return has_sha_; }
+  // Fused multiply-add on 128 and 256 bit vectors (FMA3).
+  bool has_fma3() const { return has_fma3_; }
+  // Conversions between half and single precision floats.
+  bool has_f16c() const { return has_f16c_; }
+  bool has_bmi2() const { return has_bmi2_; }
+  // The AVX-512 subsets. Like AVX, they are only reported when the operating
+  // system saves the registers they use.
+  bool has_avx512f() const { return has_avx512f_; }
+  bool has_avx512bw() const { return has_avx512bw_; }
+  bool has_avx512vl() const { return has_avx512vl_; }
+  bool has_avx512vnni() const { return has_avx512vnni_; }
   bool has_non_stop_time_stamp_counter() const {
     return has_non_stop_time_stamp_counter_;
   }
@@ -60,10 +83,19 @@ class BASE_EXPORT CPU {
   IntelMicroArchitecture GetIntelMicroArchitecture() const;
   const std::string& cpu_brand() const { return cpu_brand_; }
 
+  // The level 1 data cache and the unified level 2 and 3 caches.
+  const CacheInfo& l1d_cache() const { return l1d_cache_; }
+  const CacheInfo& l2_cache() const { return l2_cache_; }
+  const CacheInfo& l3_cache() const { return l3_cache_; }
+
  private:
   // Query the processor for CPUID information.
   void Initialize();
 
+  // Fills in the cache levels, from CPUID leaf |leaf| on x86 and from the
+  // C library elsewhere.
+  void InitializeCacheInfo(int leaf);
+
   int signature_;  // raw form of type, family, model, and stepping
   int type_;  // process type
   int family_;  // family of the processor
@@ -81,10 +113,21 @@ class BASE_EXPORT CPU {
   bool has_avx_;
   bool has_avx2_;
   bool has_aesni_;
+  bool has_sha_;
+  bool has_fma3_;
+  bool has_f16c_;
+  bool has_bmi2_;
+  bool has_avx512f_;
+  bool has_avx512bw_;
+  bool has_avx512vl_;
+  bool has_avx512vnni_;
   bool has_non_stop_time_stamp_counter_;
   bool has_broken_neon_;
   std::string cpu_vendor_;
   std::string cpu_brand_;
+  CacheInfo l1d_cache_;
+  CacheInfo l2_cache_;
+  CacheInfo l3_cache_;
 };
 
 }  // namespace base
@@ -0,0 +1,141 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/cpu_dispatch.h"
+
+#include <utility>
+#include <vector>
+
+#include "base/cpu.h"
+#include "base/lazy_instance.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "build/build_config.h"
+
+namespace base {
+
+namespace {
+
+const struct {
+  CPUFeature feature;
+  const char* name;
+} kFeatureNames[] = {
+    {CPU_FEATURE_SSE2, "sse2"},
+    {CPU_FEATURE_SSSE3, "ssse3"},
+    {CPU_FEATURE_SSE41, "sse4.1"},
+    {CPU_FEATURE_SSE42, "sse4.2"},
+    {CPU_FEATURE_AVX, "avx"},
+    {CPU_FEATURE_AVX2, "avx2"},
+    {CPU_FEATURE_FMA3, "fma"},
+    {CPU_FEATURE_F16C, "f16c"},
+    {CPU_FEATURE_BMI2, "bmi2"},
+    {CPU_FEATURE_AVX512F, "avx512f"},
+    {CPU_FEATURE_AVX512BW, "avx512bw"},
+    {CPU_FEATURE_AVX512VL, "avx512vl"},
+    {CPU_FEATURE_AVX512VNNI, "avx512vnni"},
+    {CPU_FEATURE_AESNI, "aes"},
+    {CPU_FEATURE_SHA, "sha"},
+    {CPU_FEATURE_NEON, "neon"},
+};
+
+// Set in |g_features| once the CPU has been queried.
+const subtle::Atomic32 kFeaturesKnown = 1 << 30;
+
+subtle::Atomic32 g_features = 0;
+subtle::Atomic32 g_feature_mask = -1;
+
+typedef std::vector<std::pair<const char*, const char*>> KernelChoices;
+
+LazyInstance<Lock>::Leaky g_choices_lock = LAZY_INSTANCE_INITIALIZER;
+LazyInstance<KernelChoices>::Leaky g_choices = LAZY_INSTANCE_INITIALIZER;
+
+CPUFeatures QueryCPUFeatures() {
+  CPUFeatures features = 0;
+#if defined(ARCH_CPU_X86_FAMILY)
+  CPU cpu;
+  const struct {
+    bool present;
+    CPUFeature feature;
+  } kFeatures[] = {
+      {cpu.has_sse2(), CPU_FEATURE_SSE2},
+      {cpu.has_ssse3(), CPU_FEATURE_SSSE3},
+      {cpu.has_sse41(), CPU_FEATURE_SSE41},
+      {cpu.has_sse42(), CPU_FEATURE_SSE42},
+      {cpu.has_avx(), CPU_FEATURE_AVX},
+      {cpu.has_avx2(), CPU_FEATURE_AVX2},
+      {cpu.has_fma3(), CPU_FEATURE_FMA3},
+      {cpu.has_f16c(), CPU_FEATURE_F16C},
+      {cpu.has_bmi2(), CPU_FEATURE_BMI2},
+      {cpu.has_avx512f(), CPU_FEATURE_AVX512F},
+      {cpu.has_avx512bw(), CPU_FEATURE_AVX512BW},
+      {cpu.has_avx512vl(), CPU_FEATURE_AVX512VL},
+      {cpu.has_avx512vnni(), CPU_FEATURE_AVX512VNNI},
+      {cpu.has_aesni(), CPU_FEATURE_AESNI},
+      {cpu.has_sha(), CPU_FEATURE_SHA},
+  };
+  for (size_t i = 0; i < arraysize(kFeatures); ++i) {
+    if (kFeatures[i].present)
+      features |= kFeatures[i].feature;
+  }
+#elif defined(ARCH_CPU_ARM64) || defined(__ARM_NEON__)
+  // NEON is part of the baseline on arm64, and of 32-bit ARM builds that
+  // enable it, except on the CPUs whose NEON unit is flawed.
+  CPU cpu;
+  if (!cpu.has_broken_neon())
+    features |= CPU_FEATURE_NEON;
+#endif
+  return features;
+}
+
+}  // namespace
+
+CPUFeatures GetCPUFeatures() {
+  subtle::Atomic32 features = subtle::Acquire_Load(&g_features);
+  if (!features) {
+    // Racing threads store the same value.
+    features = static_cast<subtle::Atomic32>(QueryCPUFeatures()) |
+               kFeaturesKnown;
+    subtle::Release_Store(&g_features, features);
+  }
+  return static_cast<CPUFeatures>(features & ~kFeaturesKnown &
+                                  subtle::NoBarrier_Load(&g_feature_mask));
+}
+
+std::string CPUFeaturesToString(CPUFeatures features) {
+  std::string names;
+  for (size_t i = 0; i < arraysize(kFeatureNames); ++i) {
+    if (!(features & kFeatureNames[i].feature))
+      continue;
+    if (!names.empty())
+      names += ' ';
+    names += kFeatureNames[i].name;
+  }
+  return names;
+}
+
+std::string GetCPUKernelReport() {
+  AutoLock lock(g_choices_lock.Get());
+  const KernelChoices& choices = g_choices.Get();
+  std::string report;
+  for (size_t i = 0; i < choices.size(); ++i)
+    StringAppendF(&report, "%s: %s\n", choices[i].first, choices[i].second);
+  return report;
+}
+
+void SetCPUFeatureMaskForTesting(CPUFeatures mask) {
+  subtle::NoBarrier_Store(&g_feature_mask,
+                          static_cast<subtle::Atomic32>(mask));
+}
+
+namespace internal {
+
+void RecordCPUKernelChoice(const char* kernel, const char* variant) {
+  VLOG(1) << "CPU kernel " << kernel << ": " << variant;
+  AutoLock lock(g_choices_lock.Get());
+  g_choices.Get().push_back(std::make_pair(kernel, variant));
+}
+
+}  // namespace internal
+
+}  // namespace base
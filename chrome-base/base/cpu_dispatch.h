@@ -0,0 +1,155 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Picks the best implementation of a kernel for the CPU the process runs on,
+// so that one binary can use AVX-512 where it is available and still run on
+// machines with SSE2 only.
+//
+// A kernel lists its variants from most to least preferred, each with the
+// CPU features it needs. The variants are compiled for their instruction
+// set with a function attribute rather than a build flag, and the last one
+// must need no features:
+//
+//   __attribute__((target("avx2,fma"))) void ScaleAVX2(float* v, size_t n);
+//   void ScalePortable(float* v, size_t n);
+//
+//   typedef void (*ScaleFunction)(float*, size_t);
+//   const CPUKernelVariant<ScaleFunction> kScaleVariants[] = {
+//     {"avx2", CPU_FEATURE_AVX2 | CPU_FEATURE_FMA3, &ScaleAVX2},
+//     {"portable", 0, &ScalePortable},
+//   };
+//   CPUDispatchedKernel<ScaleFunction> g_scale =
+//       CPU_DISPATCHED_KERNEL("scale", kScaleVariants);
+//
+//   g_scale.Get()(values, count);
+//
+// The first call to Get() picks the variant and records the choice, which
+// GetCPUKernelReport() lists and VLOG(1) logs. Later calls only load the
+// choice. CPUDispatchedKernel is an aggregate, so a global one needs no
+// static initializer.
+
+#ifndef BASE_CPU_DISPATCH_H_
+#define BASE_CPU_DISPATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace base {
+
+// The CPU features that kernels can require.
+enum CPUFeature {
+  CPU_FEATURE_SSE2 = 1 << 0,
+  CPU_FEATURE_SSSE3 = 1 << 1,
+  CPU_FEATURE_SSE41 = 1 << 2,
+  CPU_FEATURE_SSE42 = 1 << 3,
+  CPU_FEATURE_AVX = 1 << 4,
+  CPU_FEATURE_AVX2 = 1 << 5,
+  CPU_FEATURE_FMA3 = 1 << 6,
+  CPU_FEATURE_F16C = 1 << 7,
+  CPU_FEATURE_BMI2 = 1 << 8,
+  CPU_FEATURE_AVX512F = 1 << 9,
+  CPU_FEATURE_AVX512BW = 1 << 10,
+  CPU_FEATURE_AVX512VL = 1 << 11,
+  CPU_FEATURE_AVX512VNNI = 1 << 12,
+  CPU_FEATURE_AESNI = 1 << 13,
+  CPU_FEATURE_SHA = 1 << 14,
+  CPU_FEATURE_NEON = 1 << 15,
+};
+
+// A set of CPUFeature bits.
+typedef uint32_t CPUFeatures;
+
+// Returns the features of this CPU. The CPU is queried once.
+BASE_EXPORT CPUFeatures GetCPUFeatures();
+
+// Returns the names of |features|, separated by spaces, e.g. "sse2 avx2".
+BASE_EXPORT std::string CPUFeaturesToString(CPUFeatures features);
+
+// Returns one line per kernel that has picked a variant so far, naming the
+// variant, in the order they were picked.
+BASE_EXPORT std::string GetCPUKernelReport();
+
+// Makes GetCPUFeatures() return only the features in |mask|, to test the
+// variants that a machine would pick without some of its features. Kernels
+// that already picked a variant keep it until their ResetForTesting().
+// Passing ~0u restores all features.
+BASE_EXPORT void SetCPUFeatureMaskForTesting(CPUFeatures mask);
+
+namespace internal {
+
+// Records and logs that |kernel| uses |variant|.
+BASE_EXPORT void RecordCPUKernelChoice(const char* kernel,
+                                       const char* variant);
+
+}  // namespace internal
+
+template <typename Function>
+struct CPUKernelVariant {
+  const char* name;
+  CPUFeatures required_features;
+  Function function;
+};
+
+// Initialize with CPU_DISPATCHED_KERNEL. The fields are public only so that
+// it stays an aggregate; use Get().
+template <typename Function>
+struct CPUDispatchedKernel {
+  typedef CPUKernelVariant<Function> Variant;
+
+  // Returns the function of the first variant whose features this CPU has.
+  // Thread-safe.
+  Function Get() {
+    subtle::AtomicWord selected = subtle::Acquire_Load(&selected_);
+    if (!selected)
+      selected = Select();
+    return variants_[selected - 1].function;
+  }
+
+  // Returns the name of the variant that Get() returns.
+  const char* GetVariantName() {
+    Get();
+    return variants_[subtle::Acquire_Load(&selected_) - 1].name;
+  }
+
+  void ResetForTesting() { subtle::Release_Store(&selected_, 0); }
+
+  const char* name_;
+  const Variant* variants_;
+  size_t num_variants_;
+  // One more than the index of the chosen variant, or zero before Get().
+  subtle::AtomicWord selected_;
+
+ private:
+  subtle::AtomicWord Select() {
+    const CPUFeatures features = GetCPUFeatures();
+    size_t index = 0;
+    while (index + 1 < num_variants_ &&
+           (variants_[index].required_features & features) !=
+               variants_[index].required_features) {
+      ++index;
+    }
+    DCHECK_EQ(0u, variants_[index].required_features & ~features)
+        << name_ << " has no variant for this CPU";
+
+    // Racing threads make the same choice; only the first one records it.
+    subtle::AtomicWord selected = static_cast<subtle::AtomicWord>(index + 1);
+    if (subtle::Release_CompareAndSwap(&selected_, 0, selected) == 0)
+      internal::RecordCPUKernelChoice(name_, variants_[index].name);
+    return selected;
+  }
+};
+
+#define CPU_DISPATCHED_KERNEL(name, variants) \
+  { name, variants, arraysize(variants), 0 }
+
+}  // namespace base
+
+#endif  // BASE_CPU_DISPATCH_H_
@@ -0,0 +1,97 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/cpu_dispatch.h"
+
+#include <string>
+
+#include "base/cpu.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+typedef int (*IdentifyFunction)();
+
+int IdentifyAVX512() { return 512; }
+int IdentifyAVX2() { return 2; }
+int IdentifyPortable() { return 0; }
+
+const CPUKernelVariant<IdentifyFunction> kIdentifyVariants[] = {
+    {"avx512", CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512BW, &IdentifyAVX512},
+    {"avx2", CPU_FEATURE_AVX2 | CPU_FEATURE_FMA3, &IdentifyAVX2},
+    {"portable", 0, &IdentifyPortable},
+};
+
+CPUDispatchedKernel<IdentifyFunction> g_identify =
+    CPU_DISPATCHED_KERNEL("identify", kIdentifyVariants);
+
+class CPUDispatchTest : public testing::Test {
+ protected:
+  void SetUp() override { g_identify.ResetForTesting(); }
+  void TearDown() override {
+    SetCPUFeatureMaskForTesting(~0u);
+    g_identify.ResetForTesting();
+  }
+};
+
+}  // namespace
+
+TEST_F(CPUDispatchTest, FeaturesMatchCPU) {
+  CPUFeatures features = GetCPUFeatures();
+#if defined(ARCH_CPU_X86_FAMILY)
+  CPU cpu;
+  EXPECT_EQ(cpu.has_sse2(), (features & CPU_FEATURE_SSE2) != 0);
+  EXPECT_EQ(cpu.has_avx2(), (features & CPU_FEATURE_AVX2) != 0);
+  EXPECT_EQ(cpu.has_fma3(), (features & CPU_FEATURE_FMA3) != 0);
+  EXPECT_EQ(cpu.has_avx512f(), (features & CPU_FEATURE_AVX512F) != 0);
+  EXPECT_EQ(cpu.has_sha(), (features & CPU_FEATURE_SHA) != 0);
+  EXPECT_NE(std::string::npos, CPUFeaturesToString(features).find("sse2"));
+#endif
+  EXPECT_EQ(0u, features & ~0xffffu);
+}
+
+TEST_F(CPUDispatchTest, FeaturesToString) {
+  EXPECT_EQ("", CPUFeaturesToString(0));
+  EXPECT_EQ("sse4.1 avx2 fma",
+            CPUFeaturesToString(CPU_FEATURE_FMA3 | CPU_FEATURE_AVX2 |
+                                CPU_FEATURE_SSE41));
+}
+
+TEST_F(CPUDispatchTest, PicksBestSupportedVariant) {
+  CPUFeatures features = GetCPUFeatures();
+  int expected = 0;
+  if ((features & CPU_FEATURE_AVX512F) && (features & CPU_FEATURE_AVX512BW))
+    expected = 512;
+  else if ((features & CPU_FEATURE_AVX2) && (features & CPU_FEATURE_FMA3))
+    expected = 2;
+  EXPECT_EQ(expected, g_identify.Get()());
+}
+
+TEST_F(CPUDispatchTest, MaskedFeaturesFallBack) {
+  SetCPUFeatureMaskForTesting(0);
+  EXPECT_EQ(0u, GetCPUFeatures());
+  EXPECT_EQ(0, g_identify.Get()());
+  EXPECT_STREQ("portable", g_identify.GetVariantName());
+
+  // The choice sticks until the kernel is reset.
+  SetCPUFeatureMaskForTesting(~0u);
+  EXPECT_EQ(0, g_identify.Get()());
+
+  // A variant that needs two features is skipped if one is missing.
+  SetCPUFeatureMaskForTesting(CPU_FEATURE_AVX512F | CPU_FEATURE_AVX2);
+  g_identify.ResetForTesting();
+  EXPECT_EQ(0, g_identify.Get()());
+}
+
+TEST_F(CPUDispatchTest, ReportsChoices) {
+  SetCPUFeatureMaskForTesting(0);
+  g_identify.Get();
+  EXPECT_NE(std::string::npos,
+            GetCPUKernelReport().find("identify: portable\n"));
+}
+
+}  // namespace base
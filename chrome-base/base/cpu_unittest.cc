@@ -67,6 +67,26 @@ TEST(CPU, RunExtendedInstructions) {
     __asm__ __volatile__("vpunpcklbw %%ymm0, %%ymm0, %%ymm0\n" : : : "xmm0");
   }
 
+  if (cpu.has_fma3()) {
+    // Execute an FMA instruction.
+    __asm__ __volatile__("vfmadd231ps %%ymm0, %%ymm0, %%ymm0\n" : : : "xmm0");
+  }
+
+  if (cpu.has_f16c()) {
+    // Execute an F16C instruction.
+    __asm__ __volatile__("vcvtph2ps %%xmm0, %%ymm0\n" : : : "xmm0");
+  }
+
+  if (cpu.has_bmi2()) {
+    // Execute a BMI2 instruction.
+    __asm__ __volatile__("pdep %%eax, %%eax, %%eax\n" : : : "eax");
+  }
+
+  if (cpu.has_avx512f()) {
+    // Execute an AVX-512 instruction.
+    __asm__ __volatile__("vpxord %%zmm0, %%zmm0, %%zmm0\n" : : : "xmm0");
+  }
+
 // Visual C 32 bit and ClangCL 32/64 bit test.
 #elif defined(COMPILER_MSVC) && (defined(ARCH_CPU_32_BITS) || \
       (defined(ARCH_CPU_64_BITS) && defined(__clang__)))
@@ -115,3 +135,21 @@ TEST(CPU, RunExtendedInstructions) {
 #endif  // defined(COMPILER_GCC)
 #endif  // defined(ARCH_CPU_X86_FAMILY)
 }
+
+TEST(CPU, CacheInfo) {
+  base::CPU cpu;
+  const base::CPU::CacheInfo* caches[] = {
+      &cpu.l1d_cache(), &cpu.l2_cache(), &cpu.l3_cache()};
+  for (size_t i = 0; i < sizeof(caches) / sizeof(caches[0]); ++i) {
+    EXPECT_GE(caches[i]->size, 0);
+    EXPECT_GE(caches[i]->line_size, 0);
+    // Caches that are present have a power of two line size.
+    if (caches[i]->line_size)
+      EXPECT_EQ(0, caches[i]->line_size & (caches[i]->line_size - 1));
+  }
+#if defined(ARCH_CPU_X86_FAMILY) && defined(OS_LINUX)
+  // Every x86 CPU we run on reports its level 1 and 2 caches.
+  EXPECT_GT(cpu.l1d_cache().size, 0);
+  EXPECT_GT(cpu.l2_cache().size, cpu.l1d_cache().size);
+#endif
+}
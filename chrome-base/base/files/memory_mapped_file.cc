@@ -4,15 +4,49 @@
 
 #include "base/files/memory_mapped_file.h"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/process/process_metrics.h"
 #include "base/sys_info.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread_restrictions.h"
 #include "build/build_config.h"
 
 namespace base {
 
+namespace {
+
+// Touches one byte of every page in [start, start + size).
+class PrefaultDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  PrefaultDelegate(const uint8_t* start, size_t size, size_t page_size)
+      : start_(start), size_(size), page_size_(page_size) {}
+
+  void Run() override {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < size_; i += page_size_)
+      sum += static_cast<const volatile uint8_t*>(start_)[i];
+    sink_ = sum;
+  }
+
+ private:
+  const uint8_t* const start_;
+  const size_t size_;
+  const size_t page_size_;
+
+  // Keeps the reads from being optimized away.
+  volatile uint8_t sink_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrefaultDelegate);
+};
+
+}  // namespace
+
 const MemoryMappedFile::Region MemoryMappedFile::Region::kWholeFile = {0, 0};
 
 bool MemoryMappedFile::Region::operator==(
@@ -31,9 +65,23 @@ MemoryMappedFile::~MemoryMappedFile() {
 
 #if !defined(OS_NACL)
 bool MemoryMappedFile::Initialize(const FilePath& file_name) {
+  return Initialize(file_name, LOAD_HINT_NONE);
+}
+
+bool MemoryMappedFile::Initialize(File file) {
+  return Initialize(std::move(file), Region::kWholeFile);
+}
+
+bool MemoryMappedFile::Initialize(File file, const Region& region) {
+  return Initialize(std::move(file), region, LOAD_HINT_NONE);
+}
+
+bool MemoryMappedFile::Initialize(const FilePath& file_name, int load_hints) {
   if (IsValid())
     return false;
 
+  load_hints_ = load_hints;
+
   file_.Initialize(file_name, File::FLAG_OPEN | File::FLAG_READ);
 
   if (!file_.IsValid()) {
@@ -49,14 +97,14 @@ bool MemoryMappedFile::Initialize(const FilePath& file_name) {
   return true;
 }
 
-bool MemoryMappedFile::Initialize(File file) {
-  return Initialize(std::move(file), Region::kWholeFile);
-}
-
-bool MemoryMappedFile::Initialize(File file, const Region& region) {
+bool MemoryMappedFile::Initialize(File file,
+                                  const Region& region,
+                                  int load_hints) {
   if (IsValid())
     return false;
 
+  load_hints_ = load_hints;
+
   if (region != Region::kWholeFile) {
     DCHECK_GE(region.offset, 0);
     DCHECK_GT(region.size, 0);
@@ -76,6 +124,51 @@ bool MemoryMappedFile::IsValid() const {
   return data_ != NULL;
 }
 
+void MemoryMappedFile::Prefault(int num_threads) {
+  DCHECK(IsValid());
+  DCHECK_GT(num_threads, 0);
+  ThreadRestrictions::AssertIOAllowed();
+
+  uint8_t* start;
+  size_t size;
+  GetAlignedRange(0, length_, &start, &size);
+  const size_t page_size = GetPageSize();
+  const size_t pages = size / page_size;
+  const size_t threads =
+      std::max<size_t>(1, std::min<size_t>(num_threads, pages));
+  const size_t pages_per_thread = (pages + threads - 1) / threads;
+
+  // Each thread takes a contiguous slice, so that readahead still works.
+  std::vector<scoped_ptr<PrefaultDelegate>> delegates;
+  for (size_t first = 0; first < pages; first += pages_per_thread) {
+    const size_t count = std::min(pages_per_thread, pages - first);
+    delegates.push_back(make_scoped_ptr(new PrefaultDelegate(
+        start + first * page_size, count * page_size, page_size)));
+  }
+  std::vector<scoped_ptr<DelegateSimpleThread>> workers;
+  for (size_t i = 1; i < delegates.size(); ++i) {
+    workers.push_back(make_scoped_ptr(
+        new DelegateSimpleThread(delegates[i].get(), "MemoryMappedPrefault")));
+    workers.back()->Start();
+  }
+  if (!delegates.empty())
+    delegates[0]->Run();
+  for (size_t i = 0; i < workers.size(); ++i)
+    workers[i]->Join();
+}
+
+void MemoryMappedFile::GetAlignedRange(size_t start,
+                                       size_t size,
+                                       uint8_t** aligned_start,
+                                       size_t* aligned_size) const {
+  const uintptr_t mask = GetPageSize() - 1;
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(data_ + start) & ~mask;
+  const uintptr_t end =
+      (reinterpret_cast<uintptr_t>(data_ + start + size) + mask) & ~mask;
+  *aligned_start = reinterpret_cast<uint8_t*>(begin);
+  *aligned_size = end - begin;
+}
+
 // static
 void MemoryMappedFile::CalculateVMAlignedBoundaries(int64_t start,
                                                     int64_t size,
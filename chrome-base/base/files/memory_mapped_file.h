@@ -41,6 +41,28 @@ class BASE_EXPORT MemoryMappedFile {
     int64_t size;
   };
 
+  // Hints on how to bring the mapping into memory, combined with |. They
+  // only affect when the file is read, never the contents, and are ignored
+  // where the system does not support them. POSIX only.
+  enum LoadHint {
+    LOAD_HINT_NONE = 0,
+
+    // Reads the file and fills in the page tables before Initialize()
+    // returns (MAP_POPULATE on Linux).
+    LOAD_HINT_POPULATE = 1 << 0,
+
+    // Starts reading the whole mapping in the background (MADV_WILLNEED).
+    LOAD_HINT_WILLNEED = 1 << 1,
+
+    // The mapping will be read in order: read ahead aggressively
+    // (MADV_SEQUENTIAL).
+    LOAD_HINT_SEQUENTIAL = 1 << 2,
+
+    // Backs the mapping with transparent huge pages when the kernel supports
+    // them for files (MADV_HUGEPAGE), to save TLB misses on large models.
+    LOAD_HINT_HUGEPAGE = 1 << 3,
+  };
+
   // Opens an existing file and maps it into memory. Access is restricted to
   // read only. If this object already points to a valid memory mapped file
   // then this method will fail and return false. If it cannot open the file,
@@ -55,6 +77,11 @@ class BASE_EXPORT MemoryMappedFile {
   // As above, but works with a region of an already-opened file.
   bool Initialize(File file, const Region& region);
 
+  // As the methods above, applying |load_hints|, a combination of LoadHint
+  // values.
+  bool Initialize(const FilePath& file_name, int load_hints);
+  bool Initialize(File file, const Region& region, int load_hints);
+
 #if defined(OS_WIN)
   // Opens an existing file and maps it as an image section. Please refer to
   // the Initialize function above for additional information.
@@ -67,6 +94,17 @@ class BASE_EXPORT MemoryMappedFile {
   // Is file_ a valid file handle that points to an open, memory mapped file?
   bool IsValid() const;
 
+  // Reads one byte of every page of the mapping, so that later accesses do
+  // not fault. The pages are split between |num_threads| threads, the calling
+  // one included, which keeps several reads in flight on a cold page cache.
+  // Returns once every page is resident.
+  void Prefault(int num_threads);
+
+  // Keeps the pages of [|offset|, |offset| + |size|) of the mapping resident
+  // (mlock) until the file is closed. Returns false if the system refuses,
+  // typically because of RLIMIT_MEMLOCK.
+  bool Lock(size_t offset, size_t size);
+
  private:
   // Given the arbitrarily aligned memory region [start, size], returns the
   // boundaries of the region aligned to the granularity specified by the OS,
@@ -87,9 +125,17 @@ class BASE_EXPORT MemoryMappedFile {
   // Closes all open handles.
   void CloseHandles();
 
+  // Returns the page-aligned range of memory that contains [|start|,
+  // |start| + |size|) of the mapping.
+  void GetAlignedRange(size_t start,
+                       size_t size,
+                       uint8_t** aligned_start,
+                       size_t* aligned_size) const;
+
   File file_;
   uint8_t* data_;
   size_t length_;
+  int load_hints_;
 
 #if defined(OS_WIN)
   win::ScopedHandle file_mapping_;
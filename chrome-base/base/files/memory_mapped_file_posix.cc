@@ -11,13 +11,14 @@
 #include <unistd.h>
 
 #include "base/logging.h"
+#include "base/macros.h"
 #include "base/threading/thread_restrictions.h"
 #include "build/build_config.h"
 
 namespace base {
 
-MemoryMappedFile::MemoryMappedFile() : data_(NULL), length_(0) {
-}
+MemoryMappedFile::MemoryMappedFile()
+    : data_(NULL), length_(0), load_hints_(LOAD_HINT_NONE) {}
 
 #if !defined(OS_NACL)
 bool MemoryMappedFile::MapFileRegionToMemory(
@@ -65,23 +66,66 @@ bool MemoryMappedFile::MapFileRegionToMemory(
     length_ = static_cast<size_t>(region.size);
   }
 
-  data_ = static_cast<uint8_t*>(mmap(NULL, map_size, PROT_READ, MAP_SHARED,
+  int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+  if (load_hints_ & LOAD_HINT_POPULATE)
+    flags |= MAP_POPULATE;
+#endif
+  data_ = static_cast<uint8_t*>(mmap(NULL, map_size, PROT_READ, flags,
                                      file_.GetPlatformFile(), map_start));
   if (data_ == MAP_FAILED) {
     DPLOG(ERROR) << "mmap " << file_.GetPlatformFile();
     return false;
   }
 
+  // The hints are advice; a kernel that does not know one rejects it with
+  // EINVAL and the mapping works as before.
+  const struct {
+    int hint;
+    int advice;
+  } kAdvice[] = {
+    {LOAD_HINT_WILLNEED, MADV_WILLNEED},
+    {LOAD_HINT_SEQUENTIAL, MADV_SEQUENTIAL},
+#if defined(MADV_HUGEPAGE)
+    {LOAD_HINT_HUGEPAGE, MADV_HUGEPAGE},
+#endif
+  };
+  for (size_t i = 0; i < arraysize(kAdvice); ++i) {
+    if ((load_hints_ & kAdvice[i].hint) &&
+        madvise(data_, map_size, kAdvice[i].advice)) {
+      DPLOG(WARNING) << "madvise " << kAdvice[i].advice;
+    }
+  }
+
   data_ += data_offset;
   return true;
 }
+
+bool MemoryMappedFile::Lock(size_t offset, size_t size) {
+  DCHECK(IsValid());
+  DCHECK_LE(offset, length_);
+  DCHECK_LE(size, length_ - offset);
+  uint8_t* start;
+  size_t aligned_size;
+  GetAlignedRange(offset, size, &start, &aligned_size);
+  if (mlock(start, aligned_size)) {
+    DPLOG(ERROR) << "mlock";
+    return false;
+  }
+  return true;
+}
 #endif
 
 void MemoryMappedFile::CloseHandles() {
   ThreadRestrictions::AssertIOAllowed();
 
-  if (data_ != NULL)
-    munmap(data_, length_);
+  if (data_ != NULL) {
+    // A region mapping starts at the page that holds its first byte.
+    uint8_t* start;
+    size_t size;
+    GetAlignedRange(0, length_, &start, &size);
+    munmap(start, size);
+  }
   file_.Close();
 
   data_ = NULL;
@@ -170,6 +170,51 @@ TEST_F(MemoryMappedFileTest, MapLargePartialRegionInTheMiddle) {
   ASSERT_TRUE(CheckBufferContents(map.data(), kPartialSize, kOffset));
 }
 
+TEST_F(MemoryMappedFileTest, MapWithLoadHints) {
+  const size_t kFileSize = 4 * 1024 * 1024 + 17;
+  CreateTemporaryTestFile(kFileSize);
+  MemoryMappedFile map;
+  ASSERT_TRUE(map.Initialize(
+      temp_file_path(), MemoryMappedFile::LOAD_HINT_POPULATE |
+                            MemoryMappedFile::LOAD_HINT_WILLNEED |
+                            MemoryMappedFile::LOAD_HINT_SEQUENTIAL |
+                            MemoryMappedFile::LOAD_HINT_HUGEPAGE));
+  ASSERT_EQ(kFileSize, map.length());
+  ASSERT_TRUE(CheckBufferContents(map.data(), kFileSize, 0));
+}
+
+TEST_F(MemoryMappedFileTest, Prefault) {
+  const size_t kFileSize = 1024 * 1024 + 5;
+  CreateTemporaryTestFile(kFileSize);
+  for (int num_threads : {1, 3, 1000}) {
+    MemoryMappedFile map;
+    ASSERT_TRUE(map.Initialize(temp_file_path()));
+    map.Prefault(num_threads);
+    ASSERT_TRUE(CheckBufferContents(map.data(), kFileSize, 0));
+  }
+
+  // A region that does not start on a page boundary.
+  const size_t kOffset = 1024 * 5 + 32;
+  const size_t kPartialSize = 16 * 1024 - 32;
+  MemoryMappedFile map;
+  File file(temp_file_path(), File::FLAG_OPEN | File::FLAG_READ);
+  MemoryMappedFile::Region region = {kOffset, kPartialSize};
+  ASSERT_TRUE(map.Initialize(std::move(file), region,
+                             MemoryMappedFile::LOAD_HINT_WILLNEED));
+  map.Prefault(2);
+  ASSERT_TRUE(CheckBufferContents(map.data(), kPartialSize, kOffset));
+}
+
+TEST_F(MemoryMappedFileTest, LockRegion) {
+  const size_t kFileSize = 64 * 1024;
+  CreateTemporaryTestFile(kFileSize);
+  MemoryMappedFile map;
+  ASSERT_TRUE(map.Initialize(temp_file_path()));
+  // A few pages fit in the default RLIMIT_MEMLOCK.
+  EXPECT_TRUE(map.Lock(1000, 8 * 1024));
+  ASSERT_TRUE(CheckBufferContents(map.data(), kFileSize, 0));
+}
+
 }  // namespace
 
 }  // namespace base
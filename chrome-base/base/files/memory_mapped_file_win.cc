@@ -10,13 +10,14 @@
 #include <limits>
 
 #include "base/files/file_path.h"
+#include "base/logging.h"
 #include "base/strings/string16.h"
 #include "base/threading/thread_restrictions.h"
 
 namespace base {
 
-MemoryMappedFile::MemoryMappedFile() : data_(NULL), length_(0), image_(false) {
-}
+MemoryMappedFile::MemoryMappedFile()
+    : data_(NULL), length_(0), load_hints_(LOAD_HINT_NONE), image_(false) {}
 
 bool MemoryMappedFile::InitializeAsImageSection(const FilePath& file_name) {
   image_ = true;
@@ -80,6 +81,16 @@ bool MemoryMappedFile::MapFileRegionToMemory(
   return true;
 }
 
+bool MemoryMappedFile::Lock(size_t offset, size_t size) {
+  DCHECK(IsValid());
+  DCHECK_LE(offset, length_);
+  DCHECK_LE(size, length_ - offset);
+  uint8_t* start;
+  size_t aligned_size;
+  GetAlignedRange(offset, size, &start, &aligned_size);
+  return ::VirtualLock(start, aligned_size) != 0;
+}
+
 void MemoryMappedFile::CloseHandles() {
   if (data_)
     ::UnmapViewOfFile(data_);
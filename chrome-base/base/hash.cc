@@ -4,6 +4,10 @@
 
 #include "base/hash.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 // Definition in base/third_party/superfasthash/superfasthash.c. (Third-party
 // code did not come with its own header file, so declaring the function here.)
 // Note: This algorithm is also in Blink under Source/wtf/StringHasher.h.
@@ -11,8 +15,176 @@ extern "C" uint32_t SuperFastHash(const char* data, int len);
 
 namespace base {
 
+namespace {
+
+// wyhash (https://github.com/wangyi-fudan/wyhash), public domain.
+
+const uint64_t kSecret0 = 0x2d358dccaa6c78a5ULL;
+const uint64_t kSecret1 = 0x8bb84b93962eacc9ULL;
+const uint64_t kSecret2 = 0x4b33a62ed433d4a3ULL;
+const uint64_t kSecret3 = 0x4d5a2da51de1aa47ULL;
+
+// Replaces |*a| and |*b| with the low and high halves of their product.
+inline void Multiply128(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 product = static_cast<unsigned __int128>(*a) * *b;
+  *a = static_cast<uint64_t>(product);
+  *b = static_cast<uint64_t>(product >> 64);
+#else
+  uint64_t a_high = *a >> 32, a_low = static_cast<uint32_t>(*a);
+  uint64_t b_high = *b >> 32, b_low = static_cast<uint32_t>(*b);
+  uint64_t high_high = a_high * b_high, high_low = a_high * b_low;
+  uint64_t low_high = a_low * b_high, low_low = a_low * b_low;
+  uint64_t middle =
+      high_low + (low_low >> 32) + static_cast<uint32_t>(low_high);
+  *a = (middle << 32) | static_cast<uint32_t>(low_low);
+  *b = high_high + (middle >> 32) + (low_high >> 32);
+#endif
+}
+
+inline uint64_t Mix(uint64_t a, uint64_t b) {
+  Multiply128(&a, &b);
+  return a ^ b;
+}
+
+inline uint64_t Read8(const unsigned char* p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint64_t Read4(const unsigned char* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint64_t MixSeed(uint64_t seed) {
+  return seed ^ Mix(seed ^ kSecret0, kSecret1);
+}
+
+inline uint64_t Finalize(uint64_t a, uint64_t b, uint64_t seed,
+                         uint64_t length) {
+  a ^= kSecret1;
+  b ^= seed;
+  Multiply128(&a, &b);
+  return Mix(a ^ kSecret0 ^ length, b ^ kSecret1);
+}
+
+// Hashes inputs of at most 16 bytes.
+uint64_t HashShort(const unsigned char* p, size_t length, uint64_t seed) {
+  uint64_t a = 0;
+  uint64_t b = 0;
+  if (length >= 4) {
+    const size_t offset = (length >> 3) << 2;
+    a = (Read4(p) << 32) | Read4(p + offset);
+    b = (Read4(p + length - 4) << 32) | Read4(p + length - 4 - offset);
+  } else if (length > 0) {
+    a = (static_cast<uint64_t>(p[0]) << 16) |
+        (static_cast<uint64_t>(p[length >> 1]) << 8) | p[length - 1];
+  }
+  return Finalize(a, b, seed, length);
+}
+
+// Hashes the last |remaining| bytes (1 to 48) at |p| of an input of
+// |length| > 16 bytes. Reads up to 16 bytes before |p|.
+uint64_t HashTail(const unsigned char* p,
+                  size_t remaining,
+                  uint64_t length,
+                  uint64_t seed) {
+  while (remaining > 16) {
+    seed = Mix(Read8(p) ^ kSecret1, Read8(p + 8) ^ seed);
+    p += 16;
+    remaining -= 16;
+  }
+  return Finalize(Read8(p + remaining - 16), Read8(p + remaining - 8), seed,
+                  length);
+}
+
+}  // namespace
+
 uint32_t SuperFastHash(const char* data, int len) {
   return ::SuperFastHash(data, len);
 }
 
+uint64_t Hash64(const void* data, size_t length, uint64_t seed) {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  seed = MixSeed(seed);
+  if (length <= 16)
+    return HashShort(p, length, seed);
+
+  size_t remaining = length;
+  if (remaining > 48) {
+    uint64_t see1 = seed;
+    uint64_t see2 = seed;
+    do {
+      seed = Mix(Read8(p) ^ kSecret1, Read8(p + 8) ^ seed);
+      see1 = Mix(Read8(p + 16) ^ kSecret2, Read8(p + 24) ^ see1);
+      see2 = Mix(Read8(p + 32) ^ kSecret3, Read8(p + 40) ^ see2);
+      p += 48;
+      remaining -= 48;
+    } while (remaining > 48);
+    seed ^= see1 ^ see2;
+  }
+  return HashTail(p, remaining, length, seed);
+}
+
+IncrementalHash64::IncrementalHash64() : IncrementalHash64(0) {}
+
+IncrementalHash64::IncrementalHash64(uint64_t seed) : initial_seed_(seed) {
+  Reset();
+}
+
+IncrementalHash64::~IncrementalHash64() {}
+
+void IncrementalHash64::Update(const void* data, size_t length) {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  total_length_ += length;
+  while (length) {
+    // A block is only hashed once more data follows it, because the final
+    // step treats the last 1 to 48 bytes differently.
+    if (pending_length_ == 0 && length > kBlockSize) {
+      do {
+        ProcessBlock(p);
+        p += kBlockSize;
+        length -= kBlockSize;
+      } while (length > kBlockSize);
+      memcpy(buffer_, p - 16, 16);
+    }
+
+    size_t count = std::min(kBlockSize - pending_length_, length);
+    memcpy(buffer_ + 16 + pending_length_, p, count);
+    pending_length_ += count;
+    p += count;
+    length -= count;
+
+    if (pending_length_ == kBlockSize && length) {
+      ProcessBlock(buffer_ + 16);
+      memcpy(buffer_, buffer_ + kBlockSize, 16);
+      pending_length_ = 0;
+    }
+  }
+}
+
+uint64_t IncrementalHash64::Finish() const {
+  if (total_length_ <= 16)
+    return HashShort(buffer_ + 16, pending_length_, seed_);
+  return HashTail(buffer_ + 16, pending_length_, total_length_,
+                  seed_ ^ see1_ ^ see2_);
+}
+
+void IncrementalHash64::Reset() {
+  seed_ = MixSeed(initial_seed_);
+  see1_ = seed_;
+  see2_ = seed_;
+  total_length_ = 0;
+  pending_length_ = 0;
+}
+
+void IncrementalHash64::ProcessBlock(const unsigned char* block) {
+  seed_ = Mix(Read8(block) ^ kSecret1, Read8(block + 8) ^ seed_);
+  see1_ = Mix(Read8(block + 16) ^ kSecret2, Read8(block + 24) ^ see1_);
+  see2_ = Mix(Read8(block + 32) ^ kSecret3, Read8(block + 40) ^ see2_);
+}
+
 }  // namespace base
@@ -36,6 +36,61 @@ inline uint32_t Hash(const std::string& str) {
   return Hash(str.data(), str.size());
 }
 
+// Computes a 64-bit hash of |length| bytes at |data|, for hash tables and
+// cache keys. The algorithm is wyhash: it reads 48 bytes per step in three
+// independent 64x64->128-bit multiply chains, so long inputs hash several
+// times faster than with SuperFastHash, and it mixes much better.
+// Hashes of the same data with different |seed|s are unrelated.
+// WARNING: This hash function should not be used for any cryptographic purpose,
+// nor persisted across releases: the algorithm may change.
+BASE_EXPORT uint64_t Hash64(const void* data, size_t length, uint64_t seed);
+
+inline uint64_t Hash64(const void* data, size_t length) {
+  return Hash64(data, length, 0);
+}
+
+inline uint64_t Hash64(const std::string& str) {
+  return Hash64(str.data(), str.size(), 0);
+}
+
+// Computes Hash64() over data that arrives in pieces, such as audio as it is
+// decoded. Feeding the same bytes in any split gives the same hash as one
+// Hash64() call over their concatenation.
+class BASE_EXPORT IncrementalHash64 {
+ public:
+  IncrementalHash64();
+  explicit IncrementalHash64(uint64_t seed);
+  ~IncrementalHash64();
+
+  void Update(const void* data, size_t length);
+
+  // Returns the hash of everything passed to Update() so far. More data can
+  // be added afterwards.
+  uint64_t Finish() const;
+
+  // Starts over with the same seed.
+  void Reset();
+
+ private:
+  // Bytes hashed per step of the main loop.
+  static const size_t kBlockSize = 48;
+
+  // Hashes the block at |block|.
+  void ProcessBlock(const unsigned char* block);
+
+  uint64_t initial_seed_;
+  uint64_t seed_;
+  uint64_t see1_;
+  uint64_t see2_;
+  uint64_t total_length_;
+
+  // The last 16 bytes before the pending bytes, followed by the pending bytes
+  // that have not been hashed yet. The final step reads up to 16 bytes back
+  // from the end, so these must be kept.
+  unsigned char buffer_[16 + kBlockSize];
+  size_t pending_length_;
+};
+
 // Implement hashing for pairs of at-most 32 bit integer values.
 // When size_t is 32 bits, we turn the 64-bit hash code into 32 bits by using
 // multiply-add hashing. This algorithm, as described in
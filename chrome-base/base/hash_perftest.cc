@@ -0,0 +1,103 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Compares the throughput of the hash functions in base on buffers of the
+// sizes used for cache keys, from short strings to seconds of PCM audio.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+
+#include "base/hash.h"
+#include "base/md5.h"
+#include "base/sha1.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace base {
+namespace {
+
+const size_t kBufferSizes[] = {16, 256, 4096, 64 * 1024, 1 << 20};
+
+// Total bytes hashed per function and size.
+const size_t kBytesPerRun = 256 << 20;
+
+// Sink that keeps the compiler from dropping the hash computations.
+volatile uint64_t g_sink;
+
+uint64_t RunSuperFastHash(const std::string& data) {
+  return Hash(data);
+}
+
+uint64_t RunHash64(const std::string& data) {
+  return Hash64(data);
+}
+
+uint64_t RunIncrementalHash64(const std::string& data) {
+  // Feeds 10 ms of 16 kHz 16-bit audio at a time, as a decoder would.
+  const size_t kChunkSize = 320;
+  IncrementalHash64 hasher;
+  for (size_t offset = 0; offset < data.size(); offset += kChunkSize)
+    hasher.Update(&data[offset], std::min(kChunkSize, data.size() - offset));
+  return hasher.Finish();
+}
+
+uint64_t RunMD5(const std::string& data) {
+  MD5Digest digest;
+  MD5Sum(data.data(), data.size(), &digest);
+  return digest.a[0];
+}
+
+uint64_t RunSHA1(const std::string& data) {
+  unsigned char hash[kSHA1Length];
+  SHA1HashBytes(reinterpret_cast<const unsigned char*>(data.data()),
+                data.size(), hash);
+  return hash[0];
+}
+
+struct HashFunction {
+  const char* name;
+  uint64_t (*function)(const std::string& data);
+  // Slow functions hash less data to keep the test short.
+  size_t bytes_divisor;
+};
+
+const HashFunction kHashFunctions[] = {
+    {"SuperFastHash", &RunSuperFastHash, 1},
+    {"Hash64", &RunHash64, 1},
+    {"IncrementalHash64", &RunIncrementalHash64, 1},
+    {"MD5", &RunMD5, 8},
+    {"SHA1", &RunSHA1, 8},
+};
+
+TEST(HashPerfTest, Throughput) {
+  for (size_t size : kBufferSizes) {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; ++i)
+      data[i] = static_cast<char>(i * 2654435761u >> 13);
+
+    for (const HashFunction& hash_function : kHashFunctions) {
+      const size_t runs = std::max<size_t>(
+          1, kBytesPerRun / hash_function.bytes_divisor / size);
+      TimeTicks start = TimeTicks::Now();
+      for (size_t i = 0; i < runs; ++i) {
+        data[0] = static_cast<char>(i);
+        g_sink = hash_function.function(data);
+      }
+      TimeDelta elapsed = TimeTicks::Now() - start;
+      double megabytes_per_second =
+          runs * size / (1024.0 * 1024.0) / elapsed.InSecondsF();
+      perf_test::PrintResult("hash", StringPrintf("_%zu", size),
+                             hash_function.name, megabytes_per_second, "MB/s",
+                             true);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace base
@@ -4,6 +4,8 @@
 
 #include "base/hash.h"
 
+#include <algorithm>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -79,4 +81,54 @@ TEST(HashTest, CString) {
   EXPECT_EQ(2794219650u, Hash(str, strlen("hello world")));
 }
 
+TEST(HashTest, Hash64) {
+  std::string data;
+  for (int i = 0; i < 300; ++i)
+    data.push_back(static_cast<char>(i * 131 + 7));
+
+  // Distinct for every prefix length, including the empty one, and for
+  // different seeds.
+  std::set<uint64_t> hashes;
+  for (size_t length = 0; length <= data.size(); ++length) {
+    hashes.insert(Hash64(data.data(), length));
+    hashes.insert(Hash64(data.data(), length, 1));
+  }
+  EXPECT_EQ(2 * (data.size() + 1), hashes.size());
+
+  // Flipping any bit of a long input changes the hash.
+  const uint64_t hash = Hash64(data);
+  EXPECT_EQ(hash, Hash64(data.data(), data.size(), 0));
+  for (size_t bit = 0; bit < data.size() * 8; bit += 7) {
+    std::string flipped = data;
+    flipped[bit / 8] ^= 1 << (bit % 8);
+    EXPECT_NE(hash, Hash64(flipped)) << bit;
+  }
+}
+
+TEST(HashTest, IncrementalHash64) {
+  std::string data;
+  for (int i = 0; i < 400; ++i)
+    data.push_back(static_cast<char>(i * 37 + 11));
+
+  const size_t kChunkSizes[] = {1, 3, 16, 47, 48, 49, 97, 400};
+  for (size_t length = 0; length <= data.size(); length += 13) {
+    const uint64_t expected = Hash64(data.data(), length, 42);
+    for (size_t chunk : kChunkSizes) {
+      IncrementalHash64 hasher(42);
+      for (size_t offset = 0; offset < length; offset += chunk)
+        hasher.Update(&data[offset], std::min(chunk, length - offset));
+      EXPECT_EQ(expected, hasher.Finish()) << length << " " << chunk;
+    }
+  }
+
+  // Finish() does not end the computation, and Reset() keeps the seed.
+  IncrementalHash64 hasher(42);
+  hasher.Update(data.data(), 100);
+  EXPECT_EQ(Hash64(data.data(), 100, 42), hasher.Finish());
+  hasher.Update(data.data() + 100, 100);
+  EXPECT_EQ(Hash64(data.data(), 200, 42), hasher.Finish());
+  hasher.Reset();
+  EXPECT_EQ(Hash64(nullptr, 0, 42), hasher.Finish());
+}
+
 }  // namespace base
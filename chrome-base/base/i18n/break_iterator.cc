@@ -6,6 +6,7 @@
 
 #include <stdint.h>
 
+#include "base/i18n/icu_util.h"
 #include "base/logging.h"
 #include "third_party/icu/source/common/unicode/ubrk.h"
 #include "third_party/icu/source/common/unicode/uchar.h"
@@ -39,6 +40,12 @@ BreakIterator::~BreakIterator() {
 }
 
 bool BreakIterator::Init() {
+#if !defined(OS_NACL)
+  // The break rules and dictionaries come from the ICU data file.
+  if (!i18n::EnsureICUInitialized())
+    return false;
+#endif
+
   UErrorCode status = U_ZERO_ERROR;
   UParseError parse_error;
   UBreakIteratorType break_type;
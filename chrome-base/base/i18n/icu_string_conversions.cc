@@ -9,6 +9,7 @@
 
 #include <vector>
 
+#include "base/i18n/icu_util.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/strings/string_util.h"
@@ -136,6 +137,17 @@ void SetUpErrorHandlerForToUChars(OnStringConversionError::Type on_error,
   }
 }
 
+// The converters come from the ICU data file.
+bool OpenConverter(const char* codepage_name, UConverter** converter) {
+#if !defined(OS_NACL)
+  if (!i18n::EnsureICUInitialized())
+    return false;
+#endif
+  UErrorCode status = U_ZERO_ERROR;
+  *converter = ucnv_open(codepage_name, &status);
+  return U_SUCCESS(status);
+}
+
 }  // namespace
 
 // Codepage <-> Wide/UTF-16  ---------------------------------------------------
@@ -146,9 +158,8 @@ bool UTF16ToCodepage(const string16& utf16,
                      std::string* encoded) {
   encoded->clear();
 
-  UErrorCode status = U_ZERO_ERROR;
-  UConverter* converter = ucnv_open(codepage_name, &status);
-  if (!U_SUCCESS(status))
+  UConverter* converter;
+  if (!OpenConverter(codepage_name, &converter))
     return false;
 
   return ConvertFromUTF16(converter, utf16.c_str(),
@@ -161,9 +172,8 @@ bool CodepageToUTF16(const std::string& encoded,
                      string16* utf16) {
   utf16->clear();
 
-  UErrorCode status = U_ZERO_ERROR;
-  UConverter* converter = ucnv_open(codepage_name, &status);
-  if (!U_SUCCESS(status))
+  UConverter* converter;
+  if (!OpenConverter(codepage_name, &converter))
     return false;
 
   // Even in the worst case, the maximum length in 2-byte units of UTF-16
@@ -176,6 +186,7 @@ bool CodepageToUTF16(const std::string& encoded,
   // BOCU and SCSU, but we don't care about them.
   size_t uchar_max_length = encoded.length() + 1;
 
+  UErrorCode status = U_ZERO_ERROR;
   SetUpErrorHandlerForToUChars(on_error, converter, &status);
   scoped_ptr<char16[]> buffer(new char16[uchar_max_length]);
   int actual_size = ucnv_toUChars(converter, buffer.get(),
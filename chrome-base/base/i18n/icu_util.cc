@@ -10,13 +10,16 @@
 
 #include <string>
 
+#include "base/atomicops.h"
 #include "base/debug/alias.h"
 #include "base/files/file_path.h"
 #include "base/files/memory_mapped_file.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/path_service.h"
 #include "base/strings/string_util.h"
 #include "base/strings/sys_string_conversions.h"
+#include "base/synchronization/lock.h"
 #include "build/build_config.h"
 #include "third_party/icu/source/common/unicode/putil.h"
 #include "third_party/icu/source/common/unicode/udata.h"
@@ -216,12 +219,20 @@ bool InitializeICUFromRawMemory(const uint8_t* raw_memory) {
 
 #endif  // ICU_UTIL_DATA_IMPL == ICU_UTIL_DATA_FILE
 
-bool InitializeICU() {
-#if !defined(NDEBUG)
-  DCHECK(!g_check_called_once || !g_called_once);
-  g_called_once = true;
-#endif
+namespace {
 
+// Values of |g_init_state|.
+enum InitState {
+  INIT_STATE_NONE,
+  INIT_STATE_SUCCEEDED,
+  INIT_STATE_FAILED,
+};
+
+// Read without |g_init_lock| once it is no longer INIT_STATE_NONE.
+subtle::Atomic32 g_init_state = INIT_STATE_NONE;
+LazyInstance<Lock>::Leaky g_init_lock = LAZY_INSTANCE_INITIALIZER;
+
+bool LoadICUData() {
   bool result;
 #if (ICU_UTIL_DATA_IMPL == ICU_UTIL_DATA_SHARED)
   // We expect to find the ICU data module alongside the current module.
@@ -272,6 +283,35 @@ bool InitializeICU() {
 #endif
   return result;
 }
+
+}  // namespace
+
+bool InitializeICU() {
+#if !defined(NDEBUG)
+  DCHECK(!g_check_called_once || !g_called_once);
+  g_called_once = true;
+#endif
+
+  AutoLock lock(g_init_lock.Get());
+  bool result = LoadICUData();
+  subtle::Release_Store(&g_init_state,
+                        result ? INIT_STATE_SUCCEEDED : INIT_STATE_FAILED);
+  return result;
+}
+
+bool EnsureICUInitialized() {
+  subtle::Atomic32 state = subtle::Acquire_Load(&g_init_state);
+  if (state == INIT_STATE_NONE) {
+    AutoLock lock(g_init_lock.Get());
+    state = subtle::NoBarrier_Load(&g_init_state);
+    if (state == INIT_STATE_NONE) {
+      state = LoadICUData() ? INIT_STATE_SUCCEEDED : INIT_STATE_FAILED;
+      subtle::Release_Store(&g_init_state, state);
+    }
+  }
+  return state == INIT_STATE_SUCCEEDED;
+}
+
 #endif  // !defined(OS_NACL)
 
 void AllowMultipleInitializeCallsForTesting() {
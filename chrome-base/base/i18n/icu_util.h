@@ -19,6 +19,13 @@ namespace i18n {
 // function should be called before ICU is used.
 BASE_I18N_EXPORT bool InitializeICU();
 
+// Loads ICU's data tables the first time it is called and returns the result
+// of that first load on every later call. Unlike InitializeICU(), it may be
+// called any number of times and from any thread, so code that uses ICU can
+// call it right before its first ICU call instead of the process paying for
+// the data at startup. After InitializeICU() it only returns that result.
+BASE_I18N_EXPORT bool EnsureICUInitialized();
+
 #if ICU_UTIL_DATA_IMPL == ICU_UTIL_DATA_FILE
 #if defined(OS_ANDROID)
 // Returns the PlatformFile and Region that was initialized by InitializeICU().
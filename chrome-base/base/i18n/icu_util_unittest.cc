@@ -0,0 +1,74 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/i18n/icu_util.h"
+
+#include "base/i18n/break_iterator.h"
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace i18n {
+
+namespace {
+
+class EnsureInitializedDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  EnsureInitializedDelegate() : result_(false) {}
+  ~EnsureInitializedDelegate() override {}
+
+  void Run() override { result_ = EnsureICUInitialized(); }
+
+  bool result() const { return result_; }
+
+ private:
+  bool result_;
+
+  DISALLOW_COPY_AND_ASSIGN(EnsureInitializedDelegate);
+};
+
+}  // namespace
+
+TEST(ICUUtilTest, EnsureICUInitializedFromManyThreads) {
+  const int kThreads = 4;
+  EnsureInitializedDelegate delegates[kThreads];
+  scoped_ptr<DelegateSimpleThread> threads[kThreads];
+  for (int i = 0; i < kThreads; ++i) {
+    threads[i].reset(
+        new DelegateSimpleThread(&delegates[i], "EnsureICUInitialized"));
+    threads[i]->Start();
+  }
+  for (int i = 0; i < kThreads; ++i) {
+    threads[i]->Join();
+    EXPECT_TRUE(delegates[i].result());
+  }
+  EXPECT_TRUE(EnsureICUInitialized());
+#if ICU_UTIL_DATA_IMPL == ICU_UTIL_DATA_FILE
+  EXPECT_TRUE(GetRawIcuMemory());
+#endif
+}
+
+// Segmenting Chinese words needs both the break rules and the dictionary
+// from the data file, which a trimmed file has to keep.
+TEST(ICUUtilTest, SegmentsChineseWords) {
+  ASSERT_TRUE(EnsureICUInitialized());
+  // "The weather is fine today".
+  string16 str(UTF8ToUTF16("\xE4\xBB\x8A\xE5\xA4\xA9\xE5\xA4\xA9\xE6\xB0\x94"
+                           "\xE5\xBE\x88\xE5\xA5\xBD"));
+  BreakIterator iter(str, BreakIterator::BREAK_WORD);
+  ASSERT_TRUE(iter.Init());
+  int words = 0;
+  while (iter.Advance()) {
+    if (iter.IsWord())
+      ++words;
+  }
+  EXPECT_GT(words, 1);
+  EXPECT_LT(words, 6);
+}
+
+}  // namespace i18n
+}  // namespace base
@@ -10,6 +10,7 @@
 
 #include "base/i18n/utf8_validator_tables.h"
 #include "base/logging.h"
+#include "base/strings/utf_string_conversion_utils.h"
 
 namespace base {
 namespace {
@@ -26,10 +27,14 @@ StreamingUtf8Validator::State StreamingUtf8Validator::AddBytes(const char* data,
   // Copy |state_| into a local variable so that the compiler doesn't have to be
   // careful of aliasing.
   uint8_t state = state_;
-  for (const char* p = data; p != data + size; ++p) {
+  const char* const end = data + size;
+  for (const char* p = data; p != end; ++p) {
     if ((*p & 0x80) == 0) {
-      if (state == 0)
+      if (state == 0) {
+        // Skip the rest of the ASCII run a vector at a time.
+        p += CountLeadingASCII(p, end - p) - 1;
         continue;
+      }
       state = internal::I18N_UTF8_VALIDATOR_INVALID_INDEX;
       break;
     }
@@ -21,6 +21,7 @@
 #include "base/macros.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
 #include "base/test/perf_time_logger.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -43,6 +44,9 @@ const char kThreeByteSeqRangeEnd[] = "\xe9\xbf\x83";    // U+9FC3 "to blink"
 const char kFourByteSeqRangeStart[] = "\xf0\xa0\x80\x8b";  // U+2000B
 const char kFourByteSeqRangeEnd[] = "\xf0\xaa\x9a\xb2";    // U+2A6B2
 
+// Recognizer output: CJK text with ASCII punctuation, digits and spaces.
+const char kMixedSeq[] = "\xe4\xbb\x8a\xe5\xa4\xa9 12 \xe5\xba\xa6, ok. ";
+
 // The different lengths of strings to test.
 const size_t kTestLengths[] = {1, 32, 256, 32768, 1 << 20};
 
@@ -140,10 +144,18 @@ bool IsStringUTF8(const std::string& str) {
   return base::IsStringUTF8(base::StringPiece(str));
 }
 
+// Conversion validates as it goes, so it is tracked alongside the validators.
+bool UTF8ToUTF16(const std::string& str) {
+  string16 output;
+  return base::UTF8ToUTF16(str.data(), str.size(), &output);
+}
+
 // IsString7Bit is intentionally placed last so it can be excluded easily.
 const TestFunctionDescription kTestFunctions[] = {
     {&StreamingUtf8Validator::Validate, "StreamingUtf8Validator"},
-    {&IsStringUTF8, "IsStringUTF8"}, {&IsString7Bit, "IsString7Bit"}};
+    {&IsStringUTF8, "IsStringUTF8"},
+    {&UTF8ToUTF16, "UTF8ToUTF16"},
+    {&IsString7Bit, "IsString7Bit"}};
 
 // Construct a test string from |construct_test_string| for each of the lengths
 // in |kTestLengths| in turn. For each string, run each test in |test_functions|
@@ -175,7 +187,7 @@ TEST(StreamingUtf8ValidatorPerfTest, OneByteRepeated) {
   RunSomeTests("%s: bytes=1 repeated length=%d repeat=%d",
                base::Bind(ConstructRepeatedTestString, kOneByteSeqRangeStart),
                kTestFunctions,
-               3);
+               4);
 }
 
 TEST(StreamingUtf8ValidatorPerfTest, OneByteRange) {
@@ -184,14 +196,14 @@ TEST(StreamingUtf8ValidatorPerfTest, OneByteRange) {
                           kOneByteSeqRangeStart,
                           kOneByteSeqRangeEnd),
                kTestFunctions,
-               3);
+               4);
 }
 
 TEST(StreamingUtf8ValidatorPerfTest, TwoByteRepeated) {
   RunSomeTests("%s: bytes=2 repeated length=%d repeat=%d",
                base::Bind(ConstructRepeatedTestString, kTwoByteSeqRangeStart),
                kTestFunctions,
-               2);
+               3);
 }
 
 TEST(StreamingUtf8ValidatorPerfTest, TwoByteRange) {
@@ -200,7 +212,7 @@ TEST(StreamingUtf8ValidatorPerfTest, TwoByteRange) {
                           kTwoByteSeqRangeStart,
                           kTwoByteSeqRangeEnd),
                kTestFunctions,
-               2);
+               3);
 }
 
 TEST(StreamingUtf8ValidatorPerfTest, ThreeByteRepeated) {
@@ -208,7 +220,7 @@ TEST(StreamingUtf8ValidatorPerfTest, ThreeByteRepeated) {
       "%s: bytes=3 repeated length=%d repeat=%d",
       base::Bind(ConstructRepeatedTestString, kThreeByteSeqRangeStart),
       kTestFunctions,
-      2);
+      3);
 }
 
 TEST(StreamingUtf8ValidatorPerfTest, ThreeByteRange) {
@@ -217,14 +229,14 @@ TEST(StreamingUtf8ValidatorPerfTest, ThreeByteRange) {
                           kThreeByteSeqRangeStart,
                           kThreeByteSeqRangeEnd),
                kTestFunctions,
-               2);
+               3);
 }
 
 TEST(StreamingUtf8ValidatorPerfTest, FourByteRepeated) {
   RunSomeTests("%s: bytes=4 repeated length=%d repeat=%d",
                base::Bind(ConstructRepeatedTestString, kFourByteSeqRangeStart),
                kTestFunctions,
-               2);
+               3);
 }
 
 TEST(StreamingUtf8ValidatorPerfTest, FourByteRange) {
@@ -233,7 +245,14 @@ TEST(StreamingUtf8ValidatorPerfTest, FourByteRange) {
                           kFourByteSeqRangeStart,
                           kFourByteSeqRangeEnd),
                kTestFunctions,
-               2);
+               3);
+}
+
+TEST(StreamingUtf8ValidatorPerfTest, MixedRepeated) {
+  RunSomeTests("%s: bytes=mixed repeated length=%d repeat=%d",
+               base::Bind(ConstructRepeatedTestString, kMixedSeq),
+               kTestFunctions,
+               3);
 }
 
 }  // namespace
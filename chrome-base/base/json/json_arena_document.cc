@@ -0,0 +1,300 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_arena_document.h"
+
+#include <string.h>
+
+#include <limits>
+#include <utility>
+
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+uint32_t CheckedSize(size_t size) {
+  CHECK_LE(size, std::numeric_limits<uint32_t>::max());
+  return static_cast<uint32_t>(size);
+}
+
+}  // namespace
+
+bool JSONArenaValue::GetAsBoolean(bool* out_value) const {
+  if (type_ != Value::TYPE_BOOLEAN)
+    return false;
+  if (out_value)
+    *out_value = bool_value_;
+  return true;
+}
+
+bool JSONArenaValue::GetAsInteger(int* out_value) const {
+  if (type_ != Value::TYPE_INTEGER)
+    return false;
+  if (out_value)
+    *out_value = int_value_;
+  return true;
+}
+
+bool JSONArenaValue::GetAsDouble(double* out_value) const {
+  if (type_ == Value::TYPE_INTEGER) {
+    if (out_value)
+      *out_value = int_value_;
+    return true;
+  }
+  if (type_ != Value::TYPE_DOUBLE)
+    return false;
+  if (out_value)
+    *out_value = double_value_;
+  return true;
+}
+
+bool JSONArenaValue::GetAsString(StringPiece* out_value) const {
+  if (type_ != Value::TYPE_STRING)
+    return false;
+  if (out_value)
+    *out_value = StringPiece(string_value_, size_);
+  return true;
+}
+
+size_t JSONArenaValue::size() const {
+  if (type_ != Value::TYPE_LIST && type_ != Value::TYPE_DICTIONARY)
+    return 0;
+  return size_;
+}
+
+const JSONArenaValue* JSONArenaValue::GetListItem(size_t index) const {
+  if (type_ != Value::TYPE_LIST || index >= size_)
+    return nullptr;
+  return &items_[index];
+}
+
+const JSONArenaValue* JSONArenaValue::FindKey(const StringPiece& key) const {
+  if (type_ != Value::TYPE_DICTIONARY)
+    return nullptr;
+  for (size_t i = size_; i > 0; --i) {
+    const Member& member = members_[i - 1];
+    if (member.key_length == key.size() &&
+        (key.empty() || !memcmp(member.key, key.data(), key.size()))) {
+      return &member.value;
+    }
+  }
+  return nullptr;
+}
+
+StringPiece JSONArenaValue::GetKey(size_t index) const {
+  DCHECK(IsType(Value::TYPE_DICTIONARY));
+  DCHECK_LT(index, size_);
+  return StringPiece(members_[index].key, members_[index].key_length);
+}
+
+const JSONArenaValue* JSONArenaValue::GetValue(size_t index) const {
+  DCHECK(IsType(Value::TYPE_DICTIONARY));
+  DCHECK_LT(index, size_);
+  return &members_[index].value;
+}
+
+scoped_ptr<Value> JSONArenaValue::CreateDeepCopy() const {
+  switch (type_) {
+    case Value::TYPE_NULL:
+      return Value::CreateNullValue();
+    case Value::TYPE_BOOLEAN:
+      return make_scoped_ptr(new FundamentalValue(bool_value_));
+    case Value::TYPE_INTEGER:
+      return make_scoped_ptr(new FundamentalValue(int_value_));
+    case Value::TYPE_DOUBLE:
+      return make_scoped_ptr(new FundamentalValue(double_value_));
+    case Value::TYPE_STRING:
+      return make_scoped_ptr(
+          new StringValue(std::string(string_value_, size_)));
+    case Value::TYPE_LIST: {
+      scoped_ptr<ListValue> list(new ListValue);
+      for (size_t i = 0; i < size_; ++i)
+        list->Append(items_[i].CreateDeepCopy());
+      return std::move(list);
+    }
+    case Value::TYPE_DICTIONARY: {
+      scoped_ptr<DictionaryValue> dictionary(new DictionaryValue);
+      for (size_t i = 0; i < size_; ++i) {
+        dictionary->SetWithoutPathExpansion(GetKey(i).as_string(),
+                                            members_[i].value.CreateDeepCopy());
+      }
+      return std::move(dictionary);
+    }
+    default:
+      NOTREACHED();
+      return nullptr;
+  }
+}
+
+// Builds the tree from the tokens of JSONSaxReader. The children of each open
+// container are collected in |pending_|; when the container ends they are
+// copied into an array of the exact size in the arena.
+class JSONArenaDocument::Builder : public JSONSaxHandler {
+ public:
+  explicit Builder(JSONArenaDocument* document)
+      : document_(document), after_key_(false) {}
+  ~Builder() override {}
+
+  bool OnNull() override {
+    JSONArenaValue value;
+    value.type_ = Value::TYPE_NULL;
+    value.size_ = 0;
+    return AddValue(value);
+  }
+
+  bool OnBoolean(bool in_value) override {
+    JSONArenaValue value;
+    value.type_ = Value::TYPE_BOOLEAN;
+    value.size_ = 0;
+    value.bool_value_ = in_value;
+    return AddValue(value);
+  }
+
+  bool OnInteger(int in_value) override {
+    JSONArenaValue value;
+    value.type_ = Value::TYPE_INTEGER;
+    value.size_ = 0;
+    value.int_value_ = in_value;
+    return AddValue(value);
+  }
+
+  bool OnDouble(double in_value) override {
+    JSONArenaValue value;
+    value.type_ = Value::TYPE_DOUBLE;
+    value.size_ = 0;
+    value.double_value_ = in_value;
+    return AddValue(value);
+  }
+
+  bool OnString(const StringPiece& in_value, bool in_input) override {
+    StringPiece str =
+        in_input ? in_value : document_->arena_.CopyString(in_value);
+    JSONArenaValue value;
+    value.type_ = Value::TYPE_STRING;
+    value.size_ = CheckedSize(str.size());
+    value.string_value_ = str.data();
+    return AddValue(value);
+  }
+
+  bool OnStartDictionary() override { return StartContainer(); }
+
+  bool OnKey(const StringPiece& key, bool in_input) override {
+    StringPiece str = in_input ? key : document_->arena_.CopyString(key);
+    JSONArenaValue::Member member;
+    member.key = str.data();
+    member.key_length = CheckedSize(str.size());
+    document_->pending_.push_back(member);
+    after_key_ = true;
+    return true;
+  }
+
+  bool OnEndDictionary() override {
+    size_t first = EndContainer();
+    std::vector<JSONArenaValue::Member>& pending = document_->pending_;
+    size_t count = pending.size() - first;
+    JSONArenaValue::Member* members = nullptr;
+    if (count) {
+      members = document_->arena_.AllocateArray<JSONArenaValue::Member>(count);
+      memcpy(members, &pending[first], count * sizeof(*members));
+    }
+    pending.resize(first);
+
+    JSONArenaValue value;
+    value.type_ = Value::TYPE_DICTIONARY;
+    value.size_ = CheckedSize(count);
+    value.members_ = members;
+    return AddValue(value);
+  }
+
+  bool OnStartList() override { return StartContainer(); }
+
+  bool OnEndList() override {
+    size_t first = EndContainer();
+    std::vector<JSONArenaValue::Member>& pending = document_->pending_;
+    size_t count = pending.size() - first;
+    JSONArenaValue* items = nullptr;
+    if (count) {
+      items = document_->arena_.AllocateArray<JSONArenaValue>(count);
+      for (size_t i = 0; i < count; ++i)
+        items[i] = pending[first + i].value;
+    }
+    pending.resize(first);
+
+    JSONArenaValue value;
+    value.type_ = Value::TYPE_LIST;
+    value.size_ = CheckedSize(count);
+    value.items_ = items;
+    return AddValue(value);
+  }
+
+ private:
+  // Stores |value| as the root, the value of the pending key, or the next
+  // list item.
+  bool AddValue(const JSONArenaValue& value) {
+    std::vector<JSONArenaValue::Member>& pending = document_->pending_;
+    if (document_->frames_.empty()) {
+      document_->root_ = value;
+      document_->has_root_ = true;
+    } else if (after_key_) {
+      pending.back().value = value;
+      after_key_ = false;
+    } else {
+      JSONArenaValue::Member member;
+      member.key = nullptr;
+      member.key_length = 0;
+      member.value = value;
+      pending.push_back(member);
+    }
+    return true;
+  }
+
+  bool StartContainer() {
+    // The container is added to its parent when it ends, so whether it is the
+    // value of a pending key is remembered in the low bit of its frame.
+    document_->frames_.push_back(document_->pending_.size() * 2 + after_key_);
+    after_key_ = false;
+    return true;
+  }
+
+  // Closes the current container and returns the index in |pending_| of its
+  // first child. The caller consumes the children.
+  size_t EndContainer() {
+    size_t frame = document_->frames_.back();
+    document_->frames_.pop_back();
+    after_key_ = frame & 1;
+    return frame / 2;
+  }
+
+  JSONArenaDocument* const document_;
+
+  // Whether a key has been read and is waiting for its value.
+  bool after_key_;
+
+  DISALLOW_COPY_AND_ASSIGN(Builder);
+};
+
+JSONArenaDocument::JSONArenaDocument(int options)
+    : reader_(options), has_root_(false) {}
+
+JSONArenaDocument::~JSONArenaDocument() {}
+
+bool JSONArenaDocument::Parse(const StringPiece& input) {
+  Clear();
+  Builder builder(this);
+  bool success = reader_.Parse(input, &builder);
+  pending_.clear();
+  frames_.clear();
+  if (!success)
+    Clear();
+  return success;
+}
+
+void JSONArenaDocument::Clear() {
+  has_root_ = false;
+  arena_.Reset();
+}
+
+}  // namespace base
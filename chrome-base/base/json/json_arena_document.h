@@ -0,0 +1,142 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_ARENA_DOCUMENT_H_
+#define BASE_JSON_JSON_ARENA_DOCUMENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_sax_reader.h"
+#include "base/macros.h"
+#include "base/memory/arena.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+
+namespace base {
+
+// A read-only JSON value that lives in the Arena of a JSONArenaDocument. It
+// mirrors the accessors of Value for the types JSON can produce. Containers
+// are arrays in the arena rather than vectors and maps, and strings point
+// either into the parsed input or into the arena, so nothing is owned.
+class BASE_EXPORT JSONArenaValue {
+ public:
+  struct Member;
+
+  Value::Type GetType() const { return type_; }
+  bool IsType(Value::Type type) const { return type_ == type; }
+
+  // These return false if the value has a different type. Like Value,
+  // GetAsDouble() also accepts integers.
+  bool GetAsBoolean(bool* out_value) const;
+  bool GetAsInteger(int* out_value) const;
+  bool GetAsDouble(double* out_value) const;
+  bool GetAsString(StringPiece* out_value) const;
+
+  // Number of items of a list or entries of a dictionary, 0 otherwise.
+  size_t size() const;
+
+  // Returns the item at |index| of a list, or null if out of range or not a
+  // list.
+  const JSONArenaValue* GetListItem(size_t index) const;
+
+  // Returns the value for |key| in a dictionary, or null. If the input had
+  // duplicate keys the last one wins, as with DictionaryValue. This is a
+  // linear scan, which beats a map for the small dictionaries of a request.
+  const JSONArenaValue* FindKey(const StringPiece& key) const;
+
+  // Dictionary entries in input order, |index| < size().
+  StringPiece GetKey(size_t index) const;
+  const JSONArenaValue* GetValue(size_t index) const;
+
+  // Builds the equivalent heap-allocated Value, for code that needs one.
+  scoped_ptr<Value> CreateDeepCopy() const;
+
+ private:
+  friend class JSONArenaDocument;
+
+  Value::Type type_;
+  uint32_t size_;  // Length of a string, item count of a container.
+  union {
+    bool bool_value_;
+    int int_value_;
+    double double_value_;
+    const char* string_value_;
+    const JSONArenaValue* items_;
+    const Member* members_;
+  };
+};
+
+struct JSONArenaValue::Member {
+  const char* key;
+  uint32_t key_length;
+  JSONArenaValue value;
+};
+
+// JSONArenaDocument parses JSON into JSONArenaValues allocated from an
+// Arena, as a lightweight alternative to JSONReader for per-request data. A
+// DictionaryValue tree costs a heap allocation per node plus std::map nodes
+// and std::string keys; here a whole tree is a handful of arena blocks and is
+// freed in O(1) when the document is parsed again or destroyed. A document
+// reused across requests keeps its first arena block and stops calling malloc
+// for small requests.
+//
+// Strings without escape sequences point into the input, so the input must
+// outlive the tree. Use CreateDeepCopy() on any part that must outlive it.
+//
+// Usage:
+//
+//   JSONArenaDocument document(JSON_PARSE_RFC);  // Reused across requests.
+//   ...
+//   if (!document.Parse(request_body))
+//     return Error(document.GetErrorMessage());
+//   const JSONArenaValue* audio = document.root()->FindKey("audio");
+class BASE_EXPORT JSONArenaDocument {
+ public:
+  // |options| is a combination of JSONParserOptions, as for JSONReader.
+  explicit JSONArenaDocument(int options);
+  ~JSONArenaDocument();
+
+  // Parses |input|, replacing the previous tree. Returns false on error, in
+  // which case root() is null.
+  bool Parse(const StringPiece& input);
+
+  // Returns the root of the last successful parse, or null.
+  const JSONArenaValue* root() const { return has_root_ ? &root_ : nullptr; }
+
+  // Releases the tree.
+  void Clear();
+
+  JSONReader::JsonParseError error_code() const {
+    return reader_.error_code();
+  }
+  std::string GetErrorMessage() const { return reader_.GetErrorMessage(); }
+
+  const Arena& arena() const { return arena_; }
+
+ private:
+  class Builder;
+
+  JSONSaxReader reader_;
+  Arena arena_;
+
+  // Scratch space of the builder, kept to reuse its capacity.
+  std::vector<JSONArenaValue::Member> pending_;
+  std::vector<size_t> frames_;
+
+  JSONArenaValue root_;
+  bool has_root_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONArenaDocument);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_ARENA_DOCUMENT_H_
@@ -0,0 +1,125 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_arena_document.h"
+
+#include <string>
+
+#include "base/json/json_reader.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+TEST(JSONArenaDocumentTest, Accessors) {
+  const std::string json(
+      "{\"text\": \"hello\", \"escaped\": \"a\\nb\", \"n\": 42, "
+      "\"x\": 0.5, \"ok\": true, \"none\": null, "
+      "\"tokens\": [1, \"two\", [], {}], \"n\": 7}");
+  JSONArenaDocument document(JSON_PARSE_RFC);
+  ASSERT_TRUE(document.Parse(json));
+  const JSONArenaValue* root = document.root();
+  ASSERT_TRUE(root);
+  ASSERT_TRUE(root->IsType(Value::TYPE_DICTIONARY));
+  EXPECT_EQ(8u, root->size());
+  EXPECT_EQ("text", root->GetKey(0));
+
+  StringPiece text;
+  ASSERT_TRUE(root->FindKey("text")->GetAsString(&text));
+  EXPECT_EQ("hello", text);
+  // Unescaped strings point into the input, others into the arena.
+  EXPECT_GE(text.data(), json.data());
+  EXPECT_LT(text.data(), json.data() + json.size());
+  ASSERT_TRUE(root->FindKey("escaped")->GetAsString(&text));
+  EXPECT_EQ("a\nb", text);
+
+  // The last duplicate key wins.
+  int n;
+  ASSERT_TRUE(root->FindKey("n")->GetAsInteger(&n));
+  EXPECT_EQ(7, n);
+  double x;
+  EXPECT_TRUE(root->FindKey("n")->GetAsDouble(&x));
+  ASSERT_TRUE(root->FindKey("x")->GetAsDouble(&x));
+  EXPECT_EQ(0.5, x);
+  EXPECT_FALSE(root->FindKey("x")->GetAsInteger(&n));
+  bool ok;
+  ASSERT_TRUE(root->FindKey("ok")->GetAsBoolean(&ok));
+  EXPECT_TRUE(ok);
+  EXPECT_TRUE(root->FindKey("none")->IsType(Value::TYPE_NULL));
+  EXPECT_FALSE(root->FindKey("missing"));
+
+  const JSONArenaValue* tokens = root->FindKey("tokens");
+  ASSERT_TRUE(tokens->IsType(Value::TYPE_LIST));
+  EXPECT_EQ(4u, tokens->size());
+  ASSERT_TRUE(tokens->GetListItem(1)->GetAsString(&text));
+  EXPECT_EQ("two", text);
+  EXPECT_EQ(0u, tokens->GetListItem(2)->size());
+  EXPECT_TRUE(tokens->GetListItem(3)->IsType(Value::TYPE_DICTIONARY));
+  EXPECT_FALSE(tokens->GetListItem(4));
+  EXPECT_FALSE(tokens->FindKey("text"));
+}
+
+TEST(JSONArenaDocumentTest, MatchesJSONReader) {
+  const char* const kDocuments[] = {
+      "null",
+      "\"root string\"",
+      "[1, 2.5, -3, 1e100, true, false, null, \"\\u00e9\"]",
+      "{\"a\": {\"b\": {\"c\": [[], [{}], [1, [2, [3]]]]}}, \"d\": \"e\"}",
+      "{\"dup\": 1, \"nested\": {\"dup\": [1]}, \"dup\": {\"x\": 2}}",
+      "{\"a.b\": 1, \"\": \"empty key\", \"\\\"q\\\"\": \"quoted key\"}",
+  };
+  JSONArenaDocument document(JSON_PARSE_RFC);
+  for (size_t i = 0; i < arraysize(kDocuments); ++i) {
+    SCOPED_TRACE(kDocuments[i]);
+    scoped_ptr<Value> expected = JSONReader::Read(kDocuments[i]);
+    ASSERT_TRUE(expected);
+    ASSERT_TRUE(document.Parse(kDocuments[i]));
+    scoped_ptr<Value> actual = document.root()->CreateDeepCopy();
+    EXPECT_TRUE(expected->Equals(actual.get()));
+  }
+}
+
+TEST(JSONArenaDocumentTest, Errors) {
+  JSONArenaDocument document(JSON_PARSE_RFC);
+  ASSERT_TRUE(document.Parse("[1]"));
+  EXPECT_TRUE(document.root());
+
+  EXPECT_FALSE(document.Parse("{\"a\": [1, 2}"));
+  EXPECT_FALSE(document.root());
+  EXPECT_NE(JSONReader::JSON_NO_ERROR, document.error_code());
+  EXPECT_FALSE(document.GetErrorMessage().empty());
+
+  EXPECT_FALSE(document.Parse("[1,]"));
+  JSONArenaDocument lenient(JSON_ALLOW_TRAILING_COMMAS);
+  EXPECT_TRUE(lenient.Parse("[1,]"));
+}
+
+TEST(JSONArenaDocumentTest, ReuseDoesNotGrow) {
+  std::string json("{\"results\": [");
+  for (int i = 0; i < 50; ++i) {
+    if (i)
+      json += ", ";
+    json += "{\"word\": \"w\\u00e9\", \"start\": 1.25, \"end\": 1.5}";
+  }
+  json += "]}";
+
+  JSONArenaDocument document(JSON_PARSE_RFC);
+  ASSERT_TRUE(document.Parse(json));
+  size_t reserved = document.arena().bytes_reserved();
+  size_t allocated = document.arena().bytes_allocated();
+  EXPECT_GT(allocated, 0u);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(document.Parse(json));
+    EXPECT_EQ(allocated, document.arena().bytes_allocated());
+    EXPECT_EQ(reserved, document.arena().bytes_reserved());
+  }
+  EXPECT_EQ(50u, document.root()->FindKey("results")->size());
+
+  document.Clear();
+  EXPECT_FALSE(document.root());
+  EXPECT_EQ(0u, document.arena().bytes_allocated());
+}
+
+}  // namespace base
@@ -0,0 +1,505 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_sax_reader.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversion_utils.h"
+#include "base/third_party/icu/icu_utf.h"
+
+namespace base {
+
+namespace {
+
+// Same limit as JSONParser.
+const size_t kStackMaxDepth = 100;
+
+const uint64_t kOnes = 0x0101010101010101ULL;
+const uint64_t kHighBits = 0x8080808080808080ULL;
+
+// Returns whether any of the eight bytes in |v| is a quote, a backslash or a
+// non-ASCII byte, i.e. needs a closer look by the string scanner. The quote
+// and backslash tests use the classic "has a zero byte" trick on |v| XORed
+// with the byte; false positives are harmless.
+inline bool HasSpecialByte(uint64_t v) {
+  uint64_t quote = v ^ (kOnes * '"');
+  uint64_t backslash = v ^ (kOnes * '\\');
+  return (((quote - kOnes) & ~quote) | ((backslash - kOnes) & ~backslash) |
+          v) & kHighBits;
+}
+
+inline bool IsSpecialByte(char c) {
+  return c == '"' || c == '\\' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+// Returns the first byte in [p, end) that IsSpecialByte(), or |end|.
+const char* SkipPlainRun(const char* p, const char* end) {
+  while (end - p >= 8) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    if (HasSpecialByte(v))
+      break;
+    p += 8;
+  }
+  while (p < end && !IsSpecialByte(*p))
+    ++p;
+  return p;
+}
+
+// Validates the UTF-8 sequence at |p|. Returns the byte after it, or null if
+// it is malformed or encodes a character JSONReader rejects.
+const char* SkipUTF8Character(const char* p, const char* end) {
+  int32_t index = 0;
+  int32_t code_point;
+  CBU8_NEXT(reinterpret_cast<const uint8_t*>(p), index,
+            static_cast<int32_t>(end - p), code_point);
+  if (code_point < 0 || !IsValidCharacter(code_point))
+    return nullptr;
+  return p + index;
+}
+
+void AppendCodePoint(uint32_t code_point, std::string* out) {
+  char units[4];
+  int offset = 0;
+  CBU8_APPEND_UNSAFE(units, offset, code_point);
+  out->append(units, offset);
+}
+
+}  // namespace
+
+JSONSaxReader::JSONSaxReader(int options)
+    : options_(options),
+      start_pos_(nullptr),
+      pos_(nullptr),
+      end_pos_(nullptr),
+      error_code_(JSONReader::JSON_NO_ERROR),
+      error_line_(0),
+      error_column_(0) {}
+
+JSONSaxReader::~JSONSaxReader() {}
+
+bool JSONSaxReader::Parse(const StringPiece& input, JSONSaxHandler* handler) {
+  start_pos_ = input.data();
+  pos_ = start_pos_;
+  end_pos_ = start_pos_ + input.length();
+  stack_.clear();
+  error_code_ = JSONReader::JSON_NO_ERROR;
+  error_line_ = 0;
+  error_column_ = 0;
+
+  // Skip a UTF-8 byte order mark, as JSONParser does.
+  if (input.starts_with("\xEF\xBB\xBF"))
+    pos_ += 3;
+
+  if (!EatWhitespaceAndComments())
+    return false;
+  if (!ParseValue(handler))
+    return false;
+
+  // Values inside containers go through this loop, so that nesting does not
+  // recurse. |opened| is set right after a container starts and |after_comma|
+  // right after a separator.
+  bool opened = !stack_.empty();
+  bool after_comma = false;
+  while (!stack_.empty()) {
+    if (!EatWhitespaceAndComments())
+      return false;
+    if (pos_ == end_pos_) {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+      return false;
+    }
+
+    const bool in_dictionary = stack_.back();
+    if (*pos_ == (in_dictionary ? '}' : ']')) {
+      if (after_comma && !(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
+        ReportError(JSONReader::JSON_TRAILING_COMMA, pos_);
+        return false;
+      }
+      ++pos_;
+      stack_.pop_back();
+      if (!(in_dictionary ? handler->OnEndDictionary() : handler->OnEndList()))
+        return false;
+      opened = false;
+      after_comma = false;
+      continue;
+    }
+
+    if (!opened && !after_comma) {
+      if (*pos_ != ',') {
+        ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+        return false;
+      }
+      ++pos_;
+      after_comma = true;
+      continue;
+    }
+
+    if (in_dictionary) {
+      if (*pos_ != '"') {
+        ReportError(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY, pos_);
+        return false;
+      }
+      StringPiece key;
+      bool in_input;
+      if (!ParseString(&key, &in_input))
+        return false;
+      if (!handler->OnKey(key, in_input))
+        return false;
+      if (!EatWhitespaceAndComments())
+        return false;
+      if (pos_ == end_pos_ || *pos_ != ':') {
+        ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+        return false;
+      }
+      ++pos_;
+      if (!EatWhitespaceAndComments())
+        return false;
+    }
+
+    size_t depth = stack_.size();
+    if (!ParseValue(handler))
+      return false;
+    opened = stack_.size() > depth;
+    after_comma = false;
+  }
+
+  if (!EatWhitespaceAndComments())
+    return false;
+  if (pos_ != end_pos_) {
+    ReportError(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, pos_);
+    return false;
+  }
+  return true;
+}
+
+std::string JSONSaxReader::GetErrorMessage() const {
+  if (error_code_ == JSONReader::JSON_NO_ERROR)
+    return std::string();
+  return StringPrintf("Line: %i, column: %i, %s", error_line_, error_column_,
+                      JSONReader::ErrorCodeToString(error_code_).c_str());
+}
+
+bool JSONSaxReader::EatWhitespaceAndComments() {
+  while (pos_ < end_pos_) {
+    switch (*pos_) {
+      case ' ':
+      case '\t':
+      case '\r':
+      case '\n':
+        ++pos_;
+        break;
+      case '/': {
+        const char* comment_start = pos_;
+        if (end_pos_ - pos_ >= 2 && pos_[1] == '/') {
+          pos_ = std::find(pos_ + 2, end_pos_, '\n');
+        } else if (end_pos_ - pos_ >= 2 && pos_[1] == '*') {
+          const char kEnd[] = "*/";
+          const char* end = std::search(pos_ + 2, end_pos_, kEnd, kEnd + 2);
+          if (end == end_pos_) {
+            ReportError(JSONReader::JSON_SYNTAX_ERROR, comment_start);
+            return false;
+          }
+          pos_ = end + 2;
+        } else {
+          ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, comment_start);
+          return false;
+        }
+        break;
+      }
+      default:
+        return true;
+    }
+  }
+  return true;
+}
+
+bool JSONSaxReader::ParseValue(JSONSaxHandler* handler) {
+  if (pos_ == end_pos_) {
+    ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, pos_);
+    return false;
+  }
+
+  switch (*pos_) {
+    case '{':
+    case '[': {
+      if (stack_.size() >= kStackMaxDepth) {
+        ReportError(JSONReader::JSON_TOO_MUCH_NESTING, pos_);
+        return false;
+      }
+      bool is_dictionary = *pos_ == '{';
+      ++pos_;
+      stack_.push_back(is_dictionary);
+      return is_dictionary ? handler->OnStartDictionary()
+                           : handler->OnStartList();
+    }
+    case '"': {
+      StringPiece value;
+      bool in_input;
+      return ParseString(&value, &in_input) &&
+             handler->OnString(value, in_input);
+    }
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+      return ParseNumber(handler);
+    case 't':
+    case 'f':
+    case 'n':
+      return ParseLiteral(handler);
+    default:
+      ReportError(JSONReader::JSON_UNEXPECTED_TOKEN, pos_);
+      return false;
+  }
+}
+
+bool JSONSaxReader::ParseString(StringPiece* out, bool* in_input) {
+  DCHECK_EQ('"', *pos_);
+  const char* start = pos_ + 1;
+  const char* p = start;
+  while (true) {
+    p = SkipPlainRun(p, end_pos_);
+    if (p == end_pos_) {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, p);
+      return false;
+    }
+    if (*p == '"') {
+      *out = StringPiece(start, p - start);
+      *in_input = true;
+      pos_ = p + 1;
+      return true;
+    }
+    if (*p == '\\') {
+      pos_ = p;
+      *in_input = false;
+      return ParseEscapedString(start, out);
+    }
+    const char* next = SkipUTF8Character(p, end_pos_);
+    if (!next) {
+      ReportError(JSONReader::JSON_UNSUPPORTED_ENCODING, p);
+      return false;
+    }
+    p = next;
+  }
+}
+
+bool JSONSaxReader::ParseEscapedString(const char* start, StringPiece* out) {
+  scratch_.assign(start, pos_ - start);
+  while (true) {
+    const char* run_end = SkipPlainRun(pos_, end_pos_);
+    scratch_.append(pos_, run_end - pos_);
+    pos_ = run_end;
+    if (pos_ == end_pos_) {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+      return false;
+    }
+
+    if (*pos_ == '"') {
+      ++pos_;
+      *out = StringPiece(scratch_);
+      return true;
+    }
+
+    if (*pos_ != '\\') {
+      const char* next = SkipUTF8Character(pos_, end_pos_);
+      if (!next) {
+        ReportError(JSONReader::JSON_UNSUPPORTED_ENCODING, pos_);
+        return false;
+      }
+      scratch_.append(pos_, next - pos_);
+      pos_ = next;
+      continue;
+    }
+
+    const char* escape = pos_;
+    if (end_pos_ - pos_ < 2) {
+      ReportError(JSONReader::JSON_INVALID_ESCAPE, escape);
+      return false;
+    }
+    pos_ += 2;
+    switch (escape[1]) {
+      case 'x': {
+        // Not in the spec; accepted for compatibility with JSONParser.
+        int hex_digit = 0;
+        if (end_pos_ - pos_ < 2 ||
+            !HexStringToInt(StringPiece(pos_, 2), &hex_digit)) {
+          ReportError(JSONReader::JSON_INVALID_ESCAPE, escape);
+          return false;
+        }
+        pos_ += 2;
+        AppendCodePoint(hex_digit, &scratch_);
+        break;
+      }
+      case 'u':
+        if (!DecodeUTF16Escape()) {
+          ReportError(JSONReader::JSON_INVALID_ESCAPE, escape);
+          return false;
+        }
+        break;
+      case '"':
+        scratch_.push_back('"');
+        break;
+      case '\\':
+        scratch_.push_back('\\');
+        break;
+      case '/':
+        scratch_.push_back('/');
+        break;
+      case 'b':
+        scratch_.push_back('\b');
+        break;
+      case 'f':
+        scratch_.push_back('\f');
+        break;
+      case 'n':
+        scratch_.push_back('\n');
+        break;
+      case 'r':
+        scratch_.push_back('\r');
+        break;
+      case 't':
+        scratch_.push_back('\t');
+        break;
+      case 'v':  // Not listed as valid escape sequence in the RFC.
+        scratch_.push_back('\v');
+        break;
+      default:
+        ReportError(JSONReader::JSON_INVALID_ESCAPE, escape);
+        return false;
+    }
+  }
+}
+
+bool JSONSaxReader::DecodeUTF16Escape() {
+  int high = 0;
+  if (end_pos_ - pos_ < 4 || !HexStringToInt(StringPiece(pos_, 4), &high))
+    return false;
+  pos_ += 4;
+
+  if (!CBU16_IS_SURROGATE(high)) {
+    if (!IsValidCharacter(high))
+      return false;
+    AppendCodePoint(high, &scratch_);
+    return true;
+  }
+
+  // A high surrogate must be followed by an escaped low surrogate.
+  if (!CBU16_IS_SURROGATE_LEAD(high))
+    return false;
+  int low = 0;
+  if (end_pos_ - pos_ < 6 || pos_[0] != '\\' || pos_[1] != 'u' ||
+      !HexStringToInt(StringPiece(pos_ + 2, 4), &low) ||
+      !CBU16_IS_TRAIL(low)) {
+    return false;
+  }
+  pos_ += 6;
+
+  uint32_t code_point = CBU16_GET_SUPPLEMENTARY(high, low);
+  if (!IsValidCharacter(code_point))
+    return false;
+  AppendCodePoint(code_point, &scratch_);
+  return true;
+}
+
+bool JSONSaxReader::ParseNumber(JSONSaxHandler* handler) {
+  const char* num_start = pos_;
+
+  // Consumes a run of digits. Returns false if there is none, or if
+  // |allow_leading_zeros| is false and the run has a redundant leading zero.
+  auto read_int = [this](bool allow_leading_zeros) {
+    const char* first = pos_;
+    while (pos_ < end_pos_ && IsAsciiDigit(*pos_))
+      ++pos_;
+    if (pos_ == first)
+      return false;
+    return allow_leading_zeros || pos_ - first == 1 || *first != '0';
+  };
+
+  if (*pos_ == '-')
+    ++pos_;
+  if (!read_int(false)) {
+    ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+    return false;
+  }
+  if (pos_ < end_pos_ && *pos_ == '.') {
+    ++pos_;
+    if (!read_int(true)) {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+      return false;
+    }
+  }
+  if (pos_ < end_pos_ && (*pos_ == 'e' || *pos_ == 'E')) {
+    ++pos_;
+    if (pos_ < end_pos_ && (*pos_ == '-' || *pos_ == '+'))
+      ++pos_;
+    if (!read_int(true)) {
+      ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+      return false;
+    }
+  }
+
+  StringPiece num_string(num_start, pos_ - num_start);
+  int num_int;
+  if (StringToInt(num_string, &num_int))
+    return handler->OnInteger(num_int);
+
+  double num_double;
+  if (StringToDouble(num_string.as_string(), &num_double) &&
+      std::isfinite(num_double)) {
+    return handler->OnDouble(num_double);
+  }
+
+  ReportError(JSONReader::JSON_SYNTAX_ERROR, num_start);
+  return false;
+}
+
+bool JSONSaxReader::ParseLiteral(JSONSaxHandler* handler) {
+  StringPiece rest(pos_, end_pos_ - pos_);
+  if (rest.starts_with("true")) {
+    pos_ += 4;
+    return handler->OnBoolean(true);
+  }
+  if (rest.starts_with("false")) {
+    pos_ += 5;
+    return handler->OnBoolean(false);
+  }
+  if (rest.starts_with("null")) {
+    pos_ += 4;
+    return handler->OnNull();
+  }
+  ReportError(JSONReader::JSON_SYNTAX_ERROR, pos_);
+  return false;
+}
+
+void JSONSaxReader::ReportError(JSONReader::JsonParseError code,
+                                const char* error_pos) {
+  error_code_ = code;
+  error_line_ = 1;
+  const char* line_start = start_pos_;
+  for (const char* p = start_pos_; p < error_pos; ++p) {
+    if (*p == '\n') {
+      ++error_line_;
+      line_start = p + 1;
+    }
+  }
+  error_column_ = static_cast<int>(error_pos - line_start) + 1;
+}
+
+}  // namespace base
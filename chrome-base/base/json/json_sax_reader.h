@@ -0,0 +1,136 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_SAX_READER_H_
+#define BASE_JSON_JSON_SAX_READER_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/json/json_reader.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+// Receives the tokens of a JSON document from JSONSaxReader, in document
+// order. Every method returns true to continue or false to stop parsing.
+//
+// String and key pieces point into the parsed input whenever the string
+// contains no escape sequence, so they stay valid as long as the input does.
+// Otherwise they point into a scratch buffer of the reader that is only valid
+// for the duration of the call; |in_input| tells the two cases apart.
+class BASE_EXPORT JSONSaxHandler {
+ public:
+  virtual ~JSONSaxHandler() {}
+
+  virtual bool OnNull() = 0;
+  virtual bool OnBoolean(bool value) = 0;
+  // Numbers that fit an int are reported as integers, others as doubles, the
+  // same way JSONReader creates FundamentalValues.
+  virtual bool OnInteger(int value) = 0;
+  virtual bool OnDouble(double value) = 0;
+  virtual bool OnString(const StringPiece& value, bool in_input) = 0;
+
+  virtual bool OnStartDictionary() = 0;
+  virtual bool OnKey(const StringPiece& key, bool in_input) = 0;
+  virtual bool OnEndDictionary() = 0;
+
+  virtual bool OnStartList() = 0;
+  virtual bool OnEndList() = 0;
+};
+
+// JSONSaxReader is an event-driven alternative to JSONReader for inputs that
+// are consumed once, such as request envelopes: it builds no Value tree and
+// copies no string that does not contain escape sequences. Strings without
+// escapes or non-ASCII characters are scanned eight bytes at a time, so large
+// payloads like base64 blobs are skipped at close to memory speed and can be
+// handed to their consumer straight from the input.
+//
+// The accepted grammar, including comments, the \x and \v escapes and the
+// JSON_ALLOW_TRAILING_COMMAS option, is the same as JSONReader's.
+//
+// Usage:
+//
+//   class RequestHandler : public JSONSaxHandler { ... };
+//
+//   RequestHandler handler;
+//   JSONSaxReader reader(JSON_PARSE_RFC);
+//   if (!reader.Parse(request_body, &handler))
+//     LOG(ERROR) << reader.GetErrorMessage();
+//
+// A reader may be reused for several documents; its scratch buffer is kept.
+class BASE_EXPORT JSONSaxReader {
+ public:
+  // |options| is a combination of JSONParserOptions. JSON_DETACHABLE_CHILDREN
+  // has no effect.
+  explicit JSONSaxReader(int options);
+  ~JSONSaxReader();
+
+  // Parses |input|, calling |handler| for each token. Returns true if the
+  // whole input is a valid JSON document. Returns false on a syntax error,
+  // or with error_code() JSON_NO_ERROR if |handler| stopped the parse.
+  bool Parse(const StringPiece& input, JSONSaxHandler* handler);
+
+  JSONReader::JsonParseError error_code() const { return error_code_; }
+
+  // Returns a human-readable message with the line and column of the error,
+  // as JSONReader does.
+  std::string GetErrorMessage() const;
+
+  int error_line() const { return error_line_; }
+  int error_column() const { return error_column_; }
+
+ private:
+  // Skips whitespace and comments. Returns false on a malformed comment.
+  bool EatWhitespaceAndComments();
+
+  // Parses one value starting at |pos_|, which has been wound past leading
+  // whitespace. Containers are opened here and closed by Parse().
+  bool ParseValue(JSONSaxHandler* handler);
+
+  // Parses the string starting at the '"' at |pos_|. On success sets |out| and
+  // |in_input| as described in JSONSaxHandler and leaves |pos_| after the
+  // closing quote.
+  bool ParseString(StringPiece* out, bool* in_input);
+
+  // Decodes the rest of a string that contains an escape sequence into
+  // |scratch_|, starting at the backslash at |pos_|.
+  bool ParseEscapedString(const char* start, StringPiece* out);
+
+  // Decodes the four hex digits at |pos_| (and a following low surrogate, if
+  // needed) and appends the UTF-8 result to |scratch_|.
+  bool DecodeUTF16Escape();
+
+  bool ParseNumber(JSONSaxHandler* handler);
+  bool ParseLiteral(JSONSaxHandler* handler);
+
+  // Records |code| at |error_pos|.
+  void ReportError(JSONReader::JsonParseError code, const char* error_pos);
+
+  const int options_;
+
+  const char* start_pos_;
+  const char* pos_;
+  const char* end_pos_;
+
+  // One entry per open container: true for dictionaries, false for lists.
+  std::vector<bool> stack_;
+
+  // Holds the decoded contents of strings that contain escape sequences.
+  std::string scratch_;
+
+  JSONReader::JsonParseError error_code_;
+  int error_line_;
+  int error_column_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONSaxReader);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_SAX_READER_H_
@@ -0,0 +1,258 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_sax_reader.h"
+
+#include <stddef.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Records the events as a compact string, e.g. "{ k:a s:b }".
+class RecordingHandler : public JSONSaxHandler {
+ public:
+  RecordingHandler() : stop_after_(-1), string_in_input_(false) {}
+
+  bool OnNull() override { return Record("null"); }
+  bool OnBoolean(bool value) override {
+    return Record(value ? "true" : "false");
+  }
+  bool OnInteger(int value) override {
+    return Record("i:" + IntToString(value));
+  }
+  bool OnDouble(double value) override {
+    return Record("d:" + DoubleToString(value));
+  }
+  bool OnString(const StringPiece& value, bool in_input) override {
+    last_string_ = value;
+    string_in_input_ = in_input;
+    return Record("s:" + value.as_string());
+  }
+  bool OnStartDictionary() override { return Record("{"); }
+  bool OnKey(const StringPiece& key, bool in_input) override {
+    return Record("k:" + key.as_string());
+  }
+  bool OnEndDictionary() override { return Record("}"); }
+  bool OnStartList() override { return Record("["); }
+  bool OnEndList() override { return Record("]"); }
+
+  const std::string& events() const { return events_; }
+  void set_stop_after(int count) { stop_after_ = count; }
+  StringPiece last_string() const { return last_string_; }
+  bool string_in_input() const { return string_in_input_; }
+
+ private:
+  bool Record(const std::string& event) {
+    if (!events_.empty())
+      events_.push_back(' ');
+    events_.append(event);
+    return stop_after_ < 0 || --stop_after_ > 0;
+  }
+
+  std::string events_;
+  int stop_after_;
+  StringPiece last_string_;
+  bool string_in_input_;
+};
+
+// Builds a Value tree, to compare the reader against JSONReader.
+class ValueBuildingHandler : public JSONSaxHandler {
+ public:
+  bool OnNull() override { return Add(Value::CreateNullValue()); }
+  bool OnBoolean(bool value) override {
+    return Add(make_scoped_ptr(new FundamentalValue(value)));
+  }
+  bool OnInteger(int value) override {
+    return Add(make_scoped_ptr(new FundamentalValue(value)));
+  }
+  bool OnDouble(double value) override {
+    return Add(make_scoped_ptr(new FundamentalValue(value)));
+  }
+  bool OnString(const StringPiece& value, bool in_input) override {
+    return Add(make_scoped_ptr(new StringValue(value.as_string())));
+  }
+  bool OnStartDictionary() override {
+    DictionaryValue* dictionary = new DictionaryValue;
+    Add(make_scoped_ptr(dictionary));
+    containers_.push_back(dictionary);
+    return true;
+  }
+  bool OnKey(const StringPiece& key, bool in_input) override {
+    key_ = key.as_string();
+    return true;
+  }
+  bool OnEndDictionary() override {
+    containers_.pop_back();
+    return true;
+  }
+  bool OnStartList() override {
+    ListValue* list = new ListValue;
+    Add(make_scoped_ptr(list));
+    containers_.push_back(list);
+    return true;
+  }
+  bool OnEndList() override {
+    containers_.pop_back();
+    return true;
+  }
+
+  scoped_ptr<Value> TakeRoot() { return std::move(root_); }
+
+ private:
+  bool Add(scoped_ptr<Value> value) {
+    if (containers_.empty()) {
+      root_ = std::move(value);
+    } else if (containers_.back()->IsType(Value::TYPE_LIST)) {
+      static_cast<ListValue*>(containers_.back())->Append(std::move(value));
+    } else {
+      static_cast<DictionaryValue*>(containers_.back())
+          ->SetWithoutPathExpansion(key_, std::move(value));
+    }
+    return true;
+  }
+
+  scoped_ptr<Value> root_;
+  std::vector<Value*> containers_;
+  std::string key_;
+};
+
+}  // namespace
+
+TEST(JSONSaxReaderTest, ReportsTokensInOrder) {
+  RecordingHandler handler;
+  JSONSaxReader reader(JSON_PARSE_RFC);
+  ASSERT_TRUE(reader.Parse(
+      "{\"a\": [1, -2.5, true, false, null], \"b\": {}, \"c\": \"x\"}",
+      &handler));
+  EXPECT_EQ("{ k:a [ i:1 d:-2.5 true false null ] k:b { } k:c s:x }",
+            handler.events());
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, reader.error_code());
+}
+
+TEST(JSONSaxReaderTest, PlainStringsPointIntoInput) {
+  // A base64 payload long enough to exercise the word-at-a-time scan, with a
+  // non-ASCII character near the end.
+  std::string audio(100000, 'A');
+  audio.replace(99990, 1, "\xC3\xA9");
+  std::string input = "{\"audio\": \"" + audio + "\"}";
+
+  RecordingHandler handler;
+  JSONSaxReader reader(JSON_PARSE_RFC);
+  ASSERT_TRUE(reader.Parse(input, &handler));
+  EXPECT_TRUE(handler.string_in_input());
+  EXPECT_EQ(input.data() + 11, handler.last_string().data());
+  EXPECT_EQ(audio, handler.last_string().as_string());
+}
+
+TEST(JSONSaxReaderTest, EscapedStringsAreDecoded) {
+  RecordingHandler handler;
+  JSONSaxReader reader(JSON_PARSE_RFC);
+  ASSERT_TRUE(reader.Parse(
+      "[\"a\\\"b\\\\c\\/d\\n\\u00e9\\ud83d\\ude00\\x41 tail\"]", &handler));
+  EXPECT_FALSE(handler.string_in_input());
+  EXPECT_EQ("a\"b\\c/d\n\xC3\xA9\xF0\x9F\x98\x80" "A tail",
+            handler.last_string().as_string());
+}
+
+TEST(JSONSaxReaderTest, MatchesJSONReader) {
+  const char* const kInputs[] = {
+      "{\"number\": 9.87654321, \"null\": null, \"\\x53\": \"str\"}",
+      "[[[[[]]]], {\"a\": {\"b\": [1, 2, {\"c\": -0}]}}]",
+      "  /* comment */ {\"int\": 2147483647, \"big\": 2147483648} // end\n",
+      "\xEF\xBB\xBF{\"bom\": 1e-3, \"exp\": 6.02E23}",
+      "\"\\u00e9 caf\xC3\xA9\"",
+      "{\"dup\": 1, \"dup\": 2}",
+  };
+  for (size_t i = 0; i < arraysize(kInputs); ++i) {
+    SCOPED_TRACE(kInputs[i]);
+    ValueBuildingHandler handler;
+    JSONSaxReader reader(JSON_PARSE_RFC);
+    ASSERT_TRUE(reader.Parse(kInputs[i], &handler));
+    scoped_ptr<Value> expected = JSONReader::Read(kInputs[i]);
+    ASSERT_TRUE(expected);
+    scoped_ptr<Value> actual = handler.TakeRoot();
+    ASSERT_TRUE(actual);
+    EXPECT_TRUE(expected->Equals(actual.get()));
+  }
+}
+
+TEST(JSONSaxReaderTest, Errors) {
+  struct {
+    const char* input;
+    int options;
+    JSONReader::JsonParseError error;
+  } const kCases[] = {
+      {"", JSON_PARSE_RFC, JSONReader::JSON_UNEXPECTED_TOKEN},
+      {"[1,]", JSON_PARSE_RFC, JSONReader::JSON_TRAILING_COMMA},
+      {"{a: 1}", JSON_PARSE_RFC, JSONReader::JSON_UNQUOTED_DICTIONARY_KEY},
+      {"[1] 2", JSON_PARSE_RFC, JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT},
+      {"[1 2]", JSON_PARSE_RFC, JSONReader::JSON_SYNTAX_ERROR},
+      {"{\"a\" 1}", JSON_PARSE_RFC, JSONReader::JSON_SYNTAX_ERROR},
+      {"[\"open", JSON_PARSE_RFC, JSONReader::JSON_SYNTAX_ERROR},
+      {"[01]", JSON_PARSE_RFC, JSONReader::JSON_SYNTAX_ERROR},
+      {"[tru]", JSON_PARSE_RFC, JSONReader::JSON_SYNTAX_ERROR},
+      {"[\"\\q\"]", JSON_PARSE_RFC, JSONReader::JSON_INVALID_ESCAPE},
+      {"[\"\\ud83d\"]", JSON_PARSE_RFC, JSONReader::JSON_INVALID_ESCAPE},
+      {"[\"\xC3\"]", JSON_PARSE_RFC, JSONReader::JSON_UNSUPPORTED_ENCODING},
+      {"[\"\xEF\xBF\xBF\"]", JSON_PARSE_RFC,
+       JSONReader::JSON_UNSUPPORTED_ENCODING},
+  };
+  for (size_t i = 0; i < arraysize(kCases); ++i) {
+    SCOPED_TRACE(kCases[i].input);
+    RecordingHandler handler;
+    JSONSaxReader reader(kCases[i].options);
+    EXPECT_FALSE(reader.Parse(kCases[i].input, &handler));
+    EXPECT_EQ(kCases[i].error, reader.error_code());
+    EXPECT_FALSE(reader.GetErrorMessage().empty());
+  }
+
+  RecordingHandler handler;
+  JSONSaxReader reader(JSON_ALLOW_TRAILING_COMMAS);
+  EXPECT_TRUE(reader.Parse("{\"a\": [1, 2,],}", &handler));
+}
+
+TEST(JSONSaxReaderTest, ErrorPosition) {
+  RecordingHandler handler;
+  JSONSaxReader reader(JSON_PARSE_RFC);
+  EXPECT_FALSE(reader.Parse("{\n  \"a\": 1,\n  \"b\" 2\n}", &handler));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, reader.error_code());
+  EXPECT_EQ(3, reader.error_line());
+  EXPECT_EQ(7, reader.error_column());
+  EXPECT_EQ("Line: 3, column: 7, Syntax error.", reader.GetErrorMessage());
+}
+
+TEST(JSONSaxReaderTest, TooMuchNesting) {
+  std::string nested(100, '[');
+  nested.append(100, ']');
+  RecordingHandler handler;
+  JSONSaxReader reader(JSON_PARSE_RFC);
+  EXPECT_TRUE(reader.Parse(nested, &handler));
+
+  nested.insert(0, "[");
+  nested.append("]");
+  EXPECT_FALSE(reader.Parse(nested, &handler));
+  EXPECT_EQ(JSONReader::JSON_TOO_MUCH_NESTING, reader.error_code());
+}
+
+TEST(JSONSaxReaderTest, HandlerCanStopParsing) {
+  RecordingHandler handler;
+  handler.set_stop_after(3);
+  JSONSaxReader reader(JSON_PARSE_RFC);
+  EXPECT_FALSE(reader.Parse("{\"a\": 1, \"b\": 2}", &handler));
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, reader.error_code());
+  EXPECT_EQ("{ k:a i:1", handler.events());
+}
+
+}  // namespace base
@@ -0,0 +1,384 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_writer.h"
+
+#include <string.h>
+
+#include <cmath>
+#include <limits>
+
+#include "base/logging.h"
+#include "base/strings/utf_string_conversion_utils.h"
+#include "base/third_party/dmg_fp/dmg_fp.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__SSE2__)
+#include <emmintrin.h>
+#define JSON_STREAM_WRITER_USE_SSE2 1
+#endif
+
+namespace base {
+
+namespace {
+
+const uint64_t kOnes = 0x0101010101010101ULL;
+const uint64_t kHighBits = 0x8080808080808080ULL;
+
+// Returns whether |c| cannot be copied to the output as is: quotes,
+// backslashes, control characters, '<' (escaped like EscapeJSONString() does)
+// and the bytes of non-ASCII characters, which must be validated.
+inline bool NeedsEscaping(unsigned char c) {
+  return c < 0x20 || c == '"' || c == '\\' || c == '<' || c >= 0x80;
+}
+
+// Returns whether any of the eight bytes in |v| NeedsEscaping(). False
+// positives are harmless.
+inline bool HasByteNeedingEscaping(uint64_t v) {
+  uint64_t quote = v ^ (kOnes * '"');
+  uint64_t backslash = v ^ (kOnes * '\\');
+  uint64_t less = v ^ (kOnes * '<');
+  uint64_t zero_byte = ((quote - kOnes) & ~quote) |
+                       ((backslash - kOnes) & ~backslash) |
+                       ((less - kOnes) & ~less);
+  uint64_t below_space = (v - kOnes * 0x20) & ~v;
+  return (zero_byte | below_space | v) & kHighBits;
+}
+
+// Returns the first byte in [p, end) that NeedsEscaping(), or |end|.
+const char* FindByteNeedingEscaping(const char* p, const char* end) {
+#if defined(JSON_STREAM_WRITER_USE_SSE2)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i less = _mm_set1_epi8('<');
+  const __m128i space = _mm_set1_epi8(0x20);
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // The signed comparison with ' ' also catches bytes >= 0x80.
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, less), _mm_cmplt_epi8(v, space)));
+    if (_mm_movemask_epi8(special))
+      break;
+    p += 16;
+  }
+#endif
+  while (end - p >= 8) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    if (HasByteNeedingEscaping(v))
+      break;
+    p += 8;
+  }
+  while (p < end && !NeedsEscaping(static_cast<unsigned char>(*p)))
+    ++p;
+  return p;
+}
+
+void AppendEscapedASCII(unsigned char c, std::string* dest) {
+  static const char kHexDigits[] = "0123456789ABCDEF";
+  switch (c) {
+    case '\b':
+      dest->append("\\b");
+      break;
+    case '\f':
+      dest->append("\\f");
+      break;
+    case '\n':
+      dest->append("\\n");
+      break;
+    case '\r':
+      dest->append("\\r");
+      break;
+    case '\t':
+      dest->append("\\t");
+      break;
+    case '\\':
+      dest->append("\\\\");
+      break;
+    case '"':
+      dest->append("\\\"");
+      break;
+    case '<':
+      dest->append("\\u003C");
+      break;
+    default: {
+      DCHECK_LT(c, 0x20);
+      char escape[] = {'\\', 'u', '0', '0', kHexDigits[c >> 4],
+                       kHexDigits[c & 0xF]};
+      dest->append(escape, sizeof(escape));
+      break;
+    }
+  }
+}
+
+const double kPowersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+// 2^53: integers below this are exact in a double.
+const double kExactIntegerLimit = 9007199254740992.0;
+
+// Finds the shortest decimal for |value| (finite and positive) of the form
+// n / 10^k with n < 2^53 and k <= 9. Both n and 10^k are exact doubles, so
+// the IEEE division below is correctly rounded and equals what a reader
+// parsing "n e-k" gets; trying k in increasing order yields the shortest such
+// form. On success writes the significant digits to |digits| (at least 17
+// bytes) and returns their count, with the decimal point position in |decpt|
+// as dtoa() reports it. Returns 0 if there is no such form.
+int ShortDecimalDigits(double value, char* digits, int* decpt) {
+  for (size_t k = 0; k < arraysize(kPowersOf10); ++k) {
+    double scaled = value * kPowersOf10[k];
+    if (scaled >= kExactIntegerLimit)
+      return 0;
+    uint64_t n = static_cast<uint64_t>(scaled + 0.5);
+    if (n == 0 || static_cast<double>(n) / kPowersOf10[k] != value)
+      continue;
+
+    char reversed[20];
+    int length = 0;
+    for (; n; n /= 10)
+      reversed[length++] = static_cast<char>('0' + n % 10);
+    *decpt = length - static_cast<int>(k);
+    int first = 0;
+    while (reversed[first] == '0')
+      ++first;
+    int count = 0;
+    for (int i = length - 1; i >= first; --i)
+      digits[count++] = reversed[i];
+    return count;
+  }
+  return 0;
+}
+
+// Formats significant |digits| and |decpt| like dmg_fp::g_fmt(), with the
+// adjustments JSONWriter makes: a leading "0" before a decimal point and a
+// ".0" suffix for integers.
+void AppendFormattedDouble(bool negative,
+                           const char* digits,
+                           int count,
+                           int decpt,
+                           std::string* dest) {
+  if (negative)
+    dest->push_back('-');
+
+  if (decpt <= -4 || decpt > count + 5) {
+    dest->push_back(digits[0]);
+    if (count > 1) {
+      dest->push_back('.');
+      dest->append(digits + 1, count - 1);
+    }
+    dest->push_back('e');
+    int exponent = decpt - 1;
+    if (exponent < 0) {
+      dest->push_back('-');
+      exponent = -exponent;
+    } else {
+      dest->push_back('+');
+    }
+    if (exponent < 10)
+      dest->push_back('0');
+    char reversed[8];
+    int length = 0;
+    for (; exponent; exponent /= 10)
+      reversed[length++] = static_cast<char>('0' + exponent % 10);
+    while (length)
+      dest->push_back(reversed[--length]);
+  } else if (decpt <= 0) {
+    dest->append("0.");
+    dest->append(-decpt, '0');
+    dest->append(digits, count);
+  } else if (decpt < count) {
+    dest->append(digits, decpt);
+    dest->push_back('.');
+    dest->append(digits + decpt, count - decpt);
+  } else {
+    dest->append(digits, count);
+    dest->append(decpt - count, '0');
+    dest->append(".0");
+  }
+}
+
+}  // namespace
+
+JSONStreamWriter::JSONStreamWriter(std::string* buffer)
+    : buffer_(buffer),
+      need_comma_(false),
+      after_key_(false),
+      has_root_(false),
+      ok_(true) {
+  DCHECK(buffer_);
+}
+
+JSONStreamWriter::~JSONStreamWriter() {}
+
+void JSONStreamWriter::BeginDictionary() {
+  BeforeValue();
+  buffer_->push_back('{');
+  stack_.push_back('{');
+  need_comma_ = false;
+}
+
+void JSONStreamWriter::EndDictionary() {
+  DCHECK(!stack_.empty() && stack_.back() == '{');
+  DCHECK(!after_key_);
+  stack_.pop_back();
+  buffer_->push_back('}');
+  need_comma_ = true;
+}
+
+void JSONStreamWriter::BeginList() {
+  BeforeValue();
+  buffer_->push_back('[');
+  stack_.push_back('[');
+  need_comma_ = false;
+}
+
+void JSONStreamWriter::EndList() {
+  DCHECK(!stack_.empty() && stack_.back() == '[');
+  stack_.pop_back();
+  buffer_->push_back(']');
+  need_comma_ = true;
+}
+
+void JSONStreamWriter::Key(const StringPiece& key) {
+  DCHECK(!stack_.empty() && stack_.back() == '{');
+  DCHECK(!after_key_);
+  if (need_comma_)
+    buffer_->push_back(',');
+  if (!AppendQuotedString(key, buffer_))
+    ok_ = false;
+  buffer_->push_back(':');
+  need_comma_ = true;
+  after_key_ = true;
+}
+
+void JSONStreamWriter::Null() {
+  BeforeValue();
+  buffer_->append("null");
+}
+
+void JSONStreamWriter::Boolean(bool value) {
+  BeforeValue();
+  buffer_->append(value ? "true" : "false");
+}
+
+void JSONStreamWriter::Integer(int64_t value) {
+  BeforeValue();
+  uint64_t magnitude = static_cast<uint64_t>(value);
+  if (value < 0) {
+    buffer_->push_back('-');
+    magnitude = 0 - magnitude;
+  }
+  char reversed[20];
+  int length = 0;
+  do {
+    reversed[length++] = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude);
+  while (length)
+    buffer_->push_back(reversed[--length]);
+}
+
+void JSONStreamWriter::Double(double value) {
+  BeforeValue();
+  AppendDouble(value, buffer_);
+}
+
+void JSONStreamWriter::String(const StringPiece& value) {
+  BeforeValue();
+  if (!AppendQuotedString(value, buffer_))
+    ok_ = false;
+}
+
+bool JSONStreamWriter::IsComplete() const {
+  return has_root_ && stack_.empty();
+}
+
+// static
+bool JSONStreamWriter::AppendQuotedString(const StringPiece& str,
+                                          std::string* dest) {
+  CHECK_LE(str.length(),
+           static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+  bool did_replacement = false;
+  const char* const begin = str.data();
+  const char* const end = begin + str.length();
+
+  dest->push_back('"');
+  const char* p = begin;
+  while (p < end) {
+    const char* run_end = FindByteNeedingEscaping(p, end);
+    dest->append(p, run_end - p);
+    p = run_end;
+    if (p == end)
+      break;
+
+    unsigned char c = static_cast<unsigned char>(*p);
+    if (c < 0x80) {
+      AppendEscapedASCII(c, dest);
+      ++p;
+      continue;
+    }
+
+    // Decode exactly like EscapeJSONString() so that invalid sequences are
+    // replaced the same way.
+    int32_t index = static_cast<int32_t>(p - begin);
+    uint32_t code_point;
+    if (!ReadUnicodeCharacter(begin, static_cast<int32_t>(str.length()),
+                              &index, &code_point)) {
+      code_point = 0xFFFD;
+      did_replacement = true;
+    }
+    if (code_point == 0x2028)
+      dest->append("\\u2028");
+    else if (code_point == 0x2029)
+      dest->append("\\u2029");
+    else
+      WriteUnicodeCharacter(code_point, dest);
+    p = begin + index + 1;
+  }
+  dest->push_back('"');
+  return !did_replacement;
+}
+
+// static
+void JSONStreamWriter::AppendDouble(double value, std::string* dest) {
+  if (!std::isfinite(value)) {
+    // JSON cannot represent these.
+    dest->append("null");
+    return;
+  }
+  const bool negative = std::signbit(value);
+  if (value == 0) {
+    AppendFormattedDouble(negative, "0", 1, 1, dest);
+    return;
+  }
+
+  char digits[20];
+  int decpt;
+  int count = ShortDecimalDigits(std::fabs(value), digits, &decpt);
+  if (count) {
+    AppendFormattedDouble(negative, digits, count, decpt, dest);
+    return;
+  }
+
+  int sign;
+  char* end;
+  char* dtoa_digits = dmg_fp::dtoa(value, 0, 0, &decpt, &sign, &end);
+  AppendFormattedDouble(negative, dtoa_digits,
+                        static_cast<int>(end - dtoa_digits), decpt, dest);
+  dmg_fp::freedtoa(dtoa_digits);
+}
+
+void JSONStreamWriter::BeforeValue() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  DCHECK(!stack_.empty() ? stack_.back() == '[' : !has_root_);
+  if (need_comma_)
+    buffer_->push_back(',');
+  need_comma_ = true;
+  has_root_ = true;
+}
+
+}  // namespace base
@@ -0,0 +1,110 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_STREAM_WRITER_H_
+#define BASE_JSON_JSON_STREAM_WRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+// JSONStreamWriter appends a JSON document to a caller-owned buffer as it is
+// described, without building a Value tree first. It is meant for hot paths
+// that serialize the same kind of document over and over: clearing a
+// std::string keeps its capacity, so a buffer that is reused for each
+// document stops allocating after the first few.
+//
+// The output is the same as JSONWriter's for the equivalent Value: strings
+// are escaped like EscapeJSONString() does, scanning 16 (SSE2) or 8 bytes at
+// a time for runs that need no escaping, and doubles are printed as the
+// shortest decimal that reads back to the same value, with a ".0" suffix for
+// integral values. Most doubles with up to nine decimal places are formatted
+// without going through dmg_fp. The one exception is NaN and infinity, which
+// JSON cannot represent: they are written as null, whereas a FundamentalValue
+// replaces them with 0.0 and JSONWriter writes that.
+//
+// Usage:
+//
+//   std::string buffer;  // Reused across requests.
+//   ...
+//   buffer.clear();
+//   JSONStreamWriter writer(&buffer);
+//   writer.BeginDictionary();
+//   writer.Key("text");
+//   writer.String(text);
+//   writer.Key("start");
+//   writer.Double(start_seconds);
+//   writer.EndDictionary();
+//
+// Keys and values must be written in a valid order; this is DCHECKed.
+class BASE_EXPORT JSONStreamWriter {
+ public:
+  // Appends to |buffer|, which must outlive the writer.
+  explicit JSONStreamWriter(std::string* buffer);
+  ~JSONStreamWriter();
+
+  void BeginDictionary();
+  void EndDictionary();
+  void BeginList();
+  void EndList();
+
+  // Starts a dictionary entry. Must be followed by exactly one value.
+  void Key(const StringPiece& key);
+
+  void Null();
+  void Boolean(bool value);
+  void Integer(int64_t value);
+  // NaN and infinity are written as null.
+  void Double(double value);
+  // Invalid UTF-8 in |value| is replaced with U+FFFD, as EscapeJSONString()
+  // does; in that case the writer is no longer ok().
+  void String(const StringPiece& value);
+
+  // Returns false if a string had to be altered.
+  bool ok() const { return ok_; }
+
+  // Returns whether a complete document has been written.
+  bool IsComplete() const;
+
+  // Appends |str|, escaped and in quotes, to |dest|. Returns false if invalid
+  // UTF-8 had to be replaced.
+  static bool AppendQuotedString(const StringPiece& str, std::string* dest);
+
+  // Appends |value| to |dest| in the format described above.
+  static void AppendDouble(double value, std::string* dest);
+
+ private:
+  // Writes the separator that precedes a value or key, if any.
+  void BeforeValue();
+
+  std::string* const buffer_;
+
+  // One entry per open container: '{' or '['.
+  std::vector<char> stack_;
+
+  // Whether the next element of the current container needs a comma.
+  bool need_comma_;
+
+  // Whether a key has been written and is waiting for its value.
+  bool after_key_;
+
+  // Whether any value has been written at the root.
+  bool has_root_;
+
+  bool ok_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONStreamWriter);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_STREAM_WRITER_H_
@@ -0,0 +1,184 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_writer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "base/json/json_writer.h"
+#include "base/json/string_escape.h"
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+std::string WriteDoubleWithJSONWriter(double value) {
+  std::string json;
+  EXPECT_TRUE(JSONWriter::Write(FundamentalValue(value), &json));
+  return json;
+}
+
+std::string WriteDouble(double value) {
+  std::string json;
+  JSONStreamWriter::AppendDouble(value, &json);
+  return json;
+}
+
+}  // namespace
+
+TEST(JSONStreamWriterTest, WritesDocument) {
+  std::string buffer;
+  JSONStreamWriter writer(&buffer);
+  writer.BeginDictionary();
+  writer.Key("text");
+  writer.String("hello");
+  writer.Key("tokens");
+  writer.BeginList();
+  writer.BeginDictionary();
+  writer.Key("start");
+  writer.Double(0.48);
+  writer.Key("end");
+  writer.Integer(-1234567890123LL);
+  writer.EndDictionary();
+  writer.Null();
+  writer.Boolean(true);
+  writer.BeginList();
+  writer.EndList();
+  writer.EndList();
+  writer.Key("empty");
+  writer.BeginDictionary();
+  writer.EndDictionary();
+  writer.EndDictionary();
+
+  EXPECT_TRUE(writer.IsComplete());
+  EXPECT_TRUE(writer.ok());
+  EXPECT_EQ(
+      "{\"text\":\"hello\",\"tokens\":[{\"start\":0.48,\"end\":-1234567890123},"
+      "null,true,[]],\"empty\":{}}",
+      buffer);
+}
+
+TEST(JSONStreamWriterTest, AppendsToReusedBuffer) {
+  std::string buffer("prefix ");
+  {
+    JSONStreamWriter writer(&buffer);
+    writer.Integer(std::numeric_limits<int64_t>::min());
+    EXPECT_TRUE(writer.IsComplete());
+  }
+  EXPECT_EQ("prefix -9223372036854775808", buffer);
+
+  buffer.clear();
+  size_t capacity = buffer.capacity();
+  JSONStreamWriter writer(&buffer);
+  EXPECT_FALSE(writer.IsComplete());
+  writer.BeginList();
+  EXPECT_FALSE(writer.IsComplete());
+  writer.Integer(0);
+  writer.EndList();
+  EXPECT_EQ("[0]", buffer);
+  EXPECT_EQ(capacity, buffer.capacity());
+}
+
+TEST(JSONStreamWriterTest, EscapesLikeEscapeJSONString) {
+  const char* const kStrings[] = {
+      "",
+      "plain ascii text that is long enough to use the wide scan",
+      "quote\" backslash\\ slash/ <script> \b\f\n\r\t \x01\x1F \x7F",
+      "caf\xC3\xA9 \xE2\x80\xA8 \xE2\x80\xA9 \xF0\x9F\x98\x80 long tail tail",
+      "invalid \xC3 \xFF \xED\xA0\x80 \xEF\xBF\xBF end",
+  };
+  for (size_t i = 0; i < arraysize(kStrings); ++i) {
+    SCOPED_TRACE(i);
+    std::string expected;
+    bool expected_ok = EscapeJSONString(kStrings[i], true, &expected);
+    std::string actual;
+    EXPECT_EQ(expected_ok,
+              JSONStreamWriter::AppendQuotedString(kStrings[i], &actual));
+    EXPECT_EQ(expected, actual);
+  }
+
+  // Random bytes, with every special byte at every offset of the wide scans.
+  for (int i = 0; i < 2000; ++i) {
+    std::string input = RandBytesAsString(RandInt(0, 64));
+    for (size_t j = 0; j < input.size(); ++j) {
+      if (input[j] & 0x40)
+        input[j] &= 0x7F;
+    }
+    std::string expected;
+    bool expected_ok = EscapeJSONString(input, true, &expected);
+    std::string actual;
+    ASSERT_EQ(expected_ok,
+              JSONStreamWriter::AppendQuotedString(input, &actual));
+    ASSERT_EQ(expected, actual);
+  }
+
+  std::string buffer;
+  JSONStreamWriter writer(&buffer);
+  writer.String("bad \xFF");
+  EXPECT_FALSE(writer.ok());
+}
+
+TEST(JSONStreamWriterTest, DoublesMatchJSONWriter) {
+  const double kValues[] = {
+      0.0,    -0.0,   1.0,        -1.0,   0.5,    0.48,  1.25,
+      1e-3,   1e-4,   1.5e-7,     123456.0, 1e21, 1e22,  1234567.125,
+      0.1,    0.2 + 0.1, 1.0 / 3.0, 2.0 / 3.0, 9007199254740991.0,
+      9007199254740993.0, 5e-324, 1.7976931348623157e308, 100.0, 1e15,
+      12.000001, 3.14159265358979,
+  };
+  for (size_t i = 0; i < arraysize(kValues); ++i) {
+    SCOPED_TRACE(kValues[i]);
+    EXPECT_EQ(WriteDoubleWithJSONWriter(kValues[i]), WriteDouble(kValues[i]));
+  }
+
+  // Timestamps with millisecond precision, the common case for results.
+  for (int ms = 0; ms < 100000; ms += 7) {
+    double seconds = ms / 1000.0;
+    ASSERT_EQ(WriteDoubleWithJSONWriter(seconds), WriteDouble(seconds));
+  }
+
+  // Arbitrary bit patterns must round-trip. StringToDouble() rejects
+  // subnormals, so they are skipped.
+  for (int i = 0; i < 10000; ++i) {
+    uint64_t bits = RandUint64();
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    if (!std::isnormal(value))
+      continue;
+    std::string written = WriteDouble(value);
+    ASSERT_EQ(WriteDoubleWithJSONWriter(value), written);
+    double read;
+    ASSERT_TRUE(StringToDouble(written, &read)) << written;
+    ASSERT_EQ(value, read) << written;
+  }
+}
+
+// Unlike JSONWriter, which only sees the 0.0 that FundamentalValue stores
+// instead, non-finite doubles are written as null.
+TEST(JSONStreamWriterTest, NonFiniteDoublesAreNull) {
+  EXPECT_EQ("null", WriteDouble(std::numeric_limits<double>::infinity()));
+  EXPECT_EQ("null", WriteDouble(-std::numeric_limits<double>::infinity()));
+  EXPECT_EQ("null", WriteDouble(std::numeric_limits<double>::quiet_NaN()));
+
+  std::string json;
+  JSONStreamWriter writer(&json);
+  writer.BeginList();
+  writer.Double(std::numeric_limits<double>::quiet_NaN());
+  writer.Double(1.5);
+  writer.EndList();
+  EXPECT_TRUE(writer.IsComplete());
+  EXPECT_EQ("[null,1.5]", json);
+}
+
+}  // namespace base
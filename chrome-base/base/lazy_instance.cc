@@ -7,6 +7,7 @@
 #include "base/at_exit.h"
 #include "base/atomicops.h"
 #include "base/threading/platform_thread.h"
+#include "base/trace_event/startup_timeline.h"
 
 namespace base {
 namespace internal {
@@ -44,6 +45,7 @@ void CompleteLazyInstance(subtle::AtomicWord* state,
   // Releases visibility over private_buf_ to readers. Pairing Acquire_Load's
   // are in NeedsInstance() and Pointer().
   subtle::Release_Store(state, new_instance);
+  trace_event::StartupTimeline::OnLazyInstanceCreated();
 
   // Make sure that the lazily instantiated object will get destroyed at exit.
   if (dtor)
@@ -0,0 +1,153 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/process/memory.h"
+
+namespace base {
+
+struct Arena::Block {
+  Block* next;
+  size_t size;  // Usable bytes after the header.
+
+  char* data() { return reinterpret_cast<char*>(this + 1); }
+};
+
+namespace {
+
+inline char* AlignUp(char* p, size_t alignment) {
+  uintptr_t value = reinterpret_cast<uintptr_t>(p);
+  return reinterpret_cast<char*>((value + alignment - 1) & ~(alignment - 1));
+}
+
+}  // namespace
+
+// static
+const size_t Arena::kDefaultBlockSize;
+
+Arena::Arena() : Arena(kDefaultBlockSize) {}
+
+Arena::Arena(size_t block_size) : Arena(block_size, block_size) {}
+
+Arena::Arena(size_t block_size, size_t max_retained_size)
+    : block_size_(block_size),
+      max_retained_size_(max_retained_size),
+      blocks_(nullptr),
+      first_block_(nullptr),
+      cursor_(nullptr),
+      limit_(nullptr),
+      bytes_allocated_(0),
+      bytes_reserved_(0) {
+  DCHECK_GT(block_size_, sizeof(Block));
+}
+
+Arena::~Arena() {
+  FreeBlocks();
+}
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+  DCHECK(alignment && !(alignment & (alignment - 1)));
+  DCHECK_LE(alignment, 64u);
+  bytes_allocated_ += size;
+  if (cursor_) {
+    char* result = AlignUp(cursor_, alignment);
+    if (result <= limit_ && static_cast<size_t>(limit_ - result) >= size) {
+      cursor_ = result + size;
+      return result;
+    }
+  }
+  return AllocateInNewBlock(size, alignment);
+}
+
+StringPiece Arena::CopyString(const StringPiece& str) {
+  if (str.empty())
+    return StringPiece();
+  char* copy = static_cast<char*>(Allocate(str.size(), 1));
+  memcpy(copy, str.data(), str.size());
+  return StringPiece(copy, str.size());
+}
+
+void Arena::Reset() {
+  // The blocks of this cycle are merged if they do not fit in the first one.
+  // A first block over the limit, such as one dedicated to a large first
+  // allocation, is replaced too.
+  const size_t max_retained_size = std::max(block_size_, max_retained_size_);
+  const size_t retained_size = std::min(bytes_reserved_, max_retained_size);
+  const bool first_block_too_large =
+      first_block_ && sizeof(Block) + first_block_->size > max_retained_size;
+  if (first_block_too_large ||
+      (blocks_ != first_block_ &&
+       retained_size > sizeof(Block) + first_block_->size)) {
+    FreeBlocks();
+    Block* block = static_cast<Block*>(malloc(retained_size));
+    if (!block)
+      TerminateBecauseOutOfMemory(retained_size);
+    block->next = nullptr;
+    block->size = retained_size - sizeof(Block);
+    blocks_ = first_block_ = block;
+    bytes_reserved_ = retained_size;
+  }
+
+  Block* block = blocks_;
+  while (block) {
+    Block* next = block->next;
+    if (block != first_block_) {
+      bytes_reserved_ -= sizeof(Block) + block->size;
+      free(block);
+    }
+    block = next;
+  }
+  blocks_ = first_block_;
+  if (first_block_) {
+    first_block_->next = nullptr;
+    cursor_ = first_block_->data();
+    limit_ = cursor_ + first_block_->size;
+  }
+  bytes_allocated_ = 0;
+}
+
+void* Arena::AllocateInNewBlock(size_t size, size_t alignment) {
+  const size_t usable = block_size_ - sizeof(Block);
+  const bool dedicated = size > usable / 4;
+  const size_t block_size = dedicated ? size + alignment : usable;
+  CHECK_GE(block_size, size);
+
+  Block* block = static_cast<Block*>(malloc(sizeof(Block) + block_size));
+  if (!block)
+    TerminateBecauseOutOfMemory(sizeof(Block) + block_size);
+  block->size = block_size;
+  bytes_reserved_ += sizeof(Block) + block_size;
+
+  if (!first_block_)
+    first_block_ = block;
+  block->next = blocks_;
+  blocks_ = block;
+
+  char* result = AlignUp(block->data(), alignment);
+  if (!dedicated || !cursor_) {
+    cursor_ = result + size;
+    limit_ = block->data() + block->size;
+  }
+  return result;
+}
+
+void Arena::FreeBlocks() {
+  while (blocks_) {
+    Block* next = blocks_->next;
+    free(blocks_);
+    blocks_ = next;
+  }
+  first_block_ = nullptr;
+  cursor_ = nullptr;
+  limit_ = nullptr;
+  bytes_reserved_ = 0;
+}
+
+}  // namespace base
@@ -0,0 +1,101 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MEMORY_ARENA_H_
+#define BASE_MEMORY_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/base_export.h"
+#include "base/compiler_specific.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+// Arena is a bump allocator for data with a common lifetime, such as
+// everything built while handling one request. Allocation is a pointer
+// increment in the common case; individual allocations are never freed.
+// Instead, Reset() releases everything at once and keeps the first block for
+// reuse, so an arena that is reset after each request stops calling malloc
+// once it has grown to the request's working set.
+//
+// Objects placed in an arena are not destroyed, so only trivially
+// destructible types should be stored in it.
+//
+// Arena is not thread-safe.
+class BASE_EXPORT Arena {
+ public:
+  static const size_t kDefaultBlockSize = 16 * 1024;
+
+  Arena();
+  // |block_size| is the size of each block requested from malloc.
+  // Allocations larger than a quarter of it get a block of their own.
+  explicit Arena(size_t block_size);
+  // |max_retained_size| bounds the memory kept by Reset(). If the allocations
+  // since the last Reset() needed more than the first block, Reset() replaces
+  // all blocks with a single one large enough for them, up to this size, so
+  // that a workload repeated between resets stops calling malloc.
+  Arena(size_t block_size, size_t max_retained_size);
+  ~Arena();
+
+  // Returns |size| bytes aligned to |alignment|, a power of two no larger
+  // than 64. Never returns null; allocation failure crashes.
+  void* Allocate(size_t size, size_t alignment);
+
+  // Returns uninitialized storage for |count| objects of type T.
+  template <typename T>
+  T* AllocateArray(size_t count) {
+    DCHECK_LE(count, SIZE_MAX / sizeof(T));
+    return static_cast<T*>(Allocate(count * sizeof(T), ALIGNOF(T)));
+  }
+
+  // Copies |str| into the arena and returns the copy, which is not
+  // NUL-terminated.
+  StringPiece CopyString(const StringPiece& str);
+
+  // Releases all allocations. Keeps the first block, or a single block sized
+  // for the last cycle as described above, and frees the others. Never keeps
+  // more than |max_retained_size|, even when the first allocation was larger.
+  void Reset();
+
+  // Sum of the sizes of all allocations since the last Reset().
+  size_t bytes_allocated() const { return bytes_allocated_; }
+
+  // Memory currently obtained from malloc, including block headers.
+  size_t bytes_reserved() const { return bytes_reserved_; }
+
+ private:
+  struct Block;
+
+  // Allocates from a new block, which becomes the current one unless it is
+  // dedicated to this single large allocation.
+  void* AllocateInNewBlock(size_t size, size_t alignment);
+
+  // Frees all blocks.
+  void FreeBlocks();
+
+  const size_t block_size_;
+  const size_t max_retained_size_;
+
+  // All blocks, most recent first. |first_block_| is the oldest one, which
+  // survives Reset().
+  Block* blocks_;
+  Block* first_block_;
+
+  // Free space in the current block.
+  char* cursor_;
+  char* limit_;
+
+  size_t bytes_allocated_;
+  size_t bytes_reserved_;
+
+  DISALLOW_COPY_AND_ASSIGN(Arena);
+};
+
+}  // namespace base
+
+#endif  // BASE_MEMORY_ARENA_H_
@@ -0,0 +1,125 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/arena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+TEST(ArenaTest, Alignment) {
+  Arena arena(1024);
+  const size_t kAlignments[] = {1, 2, 4, 8, 16, 32, 64};
+  for (int round = 0; round < 50; ++round) {
+    for (size_t i = 0; i < arraysize(kAlignments); ++i) {
+      char* p = static_cast<char*>(arena.Allocate(round + 1, kAlignments[i]));
+      EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % kAlignments[i]);
+      memset(p, 0xAB, round + 1);
+    }
+  }
+  double* doubles = arena.AllocateArray<double>(3);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(doubles) % ALIGNOF(double));
+}
+
+TEST(ArenaTest, ResetKeepsFirstBlock) {
+  Arena arena(1024);
+  EXPECT_EQ(0u, arena.bytes_reserved());
+
+  char* first = static_cast<char*>(arena.Allocate(16, 8));
+  size_t one_block = arena.bytes_reserved();
+  EXPECT_LE(1024u, one_block + 64);
+  EXPECT_EQ(16u, arena.bytes_allocated());
+
+  for (int i = 0; i < 200; ++i)
+    arena.Allocate(100, 1);
+  EXPECT_GT(arena.bytes_reserved(), one_block);
+
+  // After a reset, the same allocations are served from the kept block.
+  for (int round = 0; round < 3; ++round) {
+    arena.Reset();
+    EXPECT_EQ(0u, arena.bytes_allocated());
+    EXPECT_EQ(one_block, arena.bytes_reserved());
+    EXPECT_EQ(first, arena.Allocate(16, 8));
+    EXPECT_EQ(one_block, arena.bytes_reserved());
+  }
+}
+
+TEST(ArenaTest, LargeAllocations) {
+  Arena arena(1024);
+  char* small = static_cast<char*>(arena.Allocate(8, 8));
+  size_t reserved = arena.bytes_reserved();
+
+  // A large allocation gets its own block and does not waste the current
+  // one: the next small allocation still comes from it.
+  char* large = static_cast<char*>(arena.Allocate(10000, 16));
+  memset(large, 0, 10000);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(large) % 16);
+  EXPECT_GE(arena.bytes_reserved(), reserved + 10000);
+  EXPECT_EQ(small + 8, arena.Allocate(8, 8));
+
+  arena.Reset();
+  EXPECT_EQ(reserved, arena.bytes_reserved());
+}
+
+TEST(ArenaTest, ResetMergesBlocksUpToMaxRetainedSize) {
+  Arena arena(1024, 64 * 1024);
+  arena.Allocate(16, 8);
+  arena.Allocate(10000, 16);
+  for (int i = 0; i < 100; ++i)
+    arena.Allocate(100, 1);
+  size_t reserved = arena.bytes_reserved();
+
+  // The next cycle of the same allocations fits in the merged block.
+  arena.Reset();
+  EXPECT_EQ(reserved, arena.bytes_reserved());
+  for (int round = 0; round < 3; ++round) {
+    arena.Allocate(16, 8);
+    arena.Allocate(10000, 16);
+    for (int i = 0; i < 100; ++i)
+      arena.Allocate(100, 1);
+    EXPECT_EQ(reserved, arena.bytes_reserved());
+    arena.Reset();
+  }
+
+  // Cycles larger than the limit keep only |max_retained_size|.
+  arena.Allocate(100 * 1024, 8);
+  arena.Allocate(100 * 1024, 8);
+  arena.Reset();
+  EXPECT_EQ(64u * 1024, arena.bytes_reserved());
+}
+
+TEST(ArenaTest, ResetShrinksLargeFirstBlock) {
+  Arena arena(1024, 64 * 1024);
+  // The first allocation gets a dedicated block, which becomes the first.
+  char* large = static_cast<char*>(arena.Allocate(1024 * 1024, 16));
+  memset(large, 0, 1024 * 1024);
+  EXPECT_GT(arena.bytes_reserved(), 1024u * 1024);
+
+  arena.Reset();
+  EXPECT_EQ(64u * 1024, arena.bytes_reserved());
+  arena.Allocate(16, 8);
+  EXPECT_EQ(64u * 1024, arena.bytes_reserved());
+
+  // Without a larger limit, only one default block is kept.
+  Arena small_limit(1024);
+  small_limit.Allocate(10000, 16);
+  small_limit.Reset();
+  EXPECT_EQ(1024u, small_limit.bytes_reserved());
+}
+
+TEST(ArenaTest, CopyString) {
+  Arena arena;
+  std::string source("per-request string");
+  StringPiece copy = arena.CopyString(source);
+  source.assign(source.size(), 'x');
+  EXPECT_EQ("per-request string", copy);
+  EXPECT_TRUE(arena.CopyString(StringPiece()).empty());
+}
+
+}  // namespace base
@@ -0,0 +1,143 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/discardable_cache.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+#include "base/memory/arena.h"
+#include "base/memory/discardable_memory.h"
+#include "base/memory/discardable_memory_allocator.h"
+#include "base/memory/scoped_ptr.h"
+
+namespace base {
+
+namespace {
+
+// Payloads copied into an arena are aligned for any scalar type.
+const size_t kAlignment = 16;
+
+}  // namespace
+
+struct DiscardableCache::Entry {
+  scoped_ptr<DiscardableMemory> memory;
+  size_t size;
+};
+
+DiscardableCache::DiscardableCache(size_t max_entries, size_t max_bytes)
+    : max_entries_(max_entries),
+      max_bytes_(max_bytes),
+      entries_(EntryMap::NO_AUTO_EVICT),
+      bytes_(0) {
+  DCHECK_GT(max_entries_, 0u);
+  memset(&stats_, 0, sizeof(stats_));
+}
+
+DiscardableCache::~DiscardableCache() {}
+
+bool DiscardableCache::Put(uint64_t key, const StringPiece& data) {
+  if (data.size() > max_bytes_)
+    return false;
+
+  // The copy is made before taking the lock; it may touch many pages.
+  linked_ptr<Entry> entry(new Entry);
+  entry->memory = DiscardableMemoryAllocator::GetInstance()
+                      ->AllocateLockedDiscardableMemory(data.size());
+  entry->size = data.size();
+  if (!data.empty())
+    memcpy(entry->memory->data(), data.data(), data.size());
+  entry->memory->Unlock();
+
+  AutoLock lock(lock_);
+  EntryMap::iterator it = entries_.Peek(key);
+  if (it != entries_.end())
+    EraseEntry(it);
+  bytes_ += entry->size;
+  entries_.Put(key, entry);
+  while (entries_.size() > max_entries_ || bytes_ > max_bytes_)
+    EraseEntry(--entries_.end());
+  return true;
+}
+
+bool DiscardableCache::Get(uint64_t key, std::string* data) {
+  AutoLock lock(lock_);
+  Entry* entry = Pin(key);
+  if (!entry)
+    return false;
+  data->assign(entry->memory->data_as<char>(), entry->size);
+  Unpin(entry);
+  return true;
+}
+
+bool DiscardableCache::Get(uint64_t key, Arena* arena, StringPiece* data) {
+  AutoLock lock(lock_);
+  Entry* entry = Pin(key);
+  if (!entry)
+    return false;
+  char* copy = static_cast<char*>(arena->Allocate(entry->size, kAlignment));
+  memcpy(copy, entry->memory->data(), entry->size);
+  *data = StringPiece(copy, entry->size);
+  Unpin(entry);
+  return true;
+}
+
+void DiscardableCache::Erase(uint64_t key) {
+  AutoLock lock(lock_);
+  EntryMap::iterator it = entries_.Peek(key);
+  if (it != entries_.end())
+    EraseEntry(it);
+}
+
+void DiscardableCache::Clear() {
+  AutoLock lock(lock_);
+  entries_.Clear();
+  bytes_ = 0;
+}
+
+size_t DiscardableCache::size() const {
+  AutoLock lock(lock_);
+  return entries_.size();
+}
+
+size_t DiscardableCache::bytes() const {
+  AutoLock lock(lock_);
+  return bytes_;
+}
+
+void DiscardableCache::GetStats(Stats* stats) const {
+  AutoLock lock(lock_);
+  *stats = stats_;
+}
+
+DiscardableCache::Entry* DiscardableCache::Pin(uint64_t key) {
+  lock_.AssertAcquired();
+  EntryMap::iterator it = entries_.Get(key);
+  if (it == entries_.end()) {
+    ++stats_.misses;
+    return nullptr;
+  }
+  if (!it->second->memory->Lock()) {
+    ++stats_.discarded;
+    ++stats_.misses;
+    EraseEntry(it);
+    return nullptr;
+  }
+  ++stats_.hits;
+  return it->second.get();
+}
+
+void DiscardableCache::Unpin(Entry* entry) {
+  lock_.AssertAcquired();
+  entry->memory->Unlock();
+}
+
+DiscardableCache::EntryMap::iterator DiscardableCache::EraseEntry(
+    EntryMap::iterator it) {
+  DCHECK_GE(bytes_, it->second->size);
+  bytes_ -= it->second->size;
+  return entries_.Erase(it);
+}
+
+}  // namespace base
@@ -0,0 +1,98 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MEMORY_DISCARDABLE_CACHE_H_
+#define BASE_MEMORY_DISCARDABLE_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "base/base_export.h"
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/memory/linked_ptr.h"
+#include "base/strings/string_piece.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+class Arena;
+
+// A most-recently-used cache of byte payloads whose memory the system may
+// take back while the payloads are not in use, such as results that are
+// cheap to drop but expensive to compute.
+//
+// Each payload lives in its own DiscardableMemory from
+// DiscardableMemoryAllocator::GetInstance(), unlocked between calls. A
+// lookup pins it; if the system has discarded it in the meantime the entry
+// is removed and the lookup misses, just as if it had been evicted. Keys are
+// usually a Hash64() of the input the payload was computed from.
+//
+// The limits count payload bytes; the discardable memory rounds each payload
+// up to whole pages. Thread-safe.
+class BASE_EXPORT DiscardableCache {
+ public:
+  struct Stats {
+    uint64_t hits;
+    uint64_t misses;
+
+    // Lookups that found their payload discarded by the system. They also
+    // count as misses.
+    uint64_t discarded;
+  };
+
+  DiscardableCache(size_t max_entries, size_t max_bytes);
+  ~DiscardableCache();
+
+  // Stores a copy of |data| for |key|, replacing an older payload, and
+  // evicts the least recently used entries beyond the limits. Returns false
+  // without storing anything if |data| alone exceeds |max_bytes|.
+  bool Put(uint64_t key, const StringPiece& data);
+
+  // If the payload of |key| is present and was not discarded, copies it to
+  // |data|, marks it most recently used and returns true.
+  bool Get(uint64_t key, std::string* data);
+
+  // Same as above, but copies the payload into |arena|, aligned to 16 bytes
+  // so that it can hold an array of any scalar type.
+  bool Get(uint64_t key, Arena* arena, StringPiece* data);
+
+  void Erase(uint64_t key);
+  void Clear();
+
+  // The number of entries and their payload bytes, including payloads that
+  // have been discarded but not looked up since.
+  size_t size() const;
+  size_t bytes() const;
+
+  void GetStats(Stats* stats) const;
+
+ private:
+  struct Entry;
+  typedef HashingMRUCache<uint64_t, linked_ptr<Entry>> EntryMap;
+
+  // Pins the payload of |key| and returns its entry, or null on a miss.
+  // Must be called with |lock_| held.
+  Entry* Pin(uint64_t key);
+
+  // Must be called with |lock_| held.
+  void Unpin(Entry* entry);
+  EntryMap::iterator EraseEntry(EntryMap::iterator it);
+
+  const size_t max_entries_;
+  const size_t max_bytes_;
+
+  mutable Lock lock_;
+  EntryMap entries_;
+  size_t bytes_;
+  Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(DiscardableCache);
+};
+
+}  // namespace base
+
+#endif  // BASE_MEMORY_DISCARDABLE_CACHE_H_
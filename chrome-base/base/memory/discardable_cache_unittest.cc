@@ -0,0 +1,138 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/discardable_cache.h"
+
+#include <string>
+
+#include "base/memory/arena.h"
+#include "base/memory/discardable_memory.h"
+#include "base/memory/discardable_memory_allocator.h"
+#include "base/memory/madv_free_discardable_memory_posix.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Hands out MadvFreeDiscardableMemoryPosix objects and remembers the last
+// one, so that a test can discard it.
+class TestAllocator : public DiscardableMemoryAllocator {
+ public:
+  TestAllocator() : last_(nullptr) {}
+  ~TestAllocator() override {}
+
+  scoped_ptr<DiscardableMemory> AllocateLockedDiscardableMemory(
+      size_t size) override {
+    last_ = new MadvFreeDiscardableMemoryPosix(size);
+    return make_scoped_ptr(last_);
+  }
+
+  MadvFreeDiscardableMemoryPosix* last() const { return last_; }
+
+ private:
+  MadvFreeDiscardableMemoryPosix* last_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestAllocator);
+};
+
+// The allocator instance can only be set once per process.
+TestAllocator* g_allocator = nullptr;
+
+class DiscardableCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    if (!g_allocator) {
+      g_allocator = new TestAllocator;
+      DiscardableMemoryAllocator::SetInstance(g_allocator);
+    }
+  }
+};
+
+}  // namespace
+
+TEST_F(DiscardableCacheTest, PutAndGet) {
+  DiscardableCache cache(4, 1 << 20);
+  std::string data;
+  EXPECT_FALSE(cache.Get(1, &data));
+
+  const std::string payload(10000, 'p');
+  EXPECT_TRUE(cache.Put(1, payload));
+  EXPECT_TRUE(cache.Put(2, "two"));
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(payload.size() + 3, cache.bytes());
+
+  ASSERT_TRUE(cache.Get(1, &data));
+  EXPECT_EQ(payload, data);
+  ASSERT_TRUE(cache.Get(2, &data));
+  EXPECT_EQ("two", data);
+
+  Arena arena(4096);
+  StringPiece piece;
+  ASSERT_TRUE(cache.Get(1, &arena, &piece));
+  EXPECT_EQ(payload, piece);
+
+  // Replacing a payload keeps one entry.
+  EXPECT_TRUE(cache.Put(2, ""));
+  ASSERT_TRUE(cache.Get(2, &data));
+  EXPECT_EQ("", data);
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(payload.size(), cache.bytes());
+
+  cache.Erase(1);
+  EXPECT_FALSE(cache.Get(1, &data));
+  cache.Clear();
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(0u, cache.bytes());
+
+  DiscardableCache::Stats stats;
+  cache.GetStats(&stats);
+  EXPECT_EQ(4u, stats.hits);
+  EXPECT_EQ(2u, stats.misses);
+  EXPECT_EQ(0u, stats.discarded);
+}
+
+TEST_F(DiscardableCacheTest, EvictsLeastRecentlyUsed) {
+  DiscardableCache cache(3, 100);
+  std::string data;
+  cache.Put(1, "a");
+  cache.Put(2, "b");
+  cache.Put(3, "c");
+  EXPECT_TRUE(cache.Get(1, &data));
+  cache.Put(4, "d");
+  EXPECT_FALSE(cache.Get(2, &data));
+  EXPECT_TRUE(cache.Get(1, &data));
+
+  // The byte limit evicts as well, and a payload over it is refused.
+  cache.Put(5, std::string(99, 'x'));
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(100u, cache.bytes());
+  EXPECT_FALSE(cache.Get(4, &data));
+  EXPECT_TRUE(cache.Get(1, &data));
+  EXPECT_TRUE(cache.Get(5, &data));
+  EXPECT_FALSE(cache.Put(6, std::string(101, 'x')));
+  EXPECT_TRUE(cache.Get(5, &data));
+}
+
+TEST_F(DiscardableCacheTest, DiscardedEntryMisses) {
+  DiscardableCache cache(4, 1 << 20);
+  cache.Put(1, "survives");
+  cache.Put(2, std::string(5000, 'd'));
+  g_allocator->last()->DiscardForTesting();
+
+  std::string data;
+  EXPECT_FALSE(cache.Get(2, &data));
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_EQ(8u, cache.bytes());
+  ASSERT_TRUE(cache.Get(1, &data));
+  EXPECT_EQ("survives", data);
+
+  DiscardableCache::Stats stats;
+  cache.GetStats(&stats);
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(1u, stats.discarded);
+}
+
+}  // namespace base
@@ -0,0 +1,129 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/madv_free_discardable_memory_posix.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+
+#include "base/bits.h"
+#include "base/logging.h"
+#include "base/process/memory.h"
+#include "base/process/process_metrics.h"
+#include "base/trace_event/memory_allocator_dump.h"
+#include "base/trace_event/process_memory_dump.h"
+#include "build/build_config.h"
+
+// Older C libraries do not define MADV_FREE, which the kernel accepts since
+// Linux 4.5.
+#if defined(OS_LINUX) && !defined(MADV_FREE)
+#define MADV_FREE 8
+#endif
+
+namespace base {
+
+namespace {
+
+// Any nonzero value works, as a reclaimed page reads as zeros.
+const subtle::AtomicWord kPageCookie =
+    static_cast<subtle::AtomicWord>(0x5A17C0DE5A17C0DEULL);
+
+// Set once madvise(MADV_FREE) fails with EINVAL, which means the kernel does
+// not support it.
+subtle::Atomic32 g_madv_free_unsupported = 0;
+
+}  // namespace
+
+MadvFreeDiscardableMemoryPosix::MadvFreeDiscardableMemoryPosix(size_t size)
+    : size_(size),
+      allocated_pages_(bits::Align(std::max<size_t>(size, 1), GetPageSize()) /
+                       GetPageSize()),
+      data_(nullptr),
+      is_locked_(true),
+      saved_first_words_(allocated_pages_) {
+  data_ = mmap(nullptr, allocated_pages_ * GetPageSize(),
+               PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data_ == MAP_FAILED)
+    TerminateBecauseOutOfMemory(allocated_pages_ * GetPageSize());
+}
+
+MadvFreeDiscardableMemoryPosix::~MadvFreeDiscardableMemoryPosix() {
+  munmap(data_, allocated_pages_ * GetPageSize());
+}
+
+bool MadvFreeDiscardableMemoryPosix::Lock() {
+  DCHECK(!is_locked_);
+  for (size_t page = 0; page < allocated_pages_; ++page) {
+    // The swap is a single read-modify-write, so the kernel either sees the
+    // page dirty and keeps it, or has already replaced it with zeros.
+    if (subtle::NoBarrier_CompareAndSwap(page_first_word(page), kPageCookie,
+                                         saved_first_words_[page]) !=
+        kPageCookie) {
+      return false;
+    }
+  }
+  is_locked_ = true;
+  return true;
+}
+
+void MadvFreeDiscardableMemoryPosix::Unlock() {
+  DCHECK(is_locked_);
+  for (size_t page = 0; page < allocated_pages_; ++page) {
+    saved_first_words_[page] = subtle::NoBarrier_Load(page_first_word(page));
+    subtle::NoBarrier_Store(page_first_word(page), kPageCookie);
+  }
+  is_locked_ = false;
+
+  // The cookies are written before the advice, as a later write would take
+  // the page back.
+  if (!subtle::NoBarrier_Load(&g_madv_free_unsupported) &&
+      madvise(data_, allocated_pages_ * GetPageSize(), MADV_FREE) != 0) {
+    DPCHECK(errno == EINVAL);
+    subtle::NoBarrier_Store(&g_madv_free_unsupported, 1);
+  }
+}
+
+void* MadvFreeDiscardableMemoryPosix::data() const {
+  DCHECK(is_locked_);
+  return data_;
+}
+
+trace_event::MemoryAllocatorDump*
+MadvFreeDiscardableMemoryPosix::CreateMemoryAllocatorDump(
+    const char* name,
+    trace_event::ProcessMemoryDump* pmd) const {
+  trace_event::MemoryAllocatorDump* dump = pmd->CreateAllocatorDump(name);
+  dump->AddScalar(trace_event::MemoryAllocatorDump::kNameSize,
+                  trace_event::MemoryAllocatorDump::kUnitsBytes,
+                  allocated_pages_ * GetPageSize());
+  return dump;
+}
+
+void MadvFreeDiscardableMemoryPosix::DiscardForTesting() {
+  DCHECK(!is_locked_);
+  PCHECK(madvise(data_, allocated_pages_ * GetPageSize(), MADV_DONTNEED) == 0);
+}
+
+subtle::AtomicWord* MadvFreeDiscardableMemoryPosix::page_first_word(
+    size_t page) const {
+  return reinterpret_cast<subtle::AtomicWord*>(static_cast<char*>(data_) +
+                                               page * GetPageSize());
+}
+
+MadvFreeDiscardableMemoryAllocatorPosix::
+    MadvFreeDiscardableMemoryAllocatorPosix() {}
+
+MadvFreeDiscardableMemoryAllocatorPosix::
+    ~MadvFreeDiscardableMemoryAllocatorPosix() {}
+
+scoped_ptr<DiscardableMemory>
+MadvFreeDiscardableMemoryAllocatorPosix::AllocateLockedDiscardableMemory(
+    size_t size) {
+  return make_scoped_ptr(new MadvFreeDiscardableMemoryPosix(size));
+}
+
+}  // namespace base
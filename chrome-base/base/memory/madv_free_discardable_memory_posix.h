@@ -0,0 +1,90 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MEMORY_MADV_FREE_DISCARDABLE_MEMORY_POSIX_H_
+#define BASE_MEMORY_MADV_FREE_DISCARDABLE_MEMORY_POSIX_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/memory/discardable_memory.h"
+#include "base/memory/discardable_memory_allocator.h"
+
+namespace base {
+
+// Discardable memory in private anonymous pages, for a single process.
+//
+// Unlock() hands the pages to the kernel with madvise(MADV_FREE), which lets
+// it reclaim them lazily under memory pressure instead of swapping them or
+// killing the process. Until it does, the contents stay intact, and the next
+// write to a page takes it back.
+//
+// A reclaimed page reads as zeros, so Unlock() puts a nonzero cookie in the
+// first word of each page and saves the word it replaces. Lock() swaps the
+// saved word back with an atomic compare-and-swap, which both detects a
+// reclaimed page and dirties a live one so that the kernel keeps it. If any
+// page was reclaimed Lock() fails, and the object must be deleted.
+//
+// On kernels without MADV_FREE (before Linux 4.5) the memory is never
+// reclaimed. Every allocation is at least one page; this is meant for
+// payloads of kilobytes or more. Not thread-safe.
+class BASE_EXPORT MadvFreeDiscardableMemoryPosix : public DiscardableMemory {
+ public:
+  // Allocates |size| bytes, locked.
+  explicit MadvFreeDiscardableMemoryPosix(size_t size);
+  ~MadvFreeDiscardableMemoryPosix() override;
+
+  // DiscardableMemory:
+  bool Lock() override;
+  void Unlock() override;
+  void* data() const override;
+  trace_event::MemoryAllocatorDump* CreateMemoryAllocatorDump(
+      const char* name,
+      trace_event::ProcessMemoryDump* pmd) const override;
+
+  // Drops the pages of an unlocked object at once, as if the kernel had
+  // reclaimed them.
+  void DiscardForTesting();
+
+  bool is_locked() const { return is_locked_; }
+  size_t size() const { return size_; }
+
+ private:
+  subtle::AtomicWord* page_first_word(size_t page) const;
+
+  const size_t size_;
+  const size_t allocated_pages_;
+  void* data_;
+  bool is_locked_;
+
+  // The first word of each page, while the cookie is in its place.
+  std::vector<subtle::AtomicWord> saved_first_words_;
+
+  DISALLOW_COPY_AND_ASSIGN(MadvFreeDiscardableMemoryPosix);
+};
+
+// Hands out MadvFreeDiscardableMemoryPosix objects. A process without a
+// discardable memory service installs one with
+// DiscardableMemoryAllocator::SetInstance().
+class BASE_EXPORT MadvFreeDiscardableMemoryAllocatorPosix
+    : public DiscardableMemoryAllocator {
+ public:
+  MadvFreeDiscardableMemoryAllocatorPosix();
+  ~MadvFreeDiscardableMemoryAllocatorPosix() override;
+
+  // DiscardableMemoryAllocator:
+  scoped_ptr<DiscardableMemory> AllocateLockedDiscardableMemory(
+      size_t size) override;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MadvFreeDiscardableMemoryAllocatorPosix);
+};
+
+}  // namespace base
+
+#endif  // BASE_MEMORY_MADV_FREE_DISCARDABLE_MEMORY_POSIX_H_
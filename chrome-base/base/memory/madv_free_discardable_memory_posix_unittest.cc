@@ -0,0 +1,75 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/madv_free_discardable_memory_posix.h"
+
+#include <string.h>
+
+#include "base/process/process_metrics.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+void Fill(MadvFreeDiscardableMemoryPosix* memory) {
+  unsigned char* data = memory->data_as<unsigned char>();
+  for (size_t i = 0; i < memory->size(); ++i)
+    data[i] = static_cast<unsigned char>(i * 7 + 1);
+}
+
+bool Matches(const MadvFreeDiscardableMemoryPosix& memory) {
+  const unsigned char* data = memory.data_as<unsigned char>();
+  for (size_t i = 0; i < memory.size(); ++i) {
+    if (data[i] != static_cast<unsigned char>(i * 7 + 1))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(MadvFreeDiscardableMemoryPosixTest, KeepsContentsAcrossUnlock) {
+  const size_t kSize = 3 * GetPageSize() + 100;
+  MadvFreeDiscardableMemoryPosix memory(kSize);
+  EXPECT_TRUE(memory.is_locked());
+  Fill(&memory);
+
+  for (int i = 0; i < 3; ++i) {
+    memory.Unlock();
+    EXPECT_FALSE(memory.is_locked());
+    // Nothing else is competing for memory, so the pages stay.
+    ASSERT_TRUE(memory.Lock());
+    EXPECT_TRUE(memory.is_locked());
+    EXPECT_TRUE(Matches(memory));
+  }
+}
+
+TEST(MadvFreeDiscardableMemoryPosixTest, LockFailsAfterDiscard) {
+  MadvFreeDiscardableMemoryPosix memory(2 * GetPageSize());
+  Fill(&memory);
+  memory.Unlock();
+  memory.DiscardForTesting();
+  EXPECT_FALSE(memory.Lock());
+  EXPECT_FALSE(memory.is_locked());
+}
+
+TEST(MadvFreeDiscardableMemoryPosixTest, SmallAndEmptyAllocations) {
+  MadvFreeDiscardableMemoryAllocatorPosix allocator;
+  scoped_ptr<DiscardableMemory> small =
+      allocator.AllocateLockedDiscardableMemory(1);
+  small->data_as<char>()[0] = 'x';
+  small->Unlock();
+  ASSERT_TRUE(small->Lock());
+  EXPECT_EQ('x', small->data_as<char>()[0]);
+  small->Unlock();
+
+  scoped_ptr<DiscardableMemory> empty =
+      allocator.AllocateLockedDiscardableMemory(0);
+  empty->Unlock();
+  EXPECT_TRUE(empty->Lock());
+  empty->Unlock();
+}
+
+}  // namespace base
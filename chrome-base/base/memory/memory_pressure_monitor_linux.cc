@@ -0,0 +1,363 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/memory_pressure_monitor_linux.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/time/time.h"
+
+namespace base {
+namespace nix {
+
+namespace {
+
+// The time between memory pressure checks. While under critical pressure, this
+// is also the timer to repeat cleanup attempts.
+const int kMemoryPressureIntervalMs = 1000;
+
+// The time which should pass between two moderate memory pressure calls.
+const int kModerateMemoryPressureCooldownMs = 10000;
+
+// Number of event polls before the next moderate pressure event can be sent.
+const int kModerateMemoryPressureCooldown =
+    kModerateMemoryPressureCooldownMs / kMemoryPressureIntervalMs;
+
+const char kPressureStallFile[] = "/proc/pressure/memory";
+const char kProcSelfCgroupFile[] = "/proc/self/cgroup";
+const char kCgroupV2Root[] = "/sys/fs/cgroup";
+const char kCgroupV1Root[] = "/sys/fs/cgroup/memory";
+
+// cgroup v1 reports an unlimited cgroup with a limit near INT64_MAX, rounded
+// down to a page.
+const int64_t kCgroupV1Unlimited = int64_t{1} << 62;
+
+MemoryPressureListener::MemoryPressureLevel MaxLevel(
+    MemoryPressureListener::MemoryPressureLevel a,
+    MemoryPressureListener::MemoryPressureLevel b) {
+  return a > b ? a : b;
+}
+
+// Reads a file holding one integer. Returns -1 if it cannot be read.
+int64_t ReadInt64File(const FilePath& path) {
+  std::string contents;
+  int64_t value;
+  if (!ReadFileToString(path, &contents) ||
+      !StringToInt64(TrimWhitespaceASCII(contents, TRIM_ALL), &value)) {
+    return -1;
+  }
+  return value;
+}
+
+// Returns the value of |key| in a memory.stat file, or 0.
+int64_t ReadStatValue(const FilePath& path, const StringPiece& key) {
+  std::string contents;
+  if (!ReadFileToString(path, &contents))
+    return 0;
+  for (const StringPiece& line : SplitStringPiece(
+           contents, "\n", TRIM_WHITESPACE, SPLIT_WANT_NONEMPTY)) {
+    if (line.size() > key.size() && line.starts_with(key) &&
+        line[key.size()] == ' ') {
+      int64_t value;
+      if (StringToInt64(line.substr(key.size() + 1), &value))
+        return value;
+    }
+  }
+  return 0;
+}
+
+// Returns |root| joined with the cgroup |path| if |file| exists there. Inside
+// a container the path may name a cgroup of the host, while the container
+// sees its own cgroup at |root|, so |root| is tried next.
+FilePath FindCgroupDirectory(const FilePath& root,
+                             const StringPiece& path,
+                             const char* file) {
+  StringPiece relative = path;
+  while (relative.starts_with("/"))
+    relative.remove_prefix(1);
+  if (!relative.empty()) {
+    FilePath directory = root.Append(relative);
+    if (PathExists(directory.Append(file)))
+      return directory;
+  }
+  if (PathExists(root.Append(file)))
+    return root;
+  return FilePath();
+}
+
+// Returns the limit of the cgroup in |directory|, or 0 if it has none.
+int64_t ReadCgroupLimit(const FilePath& directory, bool is_v2) {
+  if (is_v2) {
+    // An unlimited cgroup holds "max", which does not parse.
+    const int64_t limit = ReadInt64File(directory.Append("memory.max"));
+    return std::max<int64_t>(limit, 0);
+  }
+  const int64_t limit =
+      ReadInt64File(directory.Append("memory.limit_in_bytes"));
+  return limit > 0 && limit < kCgroupV1Unlimited ? limit : 0;
+}
+
+}  // namespace
+
+MemoryPressureMonitor::Thresholds::Thresholds()
+    : moderate_some_stall_percent(10),
+      critical_some_stall_percent(40),
+      critical_full_stall_percent(10),
+      moderate_cgroup_percent(80),
+      critical_cgroup_percent(95) {}
+
+MemoryPressureMonitor::Sample::Sample()
+    : some_stall_percent(-1),
+      full_stall_percent(-1),
+      cgroup_usage(-1),
+      cgroup_limit(0) {}
+
+MemoryPressureMonitor::MemoryPressureMonitor()
+    : MemoryPressureMonitor(Thresholds()) {}
+
+MemoryPressureMonitor::MemoryPressureMonitor(const Thresholds& thresholds)
+    : thresholds_(thresholds),
+      cgroup_initialized_(false),
+      cgroup_is_v2_(false),
+      current_memory_pressure_level_(
+          MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE),
+      moderate_pressure_repeat_count_(0),
+      weak_ptr_factory_(this) {
+  StartObserving();
+}
+
+MemoryPressureMonitor::~MemoryPressureMonitor() {
+  StopObserving();
+}
+
+MemoryPressureListener::MemoryPressureLevel
+MemoryPressureMonitor::CheckMemoryPressure() {
+  const MemoryPressureLevel old_pressure = GetCurrentPressureLevel();
+  Sample sample;
+  GetSample(&sample);
+  const MemoryPressureLevel new_pressure =
+      GetLevelForSample(sample, thresholds_);
+  subtle::NoBarrier_Store(&current_memory_pressure_level_, new_pressure);
+
+  // Same notification policy as on ChromeOS: critical pressure is repeated on
+  // every check, moderate pressure only after a cooldown, and a drop from
+  // critical to moderate is not announced.
+  if (new_pressure == MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE)
+    return new_pressure;
+  if (old_pressure == new_pressure) {
+    if (new_pressure ==
+            MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE &&
+        ++moderate_pressure_repeat_count_ < kModerateMemoryPressureCooldown) {
+      return new_pressure;
+    }
+  } else if (new_pressure ==
+                 MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE &&
+             old_pressure ==
+                 MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL) {
+    moderate_pressure_repeat_count_ = 0;
+    return new_pressure;
+  }
+  moderate_pressure_repeat_count_ = 0;
+  MemoryPressureListener::NotifyMemoryPressure(new_pressure);
+  return new_pressure;
+}
+
+MemoryPressureListener::MemoryPressureLevel
+MemoryPressureMonitor::GetCurrentPressureLevel() const {
+  return static_cast<MemoryPressureLevel>(
+      subtle::NoBarrier_Load(&current_memory_pressure_level_));
+}
+
+// static
+MemoryPressureMonitor* MemoryPressureMonitor::Get() {
+  return static_cast<MemoryPressureMonitor*>(
+      base::MemoryPressureMonitor::Get());
+}
+
+// static
+MemoryPressureListener::MemoryPressureLevel
+MemoryPressureMonitor::GetLevelForSample(const Sample& sample,
+                                         const Thresholds& thresholds) {
+  MemoryPressureLevel level =
+      MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE;
+
+  if (sample.full_stall_percent >= thresholds.critical_full_stall_percent ||
+      sample.some_stall_percent >= thresholds.critical_some_stall_percent) {
+    level = MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL;
+  } else if (sample.some_stall_percent >=
+             thresholds.moderate_some_stall_percent) {
+    level = MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE;
+  }
+
+  if (sample.cgroup_usage >= 0 && sample.cgroup_limit > 0) {
+    const int64_t percent = sample.cgroup_usage * 100 / sample.cgroup_limit;
+    if (percent >= thresholds.critical_cgroup_percent) {
+      level = MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL;
+    } else if (percent >= thresholds.moderate_cgroup_percent) {
+      level = MaxLevel(level,
+                       MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE);
+    }
+  }
+  return level;
+}
+
+// static
+bool MemoryPressureMonitor::ParsePressureStall(const StringPiece& contents,
+                                               double* some_percent,
+                                               double* full_percent) {
+  bool found_some = false;
+  *some_percent = -1;
+  *full_percent = -1;
+  for (const StringPiece& line : SplitStringPiece(
+           contents, "\n", TRIM_WHITESPACE, SPLIT_WANT_NONEMPTY)) {
+    std::vector<StringPiece> fields =
+        SplitStringPiece(line, " ", TRIM_WHITESPACE, SPLIT_WANT_NONEMPTY);
+    if (fields.size() < 2 || !fields[1].starts_with("avg10="))
+      continue;
+    double value;
+    if (!StringToDouble(fields[1].substr(6).as_string(), &value))
+      continue;
+    if (fields[0] == "some") {
+      *some_percent = value;
+      found_some = true;
+    } else if (fields[0] == "full") {
+      *full_percent = value;
+    }
+  }
+  return found_some;
+}
+
+// static
+FilePath MemoryPressureMonitor::GetCgroupDirectory(
+    const StringPiece& proc_self_cgroup,
+    const FilePath& v2_root,
+    const FilePath& v1_root,
+    bool* is_v2) {
+  // Each line is "hierarchy-ID:controller-list:cgroup-path". The v2 hierarchy
+  // has ID 0 and no controllers.
+  StringPiece v2_path;
+  StringPiece v1_path;
+  bool has_v2 = false;
+  bool has_v1 = false;
+  for (const StringPiece& line : SplitStringPiece(
+           proc_self_cgroup, "\n", TRIM_WHITESPACE, SPLIT_WANT_NONEMPTY)) {
+    const size_t first_colon = line.find(':');
+    const size_t second_colon = line.find(':', first_colon + 1);
+    if (first_colon == StringPiece::npos || second_colon == StringPiece::npos)
+      continue;
+    const StringPiece id = line.substr(0, first_colon);
+    const StringPiece controllers =
+        line.substr(first_colon + 1, second_colon - first_colon - 1);
+    const StringPiece path = line.substr(second_colon + 1);
+    if (id == "0" && controllers.empty()) {
+      v2_path = path;
+      has_v2 = true;
+      continue;
+    }
+    for (const StringPiece& controller : SplitStringPiece(
+             controllers, ",", TRIM_WHITESPACE, SPLIT_WANT_NONEMPTY)) {
+      if (controller == "memory") {
+        v1_path = path;
+        has_v1 = true;
+      }
+    }
+  }
+
+  // On a hybrid system the v2 hierarchy exists without the memory controller,
+  // so the v1 memory controller is preferred when the process is in one.
+  if (has_v1) {
+    FilePath directory =
+        FindCgroupDirectory(v1_root, v1_path, "memory.limit_in_bytes");
+    if (!directory.empty()) {
+      *is_v2 = false;
+      return directory;
+    }
+  }
+  if (has_v2) {
+    FilePath directory = FindCgroupDirectory(v2_root, v2_path, "memory.max");
+    if (!directory.empty()) {
+      *is_v2 = true;
+      return directory;
+    }
+  }
+  return FilePath();
+}
+
+// static
+int64_t MemoryPressureMonitor::GetCgroupMemoryLimit() {
+  std::string contents;
+  if (!ReadFileToString(FilePath(kProcSelfCgroupFile), &contents))
+    return 0;
+  bool is_v2 = false;
+  const FilePath directory = GetCgroupDirectory(
+      contents, FilePath(kCgroupV2Root), FilePath(kCgroupV1Root), &is_v2);
+  return directory.empty() ? 0 : ReadCgroupLimit(directory, is_v2);
+}
+
+void MemoryPressureMonitor::StartObserving() {
+  // Without a MessageLoop the owner polls with CheckMemoryPressure().
+  if (!MessageLoop::current())
+    return;
+  timer_.Start(FROM_HERE,
+               TimeDelta::FromMilliseconds(kMemoryPressureIntervalMs),
+               Bind(IgnoreResult(&MemoryPressureMonitor::CheckMemoryPressure),
+                    weak_ptr_factory_.GetWeakPtr()));
+}
+
+void MemoryPressureMonitor::StopObserving() {
+  timer_.Stop();
+}
+
+void MemoryPressureMonitor::GetSample(Sample* sample) {
+  std::string contents;
+  if (ReadFileToString(FilePath(kPressureStallFile), &contents)) {
+    ParsePressureStall(contents, &sample->some_stall_percent,
+                       &sample->full_stall_percent);
+  }
+  ReadCgroup(sample);
+}
+
+void MemoryPressureMonitor::ReadCgroup(Sample* sample) {
+  if (!cgroup_initialized_) {
+    cgroup_initialized_ = true;
+    std::string contents;
+    if (ReadFileToString(FilePath(kProcSelfCgroupFile), &contents)) {
+      cgroup_directory_ =
+          GetCgroupDirectory(contents, FilePath(kCgroupV2Root),
+                             FilePath(kCgroupV1Root), &cgroup_is_v2_);
+    }
+    VLOG_IF(1, cgroup_directory_.empty()) << "No memory cgroup found.";
+  }
+  if (cgroup_directory_.empty())
+    return;
+
+  // Inactive page cache is reclaimed before the cgroup runs out of memory, so
+  // it is not counted as usage.
+  int64_t usage;
+  int64_t inactive_file;
+  if (cgroup_is_v2_) {
+    usage = ReadInt64File(cgroup_directory_.Append("memory.current"));
+    inactive_file =
+        ReadStatValue(cgroup_directory_.Append("memory.stat"), "inactive_file");
+  } else {
+    usage = ReadInt64File(cgroup_directory_.Append("memory.usage_in_bytes"));
+    inactive_file = ReadStatValue(cgroup_directory_.Append("memory.stat"),
+                                  "total_inactive_file");
+  }
+  sample->cgroup_limit = ReadCgroupLimit(cgroup_directory_, cgroup_is_v2_);
+  if (usage >= 0)
+    sample->cgroup_usage = std::max<int64_t>(0, usage - inactive_file);
+}
+
+}  // namespace nix
+}  // namespace base
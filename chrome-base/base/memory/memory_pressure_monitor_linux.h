@@ -0,0 +1,145 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MEMORY_MEMORY_PRESSURE_MONITOR_LINUX_H_
+#define BASE_MEMORY_MEMORY_PRESSURE_MONITOR_LINUX_H_
+
+#include <stdint.h>
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/memory/memory_pressure_monitor.h"
+#include "base/memory/weak_ptr.h"
+#include "base/strings/string_piece.h"
+#include "base/timer/timer.h"
+
+namespace base {
+namespace nix {
+
+class TestMemoryPressureMonitor;
+
+////////////////////////////////////////////////////////////////////////////////
+// MemoryPressureMonitor
+//
+// Derives the memory pressure of the process from two kernel sources:
+//
+//  - Pressure stall information (/proc/pressure/memory, Linux 4.20+): the
+//    share of the last 10 seconds in which some or all tasks were stalled
+//    waiting for memory. This reacts to thrashing before memory is full.
+//  - The memory cgroup of the process: the usage, less the inactive page
+//    cache that the kernel can drop, as a share of the cgroup limit. This
+//    rises as the process approaches the point where it would be OOM-killed.
+//    Both cgroup v2 (memory.current, memory.max) and v1
+//    (memory.usage_in_bytes, memory.limit_in_bytes) are read.
+//
+// The level is the higher of the two. A source that is missing, or a cgroup
+// without a limit, does not contribute.
+//
+// The level is checked once a second while the thread that created the
+// monitor runs a MessageLoop, and changes are sent to the
+// MemoryPressureListeners. A process without a MessageLoop calls
+// CheckMemoryPressure() itself, e.g. before admitting work.
+class BASE_EXPORT MemoryPressureMonitor : public base::MemoryPressureMonitor {
+ public:
+  // The levels at which pressure becomes moderate or critical. PSI values are
+  // percentages of stalled time over the last 10 seconds; cgroup values are
+  // percentages of the limit.
+  struct BASE_EXPORT Thresholds {
+    Thresholds();
+
+    double moderate_some_stall_percent;
+    double critical_some_stall_percent;
+    double critical_full_stall_percent;
+    int moderate_cgroup_percent;
+    int critical_cgroup_percent;
+  };
+
+  // One reading of the sources. Unavailable values are negative, and a
+  // cgroup without a limit has a |cgroup_limit| of 0.
+  struct Sample {
+    Sample();
+
+    double some_stall_percent;
+    double full_stall_percent;
+    int64_t cgroup_usage;
+    int64_t cgroup_limit;
+  };
+
+  MemoryPressureMonitor();
+  explicit MemoryPressureMonitor(const Thresholds& thresholds);
+  ~MemoryPressureMonitor() override;
+
+  // Takes a new reading, notifies the listeners if needed and returns the new
+  // level. Must be called on the thread that created the monitor.
+  MemoryPressureLevel CheckMemoryPressure();
+
+  // Returns the level of the last check. May be called on any thread.
+  MemoryPressureLevel GetCurrentPressureLevel() const override;
+
+  // Returns a type-casted version of the current memory pressure monitor. A
+  // simple wrapper to base::MemoryPressureMonitor::Get.
+  static MemoryPressureMonitor* Get();
+
+  // Maps |sample| to a level.
+  static MemoryPressureLevel GetLevelForSample(const Sample& sample,
+                                               const Thresholds& thresholds);
+
+  // Parses the "avg10" values of the "some" and "full" lines of a PSI file.
+  static bool ParsePressureStall(const StringPiece& contents,
+                                 double* some_percent,
+                                 double* full_percent);
+
+  // Returns the directory of the memory cgroup named in |proc_self_cgroup|,
+  // the contents of /proc/self/cgroup, below the cgroup v2 mount |v2_root|
+  // or the v1 memory controller mount |v1_root|. |is_v2| tells which one.
+  // Returns an empty path if the process is in neither.
+  static FilePath GetCgroupDirectory(const StringPiece& proc_self_cgroup,
+                                     const FilePath& v2_root,
+                                     const FilePath& v1_root,
+                                     bool* is_v2);
+
+  // Returns the memory limit of the cgroup of the calling process in bytes,
+  // or 0 if it is in no memory cgroup or its cgroup has no limit. Reads the
+  // files on every call.
+  static int64_t GetCgroupMemoryLimit();
+
+ private:
+  friend TestMemoryPressureMonitor;
+
+  void StartObserving();
+  void StopObserving();
+
+  // Reads the sources (virtual for testing).
+  virtual void GetSample(Sample* sample);
+
+  // Reads the usage and limit of the cgroup, if there is one.
+  void ReadCgroup(Sample* sample);
+
+  const Thresholds thresholds_;
+
+  // The directory of the memory cgroup, found on the first read.
+  bool cgroup_initialized_;
+  bool cgroup_is_v2_;
+  FilePath cgroup_directory_;
+
+  // A MemoryPressureLevel, written on the monitor thread and read anywhere.
+  subtle::Atomic32 current_memory_pressure_level_;
+
+  // Number of checks since the last moderate notification.
+  int moderate_pressure_repeat_count_;
+
+  RepeatingTimer timer_;
+
+  WeakPtrFactory<MemoryPressureMonitor> weak_ptr_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryPressureMonitor);
+};
+
+}  // namespace nix
+}  // namespace base
+
+#endif  // BASE_MEMORY_MEMORY_PRESSURE_MONITOR_LINUX_H_
@@ -0,0 +1,197 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/memory_pressure_monitor_linux.h"
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/macros.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace nix {
+
+namespace {
+
+const MemoryPressureListener::MemoryPressureLevel kNone =
+    MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE;
+const MemoryPressureListener::MemoryPressureLevel kModerate =
+    MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE;
+const MemoryPressureListener::MemoryPressureLevel kCritical =
+    MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL;
+
+void RecordPressure(int* count,
+                    MemoryPressureListener::MemoryPressureLevel* last_level,
+                    MemoryPressureListener::MemoryPressureLevel level) {
+  ++*count;
+  *last_level = level;
+}
+
+bool WriteString(const FilePath& path, const std::string& contents) {
+  return CreateDirectory(path.DirName()) &&
+         WriteFile(path, contents.data(), contents.size()) ==
+             static_cast<int>(contents.size());
+}
+
+}  // namespace
+
+class TestMemoryPressureMonitor : public MemoryPressureMonitor {
+ public:
+  TestMemoryPressureMonitor() { StopObserving(); }
+  ~TestMemoryPressureMonitor() override {}
+
+  Sample* sample() { return &sample_; }
+
+ private:
+  void GetSample(Sample* sample) override { *sample = sample_; }
+
+  Sample sample_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestMemoryPressureMonitor);
+};
+
+TEST(LinuxMemoryPressureMonitorTest, ParsePressureStall) {
+  double some;
+  double full;
+  EXPECT_TRUE(MemoryPressureMonitor::ParsePressureStall(
+      "some avg10=12.50 avg60=3.00 avg300=0.50 total=123456\n"
+      "full avg10=2.25 avg60=1.00 avg300=0.10 total=2345\n",
+      &some, &full));
+  EXPECT_DOUBLE_EQ(12.5, some);
+  EXPECT_DOUBLE_EQ(2.25, full);
+
+  // Kernels before 5.13 have no "full" line for the whole system.
+  EXPECT_TRUE(MemoryPressureMonitor::ParsePressureStall(
+      "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\n", &some, &full));
+  EXPECT_DOUBLE_EQ(0, some);
+  EXPECT_DOUBLE_EQ(-1, full);
+
+  EXPECT_FALSE(
+      MemoryPressureMonitor::ParsePressureStall("garbage\n", &some, &full));
+  EXPECT_FALSE(MemoryPressureMonitor::ParsePressureStall("", &some, &full));
+}
+
+TEST(LinuxMemoryPressureMonitorTest, GetLevelForSample) {
+  const MemoryPressureMonitor::Thresholds thresholds;
+  MemoryPressureMonitor::Sample sample;
+  EXPECT_EQ(kNone,
+            MemoryPressureMonitor::GetLevelForSample(sample, thresholds));
+
+  sample.some_stall_percent = 1;
+  sample.full_stall_percent = 0;
+  EXPECT_EQ(kNone,
+            MemoryPressureMonitor::GetLevelForSample(sample, thresholds));
+  sample.some_stall_percent = 15;
+  EXPECT_EQ(kModerate,
+            MemoryPressureMonitor::GetLevelForSample(sample, thresholds));
+  sample.full_stall_percent = 20;
+  EXPECT_EQ(kCritical,
+            MemoryPressureMonitor::GetLevelForSample(sample, thresholds));
+
+  // The cgroup raises the level of a quiet system.
+  sample.some_stall_percent = 0;
+  sample.full_stall_percent = 0;
+  sample.cgroup_limit = 1000;
+  sample.cgroup_usage = 500;
+  EXPECT_EQ(kNone,
+            MemoryPressureMonitor::GetLevelForSample(sample, thresholds));
+  sample.cgroup_usage = 850;
+  EXPECT_EQ(kModerate,
+            MemoryPressureMonitor::GetLevelForSample(sample, thresholds));
+  sample.cgroup_usage = 990;
+  EXPECT_EQ(kCritical,
+            MemoryPressureMonitor::GetLevelForSample(sample, thresholds));
+
+  // A cgroup without a limit does not count.
+  sample.cgroup_limit = 0;
+  EXPECT_EQ(kNone,
+            MemoryPressureMonitor::GetLevelForSample(sample, thresholds));
+}
+
+TEST(LinuxMemoryPressureMonitorTest, GetCgroupDirectory) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath v2_root = temp_dir.path().Append("unified");
+  const FilePath v1_root = temp_dir.path().Append("memory");
+  ASSERT_TRUE(WriteString(v2_root.Append("service/memory.max"), "max\n"));
+  ASSERT_TRUE(WriteString(v1_root.Append("memory.limit_in_bytes"), "0\n"));
+  bool is_v2 = false;
+
+  EXPECT_EQ(v2_root.Append("service"),
+            MemoryPressureMonitor::GetCgroupDirectory("0::/service\n", v2_root,
+                                                      v1_root, &is_v2));
+  EXPECT_TRUE(is_v2);
+
+  // A cgroup that is not visible, as inside a container, falls back to the
+  // root of the mount.
+  EXPECT_EQ(v1_root, MemoryPressureMonitor::GetCgroupDirectory(
+                         "4:cpu,memory:/host/slice\n0::/\n", v2_root, v1_root,
+                         &is_v2));
+  EXPECT_FALSE(is_v2);
+
+  EXPECT_EQ(FilePath(),
+            MemoryPressureMonitor::GetCgroupDirectory(
+                "1:cpu:/\n0::/other\n", v2_root, v1_root, &is_v2));
+}
+
+TEST(LinuxMemoryPressureMonitorTest, CheckMemoryPressure) {
+  MessageLoop message_loop;
+  TestMemoryPressureMonitor monitor;
+  int count = 0;
+  MemoryPressureListener::MemoryPressureLevel last_level = kNone;
+  MemoryPressureListener listener(Bind(&RecordPressure, &count, &last_level));
+
+  EXPECT_EQ(kNone, monitor.CheckMemoryPressure());
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(0, count);
+
+  // Moderate pressure is sent once, then again after the cooldown.
+  monitor.sample()->some_stall_percent = 20;
+  EXPECT_EQ(kModerate, monitor.CheckMemoryPressure());
+  EXPECT_EQ(kModerate, monitor.GetCurrentPressureLevel());
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(kModerate, last_level);
+  for (int i = 0; i < 5; ++i)
+    monitor.CheckMemoryPressure();
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(1, count);
+  for (int i = 0; i < 5; ++i)
+    monitor.CheckMemoryPressure();
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(2, count);
+
+  // Critical pressure is sent on every check.
+  monitor.sample()->cgroup_limit = 100;
+  monitor.sample()->cgroup_usage = 99;
+  monitor.CheckMemoryPressure();
+  monitor.CheckMemoryPressure();
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(4, count);
+  EXPECT_EQ(kCritical, last_level);
+  EXPECT_EQ(kCritical, MemoryPressureMonitor::Get()->GetCurrentPressureLevel());
+
+  // Dropping back to moderate is not announced.
+  monitor.sample()->cgroup_usage = 0;
+  EXPECT_EQ(kModerate, monitor.CheckMemoryPressure());
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(4, count);
+
+  monitor.sample()->some_stall_percent = 0;
+  EXPECT_EQ(kNone, monitor.CheckMemoryPressure());
+  EXPECT_EQ(kNone, monitor.GetCurrentPressureLevel());
+}
+
+// The real sources are read without errors, whatever this machine has.
+TEST(LinuxMemoryPressureMonitorTest, ReadsSystem) {
+  MemoryPressureMonitor monitor;
+  monitor.CheckMemoryPressure();
+}
+
+}  // namespace nix
+}  // namespace base
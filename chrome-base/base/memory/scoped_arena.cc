@@ -0,0 +1,91 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/scoped_arena.h"
+
+#include "base/lazy_instance.h"
+#include "base/threading/thread_local_storage.h"
+
+namespace base {
+
+namespace {
+
+// The arenas a thread has given back, most recent first.
+struct FreeList {
+  FreeList() : size(0) {}
+  ~FreeList() {
+    for (size_t i = 0; i < size; ++i)
+      delete arenas[i];
+  }
+
+  Arena* arenas[ScopedArena::kMaxFreeArenas];
+  size_t size;
+};
+
+void DeleteFreeList(void* free_list) {
+  delete static_cast<FreeList*>(free_list);
+}
+
+// Owns the free list of each thread and frees it when the thread exits.
+class FreeListSlot {
+ public:
+  FreeListSlot() : slot_(&DeleteFreeList) {}
+
+  FreeList* Get(bool create) {
+    FreeList* free_list = static_cast<FreeList*>(slot_.Get());
+    if (!free_list && create) {
+      free_list = new FreeList;
+      slot_.Set(free_list);
+    }
+    return free_list;
+  }
+
+ private:
+  ThreadLocalStorage::Slot slot_;
+
+  DISALLOW_COPY_AND_ASSIGN(FreeListSlot);
+};
+
+LazyInstance<FreeListSlot>::Leaky g_free_list_slot = LAZY_INSTANCE_INITIALIZER;
+
+Arena* AcquireArena() {
+  FreeList* free_list = g_free_list_slot.Get().Get(false);
+  if (free_list && free_list->size)
+    return free_list->arenas[--free_list->size];
+  return new Arena(ScopedArena::kBlockSize, ScopedArena::kMaxRetainedSize);
+}
+
+void ReturnArena(Arena* arena) {
+  arena->Reset();
+  FreeList* free_list = g_free_list_slot.Get().Get(true);
+  if (free_list->size == ScopedArena::kMaxFreeArenas) {
+    delete arena;
+    return;
+  }
+  free_list->arenas[free_list->size++] = arena;
+}
+
+}  // namespace
+
+// static
+const size_t ScopedArena::kBlockSize;
+const size_t ScopedArena::kMaxRetainedSize;
+const size_t ScopedArena::kMaxFreeArenas;
+
+ScopedArena::ScopedArena() : arena_(AcquireArena()) {}
+
+ScopedArena::~ScopedArena() {
+  ReturnArena(arena_);
+}
+
+// static
+void ScopedArena::ReleaseFreeArenas() {
+  FreeList* free_list = g_free_list_slot.Get().Get(false);
+  if (!free_list)
+    return;
+  while (free_list->size)
+    delete free_list->arenas[--free_list->size];
+}
+
+}  // namespace base
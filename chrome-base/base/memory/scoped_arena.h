@@ -0,0 +1,59 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MEMORY_SCOPED_ARENA_H_
+#define BASE_MEMORY_SCOPED_ARENA_H_
+
+#include <stddef.h>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/memory/arena.h"
+
+namespace base {
+
+// ScopedArena lends an Arena for the lifetime of one unit of work, typically
+// a request, and gives it back when it goes out of scope. Arenas are recycled
+// through a free list of the current thread, so no locking is involved, and
+// each one keeps a single block sized for the largest recent request (see
+// Arena's |max_retained_size|). A thread that handles requests of similar
+// size in a loop therefore stops calling malloc for its transient buffers:
+//
+//   void HandleRequest(const StringPiece& body) {
+//     ScopedArena arena;
+//     char* decoded = arena->AllocateArray<char>(...);
+//     float* samples = arena->AllocateArray<float>(...);
+//     ...
+//   }  // Everything above is released here.
+//
+// A ScopedArena must be destroyed on the thread that created it. Nesting is
+// allowed; each level gets its own arena.
+class BASE_EXPORT ScopedArena {
+ public:
+  // Block size and retention limit of the arenas handed out.
+  static const size_t kBlockSize = 64 * 1024;
+  static const size_t kMaxRetainedSize = 16 * 1024 * 1024;
+
+  // Arenas kept per thread for reuse. Arenas returned beyond this are freed.
+  static const size_t kMaxFreeArenas = 4;
+
+  ScopedArena();
+  ~ScopedArena();
+
+  Arena* get() const { return arena_; }
+  Arena* operator->() const { return arena_; }
+
+  // Frees the arenas that are cached by the current thread. Useful when a
+  // thread goes idle or under memory pressure.
+  static void ReleaseFreeArenas();
+
+ private:
+  Arena* const arena_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedArena);
+};
+
+}  // namespace base
+
+#endif  // BASE_MEMORY_SCOPED_ARENA_H_
@@ -0,0 +1,89 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/scoped_arena.h"
+
+#include <string.h>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+void HandleRequest(size_t size) {
+  ScopedArena arena;
+  char* buffer = arena->AllocateArray<char>(size);
+  memset(buffer, 1, size);
+  float* samples = arena->AllocateArray<float>(size / 2);
+  memset(samples, 0, size / 2 * sizeof(float));
+}
+
+void GetArena(Arena** arena) {
+  ScopedArena scoped_arena;
+  *arena = scoped_arena.get();
+}
+
+}  // namespace
+
+TEST(ScopedArenaTest, ReusesArenaOnSameThread) {
+  ScopedArena::ReleaseFreeArenas();
+  Arena* first;
+  {
+    ScopedArena arena;
+    first = arena.get();
+    arena->Allocate(100, 8);
+  }
+  ScopedArena arena;
+  EXPECT_EQ(first, arena.get());
+  EXPECT_EQ(0u, arena->bytes_allocated());
+}
+
+TEST(ScopedArenaTest, NestedArenasAreDistinct) {
+  ScopedArena outer;
+  ScopedArena inner;
+  EXPECT_NE(outer.get(), inner.get());
+}
+
+TEST(ScopedArenaTest, SteadyStateKeepsOneBlock) {
+  ScopedArena::ReleaseFreeArenas();
+  const size_t kRequestSize = 300 * 1024;
+  HandleRequest(kRequestSize);
+  size_t reserved;
+  {
+    ScopedArena arena;
+    reserved = arena->bytes_reserved();
+  }
+  EXPECT_GE(reserved, kRequestSize * 3);
+
+  // Later requests of the same shape are served from that block.
+  for (int i = 0; i < 10; ++i) {
+    HandleRequest(kRequestSize);
+    ScopedArena arena;
+    EXPECT_EQ(reserved, arena->bytes_reserved());
+  }
+}
+
+TEST(ScopedArenaTest, ThreadsHaveTheirOwnFreeLists) {
+  Arena* main_arena;
+  GetArena(&main_arena);
+
+  Thread thread("ScopedArenaTest");
+  ASSERT_TRUE(thread.Start());
+  Arena* thread_arenas[2];
+  thread.task_runner()->PostTask(FROM_HERE,
+                                 Bind(&GetArena, &thread_arenas[0]));
+  thread.task_runner()->PostTask(FROM_HERE,
+                                 Bind(&GetArena, &thread_arenas[1]));
+  thread.Stop();
+
+  EXPECT_EQ(thread_arenas[0], thread_arenas[1]);
+  EXPECT_NE(main_arena, thread_arenas[0]);
+}
+
+}  // namespace base
@@ -0,0 +1,342 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/small_object_pool.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <new>
+
+#include "base/atomicops.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/process/memory.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_local_storage.h"
+
+namespace base {
+
+namespace {
+
+// Size classes are multiples of 16 bytes up to 128, then of 64 bytes up to
+// kMaxSize.
+const size_t kNumSmallClasses = 8;
+const size_t kNumClasses =
+    kNumSmallClasses + (SmallObjectPool::kMaxSize - 128) / 64;
+
+const size_t kSlabSize = 64 * 1024;
+
+inline size_t SizeClass(size_t size) {
+  if (size <= 128)
+    return size ? (size - 1) / 16 : 0;
+  return kNumSmallClasses + (size - 129) / 64;
+}
+
+inline size_t ClassSize(size_t size_class) {
+  if (size_class < kNumSmallClasses)
+    return (size_class + 1) * 16;
+  return 128 + (size_class - kNumSmallClasses + 1) * 64;
+}
+
+// Objects moved at once between a thread cache and the shared lists. A
+// thread cache holds at most two batches per class.
+inline size_t BatchSize(size_t size_class) {
+  const size_t batch_size = 4096 / ClassSize(size_class);
+  return std::max<size_t>(4, std::min<size_t>(64, batch_size));
+}
+
+struct FreeObject {
+  FreeObject* next;
+};
+
+void IncrementCounter(subtle::AtomicWord* counter, subtle::AtomicWord delta) {
+  subtle::NoBarrier_AtomicIncrement(counter, delta);
+}
+
+// Only the owning thread writes the counters of a ThreadCache, so they are
+// updated without a locked instruction and read racily by GetStats().
+void IncrementOwnCounter(subtle::AtomicWord* counter) {
+  subtle::NoBarrier_Store(counter, subtle::NoBarrier_Load(counter) + 1);
+}
+
+struct ThreadCache {
+  FreeObject* lists[kNumClasses];
+  size_t lengths[kNumClasses];
+
+  subtle::AtomicWord allocations;
+  subtle::AtomicWord frees;
+
+  // Links in the list of all thread caches.
+  ThreadCache* previous;
+  ThreadCache* next;
+};
+
+// The lists shared by all threads, and the bookkeeping of the pool.
+class SharedPool {
+ public:
+  SharedPool()
+      : slab_cursor_(nullptr),
+        slab_limit_(nullptr),
+        slab_bytes_(0),
+        large_allocations_(0),
+        large_frees_(0),
+        batch_transfers_(0),
+        uncached_frees_(0),
+        exited_allocations_(0),
+        exited_frees_(0),
+        caches_(nullptr) {
+    std::fill(lists_, lists_ + kNumClasses, nullptr);
+  }
+
+  // Moves up to a batch of objects of |size_class| into |cache|.
+  void Refill(ThreadCache* cache, size_t size_class) {
+    IncrementCounter(&batch_transfers_, 1);
+    const size_t batch_size = BatchSize(size_class);
+    FreeObject* list = nullptr;
+    size_t length = 0;
+    {
+      AutoLock lock(list_locks_[size_class]);
+      while (lists_[size_class] && length < batch_size) {
+        FreeObject* object = lists_[size_class];
+        lists_[size_class] = object->next;
+        object->next = list;
+        list = object;
+        ++length;
+      }
+    }
+    if (!length) {
+      list = CarveBatch(size_class, batch_size);
+      length = batch_size;
+    }
+    cache->lists[size_class] = list;
+    cache->lengths[size_class] = length;
+  }
+
+  // Moves |count| objects from the front of the list of |cache| to the
+  // shared list.
+  void Release(ThreadCache* cache, size_t size_class, size_t count) {
+    DCHECK_LE(count, cache->lengths[size_class]);
+    if (!count)
+      return;
+    IncrementCounter(&batch_transfers_, 1);
+    FreeObject* first = cache->lists[size_class];
+    FreeObject* last = first;
+    for (size_t i = 1; i < count; ++i)
+      last = last->next;
+    cache->lists[size_class] = last->next;
+    cache->lengths[size_class] -= count;
+
+    AutoLock lock(list_locks_[size_class]);
+    last->next = lists_[size_class];
+    lists_[size_class] = first;
+  }
+
+  // Frees an object on a thread that has no cache, for example while the
+  // thread exits.
+  void ReleaseOne(void* ptr, size_t size_class) {
+    IncrementCounter(&uncached_frees_, 1);
+    FreeObject* object = static_cast<FreeObject*>(ptr);
+    AutoLock lock(list_locks_[size_class]);
+    object->next = lists_[size_class];
+    lists_[size_class] = object;
+  }
+
+  void AddCache(ThreadCache* cache) {
+    AutoLock lock(caches_lock_);
+    cache->previous = nullptr;
+    cache->next = caches_;
+    if (caches_)
+      caches_->previous = cache;
+    caches_ = cache;
+  }
+
+  // Gives back all objects of |cache| and keeps its counters.
+  void RemoveCache(ThreadCache* cache) {
+    for (size_t i = 0; i < kNumClasses; ++i)
+      Release(cache, i, cache->lengths[i]);
+
+    AutoLock lock(caches_lock_);
+    exited_allocations_ += subtle::NoBarrier_Load(&cache->allocations);
+    exited_frees_ += subtle::NoBarrier_Load(&cache->frees);
+    if (cache->previous)
+      cache->previous->next = cache->next;
+    else
+      caches_ = cache->next;
+    if (cache->next)
+      cache->next->previous = cache->previous;
+  }
+
+  void CountLargeAllocation() { IncrementCounter(&large_allocations_, 1); }
+  void CountLargeFree() { IncrementCounter(&large_frees_, 1); }
+
+  void GetStats(SmallObjectPool::Stats* stats) {
+    AutoLock lock(caches_lock_);
+    stats->allocations = exited_allocations_;
+    stats->frees = exited_frees_ + subtle::NoBarrier_Load(&uncached_frees_);
+    for (ThreadCache* cache = caches_; cache; cache = cache->next) {
+      stats->allocations += subtle::NoBarrier_Load(&cache->allocations);
+      stats->frees += subtle::NoBarrier_Load(&cache->frees);
+    }
+    stats->large_allocations = subtle::NoBarrier_Load(&large_allocations_);
+    stats->allocations += stats->large_allocations;
+    stats->frees += subtle::NoBarrier_Load(&large_frees_);
+    stats->batch_transfers = subtle::NoBarrier_Load(&batch_transfers_);
+    stats->slab_bytes = subtle::NoBarrier_Load(&slab_bytes_);
+  }
+
+ private:
+  // Returns a list of |count| new objects of |size_class|.
+  FreeObject* CarveBatch(size_t size_class, size_t count) {
+    const size_t size = ClassSize(size_class);
+    const size_t bytes = size * count;
+    char* storage;
+    {
+      AutoLock lock(slab_lock_);
+      if (static_cast<size_t>(slab_limit_ - slab_cursor_) < bytes) {
+        // The rest of the current slab is abandoned; it is smaller than one
+        // batch.
+        slab_cursor_ = static_cast<char*>(malloc(kSlabSize));
+        if (!slab_cursor_)
+          TerminateBecauseOutOfMemory(kSlabSize);
+        slab_limit_ = slab_cursor_ + kSlabSize;
+        IncrementCounter(&slab_bytes_, kSlabSize);
+      }
+      storage = slab_cursor_;
+      slab_cursor_ += bytes;
+    }
+
+    FreeObject* list = nullptr;
+    for (size_t i = count; i > 0; --i) {
+      FreeObject* object =
+          reinterpret_cast<FreeObject*>(storage + (i - 1) * size);
+      object->next = list;
+      list = object;
+    }
+    return list;
+  }
+
+  Lock list_locks_[kNumClasses];
+  FreeObject* lists_[kNumClasses];
+
+  Lock slab_lock_;
+  char* slab_cursor_;
+  char* slab_limit_;
+
+  subtle::AtomicWord slab_bytes_;
+  subtle::AtomicWord large_allocations_;
+  subtle::AtomicWord large_frees_;
+  subtle::AtomicWord batch_transfers_;
+  subtle::AtomicWord uncached_frees_;
+
+  // Guards the list of caches and the counters of exited threads.
+  Lock caches_lock_;
+  uint64_t exited_allocations_;
+  uint64_t exited_frees_;
+  ThreadCache* caches_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedPool);
+};
+
+LazyInstance<SharedPool>::Leaky g_shared_pool = LAZY_INSTANCE_INITIALIZER;
+
+void DeleteThreadCache(void* value) {
+  ThreadCache* cache = static_cast<ThreadCache*>(value);
+  g_shared_pool.Get().RemoveCache(cache);
+  delete cache;
+}
+
+// Owns the ThreadCache of each thread and frees it when the thread exits.
+class ThreadCacheSlot {
+ public:
+  ThreadCacheSlot() : slot_(&DeleteThreadCache) {}
+
+  ThreadCache* Get() { return static_cast<ThreadCache*>(slot_.Get()); }
+
+  ThreadCache* Create() {
+    ThreadCache* cache = new ThreadCache;
+    std::fill(cache->lists, cache->lists + kNumClasses, nullptr);
+    std::fill(cache->lengths, cache->lengths + kNumClasses, 0);
+    cache->allocations = 0;
+    cache->frees = 0;
+    g_shared_pool.Get().AddCache(cache);
+    slot_.Set(cache);
+    return cache;
+  }
+
+ private:
+  ThreadLocalStorage::Slot slot_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadCacheSlot);
+};
+
+LazyInstance<ThreadCacheSlot>::Leaky g_thread_cache_slot =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+const size_t SmallObjectPool::kMaxSize;
+
+// static
+void* SmallObjectPool::Allocate(size_t size) {
+#if defined(MEMORY_TOOL_REPLACES_ALLOCATOR)
+  return ::operator new(size);
+#else
+  if (size > kMaxSize) {
+    g_shared_pool.Get().CountLargeAllocation();
+    return ::operator new(size);
+  }
+
+  ThreadCacheSlot& slot = g_thread_cache_slot.Get();
+  ThreadCache* cache = slot.Get();
+  if (!cache)
+    cache = slot.Create();
+  IncrementOwnCounter(&cache->allocations);
+
+  const size_t size_class = SizeClass(size);
+  if (!cache->lists[size_class])
+    g_shared_pool.Get().Refill(cache, size_class);
+  FreeObject* object = cache->lists[size_class];
+  cache->lists[size_class] = object->next;
+  --cache->lengths[size_class];
+  return object;
+#endif
+}
+
+// static
+void SmallObjectPool::Free(void* ptr, size_t size) {
+#if defined(MEMORY_TOOL_REPLACES_ALLOCATOR)
+  ::operator delete(ptr);
+#else
+  if (!ptr)
+    return;
+  if (size > kMaxSize) {
+    g_shared_pool.Get().CountLargeFree();
+    ::operator delete(ptr);
+    return;
+  }
+
+  const size_t size_class = SizeClass(size);
+  ThreadCache* cache = g_thread_cache_slot.Get().Get();
+  if (!cache) {
+    g_shared_pool.Get().ReleaseOne(ptr, size_class);
+    return;
+  }
+  IncrementOwnCounter(&cache->frees);
+
+  FreeObject* object = static_cast<FreeObject*>(ptr);
+  object->next = cache->lists[size_class];
+  cache->lists[size_class] = object;
+  if (++cache->lengths[size_class] > 2 * BatchSize(size_class))
+    g_shared_pool.Get().Release(cache, size_class, BatchSize(size_class));
+#endif
+}
+
+// static
+void SmallObjectPool::GetStats(Stats* stats) {
+  g_shared_pool.Get().GetStats(stats);
+}
+
+}  // namespace base
@@ -0,0 +1,92 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_MEMORY_SMALL_OBJECT_POOL_H_
+#define BASE_MEMORY_SMALL_OBJECT_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+
+namespace base {
+
+// SmallObjectPool is a size-classed allocator for small objects that are
+// created and destroyed at high rates, often on different threads: the
+// BindStates made by Bind() and the queue nodes of posted tasks.
+//
+// Each thread caches a free list per size class, so the common case takes no
+// lock. A list that grows past its limit gives half of its objects to a
+// shared list, and an empty list is refilled in one batch from the shared
+// list or from a new slab. Slabs are never returned to the system, so the
+// pool stays at the peak number of live objects. Sizes above kMaxSize go to
+// operator new.
+class BASE_EXPORT SmallObjectPool {
+ public:
+  static const size_t kMaxSize = 512;
+
+  struct Stats {
+    // Calls to Allocate() and Free(), including those larger than kMaxSize.
+    uint64_t allocations;
+    uint64_t frees;
+
+    // Calls to Allocate() larger than kMaxSize.
+    uint64_t large_allocations;
+
+    // Batches moved between the thread caches and the shared lists.
+    uint64_t batch_transfers;
+
+    // Memory obtained from the system for slabs.
+    size_t slab_bytes;
+  };
+
+  // Returns storage for an object of |size| bytes, aligned for any type up
+  // to 16 bytes. Never returns null.
+  static void* Allocate(size_t size);
+
+  // Releases |ptr|, which was returned by Allocate(|size|).
+  static void Free(void* ptr, size_t size);
+
+  // Sums the counters of all threads.
+  static void GetStats(Stats* stats);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(SmallObjectPool);
+};
+
+// An STL allocator drawing from SmallObjectPool, for node-based containers
+// such as the std::deque of a TaskQueue.
+template <typename T>
+class SmallObjectPoolAllocator {
+ public:
+  typedef T value_type;
+
+  template <typename U>
+  struct rebind {
+    typedef SmallObjectPoolAllocator<U> other;
+  };
+
+  SmallObjectPoolAllocator() {}
+  template <typename U>
+  SmallObjectPoolAllocator(const SmallObjectPoolAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(SmallObjectPool::Allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t n) { SmallObjectPool::Free(p, n * sizeof(T)); }
+
+  template <typename U>
+  bool operator==(const SmallObjectPoolAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const SmallObjectPoolAllocator<U>&) const {
+    return false;
+  }
+};
+
+}  // namespace base
+
+#endif  // BASE_MEMORY_SMALL_OBJECT_POOL_H_
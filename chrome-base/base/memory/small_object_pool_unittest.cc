@@ -0,0 +1,169 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/small_object_pool.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <deque>
+#include <set>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/location.h"
+#include "base/pending_task.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+void AllocateOnThread(size_t size, size_t count, std::vector<void*>* objects) {
+  for (size_t i = 0; i < count; ++i)
+    objects->push_back(SmallObjectPool::Allocate(size));
+}
+
+void FreeOnThread(size_t size, std::vector<void*>* objects) {
+  for (size_t i = 0; i < objects->size(); ++i)
+    SmallObjectPool::Free((*objects)[i], size);
+  objects->clear();
+}
+
+void FreeOnThreadAndSignal(size_t size,
+                           std::vector<void*>* objects,
+                           WaitableEvent* done) {
+  FreeOnThread(size, objects);
+  done->Signal();
+}
+
+void AddToSum(int value, int* sum) {
+  *sum += value;
+}
+
+}  // namespace
+
+TEST(SmallObjectPoolTest, AllocatesAlignedDistinctObjects) {
+  std::vector<void*> objects;
+  std::set<void*> distinct;
+  for (size_t size = 1; size <= SmallObjectPool::kMaxSize + 100; size += 7) {
+    void* object = SmallObjectPool::Allocate(size);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(object) % 16) << size;
+    memset(object, static_cast<int>(size), size);
+    objects.push_back(object);
+    distinct.insert(object);
+  }
+  EXPECT_EQ(objects.size(), distinct.size());
+
+  size_t size = 1;
+  for (size_t i = 0; i < objects.size(); ++i, size += 7) {
+    const unsigned char* bytes = static_cast<unsigned char*>(objects[i]);
+    EXPECT_EQ(static_cast<unsigned char>(size), bytes[0]);
+    EXPECT_EQ(static_cast<unsigned char>(size), bytes[size - 1]);
+    SmallObjectPool::Free(objects[i], size);
+  }
+  SmallObjectPool::Free(nullptr, 16);
+}
+
+TEST(SmallObjectPoolTest, ReusesFreedObjects) {
+  void* first = SmallObjectPool::Allocate(40);
+  SmallObjectPool::Free(first, 40);
+  // Same size class.
+  void* second = SmallObjectPool::Allocate(48);
+  EXPECT_EQ(first, second);
+  SmallObjectPool::Free(second, 48);
+}
+
+TEST(SmallObjectPoolTest, SteadyStateDoesNotGrow) {
+  std::vector<void*> objects;
+  for (int round = 0; round < 3; ++round) {
+    AllocateOnThread(96, 1000, &objects);
+    FreeOnThread(96, &objects);
+  }
+  SmallObjectPool::Stats before;
+  SmallObjectPool::GetStats(&before);
+  for (int round = 0; round < 100; ++round) {
+    AllocateOnThread(96, 1000, &objects);
+    FreeOnThread(96, &objects);
+  }
+  SmallObjectPool::Stats after;
+  SmallObjectPool::GetStats(&after);
+  EXPECT_EQ(before.slab_bytes, after.slab_bytes);
+  EXPECT_EQ(before.allocations + 100000, after.allocations);
+  EXPECT_EQ(before.frees + 100000, after.frees);
+}
+
+TEST(SmallObjectPoolTest, FreesOnAnotherThread) {
+  Thread thread("SmallObjectPoolTest");
+  ASSERT_TRUE(thread.Start());
+
+  // Objects made here are freed by |thread|, which hands them back to the
+  // shared lists, where this thread finds them again.
+  std::vector<void*> objects;
+  WaitableEvent done(false, false);
+  for (int round = 0; round < 20; ++round) {
+    AllocateOnThread(200, 500, &objects);
+    thread.task_runner()->PostTask(
+        FROM_HERE, Bind(&FreeOnThreadAndSignal, 200, Unretained(&objects),
+                        Unretained(&done)));
+    done.Wait();
+  }
+  thread.Stop();
+
+  SmallObjectPool::Stats stats;
+  SmallObjectPool::GetStats(&stats);
+  EXPECT_GT(stats.batch_transfers, 0u);
+  EXPECT_LT(stats.slab_bytes, 20u * 500 * 256);
+}
+
+TEST(SmallObjectPoolTest, CountsLargeAllocations) {
+  SmallObjectPool::Stats before;
+  SmallObjectPool::GetStats(&before);
+  void* large = SmallObjectPool::Allocate(SmallObjectPool::kMaxSize + 1);
+  SmallObjectPool::Free(large, SmallObjectPool::kMaxSize + 1);
+  SmallObjectPool::Stats after;
+  SmallObjectPool::GetStats(&after);
+  EXPECT_EQ(before.large_allocations + 1, after.large_allocations);
+  // They also count as calls to Allocate() and Free().
+  EXPECT_EQ(before.allocations + 1, after.allocations);
+  EXPECT_EQ(before.frees + 1, after.frees);
+}
+
+TEST(SmallObjectPoolTest, AllocatorWorksWithDeque) {
+  std::deque<int, SmallObjectPoolAllocator<int>> queue;
+  for (int i = 0; i < 10000; ++i)
+    queue.push_back(i);
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_EQ(i, queue.front());
+    queue.pop_front();
+  }
+}
+
+TEST(SmallObjectPoolTest, BindStatesAndTaskQueuesUseThePool) {
+  SmallObjectPool::Stats before;
+  SmallObjectPool::GetStats(&before);
+
+  int sum = 0;
+  {
+    TaskQueue queue;
+    for (int i = 0; i < 100; ++i)
+      queue.push(PendingTask(FROM_HERE, Bind(&AddToSum, i, &sum)));
+    while (!queue.empty()) {
+      queue.front().task.Run();
+      queue.pop();
+    }
+  }
+  EXPECT_EQ(4950, sum);
+
+  SmallObjectPool::Stats after;
+  SmallObjectPool::GetStats(&after);
+  EXPECT_GE(after.allocations - before.allocations, 100u);
+  EXPECT_EQ(after.allocations - before.allocations,
+            after.frees - before.frees);
+}
+
+}  // namespace base
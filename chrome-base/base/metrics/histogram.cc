@@ -20,7 +20,9 @@
 #include "base/logging.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/metrics/metrics_hashes.h"
+#include "base/metrics/persistent_histogram_allocator.h"
 #include "base/metrics/sample_vector.h"
+#include "base/metrics/sharded_sample_vector.h"
 #include "base/metrics/statistics_recorder.h"
 #include "base/pickle.h"
 #include "base/strings/string_util.h"
@@ -105,6 +107,7 @@ HistogramBase* Histogram::FactoryGet(const std::string& name,
         new Histogram(name, minimum, maximum, registered_ranges);
 
     tentative_histogram->SetFlags(flags);
+    tentative_histogram->InitializeSampleStorage();
     histogram =
         StatisticsRecorder::RegisterOrDeleteDuplicate(tentative_histogram);
   }
@@ -347,6 +350,29 @@ Histogram::Histogram(const std::string& name,
 Histogram::~Histogram() {
 }
 
+void Histogram::InitializeSampleStorage() {
+  if (!bucket_ranges_)
+    return;
+  DCHECK_EQ(0, samples_->redundant_count());
+
+  PersistentHistogramAllocator* allocator =
+      PersistentHistogramAllocator::GetGlobalAllocator();
+  HistogramBase::AtomicCount* counts;
+  HistogramSamples::Metadata* meta;
+  if (allocator &&
+      allocator->GetOrAllocateSampleStorage(*this, &counts, &meta)) {
+    samples_.reset(new SampleVector(HashMetricName(histogram_name()), counts,
+                                    bucket_count(), meta, bucket_ranges_));
+    SetFlags(kIsPersistent);
+    return;
+  }
+
+  if (flags() & kShardedSamplesFlag) {
+    samples_.reset(new ShardedSampleVector(HashMetricName(histogram_name()),
+                                           bucket_ranges_));
+  }
+}
+
 bool Histogram::PrintEmptyBucket(size_t index) const {
   return true;
 }
@@ -614,6 +640,7 @@ HistogramBase* LinearHistogram::FactoryGetWithRangeDescription(
     }
 
     tentative_histogram->SetFlags(flags);
+    tentative_histogram->InitializeSampleStorage();
     histogram =
         StatisticsRecorder::RegisterOrDeleteDuplicate(tentative_histogram);
   }
@@ -720,6 +747,7 @@ HistogramBase* BooleanHistogram::FactoryGet(const std::string& name,
         new BooleanHistogram(name, registered_ranges);
 
     tentative_histogram->SetFlags(flags);
+    tentative_histogram->InitializeSampleStorage();
     histogram =
         StatisticsRecorder::RegisterOrDeleteDuplicate(tentative_histogram);
   }
@@ -783,6 +811,7 @@ HistogramBase* CustomHistogram::FactoryGet(
         new CustomHistogram(name, registered_ranges);
 
     tentative_histogram->SetFlags(flags);
+    tentative_histogram->InitializeSampleStorage();
 
     histogram =
         StatisticsRecorder::RegisterOrDeleteDuplicate(tentative_histogram);
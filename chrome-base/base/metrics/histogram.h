@@ -216,6 +216,13 @@ class BASE_EXPORT Histogram : public HistogramBase {
   // be a name (or string description) given to the bucket.
   virtual const std::string GetAsciiBucketRange(size_t it) const;
 
+  // Chooses where samples are stored. With a global
+  // PersistentHistogramAllocator they go to its segment; otherwise, if
+  // kShardedSamplesFlag is set, to per-CPU shards. Factories call this right
+  // after SetFlags(), before the histogram is registered and can receive
+  // samples.
+  void InitializeSampleStorage();
+
  private:
   // Allow tests to corrupt our innards for testing purposes.
   FRIEND_TEST_ALL_PREFIXES(HistogramTest, BoundsTest);
@@ -270,7 +277,9 @@ class BASE_EXPORT Histogram : public HistogramBase {
 
   // Finally, provide the state that changes with the addition of each new
   // sample.
-  scoped_ptr<SampleVector> samples_;
+  // A SampleVector, possibly over persistent memory, unless
+  // kShardedSamplesFlag was given.
+  scoped_ptr<HistogramSamples> samples_;
 
   DISALLOW_COPY_AND_ASSIGN(Histogram);
 };
@@ -81,6 +81,18 @@ class BASE_EXPORT HistogramBase {
     // to shortcut looking up the callback if it doesn't exist.
     kCallbackExists = 0x20,
 
+    // Only for Histogram and its sub classes: record samples into per-CPU
+    // shards (see ShardedSampleVector) that are merged when snapshotting.
+    // Recording is then exact and contention-free under many threads, at the
+    // cost of one copy of the buckets per CPU. Must be passed to the factory;
+    // setting it later has no effect.
+    kShardedSamplesFlag = 0x40,
+
+    // Indicates that the histogram's samples live in a persistent memory
+    // segment (see PersistentHistogramAllocator), possibly shared with other
+    // processes, rather than on the heap. Set automatically.
+    kIsPersistent = 0x80,
+
     // Only for Histogram and its sub classes: fancy bucket-naming support.
     kHexRangePrintingFlag = 0x8000,
   };
@@ -78,15 +78,16 @@ HistogramSamples::HistogramSamples(uint64_t id, Metadata* meta)
 
 HistogramSamples::~HistogramSamples() {}
 
-// Despite using atomic operations, the increment/add actions below are *not*
-// atomic! Race conditions may cause loss of samples or even completely corrupt
-// the 64-bit sum on 32-bit machines. This is done intentionally to reduce the
-// cost of these operations that could be executed in performance-significant
-//  points of the code.
+// Despite using atomic operations, the bulk add/subtract actions below are
+// *not* atomic! Race conditions may cause loss of samples or even completely
+// corrupt the 64-bit sum on 32-bit machines. This is done intentionally to
+// reduce the cost of these operations that could be executed in
+// performance-significant points of the code.
 //
-// TODO(bcwhite): Gather quantitative information as to the cost of using
-// proper atomic increments and improve either globally or for those histograms
-// that really need it.
+// The per-sample IncreaseSum() and IncreaseRedundantCount() are real atomic
+// increments, because the metadata may live in memory shared with other
+// processes (see PersistentHistogramAllocator) where a lost update can never
+// be reconciled.
 
 void HistogramSamples::Add(const HistogramSamples& other) {
   meta_->sum += other.sum();
@@ -128,10 +129,18 @@ void HistogramSamples::Subtract(const HistogramSamples& other) {
   DCHECK(success);
 }
 
+int64_t HistogramSamples::sum() const {
+  return meta_->sum;
+}
+
+HistogramBase::Count HistogramSamples::redundant_count() const {
+  return subtle::NoBarrier_Load(&meta_->redundant_count);
+}
+
 bool HistogramSamples::Serialize(Pickle* pickle) const {
-  if (!pickle->WriteInt64(meta_->sum))
+  if (!pickle->WriteInt64(sum()))
     return false;
-  if (!pickle->WriteInt(subtle::NoBarrier_Load(&meta_->redundant_count)))
+  if (!pickle->WriteInt(redundant_count()))
     return false;
 
   HistogramBase::Sample min;
@@ -150,12 +159,16 @@ bool HistogramSamples::Serialize(Pickle* pickle) const {
 }
 
 void HistogramSamples::IncreaseSum(int64_t diff) {
+#if defined(ARCH_CPU_64_BITS)
+  subtle::NoBarrier_AtomicIncrement(
+      reinterpret_cast<volatile subtle::Atomic64*>(&meta_->sum), diff);
+#else
   meta_->sum += diff;
+#endif
 }
 
 void HistogramSamples::IncreaseRedundantCount(HistogramBase::Count diff) {
-  subtle::NoBarrier_Store(&meta_->redundant_count,
-      subtle::NoBarrier_Load(&meta_->redundant_count) + diff);
+  subtle::NoBarrier_AtomicIncrement(&meta_->redundant_count, diff);
 }
 
 SampleCountIterator::~SampleCountIterator() {}
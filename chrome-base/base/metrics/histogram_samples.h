@@ -68,12 +68,12 @@ class BASE_EXPORT HistogramSamples {
   virtual scoped_ptr<SampleCountIterator> Iterator() const = 0;
   virtual bool Serialize(Pickle* pickle) const;
 
-  // Accessor fuctions.
+  // Accessor fuctions. sum() and redundant_count() are virtual so that
+  // implementations keeping part of the metadata elsewhere (for example in
+  // per-CPU shards) can report the merged value.
   uint64_t id() const { return meta_->id; }
-  int64_t sum() const { return meta_->sum; }
-  HistogramBase::Count redundant_count() const {
-    return subtle::NoBarrier_Load(&meta_->redundant_count);
-  }
+  virtual int64_t sum() const;
+  virtual HistogramBase::Count redundant_count() const;
 
  protected:
   // Based on |op| type, add or subtract sample counts data from the iterator.
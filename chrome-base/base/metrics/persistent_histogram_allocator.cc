@@ -0,0 +1,349 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/persistent_histogram_allocator.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/metrics/bucket_ranges.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/metrics_hashes.h"
+#include "base/metrics/sample_vector.h"
+#include "base/metrics/statistics_recorder.h"
+#include "base/stl_util.h"
+
+namespace base {
+
+namespace {
+
+// Type identifiers used when storing in persistent memory so they can be
+// identified during extraction; the first 4 bytes of the SHA1 of the name
+// is used as a unique integer. A "version number" is added to the base
+// so that, if the structure of that object changes, stored older versions
+// will be safely ignored.
+enum : uint32_t {
+  kTypeIdHistogram   = 0xF1645910 + 1,  // SHA1(Histogram)   v1
+  kTypeIdRangesArray = 0xBCEA225A + 1,  // SHA1(RangesArray) v1
+  kTypeIdCountsArray = 0x53215530 + 1,  // SHA1(CountsArray) v1
+};
+
+// Flags that describe the recording process rather than the data and so are
+// not carried over to the reader's copies.
+const int32_t kProcessLocalFlags = HistogramBase::kIsPersistent |
+                                   HistogramBase::kCallbackExists |
+                                   HistogramBase::kIPCSerializationSourceFlag;
+
+PersistentHistogramAllocator* g_allocator = nullptr;
+
+}  // namespace
+
+// The record stored in the segment for each histogram. Counts and ranges are
+// separate allocations so that the record itself has a fixed layout.
+struct PersistentHistogramAllocator::PersistentHistogramData {
+  int32_t histogram_type;
+  int32_t flags;
+  int32_t minimum;
+  int32_t maximum;
+  uint32_t bucket_count;
+  uint32_t ranges_checksum;
+  PersistentMemoryAllocator::Reference ranges_ref;
+  PersistentMemoryAllocator::Reference counts_ref;
+  HistogramSamples::Metadata samples_metadata;
+
+  // Space for the histogram name will be added during the actual allocation
+  // request. This must be the last field of the structure. A zero-size array
+  // or a "flexible" array would be preferred but is not (yet) valid C++.
+  char name[1];
+};
+
+struct PersistentHistogramAllocator::MergeState {
+  // The local histogram that receives the deltas. Owned by
+  // StatisticsRecorder.
+  HistogramBase* local_histogram;
+
+  // Registered with StatisticsRecorder, so never deleted.
+  const BucketRanges* ranges;
+
+  // Live view of the shared counts.
+  scoped_ptr<SampleVector> shared_samples;
+
+  // Everything merged so far.
+  scoped_ptr<SampleVector> logged_samples;
+};
+
+PersistentHistogramAllocator::PersistentHistogramAllocator(
+    scoped_ptr<PersistentMemoryAllocator> memory)
+    : memory_allocator_(std::move(memory)) {}
+
+PersistentHistogramAllocator::~PersistentHistogramAllocator() {
+  STLDeleteValues(&merge_states_);
+}
+
+// static
+void PersistentHistogramAllocator::SetGlobalAllocator(
+    scoped_ptr<PersistentHistogramAllocator> allocator) {
+  // Releasing or changing an allocator is extremely dangerous because it
+  // likely has histograms stored within it. If the backing memory is also
+  // released, future accesses to those histograms will seg-fault.
+  CHECK(!g_allocator);
+  g_allocator = allocator.release();
+}
+
+// static
+PersistentHistogramAllocator*
+PersistentHistogramAllocator::GetGlobalAllocator() {
+  return g_allocator;
+}
+
+// static
+scoped_ptr<PersistentHistogramAllocator>
+PersistentHistogramAllocator::ReleaseGlobalAllocatorForTesting() {
+  PersistentHistogramAllocator* allocator = g_allocator;
+  g_allocator = nullptr;
+  return make_scoped_ptr(allocator);
+}
+
+bool PersistentHistogramAllocator::GetOrAllocateSampleStorage(
+    const Histogram& histogram,
+    HistogramBase::AtomicCount** counts,
+    HistogramSamples::Metadata** meta) {
+  if (memory_allocator_->IsReadonly() || memory_allocator_->IsCorrupt())
+    return false;
+
+  AutoLock auto_lock(lock_);
+  PersistentMemoryAllocator::Reference record =
+      FindRecord(histogram.histogram_name());
+  if (record) {
+    const PersistentHistogramData* data =
+        memory_allocator_->GetAsObject<PersistentHistogramData>(
+            record, kTypeIdHistogram);
+    if (data->histogram_type != histogram.GetHistogramType() ||
+        data->bucket_count != histogram.bucket_count() ||
+        data->ranges_checksum != histogram.bucket_ranges()->checksum()) {
+      DLOG(ERROR) << "Persistent histogram " << histogram.histogram_name()
+                  << " exists with a different shape";
+      return false;
+    }
+  } else {
+    record = AllocateRecord(histogram);
+    if (!record)
+      return false;
+  }
+  return GetRecordStorage(record, counts, meta);
+}
+
+size_t PersistentHistogramAllocator::MergeDeltasToStatisticsRecorder() {
+  DCHECK(StatisticsRecorder::IsActive());
+  DCHECK_NE(this, g_allocator);
+
+  size_t merged = 0;
+  PersistentMemoryAllocator::Iterator iter;
+  memory_allocator_->CreateIterator(&iter);
+  uint32_t type_id;
+  PersistentMemoryAllocator::Reference record;
+  while ((record = memory_allocator_->GetNextIterable(&iter, &type_id)) != 0) {
+    if (type_id != kTypeIdHistogram)
+      continue;
+
+    MergeState*& state = merge_states_[record];
+    if (!state) {
+      state = CreateMergeState(record).release();
+      if (!state) {
+        merge_states_.erase(record);
+        continue;
+      }
+    }
+
+    SampleVector delta(state->shared_samples->id(), state->ranges);
+    delta.Add(*state->shared_samples);
+    delta.Subtract(*state->logged_samples);
+    if (delta.TotalCount() == 0 && delta.redundant_count() == 0)
+      continue;
+
+    state->local_histogram->AddSamples(delta);
+    state->logged_samples->Add(delta);
+    ++merged;
+  }
+  return merged;
+}
+
+PersistentMemoryAllocator::Reference PersistentHistogramAllocator::FindRecord(
+    const std::string& name) {
+  PersistentMemoryAllocator::Iterator iter;
+  memory_allocator_->CreateIterator(&iter);
+  uint32_t type_id;
+  PersistentMemoryAllocator::Reference record;
+  while ((record = memory_allocator_->GetNextIterable(&iter, &type_id)) != 0) {
+    if (type_id != kTypeIdHistogram)
+      continue;
+    const PersistentHistogramData* data =
+        memory_allocator_->GetAsObject<PersistentHistogramData>(
+            record, kTypeIdHistogram);
+    size_t name_space = memory_allocator_->GetAllocSize(record) -
+                        offsetof(PersistentHistogramData, name);
+    if (data && name.size() < name_space &&
+        memcmp(data->name, name.c_str(), name.size() + 1) == 0) {
+      return record;
+    }
+  }
+  return 0;
+}
+
+PersistentMemoryAllocator::Reference
+PersistentHistogramAllocator::AllocateRecord(const Histogram& histogram) {
+  const BucketRanges* ranges = histogram.bucket_ranges();
+  const std::string& name = histogram.histogram_name();
+  size_t bucket_count = histogram.bucket_count();
+
+  PersistentMemoryAllocator::Reference ranges_ref =
+      memory_allocator_->Allocate(
+          ranges->size() * sizeof(HistogramBase::Sample), kTypeIdRangesArray);
+  PersistentMemoryAllocator::Reference counts_ref =
+      memory_allocator_->Allocate(
+          bucket_count * sizeof(HistogramBase::AtomicCount),
+          kTypeIdCountsArray);
+  PersistentMemoryAllocator::Reference record = memory_allocator_->Allocate(
+      offsetof(PersistentHistogramData, name) + name.size() + 1,
+      kTypeIdHistogram);
+  if (!ranges_ref || !counts_ref || !record) {
+    // The segment is full. Whatever was allocated is simply wasted; no reader
+    // will ever find it because nothing was made iterable.
+    return 0;
+  }
+
+  HistogramBase::Sample* ranges_data =
+      memory_allocator_->GetAsObject<HistogramBase::Sample>(ranges_ref,
+                                                            kTypeIdRangesArray);
+  for (size_t i = 0; i < ranges->size(); ++i)
+    ranges_data[i] = ranges->range(i);
+
+  PersistentHistogramData* data =
+      memory_allocator_->GetAsObject<PersistentHistogramData>(
+          record, kTypeIdHistogram);
+  data->histogram_type = histogram.GetHistogramType();
+  data->flags = histogram.flags() & ~kProcessLocalFlags;
+  data->minimum = histogram.declared_min();
+  data->maximum = histogram.declared_max();
+  data->bucket_count = static_cast<uint32_t>(bucket_count);
+  data->ranges_checksum = ranges->checksum();
+  data->ranges_ref = ranges_ref;
+  data->counts_ref = counts_ref;
+  data->samples_metadata.id = HashMetricName(name);
+  memcpy(data->name, name.c_str(), name.size() + 1);
+
+  // Publishing last guarantees that other processes never see a partially
+  // initialized record.
+  memory_allocator_->MakeIterable(record);
+  return record;
+}
+
+bool PersistentHistogramAllocator::GetRecordStorage(
+    PersistentMemoryAllocator::Reference record,
+    HistogramBase::AtomicCount** counts,
+    HistogramSamples::Metadata** meta) {
+  PersistentHistogramData* data =
+      memory_allocator_->GetAsObject<PersistentHistogramData>(
+          record, kTypeIdHistogram);
+  if (!data || data->bucket_count == 0)
+    return false;
+  HistogramBase::AtomicCount* counts_data =
+      memory_allocator_->GetAsObject<HistogramBase::AtomicCount>(
+          data->counts_ref, kTypeIdCountsArray);
+  if (!counts_data ||
+      memory_allocator_->GetAllocSize(data->counts_ref) <
+          data->bucket_count * sizeof(HistogramBase::AtomicCount)) {
+    return false;
+  }
+  *counts = counts_data;
+  *meta = &data->samples_metadata;
+  return true;
+}
+
+scoped_ptr<PersistentHistogramAllocator::MergeState>
+PersistentHistogramAllocator::CreateMergeState(
+    PersistentMemoryAllocator::Reference record) {
+  HistogramBase::AtomicCount* counts;
+  HistogramSamples::Metadata* meta;
+  if (!GetRecordStorage(record, &counts, &meta))
+    return nullptr;
+
+  const PersistentHistogramData* data =
+      memory_allocator_->GetAsObject<PersistentHistogramData>(
+          record, kTypeIdHistogram);
+  size_t name_space = memory_allocator_->GetAllocSize(record) -
+                      offsetof(PersistentHistogramData, name);
+  size_t name_length = strnlen(data->name, name_space);
+  if (name_length == name_space)
+    return nullptr;
+  std::string name(data->name, name_length);
+
+  size_t bucket_count = data->bucket_count;
+  const HistogramBase::Sample* ranges_data =
+      memory_allocator_->GetAsObject<HistogramBase::Sample>(data->ranges_ref,
+                                                            kTypeIdRangesArray);
+  if (!ranges_data ||
+      memory_allocator_->GetAllocSize(data->ranges_ref) <
+          (bucket_count + 1) * sizeof(HistogramBase::Sample)) {
+    return nullptr;
+  }
+  BucketRanges* ranges = new BucketRanges(bucket_count + 1);
+  for (size_t i = 0; i <= bucket_count; ++i)
+    ranges->set_range(i, ranges_data[i]);
+  ranges->ResetChecksum();
+  if (ranges->checksum() != data->ranges_checksum) {
+    delete ranges;
+    return nullptr;
+  }
+
+  int32_t flags = data->flags & ~kProcessLocalFlags;
+  HistogramBase* local_histogram = nullptr;
+  switch (data->histogram_type) {
+    case HISTOGRAM:
+      local_histogram = Histogram::FactoryGet(name, data->minimum,
+                                              data->maximum, bucket_count,
+                                              flags);
+      break;
+    case LINEAR_HISTOGRAM:
+      local_histogram = LinearHistogram::FactoryGet(name, data->minimum,
+                                                    data->maximum,
+                                                    bucket_count, flags);
+      break;
+    case BOOLEAN_HISTOGRAM:
+      local_histogram = BooleanHistogram::FactoryGet(name, flags);
+      break;
+    case CUSTOM_HISTOGRAM: {
+      // The first and last ranges are always 0 and INT_MAX and are added back
+      // by the factory.
+      std::vector<HistogramBase::Sample> custom_ranges(
+          ranges_data + 1, ranges_data + bucket_count);
+      local_histogram = CustomHistogram::FactoryGet(name, custom_ranges, flags);
+      break;
+    }
+    default:
+      break;
+  }
+  if (!local_histogram ||
+      local_histogram->GetHistogramType() != data->histogram_type ||
+      !static_cast<Histogram*>(local_histogram)->bucket_ranges()->Equals(
+          ranges)) {
+    DLOG(ERROR) << "Cannot merge persistent histogram " << name;
+    delete ranges;
+    return nullptr;
+  }
+
+  scoped_ptr<MergeState> state(new MergeState);
+  state->local_histogram = local_histogram;
+  state->ranges = StatisticsRecorder::RegisterOrDeleteDuplicateRanges(ranges);
+  state->shared_samples.reset(new SampleVector(
+      meta->id, counts, bucket_count, meta, state->ranges));
+  state->logged_samples.reset(new SampleVector(meta->id, state->ranges));
+  return state;
+}
+
+}  // namespace base
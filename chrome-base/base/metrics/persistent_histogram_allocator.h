@@ -0,0 +1,138 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_METRICS_PERSISTENT_HISTOGRAM_ALLOCATOR_H_
+#define BASE_METRICS_PERSISTENT_HISTOGRAM_ALLOCATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/histogram_base.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/metrics/persistent_memory_allocator.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+
+class BucketRanges;
+class Histogram;
+class SampleVector;
+
+// PersistentHistogramAllocator places histogram samples inside a
+// PersistentMemoryAllocator segment instead of the heap, so that several
+// processes can record into a single segment and one reader can export all
+// of them without any IPC.
+//
+// A typical multi-process deployment:
+//
+//   // Supervisor, before starting workers:
+//   scoped_ptr<SharedMemory> shm(new SharedMemory());
+//   shm->CreateAndMapAnonymous(kSize);
+//   ... hand shm->handle() to the workers ...
+//   PersistentHistogramAllocator reader(make_scoped_ptr(
+//       new SharedPersistentMemoryAllocator(std::move(shm), 0, "ASR", false)));
+//   ... periodically ...
+//   reader.MergeDeltasToStatisticsRecorder();
+//   StatisticsRecorder::ToJSON("");
+//
+//   // Worker, early in main():
+//   PersistentHistogramAllocator::SetGlobalAllocator(make_scoped_ptr(
+//       new PersistentHistogramAllocator(make_scoped_ptr(
+//           new SharedPersistentMemoryAllocator(std::move(shm), 0, "ASR",
+//                                               false)))));
+//   ... UMA_HISTOGRAM_* macros now record lock-free into the segment ...
+//
+// Every histogram record is identified by its name. A worker that creates a
+// histogram first looks for an existing record of the same name and shape and
+// shares its counts, so all workers normally add into one record. Two
+// processes creating the same histogram at the same instant may each allocate
+// a record; the reader sums records with equal names, so this is harmless.
+class BASE_EXPORT PersistentHistogramAllocator {
+ public:
+  explicit PersistentHistogramAllocator(
+      scoped_ptr<PersistentMemoryAllocator> memory);
+  ~PersistentHistogramAllocator();
+
+  PersistentMemoryAllocator* memory_allocator() {
+    return memory_allocator_.get();
+  }
+
+  // Makes |allocator| the destination of all histograms created from now on
+  // through the Histogram, LinearHistogram, BooleanHistogram and
+  // CustomHistogram factories. Histograms created earlier keep their heap
+  // storage. This is not thread-safe and should be called once, early, before
+  // other threads are started. The allocator is leaked at exit because
+  // histograms reference its memory until the very end.
+  static void SetGlobalAllocator(
+      scoped_ptr<PersistentHistogramAllocator> allocator);
+  static PersistentHistogramAllocator* GetGlobalAllocator();
+
+  // Removes and returns the global allocator, for tests.
+  static scoped_ptr<PersistentHistogramAllocator>
+  ReleaseGlobalAllocatorForTesting();
+
+  // Finds or allocates, in the segment, storage for the samples of
+  // |histogram|. On success returns true and points |counts| (with
+  // histogram.bucket_count() entries) and |meta| at the shared storage. Returns
+  // false if the segment is full, corrupt or read-only, or if a record of the
+  // same name has a different shape; the histogram should then keep its local
+  // storage. Thread-safe.
+  bool GetOrAllocateSampleStorage(const Histogram& histogram,
+                                  HistogramBase::AtomicCount** counts,
+                                  HistogramSamples::Metadata** meta);
+
+  // Adds everything recorded in the segment since the previous call to the
+  // identically named histograms of this process's StatisticsRecorder,
+  // creating them on the heap as needed. Records of the same name are summed.
+  // Returns the number of records that had new samples. Requires an active
+  // StatisticsRecorder, and this allocator must not be the global one (the
+  // copies would otherwise be persisted into the segment they are read
+  // from). Call from a single thread.
+  size_t MergeDeltasToStatisticsRecorder();
+
+ private:
+  struct PersistentHistogramData;
+
+  // What MergeDeltasToStatisticsRecorder() remembers about each record.
+  struct MergeState;
+
+  // Returns the record with the given name, or kReferenceNull.
+  PersistentMemoryAllocator::Reference FindRecord(const std::string& name);
+
+  // Allocates and publishes a new record for |histogram|.
+  PersistentMemoryAllocator::Reference AllocateRecord(
+      const Histogram& histogram);
+
+  // Resolves the counts and metadata of |record|. Returns false if the record
+  // is malformed.
+  bool GetRecordStorage(PersistentMemoryAllocator::Reference record,
+                        HistogramBase::AtomicCount** counts,
+                        HistogramSamples::Metadata** meta);
+
+  // Builds the state needed to merge |record|, or returns null if the record
+  // is malformed.
+  scoped_ptr<MergeState> CreateMergeState(
+      PersistentMemoryAllocator::Reference record);
+
+  scoped_ptr<PersistentMemoryAllocator> memory_allocator_;
+
+  // Serializes lookups and allocations made by this process so that threads
+  // racing to create the same histogram share one record.
+  Lock lock_;
+
+  // Reader-side state, keyed by record.
+  std::map<PersistentMemoryAllocator::Reference, MergeState*> merge_states_;
+
+  DISALLOW_COPY_AND_ASSIGN(PersistentHistogramAllocator);
+};
+
+}  // namespace base
+
+#endif  // BASE_METRICS_PERSISTENT_HISTOGRAM_ALLOCATOR_H_
@@ -0,0 +1,173 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/persistent_histogram_allocator.h"
+
+#include <utility>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/memory/shared_memory.h"
+#include "base/metrics/bucket_ranges.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/persistent_memory_allocator.h"
+#include "base/metrics/statistics_recorder.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+class PersistentHistogramAllocatorTest : public testing::Test {
+ protected:
+  static const size_t kSegmentSize = 64 << 10;
+
+  PersistentHistogramAllocatorTest() : statistics_recorder_(nullptr) {}
+
+  void SetUp() override {
+    // The "supervisor" creates the segment; the reader initializes it.
+    scoped_ptr<SharedMemory> shm(new SharedMemory());
+    ASSERT_TRUE(shm->CreateAndMapAnonymous(kSegmentSize));
+    handle_ = SharedMemory::DuplicateHandle(shm->handle());
+    reader_.reset(new PersistentHistogramAllocator(make_scoped_ptr(
+        new SharedPersistentMemoryAllocator(std::move(shm), 0, "Test",
+                                            false))));
+  }
+
+  void TearDown() override {
+    SharedMemory::CloseHandle(handle_);
+    UninitializeStatisticsRecorder();
+    PersistentHistogramAllocator::ReleaseGlobalAllocatorForTesting();
+  }
+
+  // Maps the segment again, as a worker process would, and makes it the
+  // destination of newly created histograms.
+  void StartWorker() {
+    PersistentHistogramAllocator::ReleaseGlobalAllocatorForTesting();
+    scoped_ptr<SharedMemory> shm(
+        new SharedMemory(SharedMemory::DuplicateHandle(handle_), false));
+    ASSERT_TRUE(shm->Map(kSegmentSize));
+    PersistentHistogramAllocator::SetGlobalAllocator(
+        make_scoped_ptr(new PersistentHistogramAllocator(make_scoped_ptr(
+            new SharedPersistentMemoryAllocator(std::move(shm), 0, "Test",
+                                                false)))));
+  }
+
+  void StopWorker() {
+    worker_allocators_.push_back(
+        PersistentHistogramAllocator::ReleaseGlobalAllocatorForTesting()
+            .release());
+  }
+
+  void InitializeStatisticsRecorder() {
+    statistics_recorder_ = new StatisticsRecorder();
+  }
+
+  void UninitializeStatisticsRecorder() {
+    delete statistics_recorder_;
+    statistics_recorder_ = nullptr;
+  }
+
+  SharedMemoryHandle handle_;
+  scoped_ptr<PersistentHistogramAllocator> reader_;
+  // Histograms created by the workers point into these; they must outlive
+  // the test body.
+  ScopedVector<PersistentHistogramAllocator> worker_allocators_;
+  StatisticsRecorder* statistics_recorder_;
+};
+
+TEST_F(PersistentHistogramAllocatorTest, WorkersShareOneRecord) {
+  StartWorker();
+  HistogramBase* first = Histogram::FactoryGet("Test.Latency", 1, 1000, 20,
+                                               HistogramBase::kNoFlags);
+  EXPECT_TRUE(first->flags() & HistogramBase::kIsPersistent);
+  first->AddCount(5, 10);
+  StopWorker();
+
+  StartWorker();
+  HistogramBase* second = Histogram::FactoryGet("Test.Latency", 1, 1000, 20,
+                                                HistogramBase::kNoFlags);
+  EXPECT_NE(first, second);
+  second->AddCount(500, 20);
+  StopWorker();
+
+  // Both workers recorded into the same counts.
+  scoped_ptr<HistogramSamples> samples = first->SnapshotSamples();
+  EXPECT_EQ(30, samples->TotalCount());
+  EXPECT_EQ(10 * 5 + 20 * 500, samples->sum());
+  EXPECT_EQ(20, samples->GetCount(500));
+
+  InitializeStatisticsRecorder();
+  EXPECT_EQ(1u, reader_->MergeDeltasToStatisticsRecorder());
+  HistogramBase* merged = StatisticsRecorder::FindHistogram("Test.Latency");
+  ASSERT_TRUE(merged);
+  EXPECT_FALSE(merged->flags() & HistogramBase::kIsPersistent);
+  samples = merged->SnapshotSamples();
+  EXPECT_EQ(30, samples->TotalCount());
+  EXPECT_EQ(10, samples->GetCount(5));
+  EXPECT_EQ(10 * 5 + 20 * 500, samples->sum());
+
+  // Nothing new: nothing merged.
+  EXPECT_EQ(0u, reader_->MergeDeltasToStatisticsRecorder());
+
+  // Only the delta is added on the next merge.
+  second->Add(5);
+  EXPECT_EQ(1u, reader_->MergeDeltasToStatisticsRecorder());
+  samples = merged->SnapshotSamples();
+  EXPECT_EQ(31, samples->TotalCount());
+  EXPECT_EQ(11, samples->GetCount(5));
+  EXPECT_EQ(samples->TotalCount(), samples->redundant_count());
+}
+
+TEST_F(PersistentHistogramAllocatorTest, AllHistogramTypes) {
+  StartWorker();
+  HistogramBase* linear = LinearHistogram::FactoryGet(
+      "Test.Linear", 1, 10, 11, HistogramBase::kUmaTargetedHistogramFlag);
+  linear->Add(3);
+  HistogramBase* boolean =
+      BooleanHistogram::FactoryGet("Test.Boolean", HistogramBase::kNoFlags);
+  boolean->AddBoolean(true);
+  std::vector<HistogramBase::Sample> custom_ranges;
+  custom_ranges.push_back(8000);
+  custom_ranges.push_back(16000);
+  custom_ranges.push_back(44100);
+  HistogramBase* custom = CustomHistogram::FactoryGet(
+      "Test.Custom", custom_ranges, HistogramBase::kNoFlags);
+  custom->Add(16000);
+  EXPECT_TRUE(linear->flags() & HistogramBase::kIsPersistent);
+  EXPECT_TRUE(boolean->flags() & HistogramBase::kIsPersistent);
+  EXPECT_TRUE(custom->flags() & HistogramBase::kIsPersistent);
+  StopWorker();
+
+  InitializeStatisticsRecorder();
+  EXPECT_EQ(3u, reader_->MergeDeltasToStatisticsRecorder());
+
+  HistogramBase* merged = StatisticsRecorder::FindHistogram("Test.Linear");
+  ASSERT_TRUE(merged);
+  EXPECT_EQ(LINEAR_HISTOGRAM, merged->GetHistogramType());
+  EXPECT_TRUE(merged->flags() & HistogramBase::kUmaTargetedHistogramFlag);
+  EXPECT_EQ(1, merged->SnapshotSamples()->GetCount(3));
+
+  merged = StatisticsRecorder::FindHistogram("Test.Boolean");
+  ASSERT_TRUE(merged);
+  EXPECT_EQ(BOOLEAN_HISTOGRAM, merged->GetHistogramType());
+  EXPECT_EQ(1, merged->SnapshotSamples()->GetCount(1));
+
+  merged = StatisticsRecorder::FindHistogram("Test.Custom");
+  ASSERT_TRUE(merged);
+  EXPECT_EQ(CUSTOM_HISTOGRAM, merged->GetHistogramType());
+  EXPECT_EQ(1, merged->SnapshotSamples()->GetCount(16000));
+}
+
+TEST_F(PersistentHistogramAllocatorTest, FullSegmentFallsBackToHeap) {
+  PersistentHistogramAllocator::SetGlobalAllocator(
+      make_scoped_ptr(new PersistentHistogramAllocator(make_scoped_ptr(
+          new LocalPersistentMemoryAllocator(1 << 10, 0, "Tiny")))));
+  HistogramBase* histogram = LinearHistogram::FactoryGet(
+      "Test.TooBig", 1, 1000, 1000, HistogramBase::kNoFlags);
+  EXPECT_FALSE(histogram->flags() & HistogramBase::kIsPersistent);
+  histogram->Add(10);
+  EXPECT_EQ(1, histogram->SnapshotSamples()->TotalCount());
+}
+
+}  // namespace base
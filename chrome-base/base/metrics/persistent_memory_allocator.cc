@@ -6,9 +6,11 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <utility>
 
 #include "base/files/memory_mapped_file.h"
 #include "base/logging.h"
+#include "base/memory/shared_memory.h"
 #include "base/metrics/histogram_macros.h"
 
 namespace {
@@ -648,6 +650,26 @@ LocalPersistentMemoryAllocator::~LocalPersistentMemoryAllocator() {
 }
 
 
+//----- SharedPersistentMemoryAllocator ----------------------------------------
+
+SharedPersistentMemoryAllocator::SharedPersistentMemoryAllocator(
+    scoped_ptr<SharedMemory> memory,
+    uint64_t id,
+    const std::string& name,
+    bool read_only)
+    : PersistentMemoryAllocator(static_cast<uint8_t*>(memory->memory()),
+                                memory->mapped_size(), 0, id, name, read_only),
+      shared_memory_(std::move(memory)) {}
+
+SharedPersistentMemoryAllocator::~SharedPersistentMemoryAllocator() {}
+
+// static
+bool SharedPersistentMemoryAllocator::IsSharedMemoryAcceptable(
+    const SharedMemory& memory) {
+  return IsMemoryAcceptable(memory.memory(), memory.mapped_size(), 0, true);
+}
+
+
 //----- FilePersistentMemoryAllocator ------------------------------------------
 
 FilePersistentMemoryAllocator::FilePersistentMemoryAllocator(
@@ -19,6 +19,7 @@ namespace base {
 
 class HistogramBase;
 class MemoryMappedFile;
+class SharedMemory;
 
 // Simple allocator for pieces of a memory block that may be persistent
 // to some storage or shared across multiple processes. This class resides
@@ -308,6 +309,33 @@ class BASE_EXPORT LocalPersistentMemoryAllocator
 };
 
 
+// This allocator takes a shared-memory object and performs allocation from
+// it. The memory must already be mapped. The allocator takes ownership of the
+// shared-memory object. The first process to construct an allocator over a
+// zeroed segment initializes it; others (for example workers that received
+// the handle from a supervisor) attach to the existing contents. All
+// allocations and iteration are lock-free and safe across processes.
+class BASE_EXPORT SharedPersistentMemoryAllocator
+    : public PersistentMemoryAllocator {
+ public:
+  SharedPersistentMemoryAllocator(scoped_ptr<SharedMemory> memory, uint64_t id,
+                                  const std::string& name, bool read_only);
+  ~SharedPersistentMemoryAllocator() override;
+
+  SharedMemory* shared_memory() { return shared_memory_.get(); }
+
+  // Ensure that the memory isn't so invalid that it won't crash when passing
+  // it to the allocator. This doesn't guarantee the data is valid, just that
+  // it won't cause the program to abort.
+  static bool IsSharedMemoryAcceptable(const SharedMemory& memory);
+
+ private:
+  scoped_ptr<SharedMemory> shared_memory_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedPersistentMemoryAllocator);
+};
+
+
 // This allocator takes a memory-mapped file object and performs allocation
 // from it. The allocator takes ownership of the file object. Only read access
 // is provided due to limitions of the MemoryMappedFile class.
@@ -41,8 +41,9 @@ SampleVector::~SampleVector() {}
 
 void SampleVector::Accumulate(Sample value, Count count) {
   size_t bucket_index = GetBucketIndex(value);
-  subtle::NoBarrier_Store(&counts_[bucket_index],
-      subtle::NoBarrier_Load(&counts_[bucket_index]) + count);
+  // An atomic increment keeps concurrent recorders, possibly in other
+  // processes sharing |counts_|, from losing each other's samples.
+  subtle::NoBarrier_AtomicIncrement(&counts_[bucket_index], count);
   IncreaseSum(static_cast<int64_t>(count) * value);
   IncreaseRedundantCount(count);
 }
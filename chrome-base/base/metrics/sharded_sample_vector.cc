@@ -0,0 +1,252 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/sharded_sample_vector.h"
+
+#include <string.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/metrics/bucket_ranges.h"
+#include "base/metrics/sample_vector.h"
+#include "base/sys_info.h"
+#include "base/threading/platform_thread.h"
+#include "build/build_config.h"
+
+#if defined(OS_LINUX)
+#include <sched.h>
+#endif
+
+namespace base {
+
+typedef HistogramBase::Count Count;
+typedef HistogramBase::Sample Sample;
+
+namespace {
+
+size_t DefaultShardCount() {
+  int processors = SysInfo::NumberOfProcessors();
+  if (processors < 1)
+    return 1;
+  if (static_cast<size_t>(processors) > ShardedSampleVector::kMaxShards)
+    return ShardedSampleVector::kMaxShards;
+  return static_cast<size_t>(processors);
+}
+
+size_t RoundUpToCacheLine(size_t count) {
+  const size_t per_line =
+      ShardedSampleVector::kCacheLineSize / sizeof(HistogramBase::AtomicCount);
+  return (count + per_line - 1) / per_line * per_line;
+}
+
+// Iterates over a private, merged copy of all shards.
+class MergedSampleVectorIterator : public SampleCountIterator {
+ public:
+  MergedSampleVectorIterator(
+      scoped_ptr<std::vector<HistogramBase::AtomicCount>> counts,
+      const BucketRanges* bucket_ranges)
+      : counts_(std::move(counts)), iter_(counts_.get(), bucket_ranges) {}
+  ~MergedSampleVectorIterator() override {}
+
+  // SampleCountIterator implementation:
+  bool Done() const override { return iter_.Done(); }
+  void Next() override { iter_.Next(); }
+  void Get(HistogramBase::Sample* min,
+           HistogramBase::Sample* max,
+           HistogramBase::Count* count) const override {
+    iter_.Get(min, max, count);
+  }
+  bool GetBucketIndex(size_t* index) const override {
+    return iter_.GetBucketIndex(index);
+  }
+
+ private:
+  // Must be declared before |iter_|, which points into it.
+  scoped_ptr<std::vector<HistogramBase::AtomicCount>> counts_;
+  SampleVectorIterator iter_;
+
+  DISALLOW_COPY_AND_ASSIGN(MergedSampleVectorIterator);
+};
+
+}  // namespace
+
+// static
+const size_t ShardedSampleVector::kMaxShards = 64;
+
+// static
+const size_t ShardedSampleVector::kCacheLineSize = 64;
+
+ShardedSampleVector::ShardedSampleVector(uint64_t id,
+                                         const BucketRanges* bucket_ranges)
+    : ShardedSampleVector(id, bucket_ranges, DefaultShardCount()) {}
+
+ShardedSampleVector::ShardedSampleVector(uint64_t id,
+                                         const BucketRanges* bucket_ranges,
+                                         size_t shard_count)
+    : HistogramSamples(id),
+      shard_count_(shard_count),
+      counts_stride_(RoundUpToCacheLine(bucket_ranges->bucket_count())),
+      bucket_ranges_(bucket_ranges) {
+  CHECK_GE(bucket_ranges_->bucket_count(), 1u);
+  CHECK_GE(shard_count_, 1u);
+  static_assert(sizeof(ShardMeta) <= 64, "ShardMeta must fit a cache line");
+
+  size_t counts_bytes =
+      shard_count_ * counts_stride_ * sizeof(HistogramBase::AtomicCount);
+  counts_.reset(static_cast<HistogramBase::AtomicCount*>(
+      AlignedAlloc(counts_bytes, kCacheLineSize)));
+  memset(counts_.get(), 0, counts_bytes);
+
+  size_t meta_bytes = shard_count_ * kCacheLineSize;
+  shard_meta_.reset(static_cast<char*>(AlignedAlloc(meta_bytes,
+                                                    kCacheLineSize)));
+  memset(shard_meta_.get(), 0, meta_bytes);
+}
+
+ShardedSampleVector::~ShardedSampleVector() {}
+
+void ShardedSampleVector::Accumulate(Sample value, Count count) {
+  size_t bucket_index = GetBucketIndex(value);
+  size_t shard = CurrentShardIndex();
+  subtle::NoBarrier_AtomicIncrement(&shard_counts(shard)[bucket_index],
+                                    count);
+  ShardMeta* meta = shard_meta(shard);
+#if defined(ARCH_CPU_64_BITS)
+  subtle::NoBarrier_AtomicIncrement(&meta->sum,
+                                    static_cast<int64_t>(count) * value);
+#else
+  meta->sum += static_cast<int64_t>(count) * value;
+#endif
+  subtle::NoBarrier_AtomicIncrement(&meta->redundant_count, count);
+}
+
+Count ShardedSampleVector::GetCount(Sample value) const {
+  return GetCountAtIndex(GetBucketIndex(value));
+}
+
+Count ShardedSampleVector::TotalCount() const {
+  Count count = 0;
+  size_t bucket_count = bucket_ranges_->bucket_count();
+  for (size_t shard = 0; shard < shard_count_; ++shard) {
+    const HistogramBase::AtomicCount* counts = shard_counts(shard);
+    for (size_t i = 0; i < bucket_count; ++i)
+      count += subtle::NoBarrier_Load(&counts[i]);
+  }
+  return count;
+}
+
+Count ShardedSampleVector::GetCountAtIndex(size_t bucket_index) const {
+  DCHECK_LT(bucket_index, bucket_ranges_->bucket_count());
+  Count count = 0;
+  for (size_t shard = 0; shard < shard_count_; ++shard)
+    count += subtle::NoBarrier_Load(&shard_counts(shard)[bucket_index]);
+  return count;
+}
+
+scoped_ptr<SampleCountIterator> ShardedSampleVector::Iterator() const {
+  size_t bucket_count = bucket_ranges_->bucket_count();
+  scoped_ptr<std::vector<HistogramBase::AtomicCount>> merged(
+      new std::vector<HistogramBase::AtomicCount>(bucket_count));
+  for (size_t shard = 0; shard < shard_count_; ++shard) {
+    const HistogramBase::AtomicCount* counts = shard_counts(shard);
+    for (size_t i = 0; i < bucket_count; ++i)
+      (*merged)[i] += subtle::NoBarrier_Load(&counts[i]);
+  }
+  return scoped_ptr<SampleCountIterator>(
+      new MergedSampleVectorIterator(std::move(merged), bucket_ranges_));
+}
+
+int64_t ShardedSampleVector::sum() const {
+  int64_t sum = HistogramSamples::sum();
+  for (size_t shard = 0; shard < shard_count_; ++shard) {
+#if defined(ARCH_CPU_64_BITS)
+    sum += subtle::NoBarrier_Load(&shard_meta(shard)->sum);
+#else
+    sum += shard_meta(shard)->sum;
+#endif
+  }
+  return sum;
+}
+
+Count ShardedSampleVector::redundant_count() const {
+  Count count = HistogramSamples::redundant_count();
+  for (size_t shard = 0; shard < shard_count_; ++shard)
+    count += subtle::NoBarrier_Load(&shard_meta(shard)->redundant_count);
+  return count;
+}
+
+bool ShardedSampleVector::AddSubtractImpl(SampleCountIterator* iter,
+                                          HistogramSamples::Operator op) {
+  // Bulk merges are rare compared to Accumulate(), so they all go to the
+  // current shard. The sum and redundant count have already been folded into
+  // the shared metadata by HistogramSamples.
+  HistogramBase::AtomicCount* counts = shard_counts(CurrentShardIndex());
+  HistogramBase::Sample min;
+  HistogramBase::Sample max;
+  HistogramBase::Count count;
+
+  size_t index = 0;
+  size_t bucket_count = bucket_ranges_->bucket_count();
+  while (index < bucket_count && !iter->Done()) {
+    iter->Get(&min, &max, &count);
+    if (min == bucket_ranges_->range(index) &&
+        max == bucket_ranges_->range(index + 1)) {
+      subtle::NoBarrier_AtomicIncrement(
+          &counts[index], (op == HistogramSamples::ADD) ? count : -count);
+      iter->Next();
+    } else if (min > bucket_ranges_->range(index)) {
+      index++;
+    } else {
+      return false;
+    }
+  }
+
+  return iter->Done();
+}
+
+size_t ShardedSampleVector::CurrentShardIndex() const {
+  if (shard_count_ == 1)
+    return 0;
+#if defined(OS_LINUX)
+  // sched_getcpu() is served from the vDSO and costs a few nanoseconds. A
+  // thread may migrate right after the call; that only costs some sharing,
+  // never a lost count, since all updates are atomic.
+  int cpu = sched_getcpu();
+  if (cpu >= 0)
+    return static_cast<size_t>(cpu) % shard_count_;
+#endif
+  // Spread threads by their id instead. Multiplying by a large odd constant
+  // mixes consecutive ids across the shards.
+  uint64_t id = static_cast<uint64_t>(PlatformThread::CurrentId());
+  return static_cast<size_t>((id * 0x9E3779B97F4A7C15ULL) >> 32) %
+         shard_count_;
+}
+
+// Use simple binary search, as SampleVector does.
+size_t ShardedSampleVector::GetBucketIndex(Sample value) const {
+  size_t bucket_count = bucket_ranges_->bucket_count();
+  CHECK_GE(value, bucket_ranges_->range(0));
+  CHECK_LT(value, bucket_ranges_->range(bucket_count));
+
+  size_t under = 0;
+  size_t over = bucket_count;
+  size_t mid;
+  do {
+    mid = under + (over - under) / 2;
+    if (mid == under)
+      break;
+    if (bucket_ranges_->range(mid) <= value)
+      under = mid;
+    else
+      over = mid;
+  } while (true);
+
+  DCHECK_LE(bucket_ranges_->range(mid), value);
+  DCHECK_GT(bucket_ranges_->range(mid + 1), value);
+  return mid;
+}
+
+}  // namespace base
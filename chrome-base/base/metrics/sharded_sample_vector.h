@@ -0,0 +1,119 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// ShardedSampleVector implements the HistogramSamples interface with one
+// private copy of the bucket counts per CPU. Recording a sample touches only
+// the shard of the CPU the calling thread is running on, and uses atomic
+// increments, so concurrent recording neither loses counts nor bounces a
+// shared cache line between cores. Reads (GetCount, TotalCount, Iterator and
+// therefore snapshots) merge all shards.
+//
+// Histograms created with HistogramBase::kShardedSamplesFlag use this class
+// for their live samples; snapshots are still plain SampleVectors.
+
+#ifndef BASE_METRICS_SHARDED_SAMPLE_VECTOR_H_
+#define BASE_METRICS_SHARDED_SAMPLE_VECTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/atomicops.h"
+#include "base/gtest_prod_util.h"
+#include "base/macros.h"
+#include "base/memory/aligned_memory.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/histogram_base.h"
+#include "base/metrics/histogram_samples.h"
+
+namespace base {
+
+class BucketRanges;
+
+class BASE_EXPORT ShardedSampleVector : public HistogramSamples {
+ public:
+  // Upper bound on the number of shards, regardless of the CPU count.
+  static const size_t kMaxShards;
+
+  // Alignment and padding unit used to keep shards apart.
+  static const size_t kCacheLineSize;
+
+  // Uses one shard per processor, up to kMaxShards.
+  ShardedSampleVector(uint64_t id, const BucketRanges* bucket_ranges);
+  // Uses exactly |shard_count| shards. Mostly useful for tests.
+  ShardedSampleVector(uint64_t id,
+                      const BucketRanges* bucket_ranges,
+                      size_t shard_count);
+  ~ShardedSampleVector() override;
+
+  // HistogramSamples implementation:
+  void Accumulate(HistogramBase::Sample value,
+                  HistogramBase::Count count) override;
+  HistogramBase::Count GetCount(HistogramBase::Sample value) const override;
+  HistogramBase::Count TotalCount() const override;
+  scoped_ptr<SampleCountIterator> Iterator() const override;
+  int64_t sum() const override;
+  HistogramBase::Count redundant_count() const override;
+
+  // Get the merged count of a specific bucket.
+  HistogramBase::Count GetCountAtIndex(size_t bucket_index) const;
+
+  size_t shard_count() const { return shard_count_; }
+
+ protected:
+  bool AddSubtractImpl(
+      SampleCountIterator* iter,
+      HistogramSamples::Operator op) override;  // |op| is ADD or SUBTRACT.
+
+ private:
+  FRIEND_TEST_ALL_PREFIXES(ShardedSampleVectorTest, ShardSelection);
+
+  // Per-shard equivalent of HistogramSamples::Metadata. Each one occupies a
+  // whole cache line.
+  struct ShardMeta {
+#if defined(ARCH_CPU_64_BITS)
+    subtle::Atomic64 sum;
+#else
+    // Like HistogramSamples::Metadata::sum, not atomic on 32-bit machines.
+    int64_t sum;
+#endif
+    HistogramBase::AtomicCount redundant_count;
+  };
+
+  // Returns the shard the calling thread should record into.
+  size_t CurrentShardIndex() const;
+
+  size_t GetBucketIndex(HistogramBase::Sample value) const;
+
+  // Returns the counts of shard |shard|; |counts_stride_| entries long.
+  HistogramBase::AtomicCount* shard_counts(size_t shard) {
+    return counts_.get() + shard * counts_stride_;
+  }
+  const HistogramBase::AtomicCount* shard_counts(size_t shard) const {
+    return counts_.get() + shard * counts_stride_;
+  }
+  ShardMeta* shard_meta(size_t shard) const {
+    return reinterpret_cast<ShardMeta*>(shard_meta_.get() +
+                                        shard * kCacheLineSize);
+  }
+
+  const size_t shard_count_;
+
+  // Number of counts reserved per shard: the bucket count rounded up to a
+  // whole number of cache lines so that no two shards share a line.
+  const size_t counts_stride_;
+
+  // Both blocks are cache-line aligned. |shard_meta_| holds one ShardMeta per
+  // kCacheLineSize bytes.
+  scoped_ptr<HistogramBase::AtomicCount, AlignedFreeDeleter> counts_;
+  scoped_ptr<char, AlignedFreeDeleter> shard_meta_;
+
+  // Shares the same BucketRanges with Histogram object.
+  const BucketRanges* const bucket_ranges_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedSampleVector);
+};
+
+}  // namespace base
+
+#endif  // BASE_METRICS_SHARDED_SAMPLE_VECTOR_H_
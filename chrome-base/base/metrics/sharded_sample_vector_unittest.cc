@@ -0,0 +1,206 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/sharded_sample_vector.h"
+
+#include <limits.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/bucket_ranges.h"
+#include "base/metrics/histogram.h"
+#include "base/metrics/sample_vector.h"
+#include "base/pickle.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace {
+
+// Records one sample of value 1 and two of value 5 per iteration.
+class RecordingDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  RecordingDelegate(HistogramSamples* samples, int iterations)
+      : samples_(samples), iterations_(iterations) {}
+
+  void Run() override {
+    for (int i = 0; i < iterations_; ++i) {
+      samples_->Accumulate(1, 1);
+      samples_->Accumulate(5, 2);
+    }
+  }
+
+ private:
+  HistogramSamples* const samples_;
+  const int iterations_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingDelegate);
+};
+
+void InitializeRanges(BucketRanges* ranges) {
+  // Custom buckets: [0, 1) [1, 5) [5, 10) [10, INT_MAX)
+  ranges->set_range(0, 0);
+  ranges->set_range(1, 1);
+  ranges->set_range(2, 5);
+  ranges->set_range(3, 10);
+  ranges->set_range(4, INT_MAX);
+}
+
+}  // namespace
+
+TEST(ShardedSampleVectorTest, AccumulateTest) {
+  BucketRanges ranges(5);
+  InitializeRanges(&ranges);
+  ShardedSampleVector samples(1, &ranges, 4);
+
+  samples.Accumulate(1, 200);
+  samples.Accumulate(2, -300);
+  EXPECT_EQ(-100, samples.GetCountAtIndex(1));
+
+  samples.Accumulate(5, 200);
+  EXPECT_EQ(200, samples.GetCountAtIndex(2));
+  EXPECT_EQ(200, samples.GetCount(9));
+
+  EXPECT_EQ(600, samples.sum());
+  EXPECT_EQ(100, samples.redundant_count());
+  EXPECT_EQ(samples.TotalCount(), samples.redundant_count());
+}
+
+TEST(ShardedSampleVectorTest, ShardSelection) {
+  BucketRanges ranges(5);
+  InitializeRanges(&ranges);
+
+  ShardedSampleVector single(1, &ranges, 1);
+  EXPECT_EQ(0u, single.CurrentShardIndex());
+
+  ShardedSampleVector many(1, &ranges, 3);
+  EXPECT_LT(many.CurrentShardIndex(), 3u);
+
+  ShardedSampleVector defaulted(1, &ranges);
+  EXPECT_GE(defaulted.shard_count(), 1u);
+  EXPECT_LE(defaulted.shard_count(), ShardedSampleVector::kMaxShards);
+}
+
+TEST(ShardedSampleVectorTest, ConcurrentAccumulateIsExact) {
+  const int kThreads = 8;
+  const int kIterations = 20000;
+
+  BucketRanges ranges(5);
+  InitializeRanges(&ranges);
+  ShardedSampleVector samples(1, &ranges, 4);
+
+  RecordingDelegate delegate(&samples, kIterations);
+  DelegateSimpleThreadPool pool("ShardedSampleVectorTest", kThreads);
+  pool.AddWork(&delegate, kThreads);
+  pool.Start();
+  pool.JoinAll();
+
+  EXPECT_EQ(kThreads * kIterations, samples.GetCountAtIndex(1));
+  EXPECT_EQ(2 * kThreads * kIterations, samples.GetCountAtIndex(2));
+  EXPECT_EQ(3 * kThreads * kIterations, samples.TotalCount());
+  EXPECT_EQ(samples.TotalCount(), samples.redundant_count());
+  EXPECT_EQ(11 * kThreads * kIterations, samples.sum());
+}
+
+TEST(ShardedSampleVectorTest, AddSubtractAndIterate) {
+  BucketRanges ranges(5);
+  InitializeRanges(&ranges);
+  ShardedSampleVector samples(1, &ranges, 4);
+  samples.Accumulate(0, 100);
+  samples.Accumulate(7, 300);
+
+  SampleVector other(2, &ranges);
+  other.Accumulate(0, 50);
+  other.Accumulate(12, 10);
+
+  samples.Add(other);
+  EXPECT_EQ(150, samples.GetCount(0));
+  EXPECT_EQ(300, samples.GetCount(7));
+  EXPECT_EQ(10, samples.GetCount(12));
+  EXPECT_EQ(2100 + 120, samples.sum());
+  EXPECT_EQ(460, samples.redundant_count());
+  EXPECT_EQ(samples.TotalCount(), samples.redundant_count());
+
+  samples.Subtract(other);
+  EXPECT_EQ(100, samples.GetCount(0));
+  EXPECT_EQ(0, samples.GetCount(12));
+  EXPECT_EQ(2100, samples.sum());
+  EXPECT_EQ(400, samples.redundant_count());
+
+  // The iterator skips empty buckets and reports merged counts.
+  scoped_ptr<SampleCountIterator> it = samples.Iterator();
+  HistogramBase::Sample min;
+  HistogramBase::Sample max;
+  HistogramBase::Count count;
+  size_t index;
+  ASSERT_FALSE(it->Done());
+  it->Get(&min, &max, &count);
+  EXPECT_EQ(0, min);
+  EXPECT_EQ(1, max);
+  EXPECT_EQ(100, count);
+  EXPECT_TRUE(it->GetBucketIndex(&index));
+  EXPECT_EQ(0u, index);
+  it->Next();
+  ASSERT_FALSE(it->Done());
+  it->Get(&min, &max, &count);
+  EXPECT_EQ(5, min);
+  EXPECT_EQ(10, max);
+  EXPECT_EQ(300, count);
+  it->Next();
+  EXPECT_TRUE(it->Done());
+}
+
+TEST(ShardedSampleVectorTest, SerializeMergedSamples) {
+  BucketRanges ranges(5);
+  InitializeRanges(&ranges);
+  ShardedSampleVector samples(1, &ranges, 4);
+  samples.Accumulate(1, 3);
+  samples.Accumulate(10, 2);
+
+  Pickle pickle;
+  ASSERT_TRUE(samples.Serialize(&pickle));
+
+  SampleVector restored(1, &ranges);
+  PickleIterator iter(pickle);
+  ASSERT_TRUE(restored.AddFromPickle(&iter));
+  EXPECT_EQ(3, restored.GetCount(1));
+  EXPECT_EQ(2, restored.GetCount(10));
+  EXPECT_EQ(23, restored.sum());
+  EXPECT_EQ(5, restored.redundant_count());
+}
+
+TEST(ShardedSampleVectorTest, HistogramWithShardedSamplesFlag) {
+  HistogramBase* histogram = Histogram::FactoryGet(
+      "ShardedHistogram", 1, 1000, 10, HistogramBase::kShardedSamplesFlag);
+  ASSERT_TRUE(histogram);
+
+  const int kThreads = 4;
+  const int kIterations = 10000;
+  class AddDelegate : public DelegateSimpleThread::Delegate {
+   public:
+    explicit AddDelegate(HistogramBase* histogram) : histogram_(histogram) {}
+    void Run() override {
+      for (int i = 0; i < kIterations; ++i)
+        histogram_->Add(i % 100);
+    }
+
+   private:
+    HistogramBase* const histogram_;
+  } delegate(histogram);
+  DelegateSimpleThreadPool pool("ShardedHistogramTest", kThreads);
+  pool.AddWork(&delegate, kThreads);
+  pool.Start();
+  pool.JoinAll();
+
+  scoped_ptr<HistogramSamples> snapshot = histogram->SnapshotSamples();
+  EXPECT_EQ(kThreads * kIterations, snapshot->TotalCount());
+  EXPECT_EQ(snapshot->TotalCount(), snapshot->redundant_count());
+  EXPECT_EQ(kThreads * (kIterations / 100) * (99 * 100 / 2), snapshot->sum());
+  EXPECT_EQ(HistogramBase::NO_INCONSISTENCIES,
+            histogram->FindCorruption(*snapshot));
+}
+
+}  // namespace base
@@ -5,11 +5,13 @@
 #ifndef BASE_PENDING_TASK_H_
 #define BASE_PENDING_TASK_H_
 
+#include <deque>
 #include <queue>
 
 #include "base/base_export.h"
 #include "base/callback.h"
 #include "base/location.h"
+#include "base/memory/small_object_pool.h"
 #include "base/time/time.h"
 #include "base/tracking_info.h"
 
@@ -47,7 +49,12 @@ struct BASE_EXPORT PendingTask : public TrackingInfo {
 
 // Wrapper around std::queue specialized for PendingTask which adds a Swap
 // helper method.
-class BASE_EXPORT TaskQueue : public std::queue<PendingTask> {
+// The blocks of the deque are taken from SmallObjectPool, so that a queue
+// that is filled and drained continuously does not call malloc.
+class BASE_EXPORT TaskQueue
+    : public std::queue<PendingTask,
+                        std::deque<PendingTask,
+                                   SmallObjectPoolAllocator<PendingTask>>> {
  public:
   void Swap(TaskQueue* queue);
 };
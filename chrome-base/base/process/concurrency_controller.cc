@@ -0,0 +1,203 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/process/concurrency_controller.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/process/process_metrics.h"
+#include "base/sys_info.h"
+#include "build/build_config.h"
+
+#if defined(OS_LINUX)
+#include "base/memory/memory_pressure_monitor_linux.h"
+#endif
+
+namespace base {
+
+namespace {
+
+// The bounds of the latency gradient. Below 1 the limit shrinks; the lower
+// bound keeps one bad update from halving it more than once.
+const double kMinGradient = 0.5;
+const double kMaxGradient = 1.0;
+
+// The weight of each update in the long-term service time. It rises slowly,
+// so that it stays near the service time without contention, and falls
+// quickly when requests get cheaper.
+const double kLongLatencyRiseWeight = 0.05;
+const double kLongLatencyFallWeight = 0.5;
+
+// Requests count as queued when they wait at least this fraction of their
+// service time on average.
+const double kQueuedWaitFraction = 0.05;
+
+// The share of all processors above which the CPUs count as saturated.
+const double kSaturatedCPUFraction = 0.95;
+
+// The share of its previous value that throughput may drop to after the
+// limit was raised before the raise is undone.
+const double kThroughputDropFraction = 0.95;
+
+// The default working set budget, as a share of the memory available.
+const double kDefaultWorkingSetFraction = 0.8;
+
+int64_t DefaultMaxWorkingSet() {
+#if defined(OS_LINUX)
+  const int64_t cgroup_memory_limit =
+      nix::MemoryPressureMonitor::GetCgroupMemoryLimit();
+#else
+  const int64_t cgroup_memory_limit = 0;
+#endif
+  return ConcurrencyController::GetDefaultMaxWorkingSet(
+      SysInfo::AmountOfPhysicalMemory(), cgroup_memory_limit);
+}
+
+}  // namespace
+
+ConcurrencyController::Options::Options()
+    : min_limit(1),
+      max_limit(SysInfo::NumberOfProcessors()),
+      initial_limit(1),
+      tolerance(1.5),
+      smoothing(0.2),
+      min_samples(10),
+      max_working_set(0),
+      memory_backoff(0.75) {}
+
+ConcurrencyController::Load::Load() : cpu_usage(0), working_set(0) {}
+
+ConcurrencyController::ConcurrencyController()
+    : ConcurrencyController(Options()) {}
+
+ConcurrencyController::ConcurrencyController(const Options& options)
+    : options_(options),
+      num_processors_(SysInfo::NumberOfProcessors()),
+      max_working_set_(options.max_working_set ? options.max_working_set
+                                               : DefaultMaxWorkingSet()),
+      metrics_(ProcessMetrics::CreateCurrentProcessMetrics()),
+      estimate_(options.initial_limit),
+      limit_(options.initial_limit),
+      samples_(0),
+      long_latency_(0),
+      last_throughput_(0),
+      last_queued_(false),
+      last_raised_(false),
+      previous_limit_(options.initial_limit) {
+  DCHECK_GE(options_.min_limit, 1);
+  DCHECK_LE(options_.min_limit, options_.initial_limit);
+  DCHECK_LE(options_.initial_limit, options_.max_limit);
+  DCHECK_GT(options_.smoothing, 0);
+  DCHECK_LE(options_.smoothing, 1);
+  // Starts the CPU usage measurement, whose first reading is always 0.
+  metrics_->GetPlatformIndependentCPUUsage();
+}
+
+ConcurrencyController::~ConcurrencyController() {}
+
+// static
+int64_t ConcurrencyController::GetDefaultMaxWorkingSet(
+    int64_t physical_memory,
+    int64_t cgroup_memory_limit) {
+  const int64_t memory = cgroup_memory_limit > 0
+                             ? std::min(physical_memory, cgroup_memory_limit)
+                             : physical_memory;
+  return static_cast<int64_t>(memory * kDefaultWorkingSetFraction);
+}
+
+void ConcurrencyController::OnRequestFinished(TimeDelta queue_wait,
+                                              TimeDelta latency) {
+  AutoLock auto_lock(lock_);
+  ++samples_;
+  total_queue_wait_ += queue_wait;
+  total_latency_ += latency;
+}
+
+int ConcurrencyController::Update() {
+  Load load;
+  load.cpu_usage = metrics_->GetPlatformIndependentCPUUsage();
+  load.working_set = metrics_->GetWorkingSetSize();
+  return UpdateWithLoad(TimeTicks::Now(), load);
+}
+
+int ConcurrencyController::UpdateWithLoad(TimeTicks now, const Load& load) {
+  AutoLock auto_lock(lock_);
+  const int old_limit = limit_;
+
+  if (load.working_set > max_working_set_) {
+    estimate_ = std::max<double>(estimate_ * options_.memory_backoff,
+                                 options_.min_limit);
+    // Throughput under memory backoff says nothing about the next raise.
+    last_throughput_ = 0;
+  } else if (samples_ >= options_.min_samples) {
+    const double short_latency =
+        std::max<double>(total_latency_.InMicroseconds() / samples_, 1);
+    const double queue_wait =
+        static_cast<double>(total_queue_wait_.InMicroseconds()) / samples_;
+    const bool queued = queue_wait >= short_latency * kQueuedWaitFraction;
+    const double elapsed =
+        last_update_.is_null() ? 0 : (now - last_update_).InSecondsF();
+    const double throughput = elapsed > 0 ? samples_ / elapsed : 0;
+
+    if (long_latency_ == 0) {
+      long_latency_ = short_latency;
+    } else {
+      const double weight = short_latency < long_latency_
+                                ? kLongLatencyFallWeight
+                                : kLongLatencyRiseWeight;
+      long_latency_ += (short_latency - long_latency_) * weight;
+    }
+
+    if (queued && last_queued_ && last_raised_ &&
+        throughput < last_throughput_ * kThroughputDropFraction) {
+      // The last raise made things worse while there was work to spare.
+      estimate_ = previous_limit_;
+    } else {
+      const double gradient =
+          std::min(kMaxGradient,
+                   std::max(kMinGradient, options_.tolerance * long_latency_ /
+                                              short_latency));
+      const bool cpu_saturated =
+          load.cpu_usage >= 100.0 * num_processors_ * kSaturatedCPUFraction;
+      const double headroom =
+          queued && !cpu_saturated ? sqrt(estimate_) : 0;
+      const double target = estimate_ * gradient + headroom;
+      estimate_ += (target - estimate_) * options_.smoothing;
+    }
+
+    last_update_ = now;
+    last_throughput_ = throughput;
+    last_queued_ = queued;
+    samples_ = 0;
+    total_queue_wait_ = TimeDelta();
+    total_latency_ = TimeDelta();
+  } else {
+    return limit_;
+  }
+
+  estimate_ = std::min<double>(
+      std::max<double>(estimate_, options_.min_limit), options_.max_limit);
+  limit_ = static_cast<int>(estimate_);
+  last_raised_ = limit_ > old_limit;
+  if (limit_ != old_limit) {
+    previous_limit_ = old_limit;
+    DVLOG(1) << "Concurrency limit " << old_limit << " -> " << limit_;
+  }
+  return limit_;
+}
+
+int ConcurrencyController::limit() const {
+  AutoLock auto_lock(lock_);
+  return limit_;
+}
+
+int ConcurrencyController::threads_per_instance() const {
+  AutoLock auto_lock(lock_);
+  return std::max(1, num_processors_ / limit_);
+}
+
+}  // namespace base
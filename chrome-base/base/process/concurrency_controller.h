@@ -0,0 +1,151 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_PROCESS_CONCURRENCY_CONTROLLER_H_
+#define BASE_PROCESS_CONCURRENCY_CONTROLLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace base {
+
+class ProcessMetrics;
+
+////////////////////////////////////////////////////////////////////////////////
+// ConcurrencyController
+//
+// Finds how many requests a server should work on at once, instead of a
+// worker count tuned by hand for each type of host.
+//
+// Workers report each finished request with OnRequestFinished(): how long it
+// waited in the queue and how long it took to serve. Periodically, e.g. once
+// a second, the server calls Update() and resizes its pool of workers (or
+// recognizer instances) to limit().
+//
+// The limit follows a latency gradient. A slow average of the service time
+// tracks its value without contention; the ratio of that to the recent
+// average shrinks as more concurrency makes each request slower:
+//
+//   gradient  = clamp(tolerance * long_latency / short_latency, 0.5, 1)
+//   new_limit = limit * gradient + headroom
+//
+// |headroom| is sqrt(limit) while requests wait in the queue, so the limit
+// probes upward only when there is demand for more, and zero when the queue
+// is empty or the CPUs are saturated. An increase that lowers throughput while
+// requests are queued is undone. When the working set of the process exceeds
+// its budget, the limit is cut multiplicatively instead, as in AIMD.
+//
+// Thread-safe.
+class BASE_EXPORT ConcurrencyController {
+ public:
+  struct BASE_EXPORT Options {
+    Options();
+
+    // The range of the limit, and where it starts. The default range is one
+    // to the number of processors, starting at one.
+    int min_limit;
+    int max_limit;
+    int initial_limit;
+    // How much slower than the long-term service time requests may get
+    // before the limit shrinks.
+    double tolerance;
+    // The weight of each update in the smoothed limit, in (0, 1].
+    double smoothing;
+    // Updates with fewer finished requests than this keep the limit, except
+    // for memory backoff.
+    size_t min_samples;
+    // The working set above which the limit backs off, in bytes. 0 means
+    // GetDefaultMaxWorkingSet() of this host.
+    int64_t max_working_set;
+    // The factor that the limit is multiplied by while over |max_working_set|.
+    double memory_backoff;
+  };
+
+  // What the process uses, as ProcessMetrics reports it.
+  struct Load {
+    Load();
+
+    // Percent of one CPU, from 0 to 100 times the number of processors.
+    double cpu_usage;
+    int64_t working_set;
+  };
+
+  ConcurrencyController();
+  explicit ConcurrencyController(const Options& options);
+  ~ConcurrencyController();
+
+  // Returns 80% of |physical_memory|, or of |cgroup_memory_limit| if that is
+  // lower and not 0. In a container the cgroup limit is what the OOM killer
+  // enforces, however much memory the host has.
+  static int64_t GetDefaultMaxWorkingSet(int64_t physical_memory,
+                                         int64_t cgroup_memory_limit);
+
+  // Records a request that finished after waiting |queue_wait| to start and
+  // |latency| to be served. May be called on any thread.
+  void OnRequestFinished(TimeDelta queue_wait, TimeDelta latency);
+
+  // Reads the load of the current process from ProcessMetrics and updates
+  // the limit from it and the requests finished since the last update.
+  // Returns the new limit.
+  int Update();
+
+  // Same as Update(), with a given load and time, for tests and for servers
+  // that measure load themselves.
+  int UpdateWithLoad(TimeTicks now, const Load& load);
+
+  // The number of requests to work on at once.
+  int limit() const;
+
+  // How many threads each of limit() instances should use for its own
+  // parallelism, such as the intra-op threads of an inference session, so
+  // that together they fill the processors.
+  int threads_per_instance() const;
+
+  // The working set above which the limit backs off, in bytes.
+  int64_t max_working_set() const { return max_working_set_; }
+
+ private:
+  const Options options_;
+  const int num_processors_;
+  // |options_.max_working_set|, or its default.
+  const int64_t max_working_set_;
+  scoped_ptr<ProcessMetrics> metrics_;
+
+  mutable Lock lock_;
+
+  // The smoothed limit, and limit() as of the last update.
+  double estimate_;
+  int limit_;
+
+  // Requests finished since the last update.
+  size_t samples_;
+  TimeDelta total_queue_wait_;
+  TimeDelta total_latency_;
+
+  // The slow average of the service time, in microseconds; 0 before the
+  // first update with enough samples.
+  double long_latency_;
+
+  // The previous update with enough samples: when it was, its throughput in
+  // requests per second, and whether requests were queued.
+  TimeTicks last_update_;
+  double last_throughput_;
+  bool last_queued_;
+  // Whether the last update raised the limit, and the limit before the last
+  // change.
+  bool last_raised_;
+  int previous_limit_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrencyController);
+};
+
+}  // namespace base
+
+#endif  // BASE_PROCESS_CONCURRENCY_CONTROLLER_H_
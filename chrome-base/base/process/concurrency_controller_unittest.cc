@@ -0,0 +1,180 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/process/concurrency_controller.h"
+
+#include "base/sys_info.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(OS_LINUX)
+#include "base/memory/memory_pressure_monitor_linux.h"
+#endif
+
+namespace base {
+
+namespace {
+
+const int64_t kWorkingSetBudget = 1 << 30;
+
+ConcurrencyController::Options TestOptions(int initial_limit) {
+  ConcurrencyController::Options options;
+  options.min_limit = 1;
+  options.max_limit = 8;
+  options.initial_limit = initial_limit;
+  options.max_working_set = kWorkingSetBudget;
+  return options;
+}
+
+class ConcurrencyControllerTest : public testing::Test {
+ protected:
+  ConcurrencyControllerTest() : now_(TimeTicks() + TimeDelta::FromHours(1)) {
+    load_.cpu_usage = 0;
+    load_.working_set = kWorkingSetBudget / 2;
+  }
+
+  // Finishes |requests| requests with the given times, advances the clock by
+  // |interval| and updates |controller|.
+  int Step(ConcurrencyController* controller,
+           int requests,
+           int queue_wait_ms,
+           int latency_ms,
+           TimeDelta interval = TimeDelta::FromSeconds(1)) {
+    for (int i = 0; i < requests; ++i) {
+      controller->OnRequestFinished(TimeDelta::FromMilliseconds(queue_wait_ms),
+                                    TimeDelta::FromMilliseconds(latency_ms));
+    }
+    now_ += interval;
+    return controller->UpdateWithLoad(now_, load_);
+  }
+
+  TimeTicks now_;
+  ConcurrencyController::Load load_;
+};
+
+}  // namespace
+
+TEST_F(ConcurrencyControllerTest, GrowsWhileRequestsQueue) {
+  ConcurrencyController controller(TestOptions(1));
+  int last = controller.limit();
+  for (int i = 0; i < 100; ++i) {
+    int limit = Step(&controller, 20, 50, 100);
+    EXPECT_GE(limit, last);
+    last = limit;
+  }
+  EXPECT_EQ(8, controller.limit());
+}
+
+TEST_F(ConcurrencyControllerTest, KeepsLimitWithoutQueue) {
+  ConcurrencyController controller(TestOptions(2));
+  for (int i = 0; i < 50; ++i)
+    EXPECT_EQ(2, Step(&controller, 20, 0, 100));
+}
+
+TEST_F(ConcurrencyControllerTest, KeepsLimitWhenCPUSaturated) {
+  ConcurrencyController controller(TestOptions(2));
+  load_.cpu_usage = 100.0 * SysInfo::NumberOfProcessors();
+  for (int i = 0; i < 50; ++i)
+    EXPECT_EQ(2, Step(&controller, 20, 50, 100));
+}
+
+TEST_F(ConcurrencyControllerTest, WaitsForEnoughSamples) {
+  // Without smoothing, any update with queued requests raises the limit.
+  ConcurrencyController::Options options = TestOptions(2);
+  options.smoothing = 1;
+  ConcurrencyController controller(options);
+  for (int i = 0; i < 9; ++i)
+    EXPECT_EQ(2, Step(&controller, 1, 50, 100, TimeDelta::FromSeconds(60)));
+  // The samples add up across updates until there are enough.
+  EXPECT_EQ(3, Step(&controller, 1, 50, 100, TimeDelta::FromSeconds(60)));
+}
+
+TEST_F(ConcurrencyControllerTest, ShrinksWhenLatencyRises) {
+  ConcurrencyController controller(TestOptions(8));
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(8, Step(&controller, 20, 0, 100));
+
+  // Four times slower is past the tolerance of 1.5.
+  int last = controller.limit();
+  for (int i = 0; i < 5; ++i) {
+    int limit = Step(&controller, 20, 0, 400);
+    EXPECT_LE(limit, last);
+    last = limit;
+  }
+  EXPECT_LT(controller.limit(), 8);
+
+  // A little slower is within it.
+  ConcurrencyController tolerant(TestOptions(8));
+  for (int i = 0; i < 10; ++i)
+    Step(&tolerant, 20, 0, 100);
+  for (int i = 0; i < 5; ++i)
+    EXPECT_EQ(8, Step(&tolerant, 20, 0, 120));
+}
+
+TEST_F(ConcurrencyControllerTest, BacksOffOverMemoryBudget) {
+  ConcurrencyController controller(TestOptions(8));
+  load_.working_set = kWorkingSetBudget * 2;
+  // Even without samples.
+  EXPECT_EQ(6, Step(&controller, 0, 0, 0));
+  EXPECT_EQ(4, Step(&controller, 0, 0, 0));
+  for (int i = 0; i < 10; ++i)
+    Step(&controller, 20, 50, 100);
+  EXPECT_EQ(1, controller.limit());
+
+  // Back under budget, it grows again while requests queue.
+  load_.working_set = kWorkingSetBudget / 2;
+  for (int i = 0; i < 100; ++i)
+    Step(&controller, 20, 50, 100);
+  EXPECT_EQ(8, controller.limit());
+}
+
+TEST_F(ConcurrencyControllerTest, UndoesRaiseThatLowersThroughput) {
+  ConcurrencyController controller(TestOptions(2));
+  int limit = 2;
+  for (int i = 0; i < 20 && limit == 2; ++i)
+    limit = Step(&controller, 20, 50, 100);
+  EXPECT_EQ(3, limit);
+
+  // Half the throughput at the higher limit.
+  EXPECT_EQ(2, Step(&controller, 10, 50, 100));
+}
+
+TEST_F(ConcurrencyControllerTest, ThreadsPerInstance) {
+  ConcurrencyController::Options options = TestOptions(1);
+  options.max_limit = SysInfo::NumberOfProcessors();
+  ConcurrencyController controller(options);
+  EXPECT_EQ(SysInfo::NumberOfProcessors(), controller.threads_per_instance());
+}
+
+TEST_F(ConcurrencyControllerTest, UpdateReadsProcessMetrics) {
+  // The working set of the test is far below the default budget, so without
+  // requests nothing changes.
+  ConcurrencyController controller;
+  EXPECT_EQ(1, controller.Update());
+  EXPECT_EQ(1, controller.limit());
+}
+
+TEST_F(ConcurrencyControllerTest, DefaultBudgetFollowsCgroupLimit) {
+  const int64_t kGiB = 1 << 30;
+  EXPECT_EQ(kGiB * 8 / 10,
+            ConcurrencyController::GetDefaultMaxWorkingSet(kGiB, 0));
+  // A cgroup limit below physical memory, as in a container on a large host.
+  EXPECT_EQ(2 * kGiB * 8 / 10,
+            ConcurrencyController::GetDefaultMaxWorkingSet(64 * kGiB,
+                                                           2 * kGiB));
+  // One above it does not raise the budget.
+  EXPECT_EQ(kGiB * 8 / 10,
+            ConcurrencyController::GetDefaultMaxWorkingSet(kGiB, 4 * kGiB));
+
+  int64_t cgroup_memory_limit = 0;
+#if defined(OS_LINUX)
+  cgroup_memory_limit = nix::MemoryPressureMonitor::GetCgroupMemoryLimit();
+#endif
+  ConcurrencyController controller;
+  EXPECT_EQ(ConcurrencyController::GetDefaultMaxWorkingSet(
+                SysInfo::AmountOfPhysicalMemory(), cgroup_memory_limit),
+            controller.max_working_set());
+}
+
+}  // namespace base
@@ -0,0 +1,78 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures what a process linked against base pays before it can do any
+// work: the time to launch a child that exits right away, and the number of
+// shared objects the dynamic loader maps. Run it in builds with and without
+// USE_GLIB and USE_XDG_MIME to compare them.
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/command_line.h"
+#include "base/process/launch.h"
+#include "base/process/process.h"
+#include "base/test/multiprocess_test.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/multiprocess_func_list.h"
+#include "testing/perf/perf_test.h"
+
+#if defined(OS_LINUX)
+#include <link.h>
+#endif
+
+namespace base {
+namespace {
+
+const int kLaunches = 50;
+
+#if defined(OS_LINUX)
+int CountSharedObject(struct dl_phdr_info* info, size_t size, void* data) {
+  // The executable itself has an empty name.
+  if (info->dlpi_name && info->dlpi_name[0])
+    ++*static_cast<size_t*>(data);
+  return 0;
+}
+#endif
+
+}  // namespace
+
+MULTIPROCESS_TEST_MAIN(StartupPerfChild) {
+  return 0;
+}
+
+TEST(ProcessStartupPerfTest, LaunchToExit) {
+#if defined(OS_LINUX)
+  size_t shared_objects = 0;
+  dl_iterate_phdr(&CountSharedObject, &shared_objects);
+  perf_test::PrintResult("shared_objects", "", "process", shared_objects,
+                         "count", true);
+#endif
+
+  std::vector<double> times;
+  for (int i = 0; i < kLaunches; ++i) {
+    TimeTicks start = TimeTicks::Now();
+    Process child = SpawnMultiProcessTestChild(
+        "StartupPerfChild", GetMultiProcessTestChildBaseCommandLine(),
+        LaunchOptions());
+    ASSERT_TRUE(child.IsValid());
+    int exit_code = -1;
+    ASSERT_TRUE(child.WaitForExit(&exit_code));
+    EXPECT_EQ(0, exit_code);
+    times.push_back((TimeTicks::Now() - start).InMillisecondsF());
+  }
+
+  // The minimum shows the cost itself; the median includes scheduling noise.
+  std::sort(times.begin(), times.end());
+  perf_test::PrintResult("launch_to_exit", "_min", "process", times.front(),
+                         "ms", true);
+  perf_test::PrintResult("launch_to_exit", "_median", "process",
+                         times[times.size() / 2], "ms", true);
+}
+
+}  // namespace base
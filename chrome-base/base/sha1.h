@@ -6,10 +6,12 @@
 #define BASE_SHA1_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <string>
 
 #include "base/base_export.h"
+#include "base/macros.h"
 
 namespace base {
 
@@ -26,6 +28,41 @@ BASE_EXPORT std::string SHA1HashString(const std::string& str);
 BASE_EXPORT void SHA1HashBytes(const unsigned char* data, size_t len,
                                unsigned char* hash);
 
+// Computes a SHA-1 hash incrementally, for data that is not in memory all at
+// once, such as a large file read or mapped in chunks:
+//
+//   SHA1Hasher hasher;
+//   while (...)
+//     hasher.Update(chunk, chunk_size);
+//   unsigned char hash[kSHA1Length];
+//   hasher.Finish(hash);
+//
+// Uses the SHA extensions when the CPU has them.
+class BASE_EXPORT SHA1Hasher {
+ public:
+  SHA1Hasher();
+  ~SHA1Hasher();
+
+  void Update(const void* data, size_t length);
+
+  // Writes the hash of all data passed to Update() to |hash|, which must be
+  // kSHA1Length bytes long, and resets the hasher for a new computation.
+  void Finish(unsigned char* hash);
+
+  void Reset();
+
+ private:
+  uint32_t H_[5];
+
+  // Input that does not fill a 64-byte block yet.
+  uint8_t buffer_[64];
+  size_t buffer_length_;
+
+  uint64_t total_length_;
+
+  DISALLOW_COPY_AND_ASSIGN(SHA1Hasher);
+};
+
 }  // namespace base
 
 #endif  // BASE_SHA1_H_
@@ -8,6 +8,17 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
+
+#include "base/cpu_dispatch.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY) && defined(COMPILER_GCC)
+#include <immintrin.h>
+// The SHA extensions are compiled with a function attribute rather than a
+// build flag, and only used when the CPU has them.
+#define SHA1_USE_SHA_NI 1
+#endif
 
 namespace base {
 
@@ -18,53 +29,16 @@ namespace base {
 // also find a description of the algorithm:
 // http://csrc.nist.gov/publications/fips/fips180-3/fips180-3_final.pdf
 
-// Usage example:
-//
-// SecureHashAlgorithm sha;
-// while(there is data to hash)
-//   sha.Update(moredata, size of data);
-// sha.Final();
-// memcpy(somewhere, sha.Digest(), 20);
-//
-// to reuse the instance of sha, call sha.Init();
-
-// TODO(jhawkins): Replace this implementation with a per-platform
-// implementation using each platform's crypto library.  See
-// http://crbug.com/47218
-
-class SecureHashAlgorithm {
- public:
-  SecureHashAlgorithm() { Init(); }
-
-  static const int kDigestSizeBytes;
-
-  void Init();
-  void Update(const void* data, size_t nbytes);
-  void Final();
-
-  // 20 bytes of message digest.
-  const unsigned char* Digest() const {
-    return reinterpret_cast<const unsigned char*>(H);
-  }
-
- private:
-  void Pad();
-  void Process();
-
-  uint32_t A, B, C, D, E;
+namespace {
 
-  uint32_t H[5];
+const size_t kBlockSize = 64;
 
-  union {
-    uint32_t W[80];
-    uint8_t M[64];
-  };
+// Hashes |blocks| 64-byte blocks at |data| into |H|.
+typedef void (*ProcessBlocksFunction)(uint32_t* H,
+                                      const uint8_t* data,
+                                      size_t blocks);
 
-  uint32_t cursor;
-  uint64_t l;
-};
-
-static inline uint32_t f(uint32_t t, uint32_t B, uint32_t C, uint32_t D) {
+inline uint32_t f(uint32_t t, uint32_t B, uint32_t C, uint32_t D) {
   if (t < 20) {
     return (B & C) | ((~B) & D);
   } else if (t < 40) {
@@ -76,11 +50,11 @@ static inline uint32_t f(uint32_t t, uint32_t B, uint32_t C, uint32_t D) {
   }
 }
 
-static inline uint32_t S(uint32_t n, uint32_t X) {
+inline uint32_t S(uint32_t n, uint32_t X) {
   return (X << n) | (X >> (32-n));
 }
 
-static inline uint32_t K(uint32_t t) {
+inline uint32_t K(uint32_t t) {
   if (t < 20) {
     return 0x5a827999;
   } else if (t < 40) {
@@ -92,126 +66,334 @@ static inline uint32_t K(uint32_t t) {
   }
 }
 
-static inline void swapends(uint32_t* t) {
-  *t = (*t >> 24) | ((*t >> 8) & 0xff00) | ((*t & 0xff00) << 8) | (*t << 24);
+inline uint32_t ReadBigEndian32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | p[3];
 }
 
-const int SecureHashAlgorithm::kDigestSizeBytes = 20;
-
-void SecureHashAlgorithm::Init() {
-  A = 0;
-  B = 0;
-  C = 0;
-  D = 0;
-  E = 0;
-  cursor = 0;
-  l = 0;
-  H[0] = 0x67452301;
-  H[1] = 0xefcdab89;
-  H[2] = 0x98badcfe;
-  H[3] = 0x10325476;
-  H[4] = 0xc3d2e1f0;
+void ProcessBlocksPortable(uint32_t* H, const uint8_t* data, size_t blocks) {
+  uint32_t W[80];
+  for (; blocks; --blocks, data += kBlockSize) {
+    uint32_t t;
+
+    // Each a...e corresponds to a section in the FIPS 180-3 algorithm.
+
+    // a.
+    for (t = 0; t < 16; ++t)
+      W[t] = ReadBigEndian32(data + 4 * t);
+
+    // b.
+    for (t = 16; t < 80; ++t)
+      W[t] = S(1, W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16]);
+
+    // c.
+    uint32_t A = H[0];
+    uint32_t B = H[1];
+    uint32_t C = H[2];
+    uint32_t D = H[3];
+    uint32_t E = H[4];
+
+    // d.
+    for (t = 0; t < 80; ++t) {
+      uint32_t TEMP = S(5, A) + f(t, B, C, D) + E + W[t] + K(t);
+      E = D;
+      D = C;
+      C = S(30, B);
+      B = A;
+      A = TEMP;
+    }
+
+    // e.
+    H[0] += A;
+    H[1] += B;
+    H[2] += C;
+    H[3] += D;
+    H[4] += E;
+  }
 }
 
-void SecureHashAlgorithm::Final() {
-  Pad();
-  Process();
+#if defined(SHA1_USE_SHA_NI)
+
+// Follows the reference code in Intel's "Intel SHA Extensions" white paper.
+// Each group of four rounds also advances the message schedule for the
+// groups after it.
+__attribute__((target("sha,sse4.1"))) void ProcessBlocksSHANI(
+    uint32_t* H,
+    const uint8_t* data,
+    size_t blocks) {
+  const __m128i byte_swap =
+      _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+  __m128i abcd = _mm_loadu_si128(reinterpret_cast<const __m128i*>(H));
+  abcd = _mm_shuffle_epi32(abcd, 0x1B);
+  __m128i e0 = _mm_set_epi32(H[4], 0, 0, 0);
+  __m128i e1;
+  __m128i msg0, msg1, msg2, msg3;
+
+  for (; blocks; --blocks, data += kBlockSize) {
+    const __m128i abcd_save = abcd;
+    const __m128i e0_save = e0;
+
+    // Rounds 0-3.
+    msg0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    msg0 = _mm_shuffle_epi8(msg0, byte_swap);
+    e0 = _mm_add_epi32(e0, msg0);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+    // Rounds 4-7.
+    msg1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+    msg1 = _mm_shuffle_epi8(msg1, byte_swap);
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+    // Rounds 8-11.
+    msg2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32));
+    msg2 = _mm_shuffle_epi8(msg2, byte_swap);
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    // Rounds 12-15.
+    msg3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48));
+    msg3 = _mm_shuffle_epi8(msg3, byte_swap);
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+    msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+    msg1 = _mm_xor_si128(msg1, msg3);
+
+    // Rounds 16-19.
+    e0 = _mm_sha1nexte_epu32(e0, msg0);
+    e1 = abcd;
+    msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+    msg2 = _mm_xor_si128(msg2, msg0);
+
+    // Rounds 20-23.
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+    msg3 = _mm_xor_si128(msg3, msg1);
+
+    // Rounds 24-27.
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    // Rounds 28-31.
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+    msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+    msg1 = _mm_xor_si128(msg1, msg3);
+
+    // Rounds 32-35.
+    e0 = _mm_sha1nexte_epu32(e0, msg0);
+    e1 = abcd;
+    msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+    msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+    msg2 = _mm_xor_si128(msg2, msg0);
+
+    // Rounds 36-39.
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+    msg3 = _mm_xor_si128(msg3, msg1);
+
+    // Rounds 40-43.
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    // Rounds 44-47.
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+    msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+    msg1 = _mm_xor_si128(msg1, msg3);
+
+    // Rounds 48-51.
+    e0 = _mm_sha1nexte_epu32(e0, msg0);
+    e1 = abcd;
+    msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+    msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+    msg2 = _mm_xor_si128(msg2, msg0);
+
+    // Rounds 52-55.
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+    msg3 = _mm_xor_si128(msg3, msg1);
+
+    // Rounds 56-59.
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    // Rounds 60-63.
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+    msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+    msg1 = _mm_xor_si128(msg1, msg3);
+
+    // Rounds 64-67.
+    e0 = _mm_sha1nexte_epu32(e0, msg0);
+    e1 = abcd;
+    msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+    msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+    msg2 = _mm_xor_si128(msg2, msg0);
+
+    // Rounds 68-71.
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+    msg3 = _mm_xor_si128(msg3, msg1);
+
+    // Rounds 72-75.
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+
+    // Rounds 76-79.
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+    e0 = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
 
-  for (int t = 0; t < 5; ++t)
-    swapends(&H[t]);
+  abcd = _mm_shuffle_epi32(abcd, 0x1B);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(H), abcd);
+  H[4] = _mm_extract_epi32(e0, 3);
 }
 
-void SecureHashAlgorithm::Update(const void* data, size_t nbytes) {
-  const uint8_t* d = reinterpret_cast<const uint8_t*>(data);
-  while (nbytes--) {
-    M[cursor++] = *d++;
-    if (cursor >= 64)
-      Process();
-    l += 8;
-  }
+#endif  // defined(SHA1_USE_SHA_NI)
+
+const CPUKernelVariant<ProcessBlocksFunction> kProcessBlocksVariants[] = {
+#if defined(SHA1_USE_SHA_NI)
+    {"sha", CPU_FEATURE_SHA | CPU_FEATURE_SSE41, &ProcessBlocksSHANI},
+#endif
+    {"portable", 0, &ProcessBlocksPortable},
+};
+
+CPUDispatchedKernel<ProcessBlocksFunction> g_process_blocks =
+    CPU_DISPATCHED_KERNEL("sha1", kProcessBlocksVariants);
+
+ProcessBlocksFunction GetProcessBlocksFunction() {
+  return g_process_blocks.Get();
 }
 
-void SecureHashAlgorithm::Pad() {
-  M[cursor++] = 0x80;
+}  // namespace
 
-  if (cursor > 64-8) {
-    // pad out to next block
-    while (cursor < 64)
-      M[cursor++] = 0;
+SHA1Hasher::SHA1Hasher() {
+  Reset();
+}
 
-    Process();
-  }
+SHA1Hasher::~SHA1Hasher() {}
 
-  while (cursor < 64-8)
-    M[cursor++] = 0;
-
-  M[cursor++] = (l >> 56) & 0xff;
-  M[cursor++] = (l >> 48) & 0xff;
-  M[cursor++] = (l >> 40) & 0xff;
-  M[cursor++] = (l >> 32) & 0xff;
-  M[cursor++] = (l >> 24) & 0xff;
-  M[cursor++] = (l >> 16) & 0xff;
-  M[cursor++] = (l >> 8) & 0xff;
-  M[cursor++] = l & 0xff;
+void SHA1Hasher::Reset() {
+  H_[0] = 0x67452301;
+  H_[1] = 0xefcdab89;
+  H_[2] = 0x98badcfe;
+  H_[3] = 0x10325476;
+  H_[4] = 0xc3d2e1f0;
+  buffer_length_ = 0;
+  total_length_ = 0;
 }
 
-void SecureHashAlgorithm::Process() {
-  uint32_t t;
-
-  // Each a...e corresponds to a section in the FIPS 180-3 algorithm.
-
-  // a.
-  //
-  // W and M are in a union, so no need to memcpy.
-  // memcpy(W, M, sizeof(M));
-  for (t = 0; t < 16; ++t)
-    swapends(&W[t]);
-
-  // b.
-  for (t = 16; t < 80; ++t)
-    W[t] = S(1, W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16]);
-
-  // c.
-  A = H[0];
-  B = H[1];
-  C = H[2];
-  D = H[3];
-  E = H[4];
-
-  // d.
-  for (t = 0; t < 80; ++t) {
-    uint32_t TEMP = S(5, A) + f(t, B, C, D) + E + W[t] + K(t);
-    E = D;
-    D = C;
-    C = S(30, B);
-    B = A;
-    A = TEMP;
+void SHA1Hasher::Update(const void* data, size_t length) {
+  const uint8_t* d = static_cast<const uint8_t*>(data);
+  total_length_ += length;
+  ProcessBlocksFunction process_blocks = GetProcessBlocksFunction();
+
+  if (buffer_length_) {
+    size_t count = std::min(kBlockSize - buffer_length_, length);
+    memcpy(buffer_ + buffer_length_, d, count);
+    buffer_length_ += count;
+    d += count;
+    length -= count;
+    if (buffer_length_ < kBlockSize)
+      return;
+    process_blocks(H_, buffer_, 1);
+    buffer_length_ = 0;
   }
 
-  // e.
-  H[0] += A;
-  H[1] += B;
-  H[2] += C;
-  H[3] += D;
-  H[4] += E;
+  // Whole blocks are hashed straight from the input.
+  size_t blocks = length / kBlockSize;
+  if (blocks) {
+    process_blocks(H_, d, blocks);
+    d += blocks * kBlockSize;
+    length -= blocks * kBlockSize;
+  }
 
-  cursor = 0;
+  memcpy(buffer_, d, length);
+  buffer_length_ = length;
+}
+
+void SHA1Hasher::Finish(unsigned char* hash) {
+  // Pad with 0x80, zeros, and the length in bits.
+  const uint64_t bit_length = total_length_ * 8;
+  uint8_t padding[kBlockSize + 8] = {0x80};
+  size_t padding_length =
+      (buffer_length_ < kBlockSize - 8 ? kBlockSize : 2 * kBlockSize) -
+      8 - buffer_length_;
+  for (int i = 0; i < 8; ++i)
+    padding[padding_length + i] =
+        static_cast<uint8_t>(bit_length >> (56 - 8 * i));
+  Update(padding, padding_length + 8);
+
+  for (int t = 0; t < 5; ++t) {
+    hash[4 * t] = static_cast<unsigned char>(H_[t] >> 24);
+    hash[4 * t + 1] = static_cast<unsigned char>(H_[t] >> 16);
+    hash[4 * t + 2] = static_cast<unsigned char>(H_[t] >> 8);
+    hash[4 * t + 3] = static_cast<unsigned char>(H_[t]);
+  }
+  Reset();
 }
 
 std::string SHA1HashString(const std::string& str) {
-  char hash[SecureHashAlgorithm::kDigestSizeBytes];
+  char hash[kSHA1Length];
   SHA1HashBytes(reinterpret_cast<const unsigned char*>(str.c_str()),
                 str.length(), reinterpret_cast<unsigned char*>(hash));
-  return std::string(hash, SecureHashAlgorithm::kDigestSizeBytes);
+  return std::string(hash, kSHA1Length);
 }
 
 void SHA1HashBytes(const unsigned char* data, size_t len,
                    unsigned char* hash) {
-  SecureHashAlgorithm sha;
-  sha.Update(data, len);
-  sha.Final();
-
-  memcpy(hash, sha.Digest(), SecureHashAlgorithm::kDigestSizeBytes);
+  SHA1Hasher hasher;
+  hasher.Update(data, len);
+  hasher.Finish(hash);
 }
 
 }  // namespace base
@@ -5,11 +5,36 @@
 #include "base/sha1.h"
 
 #include <stddef.h>
+#include <string.h>
 
+#include <algorithm>
 #include <string>
 
+#include "base/macros.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
+namespace {
+
+std::string MakeInput(size_t length) {
+  std::string input(length, '\0');
+  for (size_t i = 0; i < length; ++i)
+    input[i] = static_cast<char>(i * 7 + 3);
+  return input;
+}
+
+std::string HashWithHasher(const std::string& input, size_t chunk_size) {
+  base::SHA1Hasher hasher;
+  for (size_t i = 0; i < input.size(); i += chunk_size)
+    hasher.Update(input.data() + i, std::min(chunk_size, input.size() - i));
+  unsigned char hash[base::kSHA1Length];
+  hasher.Finish(hash);
+  return base::HexEncode(hash, sizeof(hash));
+}
+
+}  // namespace
+
 TEST(SHA1Test, Test1) {
   // Example A.1 from FIPS 180-2: one-block message.
   std::string input = "abc";
@@ -107,3 +132,60 @@ TEST(SHA1Test, Test3Bytes) {
   for (size_t i = 0; i < base::kSHA1Length; i++)
     EXPECT_EQ(expected[i], output[i]);
 }
+
+TEST(SHA1Test, PaddingBoundaries) {
+  // Lengths around the 56-byte point where the length no longer fits in the
+  // last block.
+  const struct {
+    size_t length;
+    const char* expected;
+  } kCases[] = {
+      {0, "da39a3ee5e6b4b0d3255bfef95601890afd80709"},
+      {1, "9842926af7ca0a8cca12604f945414f07b01e13d"},
+      {55, "ddf57317ef34bfee3b6df83d359098930eb278bc"},
+      {56, "a0d492bb0fc889d0eca3bc137066ab6f4f74f369"},
+      {63, "c55856749bef509bdfe6bfebfc7bf4e793e82132"},
+      {64, "bede92be29c3874e1b54ddc77988d606fc857a8e"},
+      {65, "b05a80522b053d6dc7e0a517d0e70212c7dad11f"},
+      {119, "504e27376a6e0f0dba8295b85cb25dc4dfa17d23"},
+      {120, "82134b02fb3f702491be9bed581eeab59334acb2"},
+      {127, "34d5e582029e9b9b85b2febe31da3db7cdabaaea"},
+      {128, "a09133e6730ffe899efb70204cb5646cd5dc24ee"},
+      {1000, "4231a8a50a10fa9758db8ec71fdef855b751048a"},
+  };
+  for (size_t i = 0; i < arraysize(kCases); ++i) {
+    SCOPED_TRACE(kCases[i].length);
+    std::string input = MakeInput(kCases[i].length);
+    EXPECT_EQ(kCases[i].expected,
+              base::ToLowerASCII(base::HexEncode(
+                  base::SHA1HashString(input).data(), base::kSHA1Length)));
+    EXPECT_EQ(kCases[i].expected,
+              base::ToLowerASCII(HashWithHasher(input, 1)));
+  }
+}
+
+TEST(SHA1Test, IncrementalMatchesOneShot) {
+  std::string input = MakeInput(4099);
+  std::string expected = base::HexEncode(
+      base::SHA1HashString(input).data(), base::kSHA1Length);
+  const size_t kChunkSizes[] = {1, 3, 63, 64, 65, 200, 4096, 5000};
+  for (size_t i = 0; i < arraysize(kChunkSizes); ++i) {
+    SCOPED_TRACE(kChunkSizes[i]);
+    EXPECT_EQ(expected, HashWithHasher(input, kChunkSizes[i]));
+  }
+}
+
+TEST(SHA1Test, HasherResetsAfterFinish) {
+  base::SHA1Hasher hasher;
+  unsigned char first[base::kSHA1Length];
+  unsigned char second[base::kSHA1Length];
+  hasher.Update("abc", 3);
+  hasher.Finish(first);
+  hasher.Update("xyz", 3);
+  hasher.Reset();
+  hasher.Update("abc", 3);
+  hasher.Finish(second);
+  EXPECT_EQ(0, memcmp(first, second, base::kSHA1Length));
+  EXPECT_EQ(base::SHA1HashString("abc"),
+            std::string(reinterpret_cast<char*>(first), base::kSHA1Length));
+}
@@ -6,15 +6,64 @@
 #include "base/strings/string_piece.h"
 
 #include <limits.h>
+#include <string.h>
 
 #include <algorithm>
 #include <ostream>
 
 #include "base/logging.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__SSE2__)
+#include <emmintrin.h>
+#define STRING_PIECE_USE_SSE2 1
+#endif
 
 namespace base {
 namespace {
 
+// Sets of at most this many characters are searched by comparing against
+// each of them rather than through a lookup table, which costs 256 bytes of
+// initialization per call. This is the common case: separators and
+// whitespace.
+const size_t kMaxSmallSetSize = 16;
+
+inline bool IsInSmallSet(char c, const StringPiece& set) {
+  return memchr(set.data(), c, set.size()) != nullptr;
+}
+
+// Returns the first byte in [p, end) that is one of the characters of |set|,
+// or |end|. |set| has at most kMaxSmallSetSize characters. With SSE2 this
+// compares 16 bytes of input against every character at once.
+const char* FindFirstOfSmallSet(const char* p,
+                                const char* end,
+                                const StringPiece& set) {
+  DCHECK_LE(set.size(), kMaxSmallSetSize);
+#if defined(STRING_PIECE_USE_SSE2)
+  if (end - p >= 16) {
+    __m128i wanted[kMaxSmallSetSize];
+    const size_t set_size = set.size();
+    for (size_t i = 0; i < set_size; ++i)
+      wanted[i] = _mm_set1_epi8(set[i]);
+    do {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      __m128i match = _mm_cmpeq_epi8(v, wanted[0]);
+      for (size_t i = 1; i < set_size; ++i)
+        match = _mm_or_si128(match, _mm_cmpeq_epi8(v, wanted[i]));
+      int mask = _mm_movemask_epi8(match);
+      if (mask)
+        return p + __builtin_ctz(mask);
+      p += 16;
+    } while (end - p >= 16);
+  }
+#endif
+  for (; p < end; ++p) {
+    if (IsInSmallSet(*p, set))
+      return p;
+  }
+  return end;
+}
+
 // For each character in characters_wanted, sets the index corresponding
 // to the ASCII code of that character to 1 in table.  This is used by
 // the find_.*_of methods below to tell whether or not a character is in
@@ -117,7 +166,22 @@ size_t findT(const BasicStringPiece<STR>& self,
 }
 
 size_t find(const StringPiece& self, const StringPiece& s, size_t pos) {
-  return findT(self, s, pos);
+  if (pos > self.size() || s.size() > self.size() - pos)
+    return StringPiece::npos;
+  if (s.empty())
+    return pos;
+
+  // Let memchr() skip to candidates for the first character; it scans a
+  // vector at a time.
+  const char* const last = self.data() + self.size() - s.size();
+  for (const char* p = self.data() + pos; p <= last; ++p) {
+    p = static_cast<const char*>(memchr(p, s[0], last - p + 1));
+    if (!p)
+      break;
+    if (memcmp(p + 1, s.data() + 1, s.size() - 1) == 0)
+      return static_cast<size_t>(p - self.data());
+  }
+  return StringPiece::npos;
 }
 
 size_t find(const StringPiece16& self, const StringPiece16& s, size_t pos) {
@@ -138,7 +202,12 @@ size_t findT(const BasicStringPiece<STR>& self,
 }
 
 size_t find(const StringPiece& self, char c, size_t pos) {
-  return findT(self, c, pos);
+  if (pos >= self.size())
+    return StringPiece::npos;
+
+  const void* result = memchr(self.data() + pos, c, self.size() - pos);
+  return result ? static_cast<const char*>(result) - self.data()
+                : StringPiece::npos;
 }
 
 size_t find(const StringPiece16& self, char16 c, size_t pos) {
@@ -196,7 +265,8 @@ size_t rfind(const StringPiece16& self, char16 c, size_t pos) {
   return rfindT(self, c, pos);
 }
 
-// 8-bit version using lookup table.
+// 8-bit version using vector compares for small sets, a lookup table
+// otherwise.
 size_t find_first_of(const StringPiece& self,
                      const StringPiece& s,
                      size_t pos) {
@@ -207,6 +277,15 @@ size_t find_first_of(const StringPiece& self,
   if (s.size() == 1)
     return find(self, s.data()[0], pos);
 
+  if (s.size() <= kMaxSmallSetSize) {
+    if (pos >= self.size())
+      return StringPiece::npos;
+    const char* end = self.data() + self.size();
+    const char* result = FindFirstOfSmallSet(self.data() + pos, end, s);
+    return result != end ? static_cast<size_t>(result - self.data())
+                         : StringPiece::npos;
+  }
+
   bool lookup[UCHAR_MAX + 1] = { false };
   BuildLookupTable(s, lookup);
   for (size_t i = pos; i < self.size(); ++i) {
@@ -242,6 +321,15 @@ size_t find_first_not_of(const StringPiece& self,
   if (s.size() == 1)
     return find_first_not_of(self, s.data()[0], pos);
 
+  // Mostly used for trimming, where only a few characters are looked at.
+  if (s.size() <= kMaxSmallSetSize) {
+    for (size_t i = pos; i < self.size(); ++i) {
+      if (!IsInSmallSet(self.data()[i], s))
+        return i;
+    }
+    return StringPiece::npos;
+  }
+
   bool lookup[UCHAR_MAX + 1] = { false };
   BuildLookupTable(s, lookup);
   for (size_t i = pos; i < self.size(); ++i) {
@@ -354,6 +442,16 @@ size_t find_last_not_of(const StringPiece& self,
   if (s.size() == 1)
     return find_last_not_of(self, s.data()[0], pos);
 
+  if (s.size() <= kMaxSmallSetSize) {
+    for (; ; --i) {
+      if (!IsInSmallSet(self.data()[i], s))
+        return i;
+      if (i == 0)
+        break;
+    }
+    return StringPiece::npos;
+  }
+
   bool lookup[UCHAR_MAX + 1] = { false };
   BuildLookupTable(s, lookup);
   for (; ; --i) {
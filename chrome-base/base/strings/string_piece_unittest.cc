@@ -6,6 +6,7 @@
 
 #include <string>
 
+#include "base/rand_util.h"
 #include "base/strings/string16.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/utf_string_conversions.h"
@@ -613,6 +614,34 @@ TYPED_TEST(CommonStringPieceTest, CheckComparisons2) {
   ASSERT_GT(abc.compare(BasicStringPiece<TypeParam>(alphabet_y)), 0);
 }
 
+// The 8-bit searches have vectorized paths; check them against std::string
+// with matches at every offset of a 16-byte block.
+TEST(StringPieceTest, SearchesMatchStdString) {
+  const char* const kSets[] = {"x", "xy", " \t\r\n", "0123456789abcdef",
+                               "0123456789abcdefg"};
+  for (int i = 0; i < 2000; ++i) {
+    std::string str;
+    int length = RandInt(0, 70);
+    for (int j = 0; j < length; ++j)
+      str.push_back(static_cast<char>(RandInt(0, 9) ? 'a' + RandInt(0, 25)
+                                                    : RandInt(0, 255)));
+    StringPiece piece(str);
+    size_t pos = RandInt(0, length + 2);
+    for (const char* set : kSets) {
+      ASSERT_EQ(str.find_first_of(set, pos), piece.find_first_of(set, pos));
+      ASSERT_EQ(str.find_first_not_of(set, pos),
+                piece.find_first_not_of(set, pos));
+      ASSERT_EQ(str.find_last_not_of(set, pos),
+                piece.find_last_not_of(set, pos));
+    }
+    char c = static_cast<char>(RandInt(0, 255));
+    ASSERT_EQ(str.find(c, pos), piece.find(c, pos));
+    std::string needle = str.substr(RandInt(0, length), RandInt(0, 3));
+    ASSERT_EQ(str.find(needle, pos), piece.find(needle, pos));
+    ASSERT_EQ(str.find("ab", pos), piece.find("ab", pos));
+  }
+}
+
 // Test operations only supported by std::string version.
 TEST(StringPieceTest, CheckComparisons2) {
   StringPiece abc("abcdefghijklmnopqrstuvwxyz");
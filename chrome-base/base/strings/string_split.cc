@@ -205,6 +205,42 @@ std::vector<StringPiece16> SplitStringPiece(StringPiece16 input,
       input, separators, whitespace, result_type);
 }
 
+StringPieceSplitter::StringPieceSplitter(StringPiece input,
+                                         StringPiece separators,
+                                         WhitespaceHandling whitespace,
+                                         SplitResult result_type)
+    : input_(input),
+      separators_(separators),
+      whitespace_(whitespace),
+      result_type_(result_type),
+      position_(input.empty() ? StringPiece::npos : 0) {}
+
+bool StringPieceSplitter::Next(StringPiece* piece) {
+  while (position_ != StringPiece::npos) {
+    size_t end = separators_.size() == 1
+                     ? input_.find(separators_[0], position_)
+                     : input_.find_first_of(separators_, position_);
+
+    StringPiece current;
+    if (end == StringPiece::npos) {
+      current = input_.substr(position_);
+      position_ = StringPiece::npos;
+    } else {
+      current = input_.substr(position_, end - position_);
+      position_ = end + 1;
+    }
+
+    if (whitespace_ == TRIM_WHITESPACE)
+      current = TrimString(current, kWhitespaceASCII, TRIM_ALL);
+
+    if (result_type_ == SPLIT_WANT_ALL || !current.empty()) {
+      *piece = current;
+      return true;
+    }
+  }
+  return false;
+}
+
 bool SplitStringIntoKeyValuePairs(StringPiece input,
                                   char key_value_delimiter,
                                   char key_value_pair_delimiter,
@@ -77,6 +77,39 @@ BASE_EXPORT std::vector<StringPiece16> SplitStringPiece(
     WhitespaceHandling whitespace,
     SplitResult result_type);
 
+// Yields the same pieces as SplitStringPiece() one at a time, without
+// building a vector. Use it to tokenize large inputs such as line-oriented
+// files, where the vector of pieces would be as large as the input:
+//
+//   StringPieceSplitter lines(file_contents, "\n", base::TRIM_WHITESPACE,
+//                             base::SPLIT_WANT_NONEMPTY);
+//   StringPiece line;
+//   while (lines.Next(&line)) {
+//     ...
+//   }
+//
+// The input and separators must outlive the splitter.
+class BASE_EXPORT StringPieceSplitter {
+ public:
+  StringPieceSplitter(StringPiece input,
+                      StringPiece separators,
+                      WhitespaceHandling whitespace,
+                      SplitResult result_type);
+
+  // Sets |piece| to the next piece and returns true, or returns false when
+  // there are no more pieces.
+  bool Next(StringPiece* piece);
+
+ private:
+  const StringPiece input_;
+  const StringPiece separators_;
+  const WhitespaceHandling whitespace_;
+  const SplitResult result_type_;
+
+  // Start of the next piece, or npos when done.
+  size_t position_;
+};
+
 using StringPairs = std::vector<std::pair<std::string, std::string>>;
 
 // Splits |line| into key value pairs according to the given delimiters and
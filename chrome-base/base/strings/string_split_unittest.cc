@@ -7,6 +7,7 @@
 #include <stddef.h>
 
 #include "base/macros.h"
+#include "base/rand_util.h"
 #include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
 #include "testing/gmock/include/gmock/gmock.h"
@@ -388,4 +389,45 @@ TEST(StringSplitTest, SplitStringAlongWhitespace) {
   }
 }
 
+TEST(StringPieceSplitterTest, MatchesSplitStringPiece) {
+  const char* const kSeparators[] = {",", "\n", " \t", ",;|", ""};
+  const WhitespaceHandling kWhitespace[] = {KEEP_WHITESPACE, TRIM_WHITESPACE};
+  const SplitResult kResultTypes[] = {SPLIT_WANT_ALL, SPLIT_WANT_NONEMPTY};
+  // Inputs long enough to cross the 16-byte blocks of the vector scan.
+  const char kAlphabet[] = "ab ,;|\t\n";
+  for (int i = 0; i < 300; ++i) {
+    std::string input;
+    int length = RandInt(0, 80);
+    for (int j = 0; j < length; ++j)
+      input.push_back(kAlphabet[RandInt(0, arraysize(kAlphabet) - 2)]);
+    for (const char* separators : kSeparators) {
+      for (WhitespaceHandling whitespace : kWhitespace) {
+        for (SplitResult result_type : kResultTypes) {
+          std::vector<StringPiece> expected =
+              SplitStringPiece(input, separators, whitespace, result_type);
+          std::vector<StringPiece> actual;
+          StringPieceSplitter splitter(input, separators, whitespace,
+                                       result_type);
+          StringPiece piece;
+          while (splitter.Next(&piece))
+            actual.push_back(piece);
+          ASSERT_EQ(expected, actual) << input;
+          EXPECT_FALSE(splitter.Next(&piece));
+        }
+      }
+    }
+  }
+}
+
+TEST(StringPieceSplitterTest, Lines) {
+  StringPieceSplitter lines("utt1 hello\r\n\nutt2 world\n", "\n",
+                            TRIM_WHITESPACE, SPLIT_WANT_NONEMPTY);
+  StringPiece line;
+  ASSERT_TRUE(lines.Next(&line));
+  EXPECT_EQ("utt1 hello", line);
+  ASSERT_TRUE(lines.Next(&line));
+  EXPECT_EQ("utt2 world", line);
+  EXPECT_FALSE(lines.Next(&line));
+}
+
 }  // namespace base
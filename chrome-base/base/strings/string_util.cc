@@ -517,17 +517,24 @@ bool IsStringASCII(const std::wstring& str) {
 #endif
 
 bool IsStringUTF8(const StringPiece& str) {
-  const char *src = str.data();
-  int32_t src_len = static_cast<int32_t>(str.length());
-  int32_t char_index = 0;
-
-  while (char_index < src_len) {
-    int32_t code_point;
-    CBU8_NEXT(src, char_index, src_len, code_point);
-    if (!IsValidCharacter(code_point))
-      return false;
+  const char* src = str.data();
+  const char* const end = src + str.length();
+
+  // Skip runs of ASCII a vector at a time, and decode other characters
+  // without going through the generic ICU macro. Each decoded character must
+  // still be checked for non-characters.
+  while (true) {
+    src += CountLeadingASCII(src, end - src);
+    while (src != end && (*src & 0x80)) {
+      uint32_t code_point;
+      size_t length = DecodeUTF8Sequence(src, end - src, &code_point);
+      if (!length || !IsValidCharacter(code_point))
+        return false;
+      src += length;
+    }
+    if (src == end)
+      return true;
   }
-  return true;
 }
 
 // Implementation note: Normally this function will be called with a hardcoded
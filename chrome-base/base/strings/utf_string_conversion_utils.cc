@@ -4,10 +4,43 @@
 
 #include "base/strings/utf_string_conversion_utils.h"
 
+#include <string.h>
+
 #include "base/third_party/icu/icu_utf.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace base {
 
+// Fast paths ------------------------------------------------------------------
+
+size_t CountLeadingASCII(const char* src, size_t src_len) {
+  const char* p = src;
+  const char* const end = src + src_len;
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__SSE2__)
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    int mask = _mm_movemask_epi8(v);
+    if (mask)
+      return (p - src) + __builtin_ctz(mask);
+    p += 16;
+  }
+#endif
+  while (end - p >= 8) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    if (v & 0x8080808080808080ULL)
+      break;
+    p += 8;
+  }
+  while (p < end && !(*p & 0x80))
+    ++p;
+  return p - src;
+}
+
 // ReadUnicodeCharacter --------------------------------------------------------
 
 bool ReadUnicodeCharacter(const char* src,
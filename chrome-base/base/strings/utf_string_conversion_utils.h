@@ -31,6 +31,54 @@ inline bool IsValidCharacter(uint32_t code_point) {
       code_point <= 0x10FFFFu && (code_point & 0xFFFEu) != 0xFFFEu);
 }
 
+// Fast paths ------------------------------------------------------------------
+
+// Returns the number of leading ASCII bytes of |src|. Looks at 16 bytes at a
+// time with SSE2, 8 otherwise.
+BASE_EXPORT size_t CountLeadingASCII(const char* src, size_t src_len);
+
+// Decodes the multi-byte UTF-8 sequence at the start of |src|, whose first
+// byte must not be ASCII. If the sequence is well-formed (no overlong forms,
+// surrogates or values above U+10FFFF) and complete, sets |*code_point| and
+// returns its length, 2 to 4. Returns 0 otherwise. This only handles the
+// common case; callers fall back to ReadUnicodeCharacter() on errors so that
+// these are reported exactly as before.
+inline size_t DecodeUTF8Sequence(const char* src,
+                                 size_t src_len,
+                                 uint32_t* code_point) {
+  const unsigned char* s = reinterpret_cast<const unsigned char*>(src);
+  const unsigned char lead = s[0];
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    if (src_len < 2 || (s[1] & 0xC0) != 0x80)
+      return 0;
+    *code_point = ((lead & 0x1Fu) << 6) | (s[1] & 0x3Fu);
+    return 2;
+  }
+  if (lead >= 0xE0 && lead <= 0xEF) {
+    if (src_len < 3 || (s[2] & 0xC0) != 0x80)
+      return 0;
+    const unsigned char min = lead == 0xE0 ? 0xA0 : 0x80;
+    const unsigned char max = lead == 0xED ? 0x9F : 0xBF;
+    if (s[1] < min || s[1] > max)
+      return 0;
+    *code_point =
+        ((lead & 0x0Fu) << 12) | ((s[1] & 0x3Fu) << 6) | (s[2] & 0x3Fu);
+    return 3;
+  }
+  if (lead >= 0xF0 && lead <= 0xF4) {
+    if (src_len < 4 || (s[2] & 0xC0) != 0x80 || (s[3] & 0xC0) != 0x80)
+      return 0;
+    const unsigned char min = lead == 0xF0 ? 0x90 : 0x80;
+    const unsigned char max = lead == 0xF4 ? 0x8F : 0xBF;
+    if (s[1] < min || s[1] > max)
+      return 0;
+    *code_point = ((lead & 0x07u) << 18) | ((s[1] & 0x3Fu) << 12) |
+                  ((s[2] & 0x3Fu) << 6) | (s[3] & 0x3Fu);
+    return 4;
+  }
+  return 0;
+}
+
 // ReadUnicodeCharacter --------------------------------------------------------
 
 // Reads a UTF-8 stream, placing the next code point into the given output
@@ -9,8 +9,14 @@
 #include "base/strings/string_piece.h"
 #include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversion_utils.h"
+#include "base/third_party/icu/icu_utf.h"
 #include "build/build_config.h"
 
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__SSE2__)
+#include <emmintrin.h>
+#define UTF_STRING_CONVERSIONS_USE_SSE2 1
+#endif
+
 namespace base {
 
 namespace {
@@ -41,6 +47,147 @@ bool ConvertUnicode(const SRC_CHAR* src,
   return success;
 }
 
+#if defined(WCHAR_T_IS_UTF32)
+
+// Stores |code_point| at |dest| as UTF-16 and returns the number of units.
+inline size_t StoreUTF16(uint32_t code_point, char16* dest) {
+  if (code_point <= 0xFFFF) {
+    dest[0] = static_cast<char16>(code_point);
+    return 1;
+  }
+  dest[0] = static_cast<char16>(CBU16_LEAD(code_point));
+  dest[1] = static_cast<char16>(CBU16_TRAIL(code_point));
+  return 2;
+}
+
+// Converts UTF-8 to UTF-16 with the same result as ConvertUnicode(), writing
+// straight into |output| sized for the worst case instead of appending a
+// code point at a time. ASCII runs are widened 16 bytes at a time and
+// well-formed sequences are decoded inline; only errors go through
+// ReadUnicodeCharacter().
+bool ConvertUTF8ToUTF16(const char* src, size_t src_len, string16* output) {
+  // Every input byte produces at most one UTF-16 unit: four-byte sequences
+  // are the only ones that need two.
+  output->resize(src_len);
+  if (!src_len)
+    return true;
+  char16* const out_begin = &(*output)[0];
+  char16* out = out_begin;
+  const char* p = src;
+  const char* const end = src + src_len;
+  bool success = true;
+
+  while (p != end) {
+    size_t ascii = CountLeadingASCII(p, end - p);
+    const char* ascii_end = p + ascii;
+#if defined(UTF_STRING_CONVERSIONS_USE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; ascii_end - p >= 16; p += 16, out += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                       _mm_unpacklo_epi8(v, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8),
+                       _mm_unpackhi_epi8(v, zero));
+    }
+#endif
+    for (; p != ascii_end; ++p, ++out)
+      *out = static_cast<unsigned char>(*p);
+
+    while (p != end && (*p & 0x80)) {
+      uint32_t code_point;
+      size_t length = DecodeUTF8Sequence(p, end - p, &code_point);
+      if (length) {
+        p += length;
+      } else {
+        int32_t index = static_cast<int32_t>(p - src);
+        if (!ReadUnicodeCharacter(src, static_cast<int32_t>(src_len), &index,
+                                  &code_point)) {
+          code_point = 0xFFFD;
+          success = false;
+        }
+        p = src + index + 1;
+      }
+      out += StoreUTF16(code_point, out);
+    }
+  }
+
+  output->resize(out - out_begin);
+  return success;
+}
+
+// Converts UTF-16 to UTF-8 with the same result as ConvertUnicode(). See
+// ConvertUTF8ToUTF16().
+bool ConvertUTF16ToUTF8(const char16* src,
+                        size_t src_len,
+                        std::string* output) {
+  // A unit produces at most three bytes; a surrogate pair four.
+  output->resize(src_len * 3);
+  if (!src_len)
+    return true;
+  char* const out_begin = &(*output)[0];
+  char* out = out_begin;
+  const char16* p = src;
+  const char16* const end = src + src_len;
+  bool success = true;
+
+  while (p != end) {
+#if defined(UTF_STRING_CONVERSIONS_USE_SSE2)
+    const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+    while (end - p >= 16 && *p < 0x80) {
+      __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+      __m128i bits = _mm_and_si128(_mm_or_si128(low, high), non_ascii);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(bits, _mm_setzero_si128())) !=
+          0xFFFF) {
+        break;
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                       _mm_packus_epi16(low, high));
+      p += 16;
+      out += 16;
+    }
+    if (p == end)
+      break;
+#endif
+    uint32_t code_point = *p;
+    if (code_point < 0x80) {
+      *out++ = static_cast<char>(code_point);
+      ++p;
+      continue;
+    }
+    if (code_point < 0x800) {
+      *out++ = static_cast<char>(0xC0 | (code_point >> 6));
+      *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+      ++p;
+      continue;
+    }
+    if (!CBU16_IS_SURROGATE(code_point)) {
+      ++p;
+    } else {
+      int32_t index = static_cast<int32_t>(p - src);
+      if (!ReadUnicodeCharacter(src, static_cast<int32_t>(src_len), &index,
+                                &code_point)) {
+        code_point = 0xFFFD;
+        success = false;
+      }
+      p = src + index + 1;
+    }
+    if (code_point <= 0xFFFF) {
+      *out++ = static_cast<char>(0xE0 | (code_point >> 12));
+    } else {
+      *out++ = static_cast<char>(0xF0 | (code_point >> 18));
+      *out++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+    }
+    *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+  }
+
+  output->resize(out - out_begin);
+  return success;
+}
+
+#endif  // defined(WCHAR_T_IS_UTF32)
+
 }  // namespace
 
 // UTF-8 <-> Wide --------------------------------------------------------------
@@ -147,47 +294,26 @@ std::wstring UTF16ToWide(const string16& utf16) {
 #if defined(WCHAR_T_IS_UTF32)
 
 bool UTF8ToUTF16(const char* src, size_t src_len, string16* output) {
-  if (IsStringASCII(StringPiece(src, src_len))) {
-    output->assign(src, src + src_len);
-    return true;
-  } else {
-    PrepareForUTF16Or32Output(src, src_len, output);
-    return ConvertUnicode(src, src_len, output);
-  }
+  return ConvertUTF8ToUTF16(src, src_len, output);
 }
 
 string16 UTF8ToUTF16(StringPiece utf8) {
-  if (IsStringASCII(utf8)) {
-    return string16(utf8.begin(), utf8.end());
-  }
-
   string16 ret;
-  PrepareForUTF16Or32Output(utf8.data(), utf8.length(), &ret);
   // Ignore the success flag of this call, it will do the best it can for
   // invalid input, which is what we want here.
-  ConvertUnicode(utf8.data(), utf8.length(), &ret);
+  ConvertUTF8ToUTF16(utf8.data(), utf8.length(), &ret);
   return ret;
 }
 
 bool UTF16ToUTF8(const char16* src, size_t src_len, std::string* output) {
-  if (IsStringASCII(StringPiece16(src, src_len))) {
-    output->assign(src, src + src_len);
-    return true;
-  } else {
-    PrepareForUTF8Output(src, src_len, output);
-    return ConvertUnicode(src, src_len, output);
-  }
+  return ConvertUTF16ToUTF8(src, src_len, output);
 }
 
 std::string UTF16ToUTF8(StringPiece16 utf16) {
-  if (IsStringASCII(utf16)) {
-    return std::string(utf16.begin(), utf16.end());
-  }
-
   std::string ret;
   // Ignore the success flag of this call, it will do the best it can for
   // invalid input, which is what we want here.
-  UTF16ToUTF8(utf16.data(), utf16.length(), &ret);
+  ConvertUTF16ToUTF8(utf16.data(), utf16.length(), &ret);
   return ret;
 }
 
@@ -6,8 +6,10 @@
 
 #include "base/logging.h"
 #include "base/macros.h"
+#include "base/rand_util.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/string_util.h"
+#include "base/strings/utf_string_conversion_utils.h"
 #include "base/strings/utf_string_conversions.h"
 #include "build/build_config.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -16,6 +18,55 @@ namespace base {
 
 namespace {
 
+// The code-point-at-a-time conversion the fast paths must match.
+template <typename SrcChar, typename DestString>
+bool ReferenceConvert(const SrcChar* src, size_t src_len, DestString* output) {
+  bool success = true;
+  int32_t src_len32 = static_cast<int32_t>(src_len);
+  for (int32_t i = 0; i < src_len32; i++) {
+    uint32_t code_point;
+    if (ReadUnicodeCharacter(src, src_len32, &i, &code_point)) {
+      WriteUnicodeCharacter(code_point, output);
+    } else {
+      WriteUnicodeCharacter(0xFFFD, output);
+      success = false;
+    }
+  }
+  return success;
+}
+
+bool ReferenceIsStringUTF8(const std::string& str) {
+  int32_t length = static_cast<int32_t>(str.length());
+  for (int32_t i = 0; i < length; ++i) {
+    uint32_t code_point;
+    if (!ReadUnicodeCharacter(str.data(), length, &i, &code_point) ||
+        !IsValidCharacter(code_point)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns mostly-valid UTF-8 with ASCII runs of varying length, multi-byte
+// characters and occasional random bytes.
+std::string RandomUTF8(int length) {
+  const char* const kPieces[] = {
+      "a", "hello world, ", "\xC3\xA9", "\xE4\xBD\xA0", "\xF0\x9F\x98\x80",
+      "\xEF\xBF\xBE", "\xED\xA0\x80", "\xE0\x80\xAF", "\xF4\x90\x80\x80",
+      "\xC3", "\xE4\xBD", "\x80", "\xFF",
+  };
+  std::string result;
+  while (static_cast<int>(result.size()) < length) {
+    if (RandInt(0, 20) == 0)
+      result.push_back(static_cast<char>(RandInt(0, 255)));
+    else if (RandInt(0, 3) == 0)
+      result += kPieces[RandInt(0, arraysize(kPieces) - 1)];
+    else
+      result += kPieces[RandInt(0, 4)];
+  }
+  return result;
+}
+
 const wchar_t* const kConvertRoundtripCases[] = {
   L"Google Video",
   // "网页 图片 资讯更多 »"
@@ -208,4 +259,35 @@ TEST(UTFStringConversionsTest, ConvertMultiString) {
   EXPECT_EQ(expected, converted);
 }
 
+TEST(UTFStringConversionsTest, FastPathsMatchReference) {
+  for (int i = 0; i < 3000; ++i) {
+    std::string utf8 = RandomUTF8(RandInt(0, 80));
+    EXPECT_EQ(ReferenceIsStringUTF8(utf8), IsStringUTF8(utf8));
+
+    string16 expected16;
+    bool expected_ok = ReferenceConvert(utf8.data(), utf8.size(), &expected16);
+    string16 utf16(ASCIIToUTF16("stale contents"));
+    ASSERT_EQ(expected_ok, UTF8ToUTF16(utf8.data(), utf8.size(), &utf16));
+    ASSERT_EQ(expected16, utf16);
+
+    // Break some surrogate pairs for the other direction.
+    if (!utf16.empty() && RandInt(0, 3) == 0)
+      utf16[RandInt(0, utf16.size() - 1)] = static_cast<char16>(0xD800);
+    std::string expected8;
+    expected_ok = ReferenceConvert(utf16.data(), utf16.size(), &expected8);
+    std::string back("stale contents");
+    ASSERT_EQ(expected_ok, UTF16ToUTF8(utf16.data(), utf16.size(), &back));
+    ASSERT_EQ(expected8, back);
+  }
+
+  EXPECT_EQ(0u, CountLeadingASCII("", 0));
+  std::string ascii(40, 'a');
+  for (size_t i = 0; i < ascii.size(); ++i) {
+    std::string str = ascii;
+    str[i] = '\x80';
+    EXPECT_EQ(i, CountLeadingASCII(str.data(), str.size()));
+  }
+  EXPECT_EQ(ascii.size(), CountLeadingASCII(ascii.data(), ascii.size()));
+}
+
 }  // namespace base
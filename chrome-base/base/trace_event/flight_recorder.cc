@@ -0,0 +1,314 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/flight_recorder.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/json/string_escape.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/process/process_handle.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/platform_thread.h"
+#include "base/trace_event/trace_config.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_log.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+// Recorded in place of names that TraceLog would have copied; the recorder
+// keeps only pointers.
+const char kCopiedName[] = "(copied name)";
+
+LazyInstance<FlightRecorder>::Leaky g_flight_recorder =
+    LAZY_INSTANCE_INITIALIZER;
+
+// The recorder that OnTraceEvent() feeds, or null.
+subtle::AtomicWord g_active_recorder = 0;
+
+}  // namespace
+
+FlightRecorder::ThreadRing::ThreadRing()
+    : recorder(nullptr),
+      thread_id(kInvalidThreadId),
+      events(nullptr),
+      next(0),
+      depth(0) {}
+
+// static
+const size_t FlightRecorder::kEventSize = sizeof(FlightRecorder::Event);
+
+// static
+FlightRecorder* FlightRecorder::GetInstance() {
+  return g_flight_recorder.Pointer();
+}
+
+FlightRecorder::FlightRecorder()
+    : ring_capacity_(0),
+      max_threads_(0),
+      dropped_events_(0),
+      thread_ring_(&FlightRecorder::ReleaseThreadRing),
+      claimed_rings_(0),
+      slo_event_name_(nullptr),
+      started_(false),
+      recording_(false) {}
+
+FlightRecorder::~FlightRecorder() {
+  Stop();
+  // Threads that exit from here on keep their rings.
+  thread_ring_.Free();
+}
+
+void FlightRecorder::Start(const std::string& category_filter,
+                           size_t memory_budget_bytes,
+                           size_t max_threads) {
+  AutoLock lock(lock_);
+  DCHECK(!started_);
+  DCHECK_GT(max_threads, 0u);
+  DCHECK(!subtle::NoBarrier_Load(&g_active_recorder));
+
+  ring_capacity_ = memory_budget_bytes / (max_threads * kEventSize);
+  DCHECK_GT(ring_capacity_, 0u);
+  max_threads_ = max_threads;
+  events_.reset(new Event[ring_capacity_ * max_threads_]);
+  memset(events_.get(), 0, ring_capacity_ * max_threads_ * kEventSize);
+  rings_.reset(new ThreadRing[max_threads_]);
+  {
+    AutoLock rings_lock(rings_lock_);
+    // Handed out from the back, so the first thread gets ring 0.
+    free_rings_.reserve(max_threads_);
+    for (size_t i = max_threads_; i-- > 0;) {
+      rings_[i].recorder = this;
+      rings_[i].events = &events_[i * ring_capacity_];
+      free_rings_.push_back(&rings_[i]);
+    }
+  }
+  started_ = true;
+  recording_ = true;
+
+  subtle::Release_Store(&g_active_recorder,
+                        reinterpret_cast<subtle::AtomicWord>(this));
+  TraceLog::GetInstance()->SetEventCallbackEnabled(
+      TraceConfig(category_filter, ""), &FlightRecorder::OnTraceEvent);
+}
+
+void FlightRecorder::Stop() {
+  AutoLock lock(lock_);
+  if (!recording_)
+    return;
+  TraceLog::GetInstance()->SetEventCallbackDisabled();
+  // TraceLog may still deliver a few events that raced with the call above;
+  // they are ignored from here on, and the rings are kept alive until the
+  // recorder is destroyed.
+  subtle::Release_Store(&g_active_recorder, 0);
+  recording_ = false;
+}
+
+bool FlightRecorder::IsRecording() const {
+  AutoLock lock(lock_);
+  return recording_;
+}
+
+void FlightRecorder::SetLatencySlo(const char* event_name,
+                                   TimeDelta slo,
+                                   TimeDelta window,
+                                   const DumpCallback& callback) {
+  DCHECK(!started_);
+  slo_event_name_ = event_name;
+  slo_ = slo;
+  slo_window_ = window;
+  slo_callback_ = callback;
+}
+
+// static
+void FlightRecorder::OnTraceEvent(TimeTicks timestamp,
+                                  char phase,
+                                  const unsigned char* category_group_enabled,
+                                  const char* name,
+                                  unsigned long long id,
+                                  int num_args,
+                                  const char* const arg_names[],
+                                  const unsigned char arg_types[],
+                                  const unsigned long long arg_values[],
+                                  unsigned int flags) {
+  FlightRecorder* recorder = reinterpret_cast<FlightRecorder*>(
+      subtle::Acquire_Load(&g_active_recorder));
+  if (recorder) {
+    recorder->AddEvent(timestamp, phase, category_group_enabled, name, id,
+                       flags);
+  }
+}
+
+void FlightRecorder::AddEvent(TimeTicks timestamp,
+                              char phase,
+                              const unsigned char* category_group_enabled,
+                              const char* name,
+                              unsigned long long id,
+                              unsigned int flags) {
+  ThreadRing* ring = GetThreadRing();
+  if (!ring) {
+    subtle::NoBarrier_AtomicIncrement(&dropped_events_, 1);
+    return;
+  }
+
+  if (flags & TRACE_EVENT_FLAG_COPY)
+    name = kCopiedName;
+
+  Event* event = &ring->events[ring->next];
+  if (++ring->next == ring_capacity_)
+    ring->next = 0;
+
+  uint32_t seq = static_cast<uint32_t>(subtle::NoBarrier_Load(&event->seq));
+  subtle::NoBarrier_Store(&event->seq, static_cast<subtle::Atomic32>(seq + 1));
+  subtle::MemoryBarrier();
+  event->phase = phase;
+  event->flags = flags;
+  event->thread_id = ring->thread_id;
+  event->timestamp = timestamp.ToInternalValue();
+  event->id = id;
+  event->name = name;
+  event->category_group_enabled = category_group_enabled;
+  subtle::Release_Store(&event->seq, static_cast<subtle::Atomic32>(seq + 2));
+
+  if (!slo_event_name_)
+    return;
+  if (phase == TRACE_EVENT_PHASE_BEGIN) {
+    if (ring->depth < kMaxBeginDepth) {
+      ring->begin_names[ring->depth] = name;
+      ring->begin_times[ring->depth] = timestamp;
+    }
+    ++ring->depth;
+  } else if (phase == TRACE_EVENT_PHASE_END && ring->depth > 0) {
+    --ring->depth;
+    if (ring->depth < kMaxBeginDepth) {
+      CheckLatencySlo(ring->begin_names[ring->depth],
+                      ring->begin_times[ring->depth], timestamp);
+    }
+  }
+}
+
+FlightRecorder::ThreadRing* FlightRecorder::GetThreadRing() {
+  ThreadRing* ring = static_cast<ThreadRing*>(thread_ring_.Get());
+  if (ring)
+    return ring;
+  if (static_cast<size_t>(subtle::NoBarrier_Load(&claimed_rings_)) >=
+      max_threads_) {
+    return nullptr;
+  }
+  {
+    AutoLock rings_lock(rings_lock_);
+    if (free_rings_.empty())
+      return nullptr;
+    ring = free_rings_.back();
+    free_rings_.pop_back();
+    subtle::NoBarrier_AtomicIncrement(&claimed_rings_, 1);
+  }
+  ring->thread_id = PlatformThread::CurrentId();
+  thread_ring_.Set(ring);
+  return ring;
+}
+
+// static
+void FlightRecorder::ReleaseThreadRing(void* value) {
+  ThreadRing* ring = static_cast<ThreadRing*>(value);
+  FlightRecorder* recorder = ring->recorder;
+  // The events stay for dumps; only the begin stack belongs to the thread.
+  ring->depth = 0;
+  AutoLock rings_lock(recorder->rings_lock_);
+  recorder->free_rings_.push_back(ring);
+  subtle::NoBarrier_AtomicIncrement(&recorder->claimed_rings_, -1);
+}
+
+void FlightRecorder::CheckLatencySlo(const char* name,
+                                     TimeTicks begin,
+                                     TimeTicks end) {
+  if (name != slo_event_name_ && strcmp(name, slo_event_name_) != 0)
+    return;
+  if (end - begin <= slo_)
+    return;
+  if (!slo_lock_.Try())
+    return;
+  bool dump = last_slo_dump_.is_null() || end - last_slo_dump_ >= slo_window_;
+  if (dump)
+    last_slo_dump_ = end;
+  slo_lock_.Release();
+  if (!dump)
+    return;
+
+  std::string json;
+  DumpRecentEvents(slo_window_, &json);
+  slo_callback_.Run(json);
+}
+
+void FlightRecorder::DumpRecentEvents(TimeDelta window,
+                                      std::string* json) const {
+  struct DumpedEvent {
+    Event event;
+
+    bool operator<(const DumpedEvent& other) const {
+      return event.timestamp < other.event.timestamp;
+    }
+  };
+
+  const int64_t cutoff = (TimeTicks::Now() - window).ToInternalValue();
+  std::vector<DumpedEvent> dumped;
+  // Rings of exited threads still hold their events, so every ring is read;
+  // slots that were never written have |seq| 0.
+  for (size_t i = 0; i < max_threads_; ++i) {
+    const ThreadRing& ring = rings_[i];
+    for (size_t j = 0; j < ring_capacity_; ++j) {
+      const Event* event = &ring.events[j];
+      subtle::Atomic32 seq = subtle::Acquire_Load(&event->seq);
+      if (seq == 0 || (seq & 1))
+        continue;
+      DumpedEvent copy;
+      copy.event.phase = event->phase;
+      copy.event.flags = event->flags;
+      copy.event.thread_id = event->thread_id;
+      copy.event.timestamp = event->timestamp;
+      copy.event.id = event->id;
+      copy.event.name = event->name;
+      copy.event.category_group_enabled = event->category_group_enabled;
+      subtle::MemoryBarrier();
+      if (subtle::NoBarrier_Load(&event->seq) != seq)
+        continue;
+      if (copy.event.timestamp < cutoff)
+        continue;
+      dumped.push_back(copy);
+    }
+  }
+  std::stable_sort(dumped.begin(), dumped.end());
+
+  const ProcessId pid = GetCurrentProcId();
+  json->assign("{\"traceEvents\":[");
+  for (size_t i = 0; i < dumped.size(); ++i) {
+    const Event& event = dumped[i].event;
+    if (i)
+      json->push_back(',');
+    StringAppendF(json, "{\"pid\":%d,\"tid\":%d,\"ts\":%" PRId64
+                        ",\"ph\":\"%c\",\"cat\":",
+                  static_cast<int>(pid), static_cast<int>(event.thread_id),
+                  event.timestamp, event.phase);
+    EscapeJSONString(
+        TraceLog::GetCategoryGroupName(event.category_group_enabled), true,
+        json);
+    json->append(",\"name\":");
+    EscapeJSONString(event.name, true, json);
+    if (event.flags & TRACE_EVENT_FLAG_HAS_ID)
+      StringAppendF(json, ",\"id\":\"0x%llx\"", event.id);
+    json->append(",\"args\":{}}");
+  }
+  json->append("]}");
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -0,0 +1,202 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TRACE_EVENT_FLIGHT_RECORDER_H_
+#define BASE_TRACE_EVENT_FLIGHT_RECORDER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread_local_storage.h"
+#include "base/time/time.h"
+
+namespace base {
+namespace trace_event {
+
+// FlightRecorder keeps the most recent trace events of a few categories in
+// memory at all times, so that the moments before a slow request can be
+// inspected after the fact. Unlike TraceLog recording, which serializes full
+// TraceEvents into a shared TraceBuffer and takes the TraceLog lock whenever
+// a thread's chunk fills, each thread writes compact events into its own
+// fixed-size ring buffer without any lock. The total memory is fixed when
+// the recorder starts.
+//
+// Usage:
+//
+//   FlightRecorder* recorder = FlightRecorder::GetInstance();
+//   recorder->SetLatencySlo("Recognize", TimeDelta::FromMilliseconds(300),
+//                           TimeDelta::FromSeconds(10),
+//                           Bind(&PostDumpToLogWriter));
+//   recorder->Start("asr", 4 << 20, 32);
+//   ...
+//   std::string json;
+//   recorder->DumpRecentEvents(TimeDelta::FromSeconds(10), &json);
+//
+// The recorder is fed through TraceLog's EventCallback, so it cannot be used
+// together with another SetEventCallbackEnabled() client. It does not need
+// TraceLog recording to be enabled, and coexists with it if it is.
+class BASE_EXPORT FlightRecorder {
+ public:
+  // Receives a dump in the JSON trace format, as accepted by about:tracing.
+  typedef Callback<void(const std::string& json)> DumpCallback;
+
+  // Size of one recorded event, for budgeting.
+  static const size_t kEventSize;
+
+  // Returns the process-wide recorder.
+  static FlightRecorder* GetInstance();
+
+  FlightRecorder();
+  ~FlightRecorder();
+
+  // Starts recording the events of |category_filter| (same syntax as
+  // TraceConfig) into |max_threads| rings sharing |memory_budget_bytes|. Each
+  // thread that emits a matching event claims a ring on its first event and
+  // returns it when it exits, so |max_threads| bounds the threads recording at
+  // once rather than over the life of the process. The events of an exited
+  // thread stay in its ring until the next owner overwrites them. Events from
+  // threads beyond |max_threads| are dropped and counted. May only be called
+  // once per recorder.
+  void Start(const std::string& category_filter,
+             size_t memory_budget_bytes,
+             size_t max_threads);
+
+  // Stops recording. The recorded events stay available for dumping.
+  void Stop();
+
+  bool IsRecording() const;
+
+  // Requests a dump whenever a complete event (a TRACE_EVENT scope or a
+  // BEGIN/END pair) named |event_name| lasts longer than |slo|. |callback|
+  // receives the events of the last |window| and runs on the thread that
+  // ended the slow event, so it should hand the JSON off rather than do I/O.
+  // Dumps are rate-limited to one per |window|. |event_name| must outlive the
+  // recorder. Call before Start().
+  void SetLatencySlo(const char* event_name,
+                     TimeDelta slo,
+                     TimeDelta window,
+                     const DumpCallback& callback);
+
+  // Writes the events recorded in the last |window| by all threads, in
+  // timestamp order, as a JSON trace to |json|. Thread-safe; events written
+  // concurrently with the dump may be skipped.
+  void DumpRecentEvents(TimeDelta window, std::string* json) const;
+
+  // Number of events that found no ring because every ring was taken.
+  int32_t dropped_event_count() const {
+    return subtle::NoBarrier_Load(&dropped_events_);
+  }
+
+  // Number of events each ring holds.
+  size_t ring_capacity() const { return ring_capacity_; }
+
+ private:
+  // Deepest nesting of BEGIN/END pairs tracked per thread for SLO checks.
+  static const int kMaxBeginDepth = 32;
+
+  // An event slot. |seq| is odd while the owning thread is writing the slot
+  // and advances by two each time the slot is reused, so that readers can
+  // detect and discard slots that change while they are being copied.
+  struct Event {
+    subtle::Atomic32 seq;
+    char phase;
+    unsigned int flags;
+    // The thread that wrote the event, which outlives its ring ownership.
+    PlatformThreadId thread_id;
+    int64_t timestamp;
+    unsigned long long id;
+    const char* name;
+    const unsigned char* category_group_enabled;
+  };
+
+  // A ring owned by one thread at a time. Only the owner writes |next| and
+  // the begin stack; readers only look at the events.
+  struct ThreadRing {
+    ThreadRing();
+
+    FlightRecorder* recorder;
+    PlatformThreadId thread_id;
+    Event* events;
+    size_t next;
+
+    // Start times of the BEGIN events that have not ended yet.
+    int depth;
+    const char* begin_names[kMaxBeginDepth];
+    TimeTicks begin_times[kMaxBeginDepth];
+  };
+
+  // Matches TraceLog::EventCallback.
+  static void OnTraceEvent(TimeTicks timestamp,
+                           char phase,
+                           const unsigned char* category_group_enabled,
+                           const char* name,
+                           unsigned long long id,
+                           int num_args,
+                           const char* const arg_names[],
+                           const unsigned char arg_types[],
+                           const unsigned long long arg_values[],
+                           unsigned int flags);
+
+  void AddEvent(TimeTicks timestamp,
+                char phase,
+                const unsigned char* category_group_enabled,
+                const char* name,
+                unsigned long long id,
+                unsigned int flags);
+
+  // Returns the ring of the calling thread, claiming one if needed, or null
+  // when none is left.
+  ThreadRing* GetThreadRing();
+
+  // The destructor of |thread_ring_|: puts the ring of an exiting thread back
+  // on the free list.
+  static void ReleaseThreadRing(void* ring);
+
+  // Checks the SLO on the END of |name| that started at |begin|.
+  void CheckLatencySlo(const char* name, TimeTicks begin, TimeTicks end);
+
+  size_t ring_capacity_;
+  size_t max_threads_;
+  scoped_ptr<Event[]> events_;
+  scoped_ptr<ThreadRing[]> rings_;
+  subtle::Atomic32 dropped_events_;
+  ThreadLocalStorage::Slot thread_ring_;
+
+  // Guards |free_rings_|. |claimed_rings_| is only written under it, and lets
+  // threads without a ring skip the lock while every ring is taken.
+  Lock rings_lock_;
+  std::vector<ThreadRing*> free_rings_;
+  subtle::Atomic32 claimed_rings_;
+
+  const char* slo_event_name_;
+  TimeDelta slo_;
+  TimeDelta slo_window_;
+  DumpCallback slo_callback_;
+  // Held while an SLO-triggered dump is being taken; threads that breach the
+  // SLO meanwhile skip their own dump.
+  Lock slo_lock_;
+  TimeTicks last_slo_dump_;
+
+  // Guards Start() and Stop().
+  mutable Lock lock_;
+  bool started_;
+  bool recording_;
+
+  DISALLOW_COPY_AND_ASSIGN(FlightRecorder);
+};
+
+}  // namespace trace_event
+}  // namespace base
+
+#endif  // BASE_TRACE_EVENT_FLIGHT_RECORDER_H_
@@ -0,0 +1,177 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/flight_recorder.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/json/json_reader.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "base/trace_event/trace_event.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+const char kCategory[] = "flight_recorder_test";
+
+// Parses |json| and returns its event list, or null.
+scoped_ptr<ListValue> ParseEvents(const std::string& json) {
+  scoped_ptr<Value> root = JSONReader::Read(json);
+  DictionaryValue* dict;
+  ListValue* events;
+  if (!root || !root->GetAsDictionary(&dict) ||
+      !dict->GetList("traceEvents", &events)) {
+    return nullptr;
+  }
+  return make_scoped_ptr(events->DeepCopy());
+}
+
+std::string EventString(const ListValue& events,
+                        size_t index,
+                        const char* key) {
+  const DictionaryValue* event = nullptr;
+  std::string value;
+  if (events.GetDictionary(index, &event))
+    event->GetString(key, &value);
+  return value;
+}
+
+class InstantEventDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  void Run() override {
+    TRACE_EVENT_INSTANT0(kCategory, "OtherThread", TRACE_EVENT_SCOPE_THREAD);
+  }
+};
+
+void SaveDump(std::string* out, int* count, const std::string& json) {
+  *out = json;
+  ++*count;
+}
+
+}  // namespace
+
+TEST(FlightRecorderTest, RecordsOnlyConfiguredCategories) {
+  FlightRecorder recorder;
+  recorder.Start(kCategory, 64 * FlightRecorder::kEventSize, 4);
+  EXPECT_TRUE(recorder.IsRecording());
+  {
+    TRACE_EVENT0(kCategory, "Recognize");
+    TRACE_EVENT0("flight_recorder_other", "Ignored");
+  }
+  recorder.Stop();
+  EXPECT_FALSE(recorder.IsRecording());
+  TRACE_EVENT_INSTANT0(kCategory, "AfterStop", TRACE_EVENT_SCOPE_THREAD);
+
+  std::string json;
+  recorder.DumpRecentEvents(TimeDelta::FromSeconds(60), &json);
+  scoped_ptr<ListValue> events = ParseEvents(json);
+  ASSERT_TRUE(events);
+  ASSERT_EQ(2u, events->GetSize());
+  EXPECT_EQ("B", EventString(*events, 0, "ph"));
+  EXPECT_EQ("Recognize", EventString(*events, 0, "name"));
+  EXPECT_EQ(kCategory, EventString(*events, 0, "cat"));
+  EXPECT_EQ("E", EventString(*events, 1, "ph"));
+}
+
+TEST(FlightRecorderTest, RingKeepsMostRecentEvents) {
+  static const char* const kNames[] = {"e0", "e1", "e2", "e3", "e4",
+                                       "e5", "e6", "e7", "e8", "e9"};
+  FlightRecorder recorder;
+  recorder.Start(kCategory, 4 * FlightRecorder::kEventSize, 1);
+  EXPECT_EQ(4u, recorder.ring_capacity());
+  for (size_t i = 0; i < arraysize(kNames); ++i)
+    TRACE_EVENT_INSTANT0(kCategory, kNames[i], TRACE_EVENT_SCOPE_THREAD);
+  recorder.Stop();
+
+  std::string json;
+  recorder.DumpRecentEvents(TimeDelta::FromSeconds(60), &json);
+  scoped_ptr<ListValue> events = ParseEvents(json);
+  ASSERT_TRUE(events);
+  ASSERT_EQ(4u, events->GetSize());
+  EXPECT_EQ("e6", EventString(*events, 0, "name"));
+  EXPECT_EQ("e9", EventString(*events, 3, "name"));
+}
+
+TEST(FlightRecorderTest, ThreadsBeyondBudgetAreDropped) {
+  FlightRecorder recorder;
+  recorder.Start(kCategory, 16 * FlightRecorder::kEventSize, 1);
+  TRACE_EVENT_INSTANT0(kCategory, "MainThread", TRACE_EVENT_SCOPE_THREAD);
+  InstantEventDelegate delegate;
+  DelegateSimpleThread thread(&delegate, "FlightRecorderTest");
+  thread.Start();
+  thread.Join();
+  recorder.Stop();
+
+  EXPECT_EQ(1, recorder.dropped_event_count());
+  std::string json;
+  recorder.DumpRecentEvents(TimeDelta::FromSeconds(60), &json);
+  scoped_ptr<ListValue> events = ParseEvents(json);
+  ASSERT_TRUE(events);
+  ASSERT_EQ(1u, events->GetSize());
+  EXPECT_EQ("MainThread", EventString(*events, 0, "name"));
+}
+
+TEST(FlightRecorderTest, ExitedThreadsReturnTheirRings) {
+  FlightRecorder recorder;
+  recorder.Start(kCategory, 16 * FlightRecorder::kEventSize, 1);
+  // More threads than rings, one after another.
+  InstantEventDelegate delegate;
+  for (int i = 0; i < 3; ++i) {
+    DelegateSimpleThread thread(&delegate, "FlightRecorderTest");
+    thread.Start();
+    thread.Join();
+  }
+  recorder.Stop();
+
+  EXPECT_EQ(0, recorder.dropped_event_count());
+  std::string json;
+  recorder.DumpRecentEvents(TimeDelta::FromSeconds(60), &json);
+  scoped_ptr<ListValue> events = ParseEvents(json);
+  ASSERT_TRUE(events);
+  ASSERT_EQ(3u, events->GetSize());
+  EXPECT_EQ("OtherThread", EventString(*events, 2, "name"));
+}
+
+TEST(FlightRecorderTest, LatencySloTriggersDump) {
+  std::string dump;
+  int dump_count = 0;
+  FlightRecorder recorder;
+  recorder.SetLatencySlo("Slow", TimeDelta::FromMilliseconds(1),
+                         TimeDelta::FromSeconds(60),
+                         Bind(&SaveDump, &dump, &dump_count));
+  recorder.Start(kCategory, 64 * FlightRecorder::kEventSize, 2);
+  {
+    TRACE_EVENT0(kCategory, "Fast");
+  }
+  EXPECT_EQ(0, dump_count);
+  {
+    TRACE_EVENT0(kCategory, "Slow");
+    PlatformThread::Sleep(TimeDelta::FromMilliseconds(5));
+  }
+  EXPECT_EQ(1, dump_count);
+  // A second breach within the window is not dumped again.
+  {
+    TRACE_EVENT0(kCategory, "Slow");
+    PlatformThread::Sleep(TimeDelta::FromMilliseconds(5));
+  }
+  recorder.Stop();
+  EXPECT_EQ(1, dump_count);
+
+  scoped_ptr<ListValue> events = ParseEvents(dump);
+  ASSERT_TRUE(events);
+  ASSERT_EQ(4u, events->GetSize());
+  EXPECT_EQ("Fast", EventString(*events, 0, "name"));
+  EXPECT_EQ("Slow", EventString(*events, 2, "name"));
+  EXPECT_EQ("E", EventString(*events, 3, "ph"));
+}
+
+}  // namespace trace_event
+}  // namespace base
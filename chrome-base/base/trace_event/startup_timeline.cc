@@ -0,0 +1,193 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/startup_timeline.h"
+
+#include <stdint.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "base/atomicops.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/platform_thread.h"
+#include "base/trace_event/trace_event.h"
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include "base/process/internal_linux.h"
+#include "base/process/process_handle.h"
+#endif
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+struct PhaseSlot {
+  const char* name;
+  int64_t start;
+  subtle::Atomic32 lazy_instances_at_start;
+  // Set once the other fields are written.
+  subtle::Atomic32 ready;
+};
+
+// Zero-initialized before any static initializer runs.
+PhaseSlot g_phases[StartupTimeline::kMaxPhases];
+subtle::Atomic32 g_phase_count = 0;
+subtle::Atomic32 g_lazy_instances = 0;
+
+bool ComparePhaseStart(const StartupTimeline::Phase& a,
+                       const StartupTimeline::Phase& b) {
+  return a.start < b.start;
+}
+
+}  // namespace
+
+// static
+const size_t StartupTimeline::kMaxPhases;
+
+// static
+void StartupTimeline::MarkPhase(const char* name) {
+  subtle::Atomic32 index =
+      subtle::NoBarrier_AtomicIncrement(&g_phase_count, 1) - 1;
+  if (static_cast<size_t>(index) >= kMaxPhases)
+    return;
+  PhaseSlot* slot = &g_phases[index];
+  slot->name = name;
+  slot->start = TimeTicks::Now().ToInternalValue();
+  subtle::NoBarrier_Store(&slot->lazy_instances_at_start,
+                          subtle::NoBarrier_Load(&g_lazy_instances));
+  subtle::Release_Store(&slot->ready, 1);
+}
+
+// static
+void StartupTimeline::OnLazyInstanceCreated() {
+  subtle::NoBarrier_AtomicIncrement(&g_lazy_instances, 1);
+}
+
+// static
+std::vector<StartupTimeline::Phase> StartupTimeline::GetPhases() {
+  size_t count = std::min(
+      static_cast<size_t>(subtle::Acquire_Load(&g_phase_count)), kMaxPhases);
+  std::vector<Phase> phases;
+  for (size_t i = 0; i < count; ++i) {
+    const PhaseSlot& slot = g_phases[i];
+    if (!subtle::Acquire_Load(&slot.ready))
+      continue;
+    Phase phase;
+    phase.name = slot.name;
+    phase.start = TimeTicks::FromInternalValue(slot.start);
+    // Stash the running count until the phases are in order.
+    phase.lazy_instances =
+        subtle::NoBarrier_Load(&slot.lazy_instances_at_start);
+    phases.push_back(phase);
+  }
+
+  // Phases marked concurrently may have claimed slots out of order.
+  std::stable_sort(phases.begin(), phases.end(), &ComparePhaseStart);
+  for (size_t i = 0; i < phases.size(); ++i) {
+    int next = i + 1 < phases.size()
+                   ? phases[i + 1].lazy_instances
+                   : subtle::NoBarrier_Load(&g_lazy_instances);
+    phases[i].lazy_instances = std::max(next - phases[i].lazy_instances, 0);
+  }
+  return phases;
+}
+
+// static
+TimeTicks StartupTimeline::GetExecTime() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // The start time counts clock ticks since boot, including suspend, so it
+  // is compared with CLOCK_BOOTTIME rather than with TimeTicks.
+  int64_t start_ticks = internal::ReadProcStatsAndGetFieldAsInt64(
+      GetCurrentProcessHandle(), internal::VM_STARTTIME);
+  struct timespec boot_time;
+  if (!start_ticks || clock_gettime(CLOCK_BOOTTIME, &boot_time) != 0)
+    return TimeTicks();
+  TimeTicks now = TimeTicks::Now();
+  TimeDelta since_boot =
+      TimeDelta::FromSeconds(boot_time.tv_sec) +
+      TimeDelta::FromMicroseconds(boot_time.tv_nsec /
+                                  Time::kNanosecondsPerMicrosecond);
+  return now - (since_boot -
+                internal::ClockTicksToTimeDelta(static_cast<int>(start_ticks)));
+#else
+  return TimeTicks();
+#endif
+}
+
+// static
+void StartupTimeline::AddToTrace() {
+  std::vector<Phase> phases = GetPhases();
+  if (phases.empty())
+    return;
+  const int thread_id = static_cast<int>(PlatformThread::CurrentId());
+
+  TimeTicks exec_time = GetExecTime();
+  if (!exec_time.is_null() && exec_time < phases[0].start) {
+    TRACE_EVENT_COPY_BEGIN_WITH_ID_TID_AND_TIMESTAMP0(
+        "startup", "exec", 0, thread_id, exec_time.ToInternalValue());
+    TRACE_EVENT_COPY_END_WITH_ID_TID_AND_TIMESTAMP0(
+        "startup", "exec", 0, thread_id, phases[0].start.ToInternalValue());
+  }
+  for (size_t i = 0; i + 1 < phases.size(); ++i) {
+    TRACE_EVENT_COPY_BEGIN_WITH_ID_TID_AND_TIMESTAMP1(
+        "startup", phases[i].name, i + 1, thread_id,
+        phases[i].start.ToInternalValue(), "lazy_instances",
+        phases[i].lazy_instances);
+    TRACE_EVENT_COPY_END_WITH_ID_TID_AND_TIMESTAMP0(
+        "startup", phases[i].name, i + 1, thread_id,
+        phases[i + 1].start.ToInternalValue());
+  }
+  TRACE_EVENT_COPY_MARK_WITH_TIMESTAMP("startup", phases.back().name,
+                                       phases.back().start.ToInternalValue());
+}
+
+// static
+std::string StartupTimeline::GetReport() {
+  std::vector<Phase> phases = GetPhases();
+  if (phases.empty())
+    return "No startup phases marked\n";
+
+  TimeTicks exec_time = GetExecTime();
+  TimeTicks origin = phases[0].start;
+  std::string report;
+  if (!exec_time.is_null() && exec_time < origin) {
+    origin = exec_time;
+    report = "Startup timeline, ms since exec (to a clock tick):\n";
+  } else {
+    report = "Startup timeline, ms since the first phase:\n";
+  }
+  StringAppendF(&report, "%10s %10s %6s  %s\n", "at", "duration", "lazy",
+                "phase");
+  if (origin != phases[0].start) {
+    StringAppendF(&report, "%10.1f %10.1f %6s  %s\n", 0.0,
+                  (phases[0].start - origin).InMillisecondsF(), "",
+                  "exec");
+  }
+  for (size_t i = 0; i < phases.size(); ++i) {
+    double at = (phases[i].start - origin).InMillisecondsF();
+    if (i + 1 < phases.size()) {
+      StringAppendF(&report, "%10.1f %10.1f %6d  %s\n", at,
+                    (phases[i + 1].start - phases[i].start).InMillisecondsF(),
+                    phases[i].lazy_instances, phases[i].name);
+    } else {
+      StringAppendF(&report, "%10.1f %10s %6d  %s\n", at, "",
+                    phases[i].lazy_instances, phases[i].name);
+    }
+  }
+  return report;
+}
+
+// static
+void StartupTimeline::ResetForTesting() {
+  for (size_t i = 0; i < kMaxPhases; ++i)
+    subtle::NoBarrier_Store(&g_phases[i].ready, 0);
+  subtle::Release_Store(&g_phase_count, 0);
+  subtle::NoBarrier_Store(&g_lazy_instances, 0);
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -0,0 +1,90 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TRACE_EVENT_STARTUP_TIMELINE_H_
+#define BASE_TRACE_EVENT_STARTUP_TIMELINE_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/macros.h"
+#include "base/time/time.h"
+
+namespace base {
+namespace trace_event {
+
+// StartupTimeline records when the process reaches each phase of its
+// startup, from before main() runs until it is ready to serve, and breaks
+// the time since exec down by phase.
+//
+// Recording needs no allocation, lock or TraceLog, so phases can be marked
+// from static initializers and before an AtExitManager exists:
+//
+//   __attribute__((constructor(101))) void MarkStaticInitializers() {
+//     StartupTimeline::MarkPhase("static_initializers");
+//   }
+//
+//   int main() {
+//     StartupTimeline::MarkPhase("main");
+//     ...
+//     StartupTimeline::MarkPhase("resource_import");
+//     TalParaformerResourceImport(...);
+//     StartupTimeline::MarkPhase("ready");
+//     LOG(INFO) << StartupTimeline::GetReport();
+//   }
+//
+// A mark ends the previous phase, so each phase is named after the work
+// that follows it. Each phase also counts the LazyInstances created during
+// it.
+class BASE_EXPORT StartupTimeline {
+ public:
+  // Marks beyond this number are dropped.
+  static const size_t kMaxPhases = 64;
+
+  struct Phase {
+    const char* name;
+    TimeTicks start;
+    // LazyInstances created from |start| to the start of the next phase.
+    int lazy_instances;
+  };
+
+  // Starts the phase |name| and ends the previous one. |name| must outlive
+  // the process, e.g. a string literal. Lock-free and thread-safe.
+  static void MarkPhase(const char* name);
+
+  // Called by LazyInstance whenever it creates an instance.
+  static void OnLazyInstanceCreated();
+
+  // Returns the phases marked so far, in order.
+  static std::vector<Phase> GetPhases();
+
+  // Returns when the process was exec'd, or a null TimeTicks if unknown. On
+  // Linux it comes from /proc/self/stat and has a resolution of one clock
+  // tick, usually 10 ms.
+  static TimeTicks GetExecTime();
+
+  // Adds an async trace event in the "startup" category for every phase,
+  // with the recorded timestamps, and one for the time from exec to the
+  // first mark. Call it while TraceLog is recording, which may start long
+  // after the phases were marked.
+  static void AddToTrace();
+
+  // Returns a table of the phases with their offsets from exec, durations
+  // and LazyInstance counts. The last phase has no duration.
+  static std::string GetReport();
+
+  // Forgets all phases.
+  static void ResetForTesting();
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(StartupTimeline);
+};
+
+}  // namespace trace_event
+}  // namespace base
+
+#endif  // BASE_TRACE_EVENT_STARTUP_TIMELINE_H_
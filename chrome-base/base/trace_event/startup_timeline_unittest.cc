@@ -0,0 +1,109 @@
+// Copyright 2016 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/startup_timeline.h"
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/lazy_instance.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/threading/platform_thread.h"
+#include "base/trace_event/trace_event.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+LazyInstance<std::string>::Leaky g_lazy_string = LAZY_INSTANCE_INITIALIZER;
+
+void AppendJson(std::string* json,
+                const scoped_refptr<RefCountedString>& events,
+                bool has_more_events) {
+  json->append(events->data());
+}
+
+class StartupTimelineTest : public testing::Test {
+ protected:
+  void SetUp() override { StartupTimeline::ResetForTesting(); }
+  void TearDown() override { StartupTimeline::ResetForTesting(); }
+};
+
+}  // namespace
+
+TEST_F(StartupTimelineTest, RecordsPhasesInOrder) {
+  StartupTimeline::MarkPhase("load");
+  StartupTimeline::OnLazyInstanceCreated();
+  StartupTimeline::OnLazyInstanceCreated();
+  PlatformThread::Sleep(TimeDelta::FromMilliseconds(2));
+  StartupTimeline::MarkPhase("import");
+  StartupTimeline::OnLazyInstanceCreated();
+
+  std::vector<StartupTimeline::Phase> phases = StartupTimeline::GetPhases();
+  ASSERT_EQ(2u, phases.size());
+  EXPECT_STREQ("load", phases[0].name);
+  EXPECT_STREQ("import", phases[1].name);
+  EXPECT_GE(phases[1].start - phases[0].start, TimeDelta::FromMilliseconds(2));
+  EXPECT_EQ(2, phases[0].lazy_instances);
+  EXPECT_EQ(1, phases[1].lazy_instances);
+
+  std::string report = StartupTimeline::GetReport();
+  EXPECT_NE(std::string::npos, report.find("load"));
+  EXPECT_NE(std::string::npos, report.find("import"));
+}
+
+TEST_F(StartupTimelineTest, CountsLazyInstances) {
+  StartupTimeline::MarkPhase("before");
+  g_lazy_string.Get() = "created";
+  StartupTimeline::MarkPhase("after");
+  g_lazy_string.Get();
+
+  std::vector<StartupTimeline::Phase> phases = StartupTimeline::GetPhases();
+  ASSERT_EQ(2u, phases.size());
+  EXPECT_EQ(1, phases[0].lazy_instances);
+  EXPECT_EQ(0, phases[1].lazy_instances);
+}
+
+TEST_F(StartupTimelineTest, DropsPhasesBeyondCapacity) {
+  for (size_t i = 0; i < StartupTimeline::kMaxPhases + 5; ++i)
+    StartupTimeline::MarkPhase("phase");
+  EXPECT_EQ(StartupTimeline::kMaxPhases,
+            StartupTimeline::GetPhases().size());
+}
+
+#if defined(OS_LINUX)
+TEST_F(StartupTimelineTest, ExecTimeIsBeforeNow) {
+  TimeTicks exec_time = StartupTimeline::GetExecTime();
+  ASSERT_FALSE(exec_time.is_null());
+  EXPECT_LE(exec_time, TimeTicks::Now());
+
+  StartupTimeline::MarkPhase("test");
+  EXPECT_NE(std::string::npos,
+            StartupTimeline::GetReport().find("since exec"));
+}
+#endif
+
+TEST_F(StartupTimelineTest, AddsPhasesToTrace) {
+  StartupTimeline::MarkPhase("resource_import");
+  StartupTimeline::MarkPhase("ready");
+
+  // Tracing starts after the phases were marked.
+  TraceLog* trace_log = TraceLog::GetInstance();
+  trace_log->SetEnabled(TraceConfig("startup", ""), TraceLog::RECORDING_MODE);
+  StartupTimeline::AddToTrace();
+  trace_log->SetDisabled();
+
+  std::string json;
+  trace_log->Flush(Bind(&AppendJson, Unretained(&json)));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"resource_import\""));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"ready\""));
+  EXPECT_NE(std::string::npos, json.find("\"cat\":\"startup\""));
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -0,0 +1,57 @@
+#!/bin/bash
+# Copyright 2016 The Chromium Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+# Writes a copy of an ICU data package that only holds the items matching
+# the patterns in a keep list, such as icudtl_keep.list.
+#
+# Usage: trim_icudtl.sh <icupkg> <input .dat> <keep list> <output .dat>
+
+set -e
+# The keep list patterns must not expand to file names.
+set -f
+
+if [ $# -ne 4 ]; then
+  echo "Usage: $0 <icupkg> <input .dat> <keep list> <output .dat>" >&2
+  exit 1
+fi
+
+icupkg="$1"
+input="$2"
+keep_list="$3"
+output="$4"
+
+# icupkg insists that the package file name matches the prefix of its item
+# names, e.g. icudt54l.dat for icudt54l/root.res, while ours is unversioned.
+prefix=$(grep -aom1 'icudt[0-9]*[lbe]/' "${input}" | head -n 1)
+prefix=${prefix%/}
+if [ -z "${prefix}" ]; then
+  echo "${input} is not an ICU data package" >&2
+  exit 1
+fi
+
+workdir=$(mktemp -d)
+trap 'rm -rf "${workdir}"' EXIT
+cp "${input}" "${workdir}/${prefix}.dat"
+
+# Chromium's own data trimming already leaves some dependencies dangling,
+# e.g. lang/en_GB.res on lang/en_001.res, so icupkg must not check them.
+
+patterns=$(grep -v -e '^#' -e '^[[:space:]]*$' "${keep_list}")
+"${icupkg}" --ignore-deps -l "${workdir}/${prefix}.dat" -o "${workdir}/all.lst"
+while read -r item; do
+  keep=
+  for pattern in ${patterns}; do
+    case "${item}" in
+      ${pattern}) keep=1; break ;;
+    esac
+  done
+  [ -n "${keep}" ] || echo "${item}"
+done < "${workdir}/all.lst" > "${workdir}/remove.lst"
+
+"${icupkg}" --ignore-deps -r "${workdir}/remove.lst" "${workdir}/${prefix}.dat"
+cp "${workdir}/${prefix}.dat" "${output}"
+echo "Kept $(($(wc -l < "${workdir}/all.lst") - \
+  $(wc -l < "${workdir}/remove.lst"))) of $(wc -l < "${workdir}/all.lst") \
+ICU data items in ${output}"
@@ -1,76 +1,495 @@
 #include "alg/include/tal_paraformer_api.h"
 #include "alg/include/wav.h"
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <fcntl.h>
+#include <stdint.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <string>
+#include <vector>
+#include "base/allocator/allocator_extension.h"
+#include "base/at_exit.h"
+#include "base/audio/polyphase_resampler.h"
+#include "base/audio/sample_conversion.h"
 #include "base/base64.h"
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/files/file_util.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/hash.h"
+#include "base/macros.h"
+#include "base/memory/discardable_cache.h"
+#include "base/memory/madv_free_discardable_memory_posix.h"
+#include "base/memory/memory_pressure_monitor_linux.h"
+#include "base/memory/scoped_arena.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
+#include "base/sys_info.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "base/trace_event/startup_timeline.h"
+#include "base/trace_event/trace_buffer.h"
+#include "base/trace_event/trace_event.h"
 
 using namespace std;
 
+typedef base::MemoryPressureListener::MemoryPressureLevel MemoryPressureLevel;
+using base::trace_event::StartupTimeline;
 
-shared_ptr<float> str2float(const std::string& data,bool& flag, int& data_size) {
-    flag = false;
-    // 除2是因为根据16的帧率要将1字节的char转换为2字节的int16  from：wav.h  算法demo使用方法
-    data_size = data.size() / 2;
-    int offset = 0;
-    std::shared_ptr<float> data_(new float[data_size],
-        [](float *p)
-        { 
-            if(p) {
-                delete[] p;
-                p = nullptr;
-            }
+// 模型的采样率，与config.json的sample_rate一致
+const int kModelSampleRate = 16000;
+// 超过60秒（16kHz）的音频算作长音频，内存严重紧张时暂缓接纳
+const size_t kLongAudioSamples = kModelSampleRate * 60;
+// 内存严重紧张时最多等待的秒数，超过后拒绝请求
+const int kMaxAdmissionWaitSeconds = 30;
+
+// 预取模型资源时最多使用的线程数
+const int kMaxPrefaultThreads = 8;
+
+// 推理时每次都会读到的热点资源，只有这些文件会被mlock锁定常驻内存，
+// 其余资源只预读进页缓存，内存紧张时仍可被回收
+const char* const kHotResources[] = {"encoder.onnx", "cif.onnx", "dict.txt"};
+
+// --resource-lock-mb=N：锁定热点资源最多使用的内存（MB），0表示不锁定。
+// root进程不受RLIMIT_MEMLOCK限制，这个上限避免把大量内存永久钉住
+const char kResourceLockSwitch[] = "resource-lock-mb";
+const size_t kDefaultResourceLockMB = 256;
+
+// --trace-startup[=文件]：打印启动各阶段耗时，并把启动过程的trace写入文件
+const char kTraceStartupSwitch[] = "trace-startup";
+const char kDefaultStartupTraceFile[] = "startup_trace.json";
+
+// --sample-rate=N：输入PCM的采样率，默认16000。其他采样率（如8k电话音频、
+// 44.1k/48k录音）在解码后重采样到16kHz再送入识别
+const char kSampleRateSwitch[] = "sample-rate";
+
+// --channels=N：输入PCM的声道数，各声道交错存放，默认1。
+// 默认把各声道混成单声道识别；加--separate-channels时每个声道单独识别
+// （如双麦克风的课堂录音），各声道在各自的识别实例上同时推理。
+const char kChannelsSwitch[] = "channels";
+const char kSeparateChannelsSwitch[] = "separate-channels";
+
+// 输入PCM的格式，由命令行给出
+struct AudioFormat
+{
+    int sample_rate;
+    int channels;
+    bool separate_channels;
+
+    // 送去识别的音频路数
+    int streams() const { return separate_channels ? channels : 1; }
+};
+
+// 优先级101是允许的最小值，在动态库加载、各共享库的初始化之后，本程序和
+// libbase的静态初始化之前运行。exec到这里的时间就是加载共享库的开销。
+__attribute__((constructor(101))) static void markStaticInitializers()
+{
+    StartupTimeline::MarkPhase("static_initializers");
+}
+
+// 启动追踪开始得越早，能记录到的TRACE_EVENT越多
+void startStartupTrace()
+{
+    base::trace_event::TraceLog::GetInstance()->SetEnabled(
+        base::trace_event::TraceConfig(),
+        base::trace_event::TraceLog::RECORDING_MODE);
+}
+
+void appendTraceFragment(base::trace_event::TraceResultBuffer* buffer,
+                         const scoped_refptr<base::RefCountedString>& events,
+                         bool has_more_events)
+{
+    buffer->AddFragment(events->data());
+}
+
+// 进入就绪状态后调用：把启动各阶段补记到trace中，停止追踪并写入path。
+// 没有消息循环，Flush在当前线程同步完成。
+void finishStartupTrace(const base::FilePath& path)
+{
+    cerr << StartupTimeline::GetReport();
+    base::trace_event::TraceLog* trace_log =
+        base::trace_event::TraceLog::GetInstance();
+    StartupTimeline::AddToTrace();
+    trace_log->SetDisabled();
+
+    base::trace_event::TraceResultBuffer buffer;
+    base::trace_event::TraceResultBuffer::SimpleOutput output;
+    buffer.SetOutputCallback(output.GetCallback());
+    buffer.Start();
+    trace_log->Flush(base::Bind(&appendTraceFragment, base::Unretained(&buffer)));
+    buffer.Finish();
+    if (base::WriteFile(path, output.json_output.data(),
+                        output.json_output.size()) < 0)
+        cerr << "failed to write startup trace:" << path.value() << endl;
+}
+
+bool isHotResource(const base::FilePath& path)
+{
+    const base::FilePath::StringType name = path.BaseName().value();
+    for (size_t i = 0; i < arraysize(kHotResources); ++i) {
+        if (name == kHotResources[i])
+            return true;
+    }
+    return false;
+}
+
+// 在SDK加载前把模型资源（encoder.onnx、dict.txt等）映射进内存：先对所有文件
+// 发起预读，再多线程预取缺页，使SDK读取时命中页缓存，启动后的前几次推理
+// 不再因缺页串行等待IO。只有kHotResources中的文件在lock_budget字节以内
+// 被mlock锁定。映射随进程一直保留；锁定失败（超出RLIMIT_MEMLOCK）只在
+// cerr提示一次，文件仍然在页缓存中。
+void preloadResources(const char* dir, size_t lock_budget,
+                      std::vector<std::unique_ptr<base::MemoryMappedFile>>* maps)
+{
+    base::FileEnumerator files(base::FilePath(dir), true,
+                               base::FileEnumerator::FILES);
+    // 与maps一一对应，是否为热点资源
+    std::vector<bool> hot;
+    for (base::FilePath path = files.Next(); !path.empty(); path = files.Next()) {
+        std::unique_ptr<base::MemoryMappedFile> map(new base::MemoryMappedFile);
+        // 空文件无法映射，跳过
+        if (!map->Initialize(path, base::MemoryMappedFile::LOAD_HINT_WILLNEED |
+                                   base::MemoryMappedFile::LOAD_HINT_HUGEPAGE))
+            continue;
+        maps->push_back(std::move(map));
+        hot.push_back(isHotResource(path));
+    }
+    const int threads =
+        std::min(base::SysInfo::NumberOfProcessors(), kMaxPrefaultThreads);
+    for (size_t i = 0; i < maps->size(); ++i)
+        (*maps)[i]->Prefault(threads);
+
+    bool lock_failed = false;
+    for (size_t i = 0; i < maps->size(); ++i) {
+        base::MemoryMappedFile* map = (*maps)[i].get();
+        if (lock_failed || !hot[i] ||
+            map->length() > lock_budget)
+            continue;
+        if (map->Lock(0, map->length())) {
+            lock_budget -= map->length();
+        } else {
+            lock_failed = true;
+            cerr << "mlock failed, hot resources stay unlocked" << endl;
         }
-    );
+    }
+}
+
+// 识别器的可选缓存，key由base64音频的Hash64和音频格式组成。内容放在可丢弃内存里，
+// 查找时发现已被内核回收就按未命中处理。MADV_FREE的页只在内核回收时才释放，
+// 所以内存有压力时由shedCaches主动清空，不等内核。
+struct RecognizerCaches
+{
+    RecognizerCaches() : results(256, 4 << 20), pcm(8, 256 << 20) {}
 
-    for(int i=0;i<data_size;++i) {
-        int16_t sample;
-        memcpy(&sample, data.data() + offset, sizeof(int16_t));
-        offset += sizeof(int16_t);
-        data_.get()[i] = static_cast<float>(sample);
+    // 最近的识别结果，同一段音频再次请求时直接返回
+    base::DiscardableCache results;
+    // 转换好的PCM，识别失败后重试同一段音频时省去解码和转换
+    base::DiscardableCache pcm;
+};
+
+// 释放可以重建的缓存：识别结果和PCM缓存、线程复用的arena和分配器缓存的空闲内存
+void shedCaches(RecognizerCaches* caches)
+{
+    caches->pcm.Clear();
+    caches->results.Clear();
+    base::ScopedArena::ReleaseFreeArenas();
+    base::allocator::ReleaseFreeMemory();
+}
+
+// 按内存压力决定是否接纳新工作。有压力时先释放缓存；严重压力时，
+// wait为true则等待压力下降，等不到就拒绝，避免处理到一半被OOM杀掉，
+// 否则释放缓存后直接接纳。
+bool admitWork(base::nix::MemoryPressureMonitor* monitor,
+               RecognizerCaches* caches, bool wait)
+{
+    for (int waited = 0;; ++waited) {
+        MemoryPressureLevel level = monitor->CheckMemoryPressure();
+        if (level == base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE)
+            return true;
+        shedCaches(caches);
+        if (!wait ||
+            level == base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE)
+            return true;
+        if (waited == kMaxAdmissionWaitSeconds)
+            return false;
+        base::PlatformThread::Sleep(base::TimeDelta::FromSeconds(1));
+    }
+}
+
+
+// 将交错的16位PCM转换为float，结果分配在arena中，随请求一起释放。
+// 分声道识别时各声道依次连续存放，否则混成一个声道。data_size是每路的采样数。
+// 按CPU选用AVX2/SSE2实现，单声道时数值与逐个static_cast<float>相同
+float* str2float(const base::StringPiece& data, const AudioFormat& format,
+                 base::Arena* arena, int& data_size) {
+    // 除2是因为根据16的帧率要将1字节的char转换为2字节的int16  from：wav.h  算法demo使用方法
+    // wav.h的WavReader把多声道数据混在一个数组里，这里按帧拆开
+    data_size = data.size() / 2 / format.channels;
+    float* data_ = arena->AllocateArray<float>(data_size * format.streams());
+    if (format.separate_channels) {
+        float* channels[base::kMaxSampleChannels];
+        for (int c = 0; c < format.channels; ++c)
+            channels[c] = data_ + c * data_size;
+        base::DeinterleaveSamplesToFloat(data.data(), base::SAMPLE_FORMAT_S16LE,
+                                         format.channels, data_size,
+                                         base::kInt16SampleScale, channels);
+    } else {
+        base::DownmixSamplesToFloat(data.data(), base::SAMPLE_FORMAT_S16LE,
+                                    format.channels, data_size,
+                                    base::kInt16SampleScale, data_);
     }
-    flag = data_ ? true : false;
     return data_;
-    
 }
 
-string getResult(string str)
+// 将input_rate的streams路PCM分别重采样到模型的16kHz，结果分配在arena中，
+// 存放方式与输入相同
+float* resamplePcm(const float* data, int data_size, int streams, int input_rate,
+                   base::Arena* arena, int& out_size)
 {
-    string result = "";
-    int index1 = str.find("\"result\":");
-    int index2 = str.find("\"sdk_version\":");
-    for(int i = index1+9;i<index2-1;i++)
+    // Flush后的输出总数是ceil(data_size * 16000 / input_rate)
+    out_size = static_cast<int>(
+        (static_cast<int64_t>(data_size) * kModelSampleRate + input_rate - 1) /
+        input_rate);
+    float* out = arena->AllocateArray<float>(out_size * streams);
+    base::PolyphaseResampler resampler(input_rate, kModelSampleRate);
+    for (int i = 0; i < streams; ++i) {
+        float* stream_out = out + i * out_size;
+        size_t written =
+            resampler.Resample(data + i * data_size, data_size, stream_out);
+        resampler.Flush(stream_out + written);
+    }
+    return out;
+}
+
+// 在单独的线程上识别一路音频，每路用各自的识别实例
+class StreamRecognizer : public base::DelegateSimpleThread::Delegate
+{
+public:
+    StreamRecognizer(void* dec, const float* data, int data_size, string* result)
+        : dec_(dec), data_(data), data_size_(data_size), result_(result), ret_(-1) {}
+
+    void Run() override
     {
-        result.push_back(str[i]);
+        result_->clear();
+        ret_ = TalParaformerInstanceRecognize(dec_, data_, data_size_, *result_); // 中文 中英
+    }
+
+    int ret() const { return ret_; }
+
+private:
+    void* dec_;
+    const float* data_;
+    int data_size_;
+    string* result_;
+    int ret_;
+};
+
+// 识别streams路连续存放、每路data_size个采样的音频。多路时各路同时推理，
+// 整体耗时接近一次推理而不是逐路相加。有一路失败就返回负值。
+int recognizeStreams(const std::vector<void*>& decoders, const float* data,
+                     int data_size, std::vector<string>& results)
+{
+    const size_t streams = results.size();
+    std::vector<std::unique_ptr<StreamRecognizer>> recognizers;
+    for (size_t i = 0; i < streams; ++i) {
+        recognizers.push_back(std::unique_ptr<StreamRecognizer>(new StreamRecognizer(
+            decoders[i], data + i * data_size, data_size, &results[i])));
     }
-    return result;
+    // 第一路在当前线程上识别
+    std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads;
+    for (size_t i = 1; i < streams; ++i) {
+        threads.push_back(std::unique_ptr<base::DelegateSimpleThread>(
+            new base::DelegateSimpleThread(recognizers[i].get(), "asr_channel")));
+        threads.back()->Start();
+    }
+    recognizers[0]->Run();
+    int ret = recognizers[0]->ret();
+    for (size_t i = 1; i < streams; ++i) {
+        threads[i - 1]->Join();
+        ret = std::min(ret, recognizers[i]->ret());
+    }
+    return ret;
 }
 
-int main()
+// 返回result字段的内容，指向str，不拷贝
+base::StringPiece getResult(const base::StringPiece& str)
 {
+    size_t index1 = str.find("\"result\":");
+    size_t index2 = str.find("\"sdk_version\":");
+    if (index1 == base::StringPiece::npos || index2 == base::StringPiece::npos ||
+        index2 < index1 + 10) {
+        return base::StringPiece();
+    }
+    return str.substr(index1 + 9, index2 - 1 - (index1 + 9));
+}
+
+// 缓存的key。同一段数据按不同格式解释是不同的音频
+uint64_t audioKey(const base::StringPiece& base64_data, const AudioFormat& format)
+{
+    uint64_t key = base::Hash64(base64_data.data(), base64_data.size());
+    key = base::HashInts64(key, format.sample_rate);
+    return base::HashInts64(key, format.channels * 2 + format.separate_channels);
+}
+
+// 处理一次识别请求。解码后的音频和PCM都从本线程的arena分配，
+// 请求结束时一次性释放；arena在线程内复用，稳定后每个请求基本不再调用malloc。
+// results每路音频一个（见AudioFormat::streams），由调用方复用，保留其容量；
+// decoders每路一个识别实例。每个请求都检查内存压力，有压力时先释放缓存；
+// 长音频在内存严重紧张时不接纳。
+// 输入PCM不是16kHz时先重采样。
+int recognize(const std::vector<void*>& decoders,
+              base::nix::MemoryPressureMonitor* monitor,
+              RecognizerCaches* caches, const base::StringPiece& base64_data,
+              const AudioFormat& format, std::vector<string>& results)
+{
+    const int streams = format.streams();
+    // 每个采样2字节，由base64长度估算送去识别的16kHz采样数
+    const uint64_t estimated_samples =
+        base::Base64DecodedMaxSize(base64_data.size()) / 2 / format.channels *
+        streams * kModelSampleRate / format.sample_rate;
+    if (!admitWork(monitor, caches, estimated_samples > kLongAudioSamples)) {
+        cout<<"memory pressure, long audio rejected"<<endl;
+        return -1;
+    }
+
+    const uint64_t key = audioKey(base64_data, format);
+    results.resize(streams);
+    int hits = 0;
+    while (hits < streams &&
+           caches->results.Get(base::HashInts64(key, hits), &results[hits]))
+        ++hits;
+    if (hits == streams)
+        return 0;
+
+    base::ScopedArena arena;
+    base::StringPiece pcm;
+    const bool pcm_cached = caches->pcm.Get(key, arena.get(), &pcm);
+    if (!pcm_cached) {
+        char* decoded = arena->AllocateArray<char>(
+            base::Base64DecodedMaxSize(base64_data.size()));
+        size_t decoded_size = 0;
+        if (!base::Base64DecodeToBuffer(base64_data, decoded, &decoded_size)) {
+            cout<<"base64 error"<<endl;
+            return -1;
+        }
+        int data_size;
+        float* res_data = str2float(base::StringPiece(decoded, decoded_size),
+                                    format, arena.get(), data_size);
+        if (format.sample_rate != kModelSampleRate) {
+            res_data = resamplePcm(res_data, data_size, streams,
+                                   format.sample_rate, arena.get(), data_size);
+        }
+        pcm.set(reinterpret_cast<const char*>(res_data),
+                data_size * streams * sizeof(float));
+    }
+    int ret = recognizeStreams(
+        decoders, reinterpret_cast<const float*>(pcm.data()),
+        static_cast<int>(pcm.size() / sizeof(float) / streams), results);
+    if (ret < 0) {
+        // 只在失败时保存PCM供重试，成功的请求不多付一次拷贝
+        if (!pcm_cached)
+            caches->pcm.Put(key, pcm);
+    } else {
+        for (int i = 0; i < streams; ++i)
+            caches->results.Put(base::HashInts64(key, i), results[i]);
+        // 重试成功后就不再需要PCM
+        if (pcm_cached)
+            caches->pcm.Erase(key);
+    }
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    StartupTimeline::MarkPhase("main");
+    base::AtExitManager at_exit_manager;
+    base::CommandLine::Init(argc, argv);
+    const base::CommandLine* command_line =
+        base::CommandLine::ForCurrentProcess();
+    const bool trace_startup = command_line->HasSwitch(kTraceStartupSwitch);
+    if (trace_startup)
+        startStartupTrace();
+
+    AudioFormat format = {kModelSampleRate, 1, false};
+    if (command_line->HasSwitch(kSampleRateSwitch) &&
+        (!base::StringToInt(command_line->GetSwitchValueASCII(kSampleRateSwitch),
+                            &format.sample_rate) ||
+         !base::PolyphaseResampler::IsSupported(format.sample_rate,
+                                                kModelSampleRate))) {
+        cout << "unsupported sample rate: "
+             << command_line->GetSwitchValueASCII(kSampleRateSwitch) << endl;
+        exit(1);
+    }
+    if (command_line->HasSwitch(kChannelsSwitch) &&
+        (!base::StringToInt(command_line->GetSwitchValueASCII(kChannelsSwitch),
+                            &format.channels) ||
+         format.channels < 1 || format.channels > base::kMaxSampleChannels)) {
+        cout << "unsupported channels: "
+             << command_line->GetSwitchValueASCII(kChannelsSwitch) << endl;
+        exit(1);
+    }
+    format.separate_channels = command_line->HasSwitch(kSeparateChannelsSwitch);
+
     const char *mod_dir = "../../res";
+    // 资源就绪前先让模型文件常驻内存
+    StartupTimeline::MarkPhase("preload_resources");
+    std::vector<std::unique_ptr<base::MemoryMappedFile>> resource_maps;
+    size_t lock_mb = kDefaultResourceLockMB;
+    if (command_line->HasSwitch(kResourceLockSwitch) &&
+        (!base::StringToSizeT(command_line->GetSwitchValueASCII(kResourceLockSwitch),
+                              &lock_mb) ||
+         lock_mb > (SIZE_MAX >> 20))) {
+        cout << "invalid resource lock budget: "
+             << command_line->GetSwitchValueASCII(kResourceLockSwitch) << endl;
+        exit(1);
+    }
+    preloadResources(mod_dir, lock_mb << 20, &resource_maps);
     void *asr_resource{nullptr};
+    StartupTimeline::MarkPhase("resource_import");
     if (TalParaformerResourceImport(mod_dir, &asr_resource) || !asr_resource)
     {
 
         cout << "failed to load alg mod:" << mod_dir<<endl;
         exit(1);
     }
-    void *dec{nullptr};
-    if (TalParaformerInstanceCreate(asr_resource, &dec) || !dec)
+    // 没有消息循环，由admitWork在接纳工作前主动检查内存压力
+    StartupTimeline::MarkPhase("caches");
+    base::nix::MemoryPressureMonitor monitor;
+    // 本进程没有可丢弃内存服务，直接用MADV_FREE的匿名内存
+    base::MadvFreeDiscardableMemoryAllocatorPosix discardable_allocator;
+    base::DiscardableMemoryAllocator::SetInstance(&discardable_allocator);
+    RecognizerCaches caches;
+    // 每路音频一个识别实例，分声道识别时各声道同时推理
+    std::vector<void*> decoders(format.streams(), nullptr);
+    if (!admitWork(&monitor, &caches, true))
     {
-        cout << "asr create failed:" << endl;
+        cout << "memory pressure, asr create refused" << endl;
+        exit(1);
+    }
+    StartupTimeline::MarkPhase("instance_create");
+    for (size_t i = 0; i < decoders.size(); ++i) {
+        if (TalParaformerInstanceCreate(asr_resource, &decoders[i]) || !decoders[i])
+        {
+            cout << "asr create failed:" << endl;
+        }
+    }
+    StartupTimeline::MarkPhase("ready");
+    if (trace_startup) {
+        base::FilePath trace_file =
+            command_line->GetSwitchValuePath(kTraceStartupSwitch);
+        finishStartupTrace(trace_file.empty()
+                               ? base::FilePath(kDefaultStartupTraceFile)
+                               : trace_file);
     }
-    std::string result_json;
+    std::vector<std::string> results;
     int ret = -1;
-    bool is_chn = true;
     string version = TalParaformerGetResourceVersion(asr_resource);
-    int data_size;
-    bool flag;
     int fd = open("../../1_base.txt",O_RDONLY);
     if (fd == -1) {
         std::cerr << "Error opening file: " << "1_base64.txt" << std::endl;
@@ -90,24 +509,20 @@ int main()
         close(fd);
         return 1;
     }
-    string data(strdata);
-    string database64;
-    if(!base::Base64Decode(data, &database64)){
-        cout<<"base64 error"<<endl;            
-    }
-    std::shared_ptr<float> res_data = str2float(database64, flag, data_size);
-    cout << "flag: " << flag << endl;
-
-    if(flag && res_data) {
-        ret = TalParaformerInstanceRecognize(dec, res_data.get(), data_size, result_json); // 中文 中英
-        if(ret < 0){
-            cout<< "err_msg:" << "base64 decode error!"<<endl;
-        }
+    // 直接使用映射的内存，不再拷贝成string
+    base::StringPiece data(strdata, file_stat.st_size);
+    ret = recognize(decoders, &monitor, &caches, data, format, results);
+    if(ret < 0){
+        cout<< "err_msg:" << "recognize error!"<<endl;
     }
     cout<<ret<<endl;
-    string resstr("R\"("+result_json+")\"");
-    string result = getResult(resstr);
-    cout<<result<<endl;
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results.size() > 1)
+            cout << "channel " << i << ":";
+        cout<<getResult(results[i])<<endl;
+    }
+    munmap(strdata, file_stat.st_size);
+    close(fd);
     return 0;
 
-}
\ No newline at end of file
+}